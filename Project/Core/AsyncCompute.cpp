@@ -0,0 +1,222 @@
+#include "AsyncCompute.h"
+
+#include <string>
+
+#include "Logger.h"
+#include "QueueFamilyIndices.h"
+#include "RenderGraph.h"
+#include "SwapChain.h"
+#include "vulkanbase/VulkanTypes.h"
+
+
+void AsyncCompute::Init(const VulkanContext* vulkanContext)
+{
+	m_pContext = vulkanContext;
+
+	const QueueFamilyIndices queueFamilyIndices = QueueFamilyIndices::FindQueueFamilies(vulkanContext->physicalDevice, SwapChain::GetSurface());
+	m_GraphicsFamily = queueFamilyIndices.graphicsFamily.value();
+
+	//The logical device only got a compute queue when the family and timeline semaphores are there
+	m_IsEnabled = vulkanContext->computeQueue != VK_NULL_HANDLE;
+	if (!m_IsEnabled)
+	{
+		LogInfo("Async compute off, the compute passes run on the graphics queue");
+		return;
+	}
+	m_ComputeFamily = queueFamilyIndices.computeFamily.value();
+
+	//Transient, the command buffers only live for one frame
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+	const std::array<uint32_t, QueueCount> families{m_GraphicsFamily, m_ComputeFamily};
+	for (uint32_t frameIndex{}; frameIndex < FrameRing::GetFrameCount(); ++frameIndex)
+	{
+		for (size_t queue{}; queue < QueueCount; ++queue)
+		{
+			poolInfo.queueFamilyIndex = families[queue];
+			VulkanCheck(vkCreateCommandPool(vulkanContext->device, &poolInfo, nullptr, &m_Frames[frameIndex].queues[queue].commandPool), "Failed to create a submit command pool")
+		}
+	}
+
+	VkSemaphoreTypeCreateInfo timelineInfo{};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	timelineInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext = &timelineInfo;
+
+	for (VkSemaphore& semaphore : m_TimelineSemaphores)
+	{
+		VulkanCheck(vkCreateSemaphore(vulkanContext->device, &semaphoreInfo, nullptr, &semaphore), "Failed to create a timeline semaphore")
+	}
+
+	LogInfo("Async compute on queue family " + std::to_string(m_ComputeFamily) + ", graphics on " + std::to_string(m_GraphicsFamily));
+}
+
+void AsyncCompute::Cleanup(const VulkanContext* vulkanContext)
+{
+	//Destroying the pool frees its command buffers
+	for (FramePools& frame : m_Frames)
+	{
+		for (const QueuePool& queue : frame.queues)
+		{
+			if (queue.commandPool != VK_NULL_HANDLE) vkDestroyCommandPool(vulkanContext->device, queue.commandPool, nullptr);
+		}
+		frame = {};
+	}
+
+	for (VkSemaphore& semaphore : m_TimelineSemaphores)
+	{
+		if (semaphore != VK_NULL_HANDLE) vkDestroySemaphore(vulkanContext->device, semaphore, nullptr);
+		semaphore = VK_NULL_HANDLE;
+	}
+	m_TimelineValue = 0;
+}
+
+void AsyncCompute::BeginFrame()
+{
+	if (!m_IsEnabled) return;
+
+	for (QueuePool& queue : m_Frames[FrameRing::GetFrameIndex()].queues)
+	{
+		vkResetCommandPool(m_pContext->device, queue.commandPool, 0);
+		for (CommandBuffer& commandBuffer : queue.commandBuffers)
+		{
+			commandBuffer.State = CommandBufferState::Ready;
+		}
+		queue.usedCommandBuffers = 0;
+	}
+}
+
+CommandBuffer& AsyncCompute::GetCommandBuffer(size_t queue)
+{
+	QueuePool& pool = m_Frames[FrameRing::GetFrameIndex()].queues[queue];
+	if (pool.usedCommandBuffers == pool.commandBuffers.size())
+	{
+		pool.commandBuffers.emplace_back();
+		CommandBufferManager::CreateCommandBuffer(m_pContext, pool.commandBuffers.back(), true, pool.commandPool);
+	}
+
+	return pool.commandBuffers[pool.usedCommandBuffers++];
+}
+
+void AsyncCompute::SubmitFrame(RenderGraph& renderGraph, FrameData& frame)
+{
+	const std::vector<RenderGraph::Submit>& submits = renderGraph.GetSubmits();
+
+	//Everything gets recorded before the first submit, a queue never waits on commands that are still being recorded
+	std::vector<CommandBuffer*> commandBuffers(submits.size());
+	bool hasUsedFrameCommandBuffer{false};
+	for (uint32_t submitIndex{}; submitIndex < submits.size(); ++submitIndex)
+	{
+		const size_t queue = static_cast<size_t>(submits[submitIndex].queue);
+		if (submits[submitIndex].queue == QueueType::Graphics && !hasUsedFrameCommandBuffer)
+		{
+			CommandBufferManager::ResetCommandBuffer(frame.commandBuffer);
+			commandBuffers[submitIndex] = &frame.commandBuffer;
+			hasUsedFrameCommandBuffer = true;
+		}
+		else
+		{
+			commandBuffers[submitIndex] = &GetCommandBuffer(queue);
+		}
+
+		CommandBuffer& commandBuffer = *commandBuffers[submitIndex];
+		CommandBufferManager::BeginCommandBufferRecording(commandBuffer, false, false, true);
+		renderGraph.Execute(submitIndex, commandBuffer.Handle);
+		CommandBufferManager::EndCommandBufferRecording(commandBuffer);
+	}
+
+	//Reset as late as possible, WaitForAllFrames during recording would never return on an unsignaled fence
+	vkResetFences(m_pContext->device, 1, &frame.inFlightFence);
+
+	//Every submit takes the next value of one counter, so the values keep growing even when a recompile changes the submit count
+	std::vector<uint64_t> timelineValues(submits.size());
+	for (uint64_t& timelineValue : timelineValues)
+	{
+		timelineValue = ++m_TimelineValue;
+	}
+
+	bool hasWaitedOnImage{false};
+	for (uint32_t submitIndex{}; submitIndex < submits.size(); ++submitIndex)
+	{
+		const RenderGraph::Submit& submit = submits[submitIndex];
+		const bool isLastSubmit = submitIndex == submits.size() - 1;
+
+		std::array<VkSemaphoreSubmitInfo, 2> waitInfos{};
+		uint32_t waitCount{};
+		if (submit.waitSubmit != RenderGraph::NoSubmit)
+		{
+			VkSemaphoreSubmitInfo& waitInfo = waitInfos[waitCount++];
+			waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+			waitInfo.semaphore = m_TimelineSemaphores[static_cast<size_t>(submits[submit.waitSubmit].queue)];
+			waitInfo.value = timelineValues[submit.waitSubmit];
+			waitInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		}
+		//A graph without a swap chain wait stage still has to consume the acquire, the last submit waits on it at every stage
+		if (!hasWaitedOnImage && (submit.waitStages != VK_PIPELINE_STAGE_2_NONE || isLastSubmit))
+		{
+			VkSemaphoreSubmitInfo& waitInfo = waitInfos[waitCount++];
+			waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+			waitInfo.semaphore = frame.imageAvailableSemaphore;
+			waitInfo.stageMask = submit.waitStages != VK_PIPELINE_STAGE_2_NONE ? submit.waitStages : VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+			hasWaitedOnImage = true;
+		}
+
+		std::array<VkSemaphoreSubmitInfo, 2> signalInfos{};
+		uint32_t signalCount{};
+		if (submit.isSignaled)
+		{
+			VkSemaphoreSubmitInfo& signalInfo = signalInfos[signalCount++];
+			signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+			signalInfo.semaphore = m_TimelineSemaphores[static_cast<size_t>(submit.queue)];
+			signalInfo.value = timelineValues[submitIndex];
+			signalInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		}
+		if (isLastSubmit)
+		{
+			VkSemaphoreSubmitInfo& signalInfo = signalInfos[signalCount++];
+			signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+			signalInfo.semaphore = frame.renderFinishedSemaphore;
+			signalInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		}
+
+		VkCommandBufferSubmitInfo commandBufferInfo{};
+		commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+		commandBufferInfo.commandBuffer = commandBuffers[submitIndex]->Handle;
+
+		VkSubmitInfo2 submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+		submitInfo.waitSemaphoreInfoCount = waitCount;
+		submitInfo.pWaitSemaphoreInfos = waitInfos.data();
+		submitInfo.commandBufferInfoCount = 1;
+		submitInfo.pCommandBufferInfos = &commandBufferInfo;
+		submitInfo.signalSemaphoreInfoCount = signalCount;
+		submitInfo.pSignalSemaphoreInfos = signalInfos.data();
+
+		//The last submit waits on the last compute submit, so its fence covers the whole frame
+		const VkQueue queue = submit.queue == QueueType::Compute ? m_pContext->computeQueue : m_pContext->graphicsQueue;
+		const VkFence fence = isLastSubmit ? frame.inFlightFence : VK_NULL_HANDLE;
+		VulkanCheck(vkQueueSubmit2(queue, 1, &submitInfo, fence), "Failed to submit the render graph")
+		commandBuffers[submitIndex]->State = CommandBufferState::Submitted;
+	}
+}
+
+void AsyncCompute::OnImGui()
+{
+	ImGui::Begin("Info");
+	ImGui::SeparatorText("Async Compute");
+	if (m_IsEnabled)
+	{
+		ImGui::Text("Compute queue family %u, graphics family %u", m_ComputeFamily, m_GraphicsFamily);
+	}
+	else
+	{
+		ImGui::Text("Off, the compute passes run on the graphics queue");
+	}
+	ImGui::End();
+}
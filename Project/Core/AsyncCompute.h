@@ -0,0 +1,72 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "CommandBuffer.h"
+#include "FrameRing.h"
+
+class RenderGraph;
+class VulkanContext;
+
+// Submits the render graph, every submit of it to its own queue
+// The queues wait on each other through a timeline semaphore per queue, every submit signals the next value of a counter that only grows
+// Without a compute only queue family or timeline semaphores the graph keeps everything in one graphics submit
+class AsyncCompute final
+{
+public:
+	AsyncCompute() = default;
+	~AsyncCompute() = default;
+	AsyncCompute(const AsyncCompute&) = delete;
+	AsyncCompute& operator=(const AsyncCompute&) = delete;
+	AsyncCompute(AsyncCompute&&) = delete;
+	AsyncCompute& operator=(AsyncCompute&&) = delete;
+
+	// Has to be set before the logical device gets created, it decides whether the compute queue exists
+	inline static bool UseAsyncCompute{true};
+
+	// Call after FrameRing::Init
+	static void Init(const VulkanContext* vulkanContext);
+	static void Cleanup(const VulkanContext* vulkanContext);
+	// Resets the pools of this frame, call after FrameRing::BeginFrame
+	static void BeginFrame();
+
+	[[nodiscard]] static bool IsEnabled() { return m_IsEnabled; }
+	[[nodiscard]] static uint32_t GetGraphicsFamily() { return m_GraphicsFamily; }
+	[[nodiscard]] static uint32_t GetComputeFamily() { return m_ComputeFamily; }
+
+	// Records every submit of the compiled graph, then submits them in order
+	// The first submit that draws to the swap chain image waits on imageAvailableSemaphore, the last one signals renderFinishedSemaphore and the fence
+	static void SubmitFrame(RenderGraph& renderGraph, FrameData& frame);
+
+	static void OnImGui();
+
+private:
+	static constexpr size_t QueueCount = 2;
+
+	struct QueuePool
+	{
+		VkCommandPool commandPool{VK_NULL_HANDLE};
+		// One per submit of the frame, they stay allocated and get reused once the pool got reset
+		std::vector<CommandBuffer> commandBuffers{};
+		uint32_t usedCommandBuffers{};
+	};
+
+	// Not called FrameData, that one is the frame of the FrameRing
+	struct FramePools
+	{
+		std::array<QueuePool, QueueCount> queues{};
+	};
+
+	[[nodiscard]] static CommandBuffer& GetCommandBuffer(size_t queue);
+
+	inline static const VulkanContext* m_pContext{};
+	inline static bool m_IsEnabled{false};
+	inline static uint32_t m_GraphicsFamily{};
+	inline static uint32_t m_ComputeFamily{};
+
+	inline static std::array<FramePools, FrameRing::MaxFramesInFlight> m_Frames{};
+	inline static std::array<VkSemaphore, QueueCount> m_TimelineSemaphores{};
+	inline static uint64_t m_TimelineValue{};
+};
@@ -12,9 +12,9 @@ struct Buffer
 	VkBuffer buffer;
 	VmaAllocation bufferMemory;
 
-	inline void BindAsIndexBuffer(VkCommandBuffer commandBuffer) const
+	inline void BindAsIndexBuffer(VkCommandBuffer commandBuffer, VkIndexType indexType = VK_INDEX_TYPE_UINT32) const
 	{
-		vkCmdBindIndexBuffer(commandBuffer, buffer, 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindIndexBuffer(commandBuffer, buffer, 0, indexType);
 	}
 
 	inline void BindAsVertexBuffer(VkCommandBuffer commandBuffer) const
@@ -92,6 +92,12 @@ void ColorAttachment::TransitionToGeneralResource(VkCommandBuffer commandBuffer)
 	m_CurrentImageLayout = VK_IMAGE_LAYOUT_GENERAL;
 }
 
+void ColorAttachment::SetImageLayout(VkImageLayout imageLayout, bool isFirstWrite)
+{
+	m_CurrentImageLayout = imageLayout;
+	m_ColorAttachmentInfo.loadOp = isFirstWrite ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+}
+
 void ColorAttachment::OnImGui()
 {
 	if(!m_DebugTexture.get())
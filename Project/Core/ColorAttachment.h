@@ -36,6 +36,8 @@ public:
 	void TransitionToWrite(VkCommandBuffer commandBuffer);
 	void TransitionToRead(VkCommandBuffer commandBuffer);
 	void TransitionToGeneralResource(VkCommandBuffer commandBuffer);
+	//Set by the render graph after its barriers, the first write of a frame clears, later ones load
+	void SetImageLayout(VkImageLayout imageLayout, bool isFirstWrite);
 
 
 	void OnImGui();
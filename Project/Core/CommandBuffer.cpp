@@ -5,7 +5,7 @@
 #include "vulkanbase/VulkanTypes.h"
 
 
-void CommandBufferManager::CreateCommandBuffer(const VulkanContext* vulkanContext, CommandBuffer& commandBuffer, bool isPrimary )
+void CommandBufferManager::CreateCommandBuffer(const VulkanContext* vulkanContext, CommandBuffer& commandBuffer, bool isPrimary, VkCommandPool commandPool)
 {
 	//reset the command buffer
 	commandBuffer.Handle = VK_NULL_HANDLE;
@@ -15,7 +15,7 @@ void CommandBufferManager::CreateCommandBuffer(const VulkanContext* vulkanContex
 	{
 		VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
 		nullptr,
-		vulkanContext->commandPool,
+		commandPool != VK_NULL_HANDLE ? commandPool : vulkanContext->commandPool,
 		level,
 		1
 	};
@@ -34,7 +34,7 @@ void CommandBufferManager::FreeCommandBuffer(const VkDevice& device, const VkCom
 		commandBuffer.State = CommandBufferState::NotAllocated;
 }
 
-void CommandBufferManager::BeginCommandBufferRecording(CommandBuffer& commandBuffer, bool isRenderpassContinue, bool isSimultaneous, bool isSingeUse)
+void CommandBufferManager::BeginCommandBufferRecording(CommandBuffer& commandBuffer, bool isRenderpassContinue, bool isSimultaneous, bool isSingeUse, const VkCommandBufferInheritanceInfo* pInheritanceInfo)
 {
 	LogAssert(commandBuffer.State == CommandBufferState::Ready, "Command buffer not allocated", true)
 
@@ -49,7 +49,7 @@ void CommandBufferManager::BeginCommandBufferRecording(CommandBuffer& commandBuf
 		VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
 		nullptr,
 		flags,
-		nullptr
+		pInheritanceInfo
 	};
 
 	VulkanCheck(vkBeginCommandBuffer(commandBuffer.Handle, &beginInfo), "failed to begin recording command buffer!")
@@ -31,10 +31,12 @@ public:
 	CommandBufferManager& operator=(const CommandBufferManager&) = delete;
 	CommandBufferManager& operator=(CommandBufferManager&&) = delete;
 
-	static void CreateCommandBuffer(const VulkanContext* vulkanContext, CommandBuffer& commandBuffer, bool isPrimary = true);
+	// commandPool VK_NULL_HANDLE allocates from the pool of the context
+	static void CreateCommandBuffer(const VulkanContext* vulkanContext, CommandBuffer& commandBuffer, bool isPrimary = true, VkCommandPool commandPool = VK_NULL_HANDLE);
 	static void FreeCommandBuffer(const VkDevice& device, const VkCommandPool& commandPool, CommandBuffer& commandBuffer);
 
-	static void BeginCommandBufferRecording(CommandBuffer& commandBuffer, bool isRenderpassContinue, bool isSimultaneous, bool isSingeUse = false);
+	// Secondary command buffers have to pass the inheritance info, isRenderpassContinue when they get executed inside a rendering scope
+	static void BeginCommandBufferRecording(CommandBuffer& commandBuffer, bool isRenderpassContinue, bool isSimultaneous, bool isSingeUse = false, const VkCommandBufferInheritanceInfo* pInheritanceInfo = nullptr);
 	static void EndCommandBufferRecording(CommandBuffer& commandBuffer);
 
 	static void SubmitCommandBuffer(const VulkanContext* vulkanContext, CommandBuffer& commandBuffer,const VkSubmitInfo* submitInfo, VkFence fence);
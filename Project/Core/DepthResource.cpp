@@ -2,6 +2,7 @@
 
 #include "ImGuiWrapper.h"
 #include "Logger.h"
+#include "QueueFamilyIndices.h"
 #include "SwapChain.h"
 #include "Camera/Camera.h"
 #include "vulkanbase/VulkanUtil.h"
@@ -157,6 +158,20 @@ void DepthAttachment::TransitionToGeneralResource(VkCommandBuffer commandBuffer)
 
 void DepthAttachment::ResetImageLayout() { m_BindImageLayout = VK_IMAGE_LAYOUT_UNDEFINED; }
 
+void DepthAttachment::SetImageLayout(VkImageLayout imageLayout, bool isFirstWrite)
+{
+    m_BindImageLayout = imageLayout;
+
+    //Later passes still read the depth, so a write always gets stored
+    //A read only pass stores nothing, a store would be a write the compute queue sampling it at the same time races with
+    if (imageLayout == VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL || imageLayout == VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL)
+    {
+        m_DepthAttachmentInfo.imageLayout = imageLayout;
+        m_DepthAttachmentInfo.loadOp = isFirstWrite ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+        m_DepthAttachmentInfo.storeOp = imageLayout == VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL ? VK_ATTACHMENT_STORE_OP_NONE : VK_ATTACHMENT_STORE_OP_STORE;
+    }
+}
+
 VkImageLayout DepthAttachment::GetBindImageLayout()
 {
     return m_BindImageLayout;
@@ -196,7 +211,14 @@ void DepthResourceBuilder::CreateDepthResources(const VulkanContext* vulkanConte
 {
 	//Create Image
     //VK_IMAGE_USAGE_SAMPLED_BIT must be added to allow the depth image to be used as a texture (Shadow Mapping)
-	Image::CreateImage(SwapChain::Extends().width, SwapChain::Extends().height, 1, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, image, memory, TextureType::TEXTURE_2D);
+    //The compute queue samples it while the color pass depth tests against it, so both queues share it instead of handing it over
+	std::vector<uint32_t> queueFamilies{};
+	if (vulkanContext->computeQueue != VK_NULL_HANDLE)
+	{
+		const QueueFamilyIndices indices = QueueFamilyIndices::FindQueueFamilies(vulkanContext->physicalDevice, SwapChain::GetSurface());
+		queueFamilies = {indices.graphicsFamily.value(), indices.computeFamily.value()};
+	}
+	Image::CreateImage(SwapChain::Extends().width, SwapChain::Extends().height, 1, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, image, memory, TextureType::TEXTURE_2D, queueFamilies);
 
 
 	VkImageAspectFlags aspectMaskFlags = VK_IMAGE_ASPECT_DEPTH_BIT;
@@ -40,6 +40,8 @@ public:
 	void TransitionToShaderReadOnly(VkCommandBuffer commandBuffer);
     void TransitionToGeneralResource(VkCommandBuffer commandBuffer);
     void ResetImageLayout();
+    //Set by the render graph after its barriers, the first write of a frame clears, later ones load
+    void SetImageLayout(VkImageLayout imageLayout, bool isFirstWrite);
 
 private:
 	void Recreate(const VulkanContext* vulkanContext);
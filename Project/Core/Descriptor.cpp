@@ -1,10 +1,23 @@
 #include "Descriptor.h"
 #include <algorithm>
+#include "FrameRing.h"
 #include "GlobalDescriptor.h"
 #include "SwapChain.h"
 
 namespace Descriptor
 {
+	namespace
+	{
+		uint64_t HashCombine(uint64_t seed, uint64_t value)
+		{
+			//Murmur3 finalizer over the running hash, enough to tell handles apart
+			uint64_t hash = seed * 0x9E3779B97F4A7C15ull ^ value;
+			hash ^= hash >> 33;
+			hash *= 0xFF51AFD7ED558CCDull;
+			hash ^= hash >> 33;
+			return hash;
+		}
+	}
 
 	// _____                     _       _                        _ _                 _             
 	//|  __ \                   (_)     | |                 /\   | | |               | |            
@@ -17,9 +30,10 @@ namespace Descriptor
 	//
 
 
-	void DescriptorAllocator::Init(VkDevice device, uint32_t maxSets, const std::vector<PoolSizeRatio>& poolRatios)
+	void DescriptorAllocator::Init(VkDevice device, uint32_t maxSets, const std::vector<PoolSizeRatio>& poolRatios, VkDescriptorPoolCreateFlags poolFlags)
 	{
 		m_PoolSizeRatios.clear();
+		m_PoolFlags = poolFlags;
 
 		if(poolRatios.empty())
 		{
@@ -33,7 +47,7 @@ namespace Descriptor
 		}
 
 
-		const VkDescriptorPool newPool = CreatePool(device, maxSets, poolRatios);
+		const VkDescriptorPool newPool = CreatePool(device, maxSets, poolRatios, m_PoolFlags);
 
 		setsPerPool = static_cast<uint32_t>(1.5f * static_cast<float>(maxSets)); //grow it next allocation
 
@@ -57,7 +71,7 @@ namespace Descriptor
 		m_FullPools.clear();
 	}
 
-	VkDescriptorSet DescriptorAllocator::Allocate(VkDevice device, VkDescriptorSetLayout layout)
+	VkDescriptorSet DescriptorAllocator::Allocate(VkDevice device, VkDescriptorSetLayout layout, VkDescriptorPool* pool)
 	{
 		//get or create a pool to allocate from
 		VkDescriptorPool poolToUse = GrabPool(device);
@@ -71,6 +85,7 @@ namespace Descriptor
 
 		VkDescriptorSet descriptorSet;
 		const VkResult result = vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet);
+		DescriptorManager::RecordAllocation();
 
 		//allocation failed. Try again
 		if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
@@ -81,12 +96,27 @@ namespace Descriptor
 			allocInfo.descriptorPool = poolToUse;
 
 			VulkanCheck(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet), "Failed To Allocate Descriptor Set!")
+			DescriptorManager::RecordAllocation();
 		}
 
 		m_ReadyPools.emplace_back(poolToUse);
+		if (pool != nullptr) *pool = poolToUse;
 		return descriptorSet;
 	}
 
+	void DescriptorAllocator::Free(VkDevice device, VkDescriptorPool pool, VkDescriptorSet set)
+	{
+		VulkanCheck(vkFreeDescriptorSets(device, pool, 1, &set), "Failed To Free Descriptor Set!")
+
+		//The pool has room again
+		const auto fullPool = std::ranges::find(m_FullPools, pool);
+		if (fullPool != m_FullPools.end())
+		{
+			m_FullPools.erase(fullPool);
+			m_ReadyPools.emplace_back(pool);
+		}
+	}
+
 	void DescriptorAllocator::Cleanup(VkDevice device)
 	{
 		for (const auto pool : m_ReadyPools) 
@@ -119,7 +149,7 @@ namespace Descriptor
 		else 
 		{
 			//Create a new pool
-			newPool = CreatePool(device, setsPerPool, m_PoolSizeRatios);
+			newPool = CreatePool(device, setsPerPool, m_PoolSizeRatios, m_PoolFlags);
 
 			setsPerPool = static_cast<uint32_t>(static_cast<float>(setsPerPool) * setMultiplier);
 			if (setsPerPool > maxSets)
@@ -131,7 +161,7 @@ namespace Descriptor
 		return newPool;
 	}
 
-	VkDescriptorPool DescriptorAllocator::CreatePool(VkDevice device, uint32_t setCount, const std::vector<PoolSizeRatio>& poolRatios)
+	VkDescriptorPool DescriptorAllocator::CreatePool(VkDevice device, uint32_t setCount, const std::vector<PoolSizeRatio>& poolRatios, VkDescriptorPoolCreateFlags poolFlags)
 	{
 		std::vector<VkDescriptorPoolSize> poolSizes;
 
@@ -146,7 +176,7 @@ namespace Descriptor
 
 		VkDescriptorPoolCreateInfo pool_info = {};
 		pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		pool_info.flags = 0;
+		pool_info.flags = poolFlags;
 		pool_info.maxSets = setCount;
 		pool_info.poolSizeCount = (uint32_t)poolSizes.size();
 		pool_info.pPoolSizes = poolSizes.data();
@@ -221,6 +251,33 @@ namespace Descriptor
 		}
 
 		vkUpdateDescriptorSets(device, static_cast<uint32_t>(m_Writes.size()), m_Writes.data(), 0, nullptr);
+		DescriptorManager::RecordUpdate();
+	}
+
+	uint64_t DescriptorWriter::GetContentsHash() const
+	{
+		uint64_t hash{};
+		for (const VkWriteDescriptorSet& write : m_Writes)
+		{
+			hash = HashCombine(hash, write.dstBinding);
+			hash = HashCombine(hash, write.descriptorType);
+
+			if (write.pImageInfo != nullptr)
+			{
+				hash = HashCombine(hash, reinterpret_cast<uint64_t>(write.pImageInfo->imageView));
+				hash = HashCombine(hash, reinterpret_cast<uint64_t>(write.pImageInfo->sampler));
+				hash = HashCombine(hash, write.pImageInfo->imageLayout);
+			}
+
+			if (write.pBufferInfo != nullptr)
+			{
+				hash = HashCombine(hash, reinterpret_cast<uint64_t>(write.pBufferInfo->buffer));
+				hash = HashCombine(hash, write.pBufferInfo->offset);
+				hash = HashCombine(hash, write.pBufferInfo->range);
+			}
+		}
+
+		return hash;
 	}
 
 	void DescriptorWriter::Cleanup()
@@ -279,6 +336,69 @@ namespace Descriptor
 		m_Bindings.clear();
 	}
 
+	//Descriptor Set Cache
+
+	VkDescriptorSet DescriptorSetCache::Get(VkDevice device, VkDescriptorSetLayout layout, uint64_t contentsKey, DescriptorWriter& writer)
+	{
+		std::vector<Entry>& entries = m_FrameEntries[FrameRing::GetFrameIndex()];
+		const uint64_t frameNumber = FrameRing::GetFrameNumber();
+
+		for (Entry& entry : entries)
+		{
+			if (!entry.isWritten || entry.contentsKey != contentsKey) continue;
+
+			entry.lastUsedFrame = frameNumber;
+			DescriptorManager::RecordCacheHit();
+			return entry.set;
+		}
+
+		//Rewrite a set that is not bound yet this frame, the fence of this frame index guarantees the GPU is done with it
+		Entry* target{};
+		for (Entry& entry : entries)
+		{
+			if (entry.lastUsedFrame != frameNumber)
+			{
+				target = &entry;
+				break;
+			}
+		}
+
+		if (target == nullptr)
+		{
+			target = &entries.emplace_back();
+			target->set = DescriptorManager::AllocatePersistent(device, layout, target->pool);
+		}
+
+		writer.UpdateSet(device, target->set);
+		target->isWritten = true;
+		target->contentsKey = contentsKey;
+		target->lastUsedFrame = frameNumber;
+		return target->set;
+	}
+
+	void DescriptorSetCache::Invalidate()
+	{
+		for (std::vector<Entry>& entries : m_FrameEntries)
+		{
+			for (Entry& entry : entries)
+			{
+				entry.isWritten = false;
+			}
+		}
+	}
+
+	void DescriptorSetCache::Clear()
+	{
+		for (std::vector<Entry>& entries : m_FrameEntries)
+		{
+			for (const Entry& entry : entries)
+			{
+				DescriptorManager::FreePersistent(entry.pool, entry.set);
+			}
+			entries.clear();
+		}
+	}
+
 	//_____                     _       _               __  __                                   
 	//|  __ \                   (_)     | |             |  \/  |                                  
 	//| |  | | ___ ___  ___ _ __ _ _ __ | |_ ___  _ __  | \  / | __ _ _ __   __ _  __ _  ___ _ __ 
@@ -292,23 +412,26 @@ namespace Descriptor
 
 	void DescriptorManager::Init(VulkanContext* vulkanContext)
 	{
-		//for (int i{}; i < SwapChain::ImageCount(); ++i)
+		// create a descriptor pool
+		const std::vector<DescriptorAllocator::PoolSizeRatio> frame_sizes =
 		{
-			// create a descriptor pool
-			std::vector<DescriptorAllocator::PoolSizeRatio> frame_sizes =
-			{
-				{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 3 },
-				{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 },
-				{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3 },
-				{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 },
-			};
-
+			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 3 },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3 },
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 },
+		};
 
+		for (uint32_t frameIndex{}; frameIndex < FrameRing::GetFrameCount(); ++frameIndex)
+		{
 			std::unique_ptr<DescriptorAllocator> allocator = std::make_unique<DescriptorAllocator>();
 			allocator->Init(vulkanContext->device, 1000, frame_sizes);
 			m_FrameAllocators.emplace_back(std::move(allocator));
 		}
 
+		//The sets of the persistent allocator get freed one by one when their DescriptorSetCache is cleared
+		m_PersistentAllocator = std::make_unique<DescriptorAllocator>();
+		m_PersistentAllocator->Init(vulkanContext->device, 1000, frame_sizes, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+
 		GlobalDescriptor::Init(vulkanContext);
 	}
 
@@ -320,17 +443,64 @@ namespace Descriptor
 		{
 			allocator->Cleanup(device);
 		}
+		m_FrameAllocators.clear();
+
+		//Destroying the pools frees whatever is still pending
+		m_PendingFrees.clear();
+		m_PersistentAllocator->Cleanup(device);
+		m_PersistentAllocator.reset();
 	}
 
 
 
-	VkDescriptorSet DescriptorManager::Allocate(VkDevice device, VkDescriptorSetLayout setLayout, uint8_t frameNumber) {
-        return m_FrameAllocators[frameNumber]->Allocate(device, setLayout);
+	VkDescriptorSet DescriptorManager::Allocate(VkDevice device, VkDescriptorSetLayout setLayout, uint32_t frameIndex) {
+        return m_FrameAllocators[frameIndex]->Allocate(device, setLayout);
     }
 
     void DescriptorManager::ClearPools(VkDevice device)
 	{
-		m_FrameAllocators[0]->ClearPools(device);
+		m_FrameAllocators[FrameRing::GetFrameIndex()]->ClearPools(device);
+	}
+
+	VkDescriptorSet DescriptorManager::AllocatePersistent(VkDevice device, VkDescriptorSetLayout setLayout, VkDescriptorPool& pool)
+	{
+		return m_PersistentAllocator->Allocate(device, setLayout, &pool);
+	}
+
+	void DescriptorManager::FreePersistent(VkDescriptorPool pool, VkDescriptorSet set)
+	{
+		//Cleared after Cleanup, the set went with its pool
+		if (!m_PersistentAllocator || set == VK_NULL_HANDLE) return;
+
+		m_PendingFrees.push_back({pool, set, FrameRing::GetFrameNumber()});
+	}
+
+	void DescriptorManager::NewFrame(VkDevice device)
+	{
+		m_LastFrameStats = m_FrameStats;
+		m_FrameStats = {};
+
+		ClearPools(device);
+
+		//The fence of this frame index got waited on, so every frame up to frameCount frames ago is done
+		const uint64_t frameNumber = FrameRing::GetFrameNumber();
+		std::erase_if(m_PendingFrees, [device, frameNumber](const PendingFree& pendingFree)
+		{
+			if (pendingFree.frameNumber + FrameRing::GetFrameCount() > frameNumber) return false;
+
+			m_PersistentAllocator->Free(device, pendingFree.pool, pendingFree.set);
+			return true;
+		});
+	}
+
+	void DescriptorManager::OnImGui()
+	{
+		ImGui::Begin("Info");
+		ImGui::SeparatorText("Descriptors");
+		ImGui::Text("vkAllocateDescriptorSets: %u", m_LastFrameStats.allocations);
+		ImGui::Text("vkUpdateDescriptorSets: %u", m_LastFrameStats.updates);
+		ImGui::Text("Cached set binds: %u", m_LastFrameStats.cacheHits);
+		ImGui::End();
 	}
 
 }
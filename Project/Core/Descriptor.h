@@ -1,9 +1,12 @@
 #pragma once
+#include <array>
+#include <cstdint>
 #include <deque>
 #include <memory>
 #include <vector>
 #include <vulkan/vulkan.h>
 #include "Buffer.h"
+#include "FrameRing.h"
 
 
 
@@ -29,22 +32,28 @@ namespace Descriptor
 		};
 
 		//Allocate the first descriptor pool
-		void Init(VkDevice device, uint32_t maxSets, const std::vector<PoolSizeRatio>& poolRatios = std::vector<PoolSizeRatio>{});
+		//Pools of an allocator that frees single sets need VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT
+		void Init(VkDevice device, uint32_t maxSets, const std::vector<PoolSizeRatio>& poolRatios = std::vector<PoolSizeRatio>{}, VkDescriptorPoolCreateFlags poolFlags = 0);
 
 		//Copy the full pools to the ready pools and clear the full pools.
 		void ClearPools(VkDevice device);
 
 		//Allocate a descriptor set from the ready pools, if there are none, create a new pool.
-		VkDescriptorSet Allocate(VkDevice device, VkDescriptorSetLayout layout);
+		//pool receives the pool the set came from, Free needs it
+		VkDescriptorSet Allocate(VkDevice device, VkDescriptorSetLayout layout, VkDescriptorPool* pool = nullptr);
+
+		//Give a single set back to its pool, only for pools created with VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT
+		void Free(VkDevice device, VkDescriptorPool pool, VkDescriptorSet set);
 
 		void Cleanup(VkDevice device);
 	private:
 		//Get a pool from the ready vector, if there are none, create a new one.
 		VkDescriptorPool GrabPool(VkDevice device);
 
-		static VkDescriptorPool CreatePool(VkDevice device, uint32_t setCount, const std::vector<PoolSizeRatio>& poolRatios);
+		static VkDescriptorPool CreatePool(VkDevice device, uint32_t setCount, const std::vector<PoolSizeRatio>& poolRatios, VkDescriptorPoolCreateFlags poolFlags);
 
 		std::vector<PoolSizeRatio> m_PoolSizeRatios;
+		VkDescriptorPoolCreateFlags m_PoolFlags{};
 		std::vector<VkDescriptorPool> m_FullPools;
 		std::vector<VkDescriptorPool> m_ReadyPools;
 		uint32_t setsPerPool;
@@ -69,6 +78,9 @@ namespace Descriptor
 		//Actual Write to the descriptor set
 		void UpdateSet(VkDevice device, VkDescriptorSet set);
 
+		//Hash of every queued write (binding, type, handles, layout), equal hashes write equal sets
+		[[nodiscard]] uint64_t GetContentsHash() const;
+
 		void Cleanup();
 
 	private:
@@ -102,6 +114,48 @@ namespace Descriptor
 	};
 
 
+	//Descriptor sets that outlive the frame, one small cache per frame in flight
+	//A set only gets rewritten when its contents key changes, and never after it was bound in the current frame
+	class DescriptorSetCache final
+	{
+	public:
+		DescriptorSetCache() = default;
+		~DescriptorSetCache() = default;
+
+		DescriptorSetCache(const DescriptorSetCache&) = delete;
+		DescriptorSetCache& operator=(const DescriptorSetCache&) = delete;
+		DescriptorSetCache(DescriptorSetCache&&) = delete;
+		DescriptorSetCache& operator=(DescriptorSetCache&&) = delete;
+
+		//Returns the set of this frame that holds contentsKey, the writer is only used when nothing matches
+		VkDescriptorSet Get(VkDevice device, VkDescriptorSetLayout layout, uint64_t contentsKey, DescriptorWriter& writer);
+
+		//The next Get of every frame writes a set again, the sets themselves are kept
+		void Invalidate();
+
+		//Gives the sets back to the persistent pool once no frame in flight can read them anymore
+		void Clear();
+
+	private:
+		struct Entry
+		{
+			VkDescriptorSet set{VK_NULL_HANDLE};
+			VkDescriptorPool pool{VK_NULL_HANDLE};
+			uint64_t contentsKey{};
+			uint64_t lastUsedFrame{UINT64_MAX};
+			bool isWritten{};
+		};
+
+		std::array<std::vector<Entry>, FrameRing::MaxFramesInFlight> m_FrameEntries{};
+	};
+
+	struct DescriptorStats
+	{
+		uint32_t allocations{};
+		uint32_t updates{};
+		uint32_t cacheHits{};
+	};
+
 	//Manages the above classes
 	class DescriptorManager final
 	{
@@ -118,10 +172,40 @@ namespace Descriptor
 		static void Cleanup(VkDevice device);
 
 
-		static VkDescriptorSet Allocate(VkDevice device, VkDescriptorSetLayout setLayout, uint8_t frameNumber);
+		//Sets are only valid for the frame they were allocated in, the pools of a frame get reset once its fence is signaled
+		static VkDescriptorSet Allocate(VkDevice device, VkDescriptorSetLayout setLayout, uint32_t frameIndex);
 		static void ClearPools(VkDevice device);
 
+		//Sets that are never reset, used through DescriptorSetCache
+		static VkDescriptorSet AllocatePersistent(VkDevice device, VkDescriptorSetLayout setLayout, VkDescriptorPool& pool);
+		//The set gets freed at the start of the first frame that no frame in flight could have bound it in
+		static void FreePersistent(VkDescriptorPool pool, VkDescriptorSet set);
+
+		//Call at the start of every frame, clears the pools of the frame, frees the persistent sets that are done and rolls the counters over
+		static void NewFrame(VkDevice device);
+
+		//Counts the vkAllocateDescriptorSets / vkUpdateDescriptorSets calls and cache hits of the frame
+		static void RecordAllocation() { ++m_FrameStats.allocations; }
+		static void RecordUpdate() { ++m_FrameStats.updates; }
+		static void RecordCacheHit() { ++m_FrameStats.cacheHits; }
+		[[nodiscard]] static const DescriptorStats& GetLastFrameStats() { return m_LastFrameStats; }
+
+		static void OnImGui();
+
 	private:
+		//One allocator per frame in flight
 		static inline std::vector<std::unique_ptr<DescriptorAllocator>> m_FrameAllocators;
+		static inline std::unique_ptr<DescriptorAllocator> m_PersistentAllocator;
+
+		struct PendingFree
+		{
+			VkDescriptorPool pool;
+			VkDescriptorSet set;
+			uint64_t frameNumber;
+		};
+		static inline std::vector<PendingFree> m_PendingFrees;
+
+		static inline DescriptorStats m_FrameStats{};
+		static inline DescriptorStats m_LastFrameStats{};
 	};
 }
@@ -5,9 +5,11 @@
 
 #include "DepthResource.h"
 #include "DynamicUniformBuffer.h"
+#include "FrameRing.h"
 #include "GBuffer.h"
 #include "SwapChain.h"
 #include "Image/ImageLoader.h"
+#include "Image/TextureCache.h"
 
 DynamicBuffer *DescriptorSet::AddBuffer(int binding, DescriptorType type)
 {
@@ -56,8 +58,16 @@ void DescriptorSet::AddTexture(int binding, const std::variant<std::filesystem::
         return;
     }
 
-    //Create a new texture
-    std::shared_ptr<Texture> texture = std::make_shared<Texture>(pathOrImage, pContext, colorType, textureType);
+    //Files go through the cache so every user of the same file shares one texture, images in memory are always new
+    std::shared_ptr<Texture> texture;
+    if (const auto path = std::get_if<std::filesystem::path>(&pathOrImage))
+    {
+        texture = TextureCache::Load(*path, pContext, colorType, textureType);
+    }
+    else
+    {
+        texture = std::make_shared<Texture>(pathOrImage, pContext, colorType, textureType);
+    }
 
     //Add a new texture at binding x
     const auto [iterator, isEmplaced] = m_Textures.try_emplace(binding, std::move(texture));
@@ -202,22 +212,24 @@ void DescriptorSet::Initialize(const VulkanContext *pContext)
 
 void DescriptorSet::Bind(VulkanContext *pContext, const VkCommandBuffer& commandBuffer, const VkPipelineLayout & pipelineLayout, int descriptorSetIndex, PipelineType pipelineType, bool fullRebind)
 {
+    const VkDescriptorSet descriptorSet = Prepare(pContext, fullRebind);
+    vkCmdBindDescriptorSets(commandBuffer, static_cast<VkPipelineBindPoint>(pipelineType), pipelineLayout, descriptorSetIndex, 1,
+                            &descriptorSet, 0, nullptr);
+}
 
-    m_DescriptorSet = Descriptor::DescriptorManager::Allocate(pContext->device, m_DescriptorSetLayout, 0);
+VkDescriptorSet DescriptorSet::Prepare(VulkanContext *pContext, bool fullRebind)
+{
     m_DescriptorWriter.Cleanup();
 
-    // Update the data of all the ubo's
+    // Update the data of all the ubo's, only the ones that changed get copied
     //Then bind them
     for (auto &[binding, ubo]: m_Buffers)
     {
         if(fullRebind)
         {
-            ubo.FullRebind(binding, m_DescriptorSet, m_DescriptorWriter, pContext);
-        }
-        else
-        {
-            ubo.ProperBind(binding, m_DescriptorWriter);
+            ubo.MarkDirty();
         }
+        ubo.ProperBind(binding, m_DescriptorWriter);
     }
 
     //Bind all textures
@@ -243,9 +255,23 @@ void DescriptorSet::Bind(VulkanContext *pContext, const VkCommandBuffer& command
         GBuffer::BindNormal(m_DescriptorWriter, m_NormalTextureBinding);
     }
 
-    m_DescriptorWriter.UpdateSet(pContext->device, m_DescriptorSet);
-    vkCmdBindDescriptorSets(commandBuffer, static_cast<VkPipelineBindPoint>(pipelineType), pipelineLayout, descriptorSetIndex, 1,
-                            &m_DescriptorSet, 0, nullptr);
+    //The handles alone can repeat after a resource got recreated, the versions can not
+    uint64_t contentsKey = m_DescriptorWriter.GetContentsHash();
+    contentsKey ^= static_cast<uint64_t>(SwapChain::GetRecreationCount()) << 48;
+    for (const auto &[binding, ubo]: m_Buffers)
+    {
+        contentsKey += static_cast<uint64_t>(ubo.GetVersion()) << 32;
+    }
+    for (const auto &[binding, texture]: m_Textures)
+    {
+        contentsKey += texture->GetVersion();
+    }
+    if(fullRebind)
+    {
+        m_SetCache.Invalidate();
+    }
+
+    return m_SetCache.Get(pContext->device, m_DescriptorSetLayout, contentsKey, m_DescriptorWriter);
 }
 
 VkDescriptorSetLayout &DescriptorSet::GetLayout(const VulkanContext* pContext)
@@ -273,12 +299,13 @@ void DescriptorSet::CleanUp(VkDevice device)
     // Cleanup the textures
     for (auto &texture : m_Textures | std::views::values)
     {
-    	if(!texture->IsPendingKill())
+    	if(!texture->IsPendingKill() && !texture->IsCached())
 			texture->Cleanup(device);
     }
 	m_Textures.clear();
 
-    // Cleanup the layout
+    // Cleanup the layout, the cached sets go back to the persistent pool once the frames in flight are done with them
+    m_SetCache.Clear();
     vkDestroyDescriptorSetLayout(device, m_DescriptorSetLayout, nullptr);
 }
 void DescriptorSet::OnImGui()
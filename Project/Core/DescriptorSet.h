@@ -58,7 +58,10 @@ public:
 	void AddColorAttachment(ColorAttachment* colorAttachment, int binding);
 
     void Initialize(const VulkanContext* pContext);
+    //Reuses the cached set of this frame when nothing it points at changed, fullRebind forces a fresh write
     void Bind(VulkanContext *pContext, const VkCommandBuffer& commandBuffer, const VkPipelineLayout & pipelineLayout, int descriptorSetIndex, PipelineType pipelineType, bool fullRebind = false);
+    //The write half of Bind, not thread safe, the returned set can then be bound from any thread
+    [[nodiscard]] VkDescriptorSet Prepare(VulkanContext *pContext, bool fullRebind = false);
 
     //Layout to specify in the pipeline layout
     VkDescriptorSetLayout &GetLayout(const VulkanContext* pContext);
@@ -82,7 +85,7 @@ private:
 	int m_NormalTextureBinding{-1};
 
     VkDescriptorSetLayout m_DescriptorSetLayout{};
-    VkDescriptorSet m_DescriptorSet{};
+    Descriptor::DescriptorSetCache m_SetCache{};
 
     Descriptor::DescriptorWriter m_DescriptorWriter{};
     Descriptor::DescriptorBuilder m_DescriptorBuilder{};
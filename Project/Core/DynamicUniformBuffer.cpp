@@ -22,15 +22,19 @@ DynamicBuffer::DynamicBuffer(DynamicBuffer &&other) noexcept {
     if(this != &other)
     {
         m_Data = std::move(other.m_Data);
-        m_UniformBuffer = other.m_UniformBuffer;
+        m_UniformBuffers = other.m_UniformBuffers;
         m_UniformBuffersMemory = other.m_UniformBuffersMemory;
         m_UniformBuffersMapped = other.m_UniformBuffersMapped;
+        m_FrameCount = other.m_FrameCount;
+        m_DirtyFrames = other.m_DirtyFrames;
+        m_Version = other.m_Version;
         m_BufferType = other.m_BufferType;
         m_DescriptorType = other.m_DescriptorType;
 
-        other.m_UniformBuffer = nullptr;
-        other.m_UniformBuffersMemory = nullptr;
-        other.m_UniformBuffersMapped = nullptr;
+        other.m_UniformBuffers = {};
+        other.m_UniformBuffersMemory = {};
+        other.m_UniformBuffersMapped = {};
+        other.m_FrameCount = 0;
     }
 }
 
@@ -41,33 +45,49 @@ void DynamicBuffer::Init()
 	//Log the size of the buffer in bytes
 	LogInfo("Initializing Dynamic buffer with size: " + std::to_string(GetSize()) + " bytes");
 
-	Core::Buffer::CreateBuffer(GetSize(), static_cast<VkBufferUsageFlags>(m_BufferType), m_UniformBuffer, m_UniformBuffersMemory, true, true);
+	m_FrameCount = FrameRing::GetFrameCount();
+	for (uint32_t frameIndex{}; frameIndex < m_FrameCount; ++frameIndex)
+	{
+		Core::Buffer::CreateBuffer(GetSize(), static_cast<VkBufferUsageFlags>(m_BufferType), m_UniformBuffers[frameIndex], m_UniformBuffersMemory[frameIndex], true, true);
 
-    VmaAllocationInfo allocInfo;
-    vmaGetAllocationInfo(Allocator::vmaAllocator, m_UniformBuffersMemory, &allocInfo);
-    m_UniformBuffersMapped = (void*)allocInfo.pMappedData;
+		VmaAllocationInfo allocInfo;
+		vmaGetAllocationInfo(Allocator::vmaAllocator, m_UniformBuffersMemory[frameIndex], &allocInfo);
+		m_UniformBuffersMapped[frameIndex] = allocInfo.pMappedData;
+	}
+
+	++m_Version;
+	MarkDirty();
 }
 
-void DynamicBuffer::ProperBind(int bindingNumber, Descriptor::DescriptorWriter &descriptorWriter) const {
-    //Update the data for the descriptor set
-    memcpy(m_UniformBuffersMapped, GetData(), GetSize());
+void DynamicBuffer::ProperBind(int bindingNumber, Descriptor::DescriptorWriter &descriptorWriter) {
+    //Update the data for the descriptor set, the copies of the other frames can still be read by the GPU
+    const uint32_t frameIndex = FrameRing::GetFrameIndex();
+    if (m_DirtyFrames & (1u << frameIndex))
+    {
+        memcpy(m_UniformBuffersMapped[frameIndex], GetData(), GetSize());
+        m_DirtyFrames &= ~(1u << frameIndex);
+    }
 
     //Write the buffer to the descriptor set
-    descriptorWriter.WriteBuffer(bindingNumber, m_UniformBuffer, GetSize(), 0, static_cast<VkDescriptorType>(m_DescriptorType));
+    descriptorWriter.WriteBuffer(bindingNumber, m_UniformBuffers[frameIndex], GetSize(), 0, static_cast<VkDescriptorType>(m_DescriptorType));
 }
 void DynamicBuffer::FullRebind(int bindingNumber, const VkDescriptorSet &descriptorSet, Descriptor::DescriptorWriter &descriptorWriter, VulkanContext *vulkanContext) const
 {
-    memcpy(m_UniformBuffersMapped, GetData(), GetSize());
+    const uint32_t frameIndex = FrameRing::GetFrameIndex();
+    memcpy(m_UniformBuffersMapped[frameIndex], GetData(), GetSize());
 
     descriptorWriter.Cleanup();
-    descriptorWriter.WriteBuffer(bindingNumber, m_UniformBuffer, GetSize(), 0, static_cast<VkDescriptorType>(m_DescriptorType));
+    descriptorWriter.WriteBuffer(bindingNumber, m_UniformBuffers[frameIndex], GetSize(), 0, static_cast<VkDescriptorType>(m_DescriptorType));
     descriptorWriter.UpdateSet(vulkanContext->device, descriptorSet);
 }
 
 
 void DynamicBuffer::Cleanup(VkDevice device) const
 {
-    vmaDestroyBuffer(Allocator::vmaAllocator, m_UniformBuffer, m_UniformBuffersMemory);
+    for (uint32_t frameIndex{}; frameIndex < m_FrameCount; ++frameIndex)
+    {
+        vmaDestroyBuffer(Allocator::vmaAllocator, m_UniformBuffers[frameIndex], m_UniformBuffersMemory[frameIndex]);
+    }
 }
 
 uint16_t DynamicBuffer::AddVariable(const float value)
@@ -123,13 +143,18 @@ void DynamicBuffer::OnImGui()
 
         //Get pointer to Those 4 floats
         float* dataPtr = m_Data.data() + i;
-        ImGui::ColorEdit4(label.c_str(), dataPtr);
+        if (ImGui::ColorEdit4(label.c_str(), dataPtr))
+        {
+            MarkDirty();
+        }
     }
 
     std::string labelAddColor4 = "Add Color4" + labelAddition;
     if(ImGui::Button(labelAddColor4.c_str()))
     {
         AddVariable(glm::vec4{0});
+        //The old copies can still be in use by the frames in flight
+        FrameRing::WaitForAllFrames();
         Cleanup(ServiceLocator::GetService<VulkanContext>()->device);
         Init();
     }
@@ -138,11 +163,18 @@ void DynamicBuffer::OnImGui()
     if(ImGui::Button(labelAddMat4.c_str()))
     {
         AddVariable(glm::mat4{1});
+        //The old copies can still be in use by the frames in flight
+        FrameRing::WaitForAllFrames();
         Cleanup(ServiceLocator::GetService<VulkanContext>()->device);
         Init();
     }
 }
 
+void DynamicBuffer::MarkDirty()
+{
+    m_DirtyFrames = (1u << FrameRing::MaxFramesInFlight) - 1;
+}
+
 void DynamicBuffer::SetDescriptorType(DescriptorType descriptorType)
 {
     m_DescriptorType = descriptorType;
@@ -179,5 +211,9 @@ void DynamicBuffer::Update(uint16_t handle, const float* dataPtr, uint8_t size)
 {
 	LogAssert(handle + size <= m_Data.size(), "Handle out of bounds", true)
 
+	//Most variables get set to the same value every frame, only a real change has to reach the GPU
+	if (std::equal(dataPtr, dataPtr + size, m_Data.begin() + handle)) return;
+
 	std::copy_n(dataPtr, size, m_Data.begin() + handle);
+	MarkDirty();
 }
\ No newline at end of file
@@ -1,9 +1,11 @@
 #pragma once
+#include <array>
 #include <vector>
 #include <glm/mat4x4.hpp>
 #include <glm/vec4.hpp>
 #include <vulkan/vulkan.h>
 #include "vulkanbase/VulkanTypes.h"
+#include "Core/FrameRing.h"
 #include "Core/VmaUsage.h"
 
 enum class DescriptorType;
@@ -24,6 +26,8 @@ enum class BufferType
 
 //TODO: pad the dynamic buffer to 256 bytes
 //TODO: return actual pointers to the data instead of the handle, Or make a handle struct
+//Keeps one mapped copy per frame in flight, binding writes the CPU data into the copy of the current frame
+//Copies are only rewritten when the data changed since they were last written
 class DynamicBuffer final
 {
 public:
@@ -36,7 +40,7 @@ public:
     DynamicBuffer& operator=(DynamicBuffer&& other) noexcept = delete;
 
 	void Init();
-	void ProperBind(int bindingNumber, Descriptor::DescriptorWriter& descriptorWriter) const;
+	void ProperBind(int bindingNumber, Descriptor::DescriptorWriter& descriptorWriter);
     void FullRebind(int bindingNumber, const VkDescriptorSet& descriptorSet, Descriptor::DescriptorWriter& descriptorWriter, VulkanContext* vulkanContext) const;
     void Cleanup(VkDevice device) const;
 
@@ -54,6 +58,11 @@ public:
 
     void SetDescriptorType(DescriptorType descriptorType);
 
+    //Flags every frame copy as stale
+    void MarkDirty();
+    //Changes whenever the buffers get recreated, descriptor sets that point at the old ones have to be rewritten
+    [[nodiscard]] uint32_t GetVersion() const { return m_Version; }
+
 private:
 	[[nodiscard]] const float* GetData() const;
 	[[nodiscard]] size_t GetSize() const;
@@ -63,9 +72,12 @@ private:
 	std::vector<float> m_Data;
 
 
-	VkBuffer m_UniformBuffer{};
-	VmaAllocation m_UniformBuffersMemory{};
-	void* m_UniformBuffersMapped{};
+	std::array<VkBuffer, FrameRing::MaxFramesInFlight> m_UniformBuffers{};
+	std::array<VmaAllocation, FrameRing::MaxFramesInFlight> m_UniformBuffersMemory{};
+	std::array<void*, FrameRing::MaxFramesInFlight> m_UniformBuffersMapped{};
+	uint32_t m_FrameCount{};
+	uint32_t m_DirtyFrames{};
+	uint32_t m_Version{};
 
     BufferType m_BufferType{};
     DescriptorType m_DescriptorType{};
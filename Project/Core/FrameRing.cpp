@@ -0,0 +1,88 @@
+#include "FrameRing.h"
+
+#include <algorithm>
+#include <string>
+
+#include "Logger.h"
+#include "vulkanbase/VulkanTypes.h"
+
+
+void FrameRing::Init(const VulkanContext* vulkanContext)
+{
+	m_pContext = vulkanContext;
+	m_FrameCount = std::clamp(FramesInFlight, 1u, MaxFramesInFlight);
+	m_FrameIndex = 0;
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	//Signaled, so the first wait on every slot returns right away
+	VkFenceCreateInfo fenceInfo{};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+	for (uint32_t frameIndex{}; frameIndex < m_FrameCount; ++frameIndex)
+	{
+		FrameData& frame = m_Frames[frameIndex];
+		CommandBufferManager::CreateCommandBuffer(vulkanContext, frame.commandBuffer);
+
+		VulkanCheck(vkCreateSemaphore(vulkanContext->device, &semaphoreInfo, nullptr, &frame.imageAvailableSemaphore), "Failed to create the image available semaphore")
+		VulkanCheck(vkCreateSemaphore(vulkanContext->device, &semaphoreInfo, nullptr, &frame.renderFinishedSemaphore), "Failed to create the render finished semaphore")
+		VulkanCheck(vkCreateFence(vulkanContext->device, &fenceInfo, nullptr, &frame.inFlightFence), "Failed to create the in flight fence")
+	}
+
+	m_LastFrameStart = std::chrono::steady_clock::now();
+	LogInfo("Frames in flight: " + std::to_string(m_FrameCount));
+}
+
+void FrameRing::Cleanup(const VulkanContext* vulkanContext)
+{
+	WaitForAllFrames();
+
+	for (uint32_t frameIndex{}; frameIndex < m_FrameCount; ++frameIndex)
+	{
+		FrameData& frame = m_Frames[frameIndex];
+		CommandBufferManager::FreeCommandBuffer(vulkanContext->device, vulkanContext->commandPool, frame.commandBuffer);
+
+		vkDestroySemaphore(vulkanContext->device, frame.imageAvailableSemaphore, nullptr);
+		vkDestroySemaphore(vulkanContext->device, frame.renderFinishedSemaphore, nullptr);
+		vkDestroyFence(vulkanContext->device, frame.inFlightFence, nullptr);
+
+		frame = {};
+	}
+}
+
+FrameData& FrameRing::BeginFrame()
+{
+	FrameData& frame = m_Frames[m_FrameIndex];
+
+	const auto waitStart = std::chrono::steady_clock::now();
+	vkWaitForFences(m_pContext->device, 1, &frame.inFlightFence, VK_TRUE, UINT64_MAX);
+	const auto waitEnd = std::chrono::steady_clock::now();
+
+	m_LastFenceWaitMs = std::chrono::duration<float, std::milli>(waitEnd - waitStart).count();
+	m_LastFrameIntervalMs = std::chrono::duration<float, std::milli>(waitStart - m_LastFrameStart).count();
+	m_LastFrameStart = waitStart;
+
+	return frame;
+}
+
+void FrameRing::AdvanceFrame()
+{
+	m_FrameIndex = (m_FrameIndex + 1) % m_FrameCount;
+	++m_FrameNumber;
+}
+
+void FrameRing::WaitForAllFrames()
+{
+	//Also called from cleanup code that can run after the ring is gone
+	if (m_pContext == nullptr || m_Frames[0].inFlightFence == VK_NULL_HANDLE) return;
+
+	std::array<VkFence, MaxFramesInFlight> fences{};
+	for (uint32_t frameIndex{}; frameIndex < m_FrameCount; ++frameIndex)
+	{
+		fences[frameIndex] = m_Frames[frameIndex].inFlightFence;
+	}
+
+	vkWaitForFences(m_pContext->device, m_FrameCount, fences.data(), VK_TRUE, UINT64_MAX);
+}
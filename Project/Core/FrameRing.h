@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+#include "CommandBuffer.h"
+
+class VulkanContext;
+
+// Everything the CPU records into while the GPU may still be busy with the other frames
+struct FrameData
+{
+	CommandBuffer commandBuffer{};
+	VkSemaphore imageAvailableSemaphore{VK_NULL_HANDLE};
+	VkSemaphore renderFinishedSemaphore{VK_NULL_HANDLE};
+	VkFence inFlightFence{VK_NULL_HANDLE};
+};
+
+// Ring of frames in flight, the CPU records frame N+1 while the GPU still renders frame N
+// Per frame resources (descriptor allocators, mapped uniform buffers) index into their copies with GetFrameIndex
+// Anything that frees or moves GPU data that a frame might still read has to call WaitForAllFrames first
+class FrameRing final
+{
+public:
+	FrameRing() = default;
+	~FrameRing() = default;
+	FrameRing(const FrameRing&) = delete;
+	FrameRing& operator=(const FrameRing&) = delete;
+	FrameRing(FrameRing&&) = delete;
+	FrameRing& operator=(FrameRing&&) = delete;
+
+	static constexpr uint32_t MaxFramesInFlight = 3;
+
+	// Has to be set before Init, 1 gives back the old fully serialized behaviour
+	inline static uint32_t FramesInFlight{2};
+
+	static void Init(const VulkanContext* vulkanContext);
+	static void Cleanup(const VulkanContext* vulkanContext);
+
+	// Waits until the GPU is done with the frame that used this slot last
+	// The fence stays signaled, reset it right before submitting so an early out can not deadlock the next wait
+	static FrameData& BeginFrame();
+	// Call after the frame got submitted
+	static void AdvanceFrame();
+
+	static void WaitForAllFrames();
+
+	[[nodiscard]] static uint32_t GetFrameIndex() { return m_FrameIndex; }
+	[[nodiscard]] static uint32_t GetFrameCount() { return m_FrameCount; }
+	// Counts every frame since Init, unlike the index it never wraps
+	[[nodiscard]] static uint64_t GetFrameNumber() { return m_FrameNumber; }
+	[[nodiscard]] static FrameData& GetCurrentFrame() { return m_Frames[m_FrameIndex]; }
+
+	// Time between the last two BeginFrame calls and how much of it was spent blocked on the fence
+	[[nodiscard]] static float GetLastFrameIntervalMs() { return m_LastFrameIntervalMs; }
+	[[nodiscard]] static float GetLastFenceWaitMs() { return m_LastFenceWaitMs; }
+
+private:
+	inline static const VulkanContext* m_pContext{};
+
+	inline static std::array<FrameData, MaxFramesInFlight> m_Frames{};
+	inline static uint32_t m_FrameIndex{};
+	inline static uint32_t m_FrameCount{1};
+	inline static uint64_t m_FrameNumber{};
+
+	inline static std::chrono::steady_clock::time_point m_LastFrameStart{};
+	inline static float m_LastFrameIntervalMs{};
+	inline static float m_LastFenceWaitMs{};
+};
@@ -0,0 +1,113 @@
+#include "Frustum.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_SSE 1
+#include <emmintrin.h>
+#else
+#define FRUSTUM_SSE 0
+#endif
+
+
+AABB AABB::Transform(const glm::mat4& matrix) const
+{
+	if (IsEmpty()) return *this;
+
+	const glm::vec3 center = matrix * glm::vec4(GetCenter(), 1.0f);
+	const glm::vec3 extent = GetExtent();
+
+	glm::vec3 worldExtent{};
+	for (int axis{}; axis < 3; ++axis)
+	{
+		worldExtent += glm::abs(glm::vec3(matrix[axis])) * extent[axis];
+	}
+	return {center - worldExtent, center + worldExtent};
+}
+
+Frustum Frustum::FromMatrix(const glm::mat4& viewProjection)
+{
+	//glm is column major, row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+	const auto row = [&viewProjection](int index) { return glm::vec4{viewProjection[0][index], viewProjection[1][index], viewProjection[2][index], viewProjection[3][index]}; };
+	const std::array<glm::vec4, 6> planes
+	{
+		row(3) + row(0),
+		row(3) - row(0),
+		row(3) + row(1),
+		row(3) - row(1),
+		row(2),
+		row(3) - row(2),
+	};
+
+	Frustum frustum{};
+	for (size_t planeIndex{}; planeIndex < planes.size(); ++planeIndex)
+	{
+		const glm::vec4 plane = planes[planeIndex] / glm::length(glm::vec3(planes[planeIndex]));
+		frustum.normalX[planeIndex] = plane.x;
+		frustum.normalY[planeIndex] = plane.y;
+		frustum.normalZ[planeIndex] = plane.z;
+		frustum.distance[planeIndex] = plane.w;
+	}
+	for (size_t planeIndex{planes.size()}; planeIndex < frustum.distance.size(); ++planeIndex)
+	{
+		frustum.distance[planeIndex] = std::numeric_limits<float>::max();
+	}
+	return frustum;
+}
+
+CullResult Frustum::TestAABB(const AABB& box) const
+{
+#if FRUSTUM_SSE
+	const glm::vec3 center = box.GetCenter();
+	const glm::vec3 extent = box.GetExtent();
+
+	const __m128 centerX = _mm_set1_ps(center.x);
+	const __m128 centerY = _mm_set1_ps(center.y);
+	const __m128 centerZ = _mm_set1_ps(center.z);
+	const __m128 extentX = _mm_set1_ps(extent.x);
+	const __m128 extentY = _mm_set1_ps(extent.y);
+	const __m128 extentZ = _mm_set1_ps(extent.z);
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	const __m128 zero = _mm_setzero_ps();
+
+	int intersectMask{};
+	for (size_t first{}; first < distance.size(); first += 4)
+	{
+		const __m128 planeX = _mm_load_ps(&normalX[first]);
+		const __m128 planeY = _mm_load_ps(&normalY[first]);
+		const __m128 planeZ = _mm_load_ps(&normalZ[first]);
+
+		//Signed distance of the center and the extent of the box along the plane normal
+		const __m128 centerDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX, centerX), _mm_mul_ps(planeY, centerY)), _mm_add_ps(_mm_mul_ps(planeZ, centerZ), _mm_load_ps(&distance[first])));
+		const __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(planeX, absMask), extentX), _mm_mul_ps(_mm_and_ps(planeY, absMask), extentY)), _mm_mul_ps(_mm_and_ps(planeZ, absMask), extentZ));
+
+		if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(centerDistance, radius), zero)) != 0) return CullResult::Outside;
+		intersectMask |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(centerDistance, radius), zero));
+	}
+	return intersectMask != 0 ? CullResult::Intersecting : CullResult::Inside;
+#else
+	return TestAABBScalar(box);
+#endif
+}
+
+bool Frustum::HasSimd()
+{
+	return FRUSTUM_SSE;
+}
+
+CullResult Frustum::TestAABBScalar(const AABB& box) const
+{
+	const glm::vec3 center = box.GetCenter();
+	const glm::vec3 extent = box.GetExtent();
+
+	CullResult result{CullResult::Inside};
+	for (size_t planeIndex{}; planeIndex < distance.size(); ++planeIndex)
+	{
+		const float centerDistance = normalX[planeIndex] * center.x + normalY[planeIndex] * center.y + normalZ[planeIndex] * center.z + distance[planeIndex];
+		const float radius = std::abs(normalX[planeIndex]) * extent.x + std::abs(normalY[planeIndex]) * extent.y + std::abs(normalZ[planeIndex]) * extent.z;
+
+		if (centerDistance + radius < 0.0f) return CullResult::Outside;
+		if (centerDistance - radius < 0.0f) result = CullResult::Intersecting;
+	}
+	return result;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <array>
+#include <limits>
+#include <glm/glm.hpp>
+
+// Axis aligned box, starts out empty so growing it with the first point gives that point
+struct AABB
+{
+	glm::vec3 minimum{std::numeric_limits<float>::max()};
+	glm::vec3 maximum{std::numeric_limits<float>::lowest()};
+
+	void Grow(const glm::vec3& point) { minimum = glm::min(minimum, point); maximum = glm::max(maximum, point); }
+	void Grow(const AABB& other) { minimum = glm::min(minimum, other.minimum); maximum = glm::max(maximum, other.maximum); }
+
+	[[nodiscard]] bool IsEmpty() const { return minimum.x > maximum.x; }
+	[[nodiscard]] glm::vec3 GetCenter() const { return (minimum + maximum) * 0.5f; }
+	[[nodiscard]] glm::vec3 GetExtent() const { return (maximum - minimum) * 0.5f; }
+
+	// Box around the transformed box, the extent gets projected on the absolute axes of the matrix
+	[[nodiscard]] AABB Transform(const glm::mat4& matrix) const;
+};
+
+enum class CullResult
+{
+	Outside,
+	Intersecting,
+	Inside
+};
+
+// The six planes of a view projection matrix, stored per component so four planes get tested at once
+// Plane 6 and 7 are padding that never rejects anything
+struct Frustum
+{
+	alignas(16) std::array<float, 8> normalX{};
+	alignas(16) std::array<float, 8> normalY{};
+	alignas(16) std::array<float, 8> normalZ{};
+	alignas(16) std::array<float, 8> distance{};
+
+	// Expects a 0 to 1 depth range (GLM_FORCE_DEPTH_ZERO_TO_ONE), the planes point inwards
+	[[nodiscard]] static Frustum FromMatrix(const glm::mat4& viewProjection);
+
+	// SSE when the target has it, the scalar version otherwise
+	[[nodiscard]] CullResult TestAABB(const AABB& box) const;
+	[[nodiscard]] CullResult TestAABBScalar(const AABB& box) const;
+	[[nodiscard]] static bool HasSimd();
+};
@@ -0,0 +1,410 @@
+#include "GeometryPool.h"
+
+#include <algorithm>
+#include <string>
+
+#include "Buffer.h"
+#include "FrameRing.h"
+#include "Logger.h"
+#include "UploadBatch.h"
+
+
+void GeometryPool::Init(VulkanContext* vulkanContext, uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+	m_pContext = vulkanContext;
+
+	m_VertexStreams[static_cast<size_t>(VertexFormat::Full)].stride = sizeof(Vertex);
+	m_VertexStreams[static_cast<size_t>(VertexFormat::Packed)].stride = sizeof(PackedVertex);
+
+	m_IndexStreams[GetIndexStreamIndex(VK_INDEX_TYPE_UINT32)].stride = sizeof(uint32_t);
+	m_IndexStreams[GetIndexStreamIndex(VK_INDEX_TYPE_UINT16)].stride = sizeof(uint16_t);
+
+	std::array<uint32_t, VertexFormatCount> vertexCapacities{};
+	vertexCapacities.fill(vertexCapacity);
+	std::array<uint32_t, IndexTypeCount> indexCapacities{};
+	indexCapacities.fill(indexCapacity);
+	Rebuild(vertexCapacities, indexCapacities);
+}
+
+void GeometryPool::Cleanup()
+{
+	for (VertexStream& stream : m_VertexStreams)
+	{
+		vmaClearVirtualBlock(stream.block);
+		vmaDestroyVirtualBlock(stream.block);
+		vmaDestroyBuffer(Allocator::vmaAllocator, stream.buffer, stream.memory);
+
+		stream.block = VK_NULL_HANDLE;
+		stream.buffer = VK_NULL_HANDLE;
+	}
+
+	for (IndexStream& stream : m_IndexStreams)
+	{
+		vmaClearVirtualBlock(stream.block);
+		vmaDestroyVirtualBlock(stream.block);
+		vmaDestroyBuffer(Allocator::vmaAllocator, stream.buffer, stream.memory);
+
+		stream.block = VK_NULL_HANDLE;
+		stream.buffer = VK_NULL_HANDLE;
+	}
+
+	m_Entries.clear();
+	m_FreeHandles.clear();
+}
+
+GeometryHandle GeometryPool::Allocate(std::span<const Vertex> vertices, std::span<const uint32_t> indices)
+{
+	return Allocate(VertexFormat::Full, vertices.data(), static_cast<uint32_t>(vertices.size()), VK_INDEX_TYPE_UINT32, indices.data(), static_cast<uint32_t>(indices.size()));
+}
+
+GeometryHandle GeometryPool::Allocate(std::span<const Vertex> vertices, std::span<const uint16_t> indices)
+{
+	return Allocate(VertexFormat::Full, vertices.data(), static_cast<uint32_t>(vertices.size()), VK_INDEX_TYPE_UINT16, indices.data(), static_cast<uint32_t>(indices.size()));
+}
+
+GeometryHandle GeometryPool::Allocate(std::span<const PackedVertex> vertices, std::span<const uint32_t> indices)
+{
+	return Allocate(VertexFormat::Packed, vertices.data(), static_cast<uint32_t>(vertices.size()), VK_INDEX_TYPE_UINT32, indices.data(), static_cast<uint32_t>(indices.size()));
+}
+
+GeometryHandle GeometryPool::Allocate(std::span<const PackedVertex> vertices, std::span<const uint16_t> indices)
+{
+	return Allocate(VertexFormat::Packed, vertices.data(), static_cast<uint32_t>(vertices.size()), VK_INDEX_TYPE_UINT16, indices.data(), static_cast<uint32_t>(indices.size()));
+}
+
+GeometryHandle GeometryPool::Allocate(VertexFormat vertexFormat, const void* vertexData, uint32_t vertexCount, VkIndexType indexType, const void* indexData, uint32_t indexCount)
+{
+	Entry entry{};
+	entry.vertexFormat = vertexFormat;
+	entry.range.vertexCount = vertexCount;
+	entry.range.indexCount = indexCount;
+	entry.range.indexType = indexType;
+
+	const size_t streamIndex = static_cast<size_t>(vertexFormat);
+	const size_t indexStreamIndex = GetIndexStreamIndex(indexType);
+
+	if (!TryAllocate(entry))
+	{
+		//Grow until everything that is alive plus the new mesh fits, the rebuild compacts the old data as well
+		VmaStatistics vertexStats{};
+		VmaStatistics indexStats{};
+		vmaGetVirtualBlockStatistics(m_VertexStreams[streamIndex].block, &vertexStats);
+		vmaGetVirtualBlockStatistics(m_IndexStreams[indexStreamIndex].block, &indexStats);
+
+		std::array<uint32_t, VertexFormatCount> vertexCapacities = GetVertexCapacities();
+		std::array<uint32_t, IndexTypeCount> indexCapacities = GetIndexCapacities();
+		while (vertexCapacities[streamIndex] < vertexStats.allocationBytes + entry.range.vertexCount) vertexCapacities[streamIndex] *= 2;
+		while (indexCapacities[indexStreamIndex] < indexStats.allocationBytes + entry.range.indexCount) indexCapacities[indexStreamIndex] *= 2;
+
+		Rebuild(vertexCapacities, indexCapacities);
+
+		if (!TryAllocate(entry))
+		{
+			LogError("GeometryPool failed to allocate " + std::to_string(entry.range.vertexCount) + " vertices");
+			return InvalidGeometryHandle;
+		}
+	}
+
+	GeometryHandle handle;
+	if (!m_FreeHandles.empty())
+	{
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+		m_Entries[handle] = entry;
+	}
+	else
+	{
+		handle = static_cast<GeometryHandle>(m_Entries.size());
+		m_Entries.push_back(entry);
+	}
+
+	//The rebuild above can replace the stream buffers, so look them up after allocating
+	const VertexStream& stream = m_VertexStreams[streamIndex];
+	const IndexStream& indexStream = m_IndexStreams[indexStreamIndex];
+	UploadBatch::UploadBuffer(vertexData, static_cast<VkDeviceSize>(stream.stride) * vertexCount, stream.buffer, static_cast<VkDeviceSize>(stream.stride) * entry.range.vertexOffset);
+	UploadBatch::UploadBuffer(indexData, static_cast<VkDeviceSize>(indexStream.stride) * indexCount, indexStream.buffer, static_cast<VkDeviceSize>(indexStream.stride) * entry.range.firstIndex);
+
+	return handle;
+}
+
+void GeometryPool::Free(GeometryHandle handle)
+{
+	if (handle >= m_Entries.size() || !m_Entries[handle].isAlive) return;
+
+	//The range can be handed out again right away, so no frame in flight may still read it
+	FrameRing::WaitForAllFrames();
+
+	Entry& entry = m_Entries[handle];
+	vmaVirtualFree(m_VertexStreams[static_cast<size_t>(entry.vertexFormat)].block, entry.vertexAllocation);
+	vmaVirtualFree(m_IndexStreams[GetIndexStreamIndex(entry.range.indexType)].block, entry.indexAllocation);
+	entry = {};
+
+	m_FreeHandles.push_back(handle);
+	m_HasFreedSinceCompaction = true;
+}
+
+void GeometryPool::Bind(VkCommandBuffer commandBuffer)
+{
+	std::array<VkBuffer, VertexFormatCount> vertexBuffers{};
+	std::array<VkDeviceSize, VertexFormatCount> offsets{};
+	for (size_t streamIndex{}; streamIndex < VertexFormatCount; ++streamIndex)
+	{
+		vertexBuffers[streamIndex] = m_VertexStreams[streamIndex].buffer;
+	}
+
+	vkCmdBindVertexBuffers(commandBuffer, 0, static_cast<uint32_t>(VertexFormatCount), vertexBuffers.data(), offsets.data());
+
+	BindIndexBuffer(commandBuffer, VK_INDEX_TYPE_UINT32);
+}
+
+void GeometryPool::BindIndexBuffer(VkCommandBuffer commandBuffer, VkIndexType indexType)
+{
+	vkCmdBindIndexBuffer(commandBuffer, m_IndexStreams[GetIndexStreamIndex(indexType)].buffer, 0, indexType);
+}
+
+void GeometryPool::Compact()
+{
+	Rebuild(GetVertexCapacities(), GetIndexCapacities());
+
+	++m_CompactionCount;
+	LogInfo("GeometryPool compacted");
+}
+
+void GeometryPool::CompactIfFragmented()
+{
+	if (m_CompactionRequested)
+	{
+		m_CompactionRequested = false;
+		Compact();
+		return;
+	}
+
+	if (!m_HasFreedSinceCompaction) return;
+	m_HasFreedSinceCompaction = false;
+
+	bool isFragmented = false;
+	for (const VertexStream& stream : m_VertexStreams)
+	{
+		isFragmented |= GetFragmentation(stream.block) > m_CompactionThreshold;
+	}
+	for (const IndexStream& stream : m_IndexStreams)
+	{
+		isFragmented |= GetFragmentation(stream.block) > m_CompactionThreshold;
+	}
+
+	if (isFragmented)
+	{
+		Compact();
+	}
+}
+
+void GeometryPool::OnImGui()
+{
+	constexpr const char* streamNames[VertexFormatCount] = {"Full", "Packed"};
+	constexpr const char* indexStreamNames[IndexTypeCount] = {"32 bit", "16 bit"};
+
+	ImGui::Begin("Info");
+	ImGui::SeparatorText("Geometry Pool");
+	ImGui::Text("Meshes: %u", static_cast<uint32_t>(m_Entries.size() - m_FreeHandles.size()));
+	for (size_t streamIndex{}; streamIndex < VertexFormatCount; ++streamIndex)
+	{
+		const VertexStream& stream = m_VertexStreams[streamIndex];
+
+		VmaStatistics vertexStats{};
+		vmaGetVirtualBlockStatistics(stream.block, &vertexStats);
+		const float usedMegabytes = static_cast<float>(vertexStats.allocationBytes * stream.stride) / (1024.0f * 1024.0f);
+		ImGui::Text("%s vertices: %llu / %u (%.2f MB)", streamNames[streamIndex], static_cast<unsigned long long>(vertexStats.allocationBytes), stream.capacity, usedMegabytes);
+	}
+	for (size_t streamIndex{}; streamIndex < IndexTypeCount; ++streamIndex)
+	{
+		const IndexStream& stream = m_IndexStreams[streamIndex];
+
+		VmaStatistics indexStats{};
+		vmaGetVirtualBlockStatistics(stream.block, &indexStats);
+		const float usedMegabytes = static_cast<float>(indexStats.allocationBytes * stream.stride) / (1024.0f * 1024.0f);
+		ImGui::Text("%s indices: %llu / %u (%.2f MB, fragmentation %.2f)", indexStreamNames[streamIndex], static_cast<unsigned long long>(indexStats.allocationBytes), stream.capacity, usedMegabytes, GetFragmentation(stream.block));
+	}
+	ImGui::Text("Compactions: %u", m_CompactionCount);
+
+	//Deferred to the frame boundary, this runs while the frame is being recorded
+	if (ImGui::Button("Compact"))
+	{
+		m_CompactionRequested = true;
+	}
+	ImGui::End();
+}
+
+bool GeometryPool::TryAllocate(Entry& entry)
+{
+	const VmaVirtualBlock vertexBlock = m_VertexStreams[static_cast<size_t>(entry.vertexFormat)].block;
+	const VmaVirtualBlock indexBlock = m_IndexStreams[GetIndexStreamIndex(entry.range.indexType)].block;
+
+	//Virtual blocks work in vertices and indices, a size of 0 is not allowed
+	VmaVirtualAllocationCreateInfo vertexInfo{};
+	vertexInfo.size = std::max(entry.range.vertexCount, 1u);
+
+	VkDeviceSize vertexOffset{};
+	if (vmaVirtualAllocate(vertexBlock, &vertexInfo, &entry.vertexAllocation, &vertexOffset) != VK_SUCCESS)
+	{
+		return false;
+	}
+
+	VmaVirtualAllocationCreateInfo indexInfo{};
+	indexInfo.size = std::max(entry.range.indexCount, 1u);
+
+	VkDeviceSize indexOffset{};
+	if (vmaVirtualAllocate(indexBlock, &indexInfo, &entry.indexAllocation, &indexOffset) != VK_SUCCESS)
+	{
+		vmaVirtualFree(vertexBlock, entry.vertexAllocation);
+		entry.vertexAllocation = VK_NULL_HANDLE;
+		return false;
+	}
+
+	entry.range.vertexOffset = static_cast<int32_t>(vertexOffset);
+	entry.range.firstIndex = static_cast<uint32_t>(indexOffset);
+	entry.isAlive = true;
+	return true;
+}
+
+void GeometryPool::Rebuild(std::array<uint32_t, VertexFormatCount> vertexCapacities, std::array<uint32_t, IndexTypeCount> indexCapacities)
+{
+	//The live ranges get packed without gaps, so a capacity of at least their sum always fits all of them
+	std::array<uint64_t, VertexFormatCount> liveVertices{};
+	std::array<uint64_t, IndexTypeCount> liveIndices{};
+	for (const Entry& entry : m_Entries)
+	{
+		if (!entry.isAlive) continue;
+
+		liveVertices[static_cast<size_t>(entry.vertexFormat)] += std::max(entry.range.vertexCount, 1u);
+		liveIndices[GetIndexStreamIndex(entry.range.indexType)] += std::max(entry.range.indexCount, 1u);
+	}
+	for (size_t streamIndex{}; streamIndex < VertexFormatCount; ++streamIndex)
+	{
+		while (vertexCapacities[streamIndex] < liveVertices[streamIndex]) vertexCapacities[streamIndex] *= 2;
+	}
+	for (size_t streamIndex{}; streamIndex < IndexTypeCount; ++streamIndex)
+	{
+		while (indexCapacities[streamIndex] < liveIndices[streamIndex]) indexCapacities[streamIndex] *= 2;
+	}
+
+	//The old buffers get released with the upload batch, the frames in flight must be done reading them
+	FrameRing::WaitForAllFrames();
+
+	const std::array<VertexStream, VertexFormatCount> oldStreams = m_VertexStreams;
+	const std::array<IndexStream, IndexTypeCount> oldIndexStreams = m_IndexStreams;
+
+	constexpr VkBufferUsageFlags copyUsage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	for (size_t streamIndex{}; streamIndex < VertexFormatCount; ++streamIndex)
+	{
+		VertexStream& stream = m_VertexStreams[streamIndex];
+		stream.capacity = vertexCapacities[streamIndex];
+		Core::Buffer::CreateBuffer(static_cast<VkDeviceSize>(stream.stride) * stream.capacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | copyUsage, stream.buffer, stream.memory);
+
+		VmaVirtualBlockCreateInfo vertexBlockInfo{};
+		vertexBlockInfo.size = stream.capacity;
+		VulkanCheck(vmaCreateVirtualBlock(&vertexBlockInfo, &stream.block), "Failed to create the vertex virtual block")
+	}
+
+	for (size_t streamIndex{}; streamIndex < IndexTypeCount; ++streamIndex)
+	{
+		IndexStream& stream = m_IndexStreams[streamIndex];
+		stream.capacity = indexCapacities[streamIndex];
+		Core::Buffer::CreateBuffer(static_cast<VkDeviceSize>(stream.stride) * stream.capacity, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | copyUsage, stream.buffer, stream.memory);
+
+		VmaVirtualBlockCreateInfo indexBlockInfo{};
+		indexBlockInfo.size = stream.capacity;
+		VulkanCheck(vmaCreateVirtualBlock(&indexBlockInfo, &stream.block), "Failed to create the index virtual block")
+	}
+
+	m_HasFreedSinceCompaction = false;
+
+	if (oldIndexStreams[0].buffer == VK_NULL_HANDLE) return;
+
+	//Re-allocate every live range in the fresh blocks, they end up packed at the front
+	std::array<std::vector<VkBufferCopy>, VertexFormatCount> vertexCopies;
+	std::array<std::vector<VkBufferCopy>, IndexTypeCount> indexCopies;
+	for (Entry& entry : m_Entries)
+	{
+		if (!entry.isAlive) continue;
+
+		const GeometryRange oldRange = entry.range;
+		if (!TryAllocate(entry))
+		{
+			//Can not happen with the capacities above, but the old allocations belong to blocks that are about to be destroyed
+			LogError("GeometryPool rebuild ran out of space, the mesh is dropped");
+			entry = {};
+			continue;
+		}
+
+		const size_t streamIndex = static_cast<size_t>(entry.vertexFormat);
+		const VkDeviceSize stride = m_VertexStreams[streamIndex].stride;
+		if (oldRange.vertexCount > 0)
+		{
+			vertexCopies[streamIndex].push_back({stride * oldRange.vertexOffset, stride * entry.range.vertexOffset, stride * oldRange.vertexCount});
+		}
+
+		const size_t indexStreamIndex = GetIndexStreamIndex(entry.range.indexType);
+		const VkDeviceSize indexStride = m_IndexStreams[indexStreamIndex].stride;
+		if (oldRange.indexCount > 0)
+		{
+			indexCopies[indexStreamIndex].push_back({indexStride * oldRange.firstIndex, indexStride * entry.range.firstIndex, indexStride * oldRange.indexCount});
+		}
+	}
+
+	UploadBatch::Begin();
+	for (size_t streamIndex{}; streamIndex < VertexFormatCount; ++streamIndex)
+	{
+		UploadBatch::CopyBufferRegions(oldStreams[streamIndex].buffer, m_VertexStreams[streamIndex].buffer, vertexCopies[streamIndex]);
+		UploadBatch::ReleaseAfterBatch(oldStreams[streamIndex].buffer, oldStreams[streamIndex].memory);
+	}
+	for (size_t streamIndex{}; streamIndex < IndexTypeCount; ++streamIndex)
+	{
+		UploadBatch::CopyBufferRegions(oldIndexStreams[streamIndex].buffer, m_IndexStreams[streamIndex].buffer, indexCopies[streamIndex]);
+		UploadBatch::ReleaseAfterBatch(oldIndexStreams[streamIndex].buffer, oldIndexStreams[streamIndex].memory);
+	}
+	UploadBatch::End();
+
+	for (const VertexStream& oldStream : oldStreams)
+	{
+		vmaClearVirtualBlock(oldStream.block);
+		vmaDestroyVirtualBlock(oldStream.block);
+	}
+	for (const IndexStream& oldStream : oldIndexStreams)
+	{
+		vmaClearVirtualBlock(oldStream.block);
+		vmaDestroyVirtualBlock(oldStream.block);
+	}
+}
+
+std::array<uint32_t, GeometryPool::VertexFormatCount> GeometryPool::GetVertexCapacities()
+{
+	std::array<uint32_t, VertexFormatCount> vertexCapacities{};
+	for (size_t streamIndex{}; streamIndex < VertexFormatCount; ++streamIndex)
+	{
+		vertexCapacities[streamIndex] = m_VertexStreams[streamIndex].capacity;
+	}
+
+	return vertexCapacities;
+}
+
+std::array<uint32_t, GeometryPool::IndexTypeCount> GeometryPool::GetIndexCapacities()
+{
+	std::array<uint32_t, IndexTypeCount> indexCapacities{};
+	for (size_t streamIndex{}; streamIndex < IndexTypeCount; ++streamIndex)
+	{
+		indexCapacities[streamIndex] = m_IndexStreams[streamIndex].capacity;
+	}
+
+	return indexCapacities;
+}
+
+float GeometryPool::GetFragmentation(VmaVirtualBlock block)
+{
+	VmaDetailedStatistics stats{};
+	vmaCalculateVirtualBlockStatistics(block, &stats);
+
+	const VkDeviceSize freeSpace = stats.statistics.blockBytes - stats.statistics.allocationBytes;
+	if (freeSpace == 0) return 0.0f;
+
+	return 1.0f - static_cast<float>(stats.unusedRangeSizeMax) / static_cast<float>(freeSpace);
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "VmaUsage.h"
+#include "Mesh/Vertex.h"
+
+class VulkanContext;
+
+using GeometryHandle = uint32_t;
+inline constexpr GeometryHandle InvalidGeometryHandle = UINT32_MAX;
+
+// Where a mesh lives inside the shared buffers, in vertices and indices not bytes
+struct GeometryRange
+{
+	uint32_t firstIndex{};
+	int32_t vertexOffset{};
+	uint32_t indexCount{};
+	uint32_t vertexCount{};
+	VkIndexType indexType{VK_INDEX_TYPE_UINT32};
+};
+
+// All mesh geometry lives in one vertex buffer per VertexFormat and one index buffer per index type, sub allocated with VMA virtual blocks
+// Every vertex format has its own binding (its index in VertexFormat), so all of them can stay bound at once
+// Only one index buffer can be bound, BindIndexBuffer switches it when the index type of a mesh differs
+// Meshes only keep a handle, the ranges can move when the pool grows or gets compacted
+// Allocate/Free/Compact have to happen outside of recording (frame boundary or load time)
+// Free and anything that moves the ranges wait for the frames in flight first
+class GeometryPool final
+{
+public:
+	GeometryPool() = default;
+	~GeometryPool() = default;
+	GeometryPool(const GeometryPool&) = delete;
+	GeometryPool& operator=(const GeometryPool&) = delete;
+	GeometryPool(GeometryPool&&) = delete;
+	GeometryPool& operator=(GeometryPool&&) = delete;
+
+	static void Init(VulkanContext* vulkanContext, uint32_t vertexCapacity = 1u << 19, uint32_t indexCapacity = 1u << 21);
+	static void Cleanup();
+
+	static GeometryHandle Allocate(std::span<const Vertex> vertices, std::span<const uint32_t> indices);
+	static GeometryHandle Allocate(std::span<const Vertex> vertices, std::span<const uint16_t> indices);
+	static GeometryHandle Allocate(std::span<const PackedVertex> vertices, std::span<const uint32_t> indices);
+	static GeometryHandle Allocate(std::span<const PackedVertex> vertices, std::span<const uint16_t> indices);
+	static void Free(GeometryHandle handle);
+
+	// Binds the vertex buffers and the 32 bit index buffer, once per pass is enough for every mesh
+	static void Bind(VkCommandBuffer commandBuffer);
+	// Switches to the index buffer of the other index type, the caller tracks which one is bound so it works from any thread
+	static void BindIndexBuffer(VkCommandBuffer commandBuffer, VkIndexType indexType);
+
+	[[nodiscard]] static const GeometryRange& GetRange(GeometryHandle handle) { return m_Entries[handle].range; }
+	// A mesh whose ranges could not be moved by a rebuild is dead, its range is empty so it draws nothing
+	[[nodiscard]] static bool IsAlive(GeometryHandle handle) { return handle < m_Entries.size() && m_Entries[handle].isAlive; }
+
+	// Moves all live ranges to the front of fresh buffers
+	static void Compact();
+	// Call at the frame boundary, also handles compactions requested from the UI
+	static void CompactIfFragmented();
+
+	static void OnImGui();
+
+private:
+	static constexpr size_t VertexFormatCount = 2;
+	static constexpr size_t IndexTypeCount = 2;
+
+	struct VertexStream
+	{
+		VkBuffer buffer{VK_NULL_HANDLE};
+		VmaAllocation memory{};
+		VmaVirtualBlock block{VK_NULL_HANDLE};
+		uint32_t capacity{};
+		uint32_t stride{};
+	};
+
+	struct IndexStream
+	{
+		VkBuffer buffer{VK_NULL_HANDLE};
+		VmaAllocation memory{};
+		VmaVirtualBlock block{VK_NULL_HANDLE};
+		uint32_t capacity{};
+		uint32_t stride{};
+	};
+
+	struct Entry
+	{
+		VertexFormat vertexFormat{VertexFormat::Full};
+		VmaVirtualAllocation vertexAllocation{VK_NULL_HANDLE};
+		VmaVirtualAllocation indexAllocation{VK_NULL_HANDLE};
+		GeometryRange range{};
+		bool isAlive{false};
+	};
+
+	static GeometryHandle Allocate(VertexFormat vertexFormat, const void* vertexData, uint32_t vertexCount, VkIndexType indexType, const void* indexData, uint32_t indexCount);
+	static bool TryAllocate(Entry& entry);
+	// Grows the given capacities when the live ranges would not fit them
+	static void Rebuild(std::array<uint32_t, VertexFormatCount> vertexCapacities, std::array<uint32_t, IndexTypeCount> indexCapacities);
+	[[nodiscard]] static std::array<uint32_t, VertexFormatCount> GetVertexCapacities();
+	[[nodiscard]] static std::array<uint32_t, IndexTypeCount> GetIndexCapacities();
+
+	[[nodiscard]] static size_t GetIndexStreamIndex(VkIndexType indexType) { return indexType == VK_INDEX_TYPE_UINT16 ? 1 : 0; }
+
+	// Fraction of free space that is not part of the largest free range
+	[[nodiscard]] static float GetFragmentation(VmaVirtualBlock block);
+
+	inline static VulkanContext* m_pContext{};
+
+	inline static std::array<VertexStream, VertexFormatCount> m_VertexStreams{};
+
+	inline static std::array<IndexStream, IndexTypeCount> m_IndexStreams{};
+
+	inline static std::vector<Entry> m_Entries{};
+	inline static std::vector<GeometryHandle> m_FreeHandles{};
+
+	inline static bool m_HasFreedSinceCompaction{false};
+	inline static bool m_CompactionRequested{false};
+	inline static uint32_t m_CompactionCount{};
+
+	static constexpr float m_CompactionThreshold{0.5f};
+};
@@ -2,6 +2,7 @@
 
 #include "DepthResource.h"
 #include "Descriptor.h"
+#include "IndirectRenderer.h"
 #include "Camera/Camera.h"
 #include "shaders/Logic/Shader.h"
 
@@ -22,25 +23,30 @@ void GlobalDescriptor::Init(VulkanContext *vulkanContext)
 	lightColorHandle = m_GlobalBuffer.AddVariable(glm::vec4(light->GetColor()[0], light->GetColor()[1], light->GetColor()[2], 1.0f));
 	inverseProjectionHandle = m_GlobalBuffer.AddVariable(inverse(Camera::GetProjectionMatrix()));
 	viewMatrixHandle = m_GlobalBuffer.AddVariable(Camera::GetViewMatrix());
+	instanceCountHandle = m_GlobalBuffer.AddVariable(glm::vec4{0});
 
 
 	m_GlobalBuffer.Init();
 
 	Descriptor::DescriptorBuilder builder{};
 	builder.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+	//Instances, indirect commands and draw counts of the GPU driven path
+	builder.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+	builder.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+	builder.AddBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
 	m_GlobalDescriptorSetLayout = builder.Build(vulkanContext->device, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT);
 }
 
 
-void GlobalDescriptor::Bind(VulkanContext *vulkanContext, const VkCommandBuffer commandBuffer, const VkPipelineLayout &pipelineLayout, PipelineType pipelineType)
+void GlobalDescriptor::UpdateFrameConstants(VulkanContext *vulkanContext)
 {
 	LogAssert(m_GlobalDescriptorSetLayout != VK_NULL_HANDLE, "GlobalDescriptorSetLayout is not initialized", true);
 	m_GlobalBuffer.UpdateVariable(viewProjectionHandle, Camera::GetViewProjectionMatrix());
-	m_GlobalBuffer.UpdateVariable(viewProjectionHandle, Camera::GetViewProjectionMatrix());
 	m_GlobalBuffer.UpdateVariable(cameraHandle, glm::vec4(Camera::GetPosition(), 1.0f));
 	m_GlobalBuffer.UpdateVariable(cameraPlaneHandle, glm::vec4(Camera::GetNearPlane(), Camera::GetFarPlane(), 0.0f, 0.0f));
 	m_GlobalBuffer.UpdateVariable(inverseProjectionHandle, inverse(Camera::GetProjectionMatrix()));
 	m_GlobalBuffer.UpdateVariable(viewMatrixHandle, Camera::GetViewMatrix());
+	m_GlobalBuffer.UpdateVariable(instanceCountHandle, glm::vec4{static_cast<float>(IndirectRenderer::GetInstanceCount()), 0.0f, 0.0f, 0.0f});
 
 	//TODO: I Need a proper way to pass a ARRAY of light structurs to the GPU.
 	const std::vector<Light *> Lights = LightManager::GetLights();
@@ -49,13 +55,19 @@ void GlobalDescriptor::Bind(VulkanContext *vulkanContext, const VkCommandBuffer
 	m_GlobalBuffer.UpdateVariable(lightColorHandle, glm::vec4(light->GetColor()[0], light->GetColor()[1], light->GetColor()[2], 1.0f));
 
 
-	m_GlobalDescriptorSet = Descriptor::DescriptorManager::Allocate(vulkanContext->device, m_GlobalDescriptorSetLayout, 0);
 	m_Writer.Cleanup();
-
-
 	m_GlobalBuffer.ProperBind(0, m_Writer);
-	m_Writer.UpdateSet(vulkanContext->device, m_GlobalDescriptorSet);
+	IndirectRenderer::WriteDescriptors(m_Writer);
 
+	//Only the buffer handle goes into the set, the camera moving does not need a rewrite
+	const uint64_t contentsKey = m_Writer.GetContentsHash() + (static_cast<uint64_t>(m_GlobalBuffer.GetVersion()) << 32);
+	m_GlobalDescriptorSet = m_SetCache.Get(vulkanContext->device, m_GlobalDescriptorSetLayout, contentsKey, m_Writer);
+}
+
+void GlobalDescriptor::Bind(VulkanContext *vulkanContext, const VkCommandBuffer commandBuffer, const VkPipelineLayout &pipelineLayout, PipelineType pipelineType)
+{
+	(void)vulkanContext;
+	LogAssert(m_GlobalDescriptorSet != VK_NULL_HANDLE, "UpdateFrameConstants has to run before the first Bind", true);
 	vkCmdBindDescriptorSets(commandBuffer, static_cast<VkPipelineBindPoint>(pipelineType), pipelineLayout, 0, 1, &m_GlobalDescriptorSet, 0, nullptr);
 }
 
@@ -67,6 +79,7 @@ VkDescriptorSetLayout &GlobalDescriptor::GetLayout()
 
 void GlobalDescriptor::Cleanup(VkDevice device)
 {
+	m_SetCache.Clear();
 	vkDestroyDescriptorSetLayout(device, m_GlobalDescriptorSetLayout, nullptr);
 	m_GlobalBuffer.Cleanup(device);
 }
@@ -20,6 +20,10 @@ struct GlobalDescriptor
 	static void Init(VulkanContext* vulkanContext);
 
 
+	//Computes the camera and light data into the uniform buffer of this frame, once at the start of the frame
+	//Also points the set at the instance buffers of this frame, so it has to run after the draws got sorted
+	static void UpdateFrameConstants(VulkanContext* vulkanContext);
+	//Only binds the set of this frame, the data is not touched
 	static void Bind(VulkanContext* vulkanContext, VkCommandBuffer commandBuffer, const VkPipelineLayout& pipelineLayout, PipelineType pipelineType = PipelineType::Graphics);
 	static VkDescriptorSetLayout& GetLayout();
 	static void Cleanup(VkDevice device);
@@ -39,6 +43,8 @@ private:
     static inline uint16_t lightPositionHandle = 0;
     static inline uint16_t lightColorHandle = 0;
 	static inline uint16_t viewMatrixHandle = 0;
+	static inline uint16_t instanceCountHandle = 0;
 
 	static inline Descriptor::DescriptorWriter m_Writer{};
+	static inline Descriptor::DescriptorSetCache m_SetCache{};
 };
@@ -119,7 +119,7 @@ void GraphicsPipelineBuilder::CreatePipeline(GraphicsPipeline& graphicsPipeline,
     };
 
     const auto inputAssemblyState = ShaderManager::GetInputAssemblyStateInfo();
-    const auto vertexInputState = ShaderManager::GetVertexInputStateInfo();
+    const auto vertexInputState = ShaderManager::GetVertexInputStateInfo(material->GetVertexFormat());
 
 	std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
 	for (const auto& shader : material->GetShaders())
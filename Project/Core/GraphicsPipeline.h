@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <glm/mat4x4.hpp>
 #include <vulkan/vulkan.h>
@@ -48,11 +49,20 @@ public:
 		return m_PipelineLayout;
 	}
 
+	//Stays the same when the pipeline gets recreated, used in the render queue sort keys
+	uint16_t GetSortId() const
+	{
+		return m_SortId;
+	}
+
 private:
 	friend class GraphicsPipelineBuilder;
 
 	VkPipelineLayout m_PipelineLayout{};
 	VkPipeline m_GraphicsPipeline{};
+
+	inline static uint16_t m_NextSortId{};
+	uint16_t m_SortId{m_NextSortId++};
 };
 
 
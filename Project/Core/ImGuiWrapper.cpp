@@ -1,4 +1,5 @@
 #include "ImGuiWrapper.h"
+#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "implot.h"
 #include "backends/imgui_impl_glfw.h"
@@ -16,6 +17,7 @@
 #include <ImGuiFileDialog.h>
 
 #include "GBuffer.h"
+#include "Mesh/AssetStreamer.h"
 #include "Mesh/ModelLoader.h"
 
 void ImGuiWrapper::Initialize(VkQueue graphicsQueue)
@@ -116,6 +118,8 @@ void ImGuiWrapper::NewFrame()
 				config.flags = ImGuiFileDialogFlags_Modal;
 				ImGuiFileDialog::Instance()->OpenDialog("ChooseFileDlgKey", "Choose File", ".obj,.gltf", config);
 			}
+			ImGui::MenuItem("Quantize Imported Vertices", nullptr, &m_QuantizeImports);
+			ImGui::DragFloat3("Import Position", glm::value_ptr(m_ImportPosition), 0.1f);
 			ImGui::EndMenu();
 		}
 
@@ -140,16 +144,14 @@ void ImGuiWrapper::NewFrame()
 			//Get the extension
 			std::string extension = filePathName.substr(filePathName.find_last_of('.') + 1);
 
+			const glm::mat4 importTransform = glm::translate(glm::mat4{1.0f}, m_ImportPosition);
 			if (extension == "gltf")
 			{
-				const auto vulkanContext = ServiceLocator::GetService<VulkanContext>();
-				GLTFLoader::LoadGLTF(filePathName, SceneManager::GetActiveScene(), vulkanContext);
+				AssetStreamer::RequestGLTF(filePathName, SceneManager::GetActiveScene(), m_QuantizeImports ? VertexFormat::Packed : VertexFormat::Full, importTransform);
 			}
 			else
 			{
-				//TODO: move to  OBJLoader::Load("FlightHelmet.obj", this, vulkanContext);
-				std::unique_ptr<Mesh> newMesh = std::make_unique<Mesh>(filePathName, "PBR_Material", filePathName);
-				SceneManager::GetActiveScene()->AddMesh(std::move(newMesh));
+				AssetStreamer::RequestObj(filePathName, "PBR_Material", filePathName, SceneManager::GetActiveScene(), importTransform);
 			}
 		}
 		ImGuiFileDialog::Instance()->Close();
@@ -3,6 +3,7 @@
 
 #include "imgui.h"
 #include "ImGuizmo.h"
+#include <glm/vec3.hpp>
 #include <vulkan/vulkan.h>
 
 
@@ -29,6 +30,11 @@ public:
 
 private:
 	inline static VkDescriptorPool descriptorPool;
+
+	// glTF imports from the File menu use the packed vertex format, obj materials are shared so those stay full
+	inline static bool m_QuantizeImports{false};
+	// Imported models get placed here, importing a model that is already loaded adds instances of it at this position
+	inline static glm::vec3 m_ImportPosition{};
 };
 
 struct ImGuizmoHandler
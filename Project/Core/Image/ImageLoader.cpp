@@ -1,19 +1,25 @@
 #include "ImageLoader.h"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+
 #define STB_IMAGE_IMPLEMENTATION
 #include <ImGuiFileDialog.h>
 #include <ktx.h>
 #include <ktxvulkan.h>
 #include <stb/stb_image.h>
 
+#include "MipGenerator.h"
 #include "Texture.h"
 #include "Core/Logger.h"
+#include "Core/UploadBatch.h"
 #include "Patterns/ServiceLocator.h"
 #include "vulkanbase/VulkanBase.h"
 
 namespace Image
 {
-	void CreateImage(const uint32_t width, const uint32_t height, const uint32_t mipLevels, const VkSampleCountFlagBits numSamples, const VkFormat format, const VkImageTiling tiling, const VkImageUsageFlags usage,VkImage& image, VmaAllocation& imageMemory, const TextureType textureType)
+	static VkImageCreateInfo GetImageCreateInfo(const uint32_t width, const uint32_t height, const uint32_t mipLevels, const VkSampleCountFlagBits numSamples, const VkFormat format, const VkImageTiling tiling, const VkImageUsageFlags usage, const TextureType textureType, std::span<const uint32_t> queueFamilies = {})
 	{
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -30,12 +36,26 @@ namespace Image
 		imageInfo.samples = numSamples;
 		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+		if (queueFamilies.size() > 1)
+		{
+			imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			imageInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+			imageInfo.pQueueFamilyIndices = queueFamilies.data();
+		}
+
         if(textureType == TextureType::TEXTURE_CUBE)
         {
             imageInfo.arrayLayers = 6;
             imageInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
         }
 
+		return imageInfo;
+	}
+
+	void CreateImage(const uint32_t width, const uint32_t height, const uint32_t mipLevels, const VkSampleCountFlagBits numSamples, const VkFormat format, const VkImageTiling tiling, const VkImageUsageFlags usage,VkImage& image, VmaAllocation& imageMemory, const TextureType textureType, std::span<const uint32_t> queueFamilies)
+	{
+		const VkImageCreateInfo imageInfo = GetImageCreateInfo(width, height, mipLevels, numSamples, format, tiling, usage, textureType, queueFamilies);
+
 	    VmaAllocationCreateInfo props{};
 	    props.usage = VMA_MEMORY_USAGE_AUTO ;
 	    props.priority = 1.0f;
@@ -51,9 +71,16 @@ namespace Image
 	    VulkanCheck(vmaCreateImage(Allocator::vmaAllocator, &imageInfo, &props, &image, &imageMemory, nullptr), "Failed To Create Image");
 	}
 
+	void CreateAliasingImage(const uint32_t width, const uint32_t height, const uint32_t mipLevels, const VkFormat format, const VkImageUsageFlags usage, VmaAllocation memory, VkImage& image, const TextureType textureType)
+	{
+		const VkImageCreateInfo imageInfo = GetImageCreateInfo(width, height, mipLevels, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, usage, textureType);
+
+		VulkanCheck(vmaCreateAliasingImage(Allocator::vmaAllocator, memory, &imageInfo, &image), "Failed To Create Aliasing Image")
+	}
+
 	void CreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VkImageView &imageView, TextureType textureType)
     {
-	    //TODO: Should mips be in .levelCount?
+	    //Every level of the image, attachments only have one
 	    const uint32_t layerCount = textureType == TextureType::TEXTURE_CUBE ? 6 : 1;
 	    const VkImageViewCreateInfo viewInfo
         {
@@ -64,7 +91,7 @@ namespace Image
           static_cast<VkImageViewType>(textureType),
           format,
           {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY},
-          {aspectFlags, 0, 1, 0, layerCount}
+          {aspectFlags, 0, VK_REMAINING_MIP_LEVELS, 0, layerCount}
         };
 
 	    VulkanCheck(vkCreateImageView(device, &viewInfo, nullptr, &imageView), "Failed to create texture image view!")
@@ -121,7 +148,7 @@ std::pair<VkBuffer, VmaAllocation> stbi::CreateImage(const std::filesystem::path
     stbi_uc *pixels = stbi_load(path.generic_string().c_str(), &imageSize.x, &imageSize.y, &channels, STBI_rgb_alpha);
 
     LogAssert(pixels, "failed to load texture image!", true)
-    mipLevels = 1;
+    mipLevels = MipGenerator::GetMipLevelCount(imageSize.x, imageSize.y);
 
 
     const VkDeviceSize deviceImageSize = static_cast<VkDeviceSize>(imageSize.x) * imageSize.y * 4;
@@ -134,21 +161,42 @@ std::pair<VkBuffer, VmaAllocation> stbi::CreateImage(const std::filesystem::path
 
     return {stagingBuffer, stagingBufferMemory};
 }
-std::pair<VkBuffer, VmaAllocation> stbi::CreateImageFromMemory(const std::uint8_t* data, size_t size, glm::ivec2 &imageSize, uint32_t &mipLevels)
+std::optional<stbi::DecodedImage> stbi::Decode(std::span<const std::uint8_t> encoded)
 {
+    DecodedImage decoded{};
     int channels{};
-    stbi_uc *pixels = stbi_load_from_memory(data, size, &imageSize.x, &imageSize.y, &channels, 4);
-    LogAssert(pixels, "failed to load texture image!", true)
-    mipLevels = 1;
-
-    const VkDeviceSize deviceImageSize = static_cast<VkDeviceSize>(imageSize.x) * imageSize.y * 4;
-    VkBuffer stagingBuffer;
-    VmaAllocation stagingBufferMemory;
-    Core::Buffer::CreateStagingBuffer<stbi_uc>(deviceImageSize, stagingBuffer, stagingBufferMemory,pixels);
+    stbi_uc *pixels = stbi_load_from_memory(encoded.data(), static_cast<int>(encoded.size()), &decoded.imageSize.x, &decoded.imageSize.y, &channels, STBI_rgb_alpha);
+    if (!pixels)
+    {
+        LogError(std::string("Failed to decode image: ") + stbi_failure_reason());
+        return std::nullopt;
+    }
 
-    stbi_image_free(pixels);
+    decoded.pixels = {pixels, stbi_image_free};
+    return decoded;
+}
+ImageInMemory stbi::CreateImageFromPixels(const DecodedImage &decoded)
+{
+    ImageInMemory image{};
+    image.imageSize = decoded.imageSize;
+    image.mipLevels = MipGenerator::GetMipLevelCount(image.imageSize.x, image.imageSize.y);
+    image.generateMips = true;
+
+    //stb always allocates its own output, copying that into the ring is the only copy between the file and the GPU
+    image.stagingSize = static_cast<VkDeviceSize>(image.imageSize.x) * image.imageSize.y * 4;
+    const StagingAllocation staging = UploadBatch::AllocateStaging(image.stagingSize);
+    std::memcpy(staging.mappedData, decoded.pixels.get(), image.stagingSize);
+
+    image.stagingBuffer = staging.buffer;
+    image.stagingOffset = staging.offset;
+    return image;
+}
+std::optional<ImageInMemory> stbi::CreateImageFromMemory(std::span<const std::uint8_t> encoded)
+{
+    const std::optional<DecodedImage> decoded = Decode(encoded);
+    if (!decoded) return std::nullopt;
 
-    return {stagingBuffer, stagingBufferMemory};
+    return CreateImageFromPixels(decoded.value());
 }
 ktxVulkanTexture ktx::CreateImage(const std::filesystem::path &path)
 {
@@ -195,24 +243,63 @@ ktxVulkanTexture ktx::CreateImage(const std::filesystem::path &path)
     //
     // return {stagingBuffer, stagingBufferMemory};
 }
-std::pair<VkBuffer, VmaAllocation> ktx::CreateImageFromMemory(const std::uint8_t* data, size_t size, glm::ivec2 &imageSize, uint32_t &mipLevels, ktxTexture **texture)
+bool ktx::IsKtx(std::span<const std::uint8_t> encoded)
 {
-    // TODO: KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT -  should not be set, It should be directly loaded in the staging buffer
-    const auto errorCode = ktxTexture_CreateFromMemory(data, size, KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, texture);
-    LogAssert(errorCode == KTX_SUCCESS, "Failed to load texture image!", true)
-    LogAssert((*texture) != nullptr, "The KTX Texture is not valid", true)
+    constexpr std::array<std::uint8_t, 12> Identifier{0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+    return encoded.size() >= Identifier.size() && std::equal(Identifier.begin(), Identifier.end(), encoded.begin());
+}
 
-    // Get properties required for using and upload texture data from the ktx texture object
-    imageSize = {(*texture)->baseWidth, (*texture)->baseHeight};
-    mipLevels = (*texture)->numLevels;
+std::optional<ImageInMemory> ktx::CreateImageFromMemory(std::span<const std::uint8_t> encoded)
+{
+    //Without KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT the levels stay in the encoded bytes until LoadImageData
+    ktxTexture *texture = nullptr;
+    KTX_error_code errorCode = ktxTexture_CreateFromMemory(encoded.data(), encoded.size(), KTX_TEXTURE_CREATE_NO_FLAGS, &texture);
+    if (errorCode != KTX_SUCCESS)
+    {
+        LogError(std::string("Failed to load embedded texture image: ") + ktxErrorString(errorCode));
+        return std::nullopt;
+    }
 
-    const ktx_uint8_t *ktxTextureData = ktxTexture_GetData((*texture));
-    const ktx_size_t ktxTextureSize = ktxTexture_GetSize((*texture));
+    ImageInMemory image{};
+    image.format = ktxTexture_GetVkFormat(texture);
+    if (texture->numDimensions != 2 || texture->numFaces != 1 || texture->numLayers != 1 || image.format == VK_FORMAT_UNDEFINED)
+    {
+        LogError("Only 2D .ktx images with a Vulkan format can be embedded");
+        ktxTexture_Destroy(texture);
+        return std::nullopt;
+    }
 
-    VkBuffer stagingBuffer;
-    VmaAllocation stagingBufferMemory;
+    image.imageSize = {texture->baseWidth, texture->baseHeight};
+    image.mipLevels = texture->numLevels;
+    image.stagingSize = ktxTexture_GetSize(texture);
 
-    Core::Buffer::CreateStagingBuffer<ktx_uint8_t>(ktxTextureSize, stagingBuffer, stagingBufferMemory, ktxTextureData);
+    //Block formats need every copy offset to be a multiple of the block size
+    const StagingAllocation staging = UploadBatch::AllocateStaging(image.stagingSize, 16);
+    errorCode = ktxTexture_LoadImageData(texture, static_cast<ktx_uint8_t *>(staging.mappedData), image.stagingSize);
 
-    return {stagingBuffer, stagingBufferMemory};
+    for (uint32_t level{}; level < texture->numLevels; ++level)
+    {
+        ktx_size_t levelOffset{};
+        ktxTexture_GetImageOffset(texture, level, 0, 0, &levelOffset);
+        image.levelOffsets.push_back(levelOffset);
+    }
+
+    //A file that asks for generated mips only has the first level
+    if (texture->generateMipmaps)
+    {
+        image.mipLevels = MipGenerator::GetMipLevelCount(image.imageSize.x, image.imageSize.y);
+        image.generateMips = true;
+    }
+
+    ktxTexture_Destroy(texture);
+
+    if (errorCode != KTX_SUCCESS)
+    {
+        LogError(std::string("Failed to load embedded texture image: ") + ktxErrorString(errorCode));
+        return std::nullopt;
+    }
+
+    image.stagingBuffer = staging.buffer;
+    image.stagingOffset = staging.offset;
+    return image;
 }
@@ -1,7 +1,9 @@
 #pragma once
 #include <vulkan/vulkan.h>
 #include <ktxvulkan.h>
+#include <memory>
 #include <optional>
+#include <span>
 
 #include "Texture.h"
 #include "vk_mem_alloc.h"
@@ -9,12 +11,17 @@
 
 
 enum class TextureType : uint8_t;
+struct ImageInMemory;
 
 namespace Image
 {
+    //More than one queue family makes the image concurrent, those queues can all use it without ownership transfers
     void CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels,
         VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-        VkImage& image, VmaAllocation& imageMemory, TextureType textureType);
+        VkImage& image, VmaAllocation& imageMemory, TextureType textureType, std::span<const uint32_t> queueFamilies = {});
+    //Binds the image to memory that already exists, other images can live in the same memory
+    void CreateAliasingImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format, VkImageUsageFlags usage,
+        VmaAllocation memory, VkImage& image, TextureType textureType);
 
     void CreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VkImageView& imageView, TextureType textureType);
     void CreateSampler(const VulkanContext * vulkanContext, VkSampler& sampler, uint32_t mipLevels,const std::optional<VkSamplerCreateInfo> &overridenSamplerInfo = std::nullopt);
@@ -24,15 +31,30 @@ namespace Image
 
 
 //stbi loader
+//mipLevels is the length of the whole chain, the staging buffer only holds the first level
 namespace stbi
 {
     std::pair<VkBuffer, VmaAllocation> CreateImage(const std::filesystem::path &path, glm::ivec2 &imageSize, uint32_t &mipLevels);
-    std::pair<VkBuffer, VmaAllocation> CreateImageFromMemory(const std::uint8_t* data, size_t size, glm::ivec2 &imageSize, uint32_t &mipLevels);
+    //RGBA8 pixels of a decode that has not been uploaded yet
+    struct DecodedImage
+    {
+        std::unique_ptr<std::uint8_t, void (*)(void *)> pixels{nullptr, nullptr};
+        glm::ivec2 imageSize{};
+    };
+
+    //Only touches CPU memory, so it can run on a ThreadPool worker
+    std::optional<DecodedImage> Decode(std::span<const std::uint8_t> encoded);
+    //Copies the pixels into the staging ring of the active UploadBatch, main thread only
+    ImageInMemory CreateImageFromPixels(const DecodedImage &decoded);
+    //Decodes straight out of the encoded bytes (a mapped file), the pixels go into the staging ring of the active UploadBatch
+    std::optional<ImageInMemory> CreateImageFromMemory(std::span<const std::uint8_t> encoded);
 }
 
 //ktx Loader
 namespace ktx
 {
     ktxVulkanTexture CreateImage(const std::filesystem::path &path);
-    std::pair<VkBuffer, VmaAllocation> CreateImageFromMemory(const std::uint8_t* data, size_t size, glm::ivec2 &imageSize, uint32_t &mipLevels, ktxTexture** texture);
+    [[nodiscard]] bool IsKtx(std::span<const std::uint8_t> encoded);
+    //Only the header gets parsed up front, the levels get read out of the encoded bytes straight into the staging ring of the active UploadBatch
+    std::optional<ImageInMemory> CreateImageFromMemory(std::span<const std::uint8_t> encoded);
 }
\ No newline at end of file
@@ -0,0 +1,270 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <stb/stb_image.h>
+
+#include "Core/Logger.h"
+#include "vulkanbase/VulkanTypes.h"
+#include "vulkanbase/VulkanUtil.h"
+
+
+namespace
+{
+	float SrgbToLinear(const float value)
+	{
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float LinearToSrgb(const float value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	uint8_t ToUnorm8(const float value)
+	{
+		return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	// Where the center of a destination texel lands in the source, the two texels around it and the weight of the second one
+	struct Tap
+	{
+		uint32_t first{};
+		uint32_t second{};
+		float weight{};
+	};
+
+	Tap GetTap(const uint32_t destination, const uint32_t sourceSize, const uint32_t destinationSize)
+	{
+		const float source = (static_cast<float>(destination) + 0.5f) * static_cast<float>(sourceSize) / static_cast<float>(destinationSize) - 0.5f;
+		const float clamped = std::clamp(source, 0.0f, static_cast<float>(sourceSize - 1));
+		const uint32_t first = static_cast<uint32_t>(clamped);
+		return {first, std::min(first + 1, sourceSize - 1), clamped - static_cast<float>(first)};
+	}
+
+	MipGenerator::MipLevel Downsample(const MipGenerator::MipLevel& source, const bool isSrgb)
+	{
+		MipGenerator::MipLevel destination{std::max(source.width / 2, 1u), std::max(source.height / 2, 1u)};
+		destination.pixels.resize(static_cast<size_t>(destination.width) * destination.height * 4);
+
+		//Decoded once up front, every source texel gets read by up to four destination texels
+		std::vector<float> decoded(source.pixels.size());
+		for (size_t index{}; index < source.pixels.size(); ++index)
+		{
+			const float value = static_cast<float>(source.pixels[index]) / 255.0f;
+			decoded[index] = isSrgb && index % 4 != 3 ? SrgbToLinear(value) : value;
+		}
+
+		for (uint32_t y{}; y < destination.height; ++y)
+		{
+			const Tap tapY = GetTap(y, source.height, destination.height);
+			for (uint32_t x{}; x < destination.width; ++x)
+			{
+				const Tap tapX = GetTap(x, source.width, destination.width);
+				for (uint32_t channel{}; channel < 4; ++channel)
+				{
+					const auto texel = [&](const uint32_t texelX, const uint32_t texelY)
+					{
+						return decoded[(static_cast<size_t>(texelY) * source.width + texelX) * 4 + channel];
+					};
+
+					const float top = std::lerp(texel(tapX.first, tapY.first), texel(tapX.second, tapY.first), tapX.weight);
+					const float bottom = std::lerp(texel(tapX.first, tapY.second), texel(tapX.second, tapY.second), tapX.weight);
+					const float value = std::lerp(top, bottom, tapY.weight);
+
+					destination.pixels[(static_cast<size_t>(y) * destination.width + x) * 4 + channel] = ToUnorm8(isSrgb && channel != 3 ? LinearToSrgb(value) : value);
+				}
+			}
+		}
+
+		return destination;
+	}
+
+	// Mean of the color channels in linear space, filtering only moves light around so it should stay the same on every level
+	float GetLinearMean(const MipGenerator::MipLevel& level, const bool isSrgb)
+	{
+		double sum{};
+		for (size_t index{}; index < level.pixels.size(); ++index)
+		{
+			if (index % 4 == 3) continue;
+
+			const float value = static_cast<float>(level.pixels[index]) / 255.0f;
+			sum += isSrgb ? SrgbToLinear(value) : value;
+		}
+		return static_cast<float>(sum / static_cast<double>(level.pixels.size() / 4 * 3));
+	}
+
+	bool Check(const bool condition, const std::string& message)
+	{
+		if (!condition) LogError("MipGenerator self test: " + message);
+		return condition;
+	}
+}
+
+uint32_t MipGenerator::GetMipLevelCount(const uint32_t width, const uint32_t height)
+{
+	return std::bit_width(std::max({width, height, 1u}));
+}
+
+bool MipGenerator::IsBlitSupported(const VulkanContext* vulkanContext, const VkFormat format)
+{
+	VkFormatProperties formatProperties{};
+	vkGetPhysicalDeviceFormatProperties(vulkanContext->physicalDevice, format, &formatProperties);
+
+	constexpr VkFormatFeatureFlags requiredFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	return (formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+}
+
+void MipGenerator::RecordBlitChain(VkCommandBuffer commandBuffer, VkImage image, const VkExtent2D extent, const VkImageSubresourceRange& subresourceRange)
+{
+	VkImageSubresourceRange levelRange = subresourceRange;
+	levelRange.levelCount = 1;
+
+	int32_t sourceWidth = static_cast<int32_t>(extent.width);
+	int32_t sourceHeight = static_cast<int32_t>(extent.height);
+	for (uint32_t level = subresourceRange.baseMipLevel + 1; level < subresourceRange.baseMipLevel + subresourceRange.levelCount; ++level)
+	{
+		const int32_t width = std::max(sourceWidth / 2, 1);
+		const int32_t height = std::max(sourceHeight / 2, 1);
+
+		//The level above is done being written, it only gets read from here on
+		levelRange.baseMipLevel = level - 1;
+		tools::InsertImageMemoryBarrier(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, levelRange);
+
+		VkImageBlit blit{};
+		blit.srcSubresource = {subresourceRange.aspectMask, level - 1, subresourceRange.baseArrayLayer, subresourceRange.layerCount};
+		blit.srcOffsets[1] = {sourceWidth, sourceHeight, 1};
+		blit.dstSubresource = {subresourceRange.aspectMask, level, subresourceRange.baseArrayLayer, subresourceRange.layerCount};
+		blit.dstOffsets[1] = {width, height, 1};
+		vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+		tools::InsertImageMemoryBarrier(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, levelRange);
+
+		sourceWidth = width;
+		sourceHeight = height;
+	}
+
+	//Nothing reads the last level, it goes straight from the blit to the shaders
+	levelRange.baseMipLevel = subresourceRange.baseMipLevel + subresourceRange.levelCount - 1;
+	tools::InsertImageMemoryBarrier(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, levelRange);
+}
+
+std::vector<MipGenerator::MipLevel> MipGenerator::GenerateReference(const std::span<const uint8_t> pixels, const uint32_t width, const uint32_t height, const bool isSrgb)
+{
+	std::vector<MipLevel> levels{};
+	levels.reserve(GetMipLevelCount(width, height));
+	levels.push_back({width, height, std::vector<uint8_t>(pixels.begin(), pixels.end())});
+
+	//Every level comes from the 8 bit level above it, like the blits read what the one before wrote
+	while (levels.back().width > 1 || levels.back().height > 1)
+	{
+		levels.push_back(Downsample(levels.back(), isSrgb));
+	}
+
+	return levels;
+}
+
+bool MipGenerator::SelfTest(const std::vector<std::string>& imagePaths)
+{
+	bool isPassing = true;
+
+	isPassing &= Check(GetMipLevelCount(1, 1) == 1, "1x1 should have 1 level");
+	isPassing &= Check(GetMipLevelCount(1024, 512) == 11, "1024x512 should have 11 levels");
+	isPassing &= Check(GetMipLevelCount(5, 3) == 3, "5x3 should have 3 levels");
+	isPassing &= Check(GetMipLevelCount(4096, 1) == 13, "4096x1 should have 13 levels");
+
+	//A constant color stays the same on every level, also with odd sizes where the taps land between texels
+	{
+		constexpr std::array<uint8_t, 4> color{10, 200, 77, 128};
+		std::vector<uint8_t> pixels{};
+		for (uint32_t texel{}; texel < 7 * 5; ++texel) pixels.insert(pixels.end(), color.begin(), color.end());
+
+		const std::vector<MipLevel> levels = GenerateReference(pixels, 7, 5, true);
+		isPassing &= Check(levels.size() == GetMipLevelCount(7, 5), "7x5 chain has the wrong length");
+		isPassing &= Check(levels.back().width == 1 && levels.back().height == 1, "The chain does not end at 1x1");
+		for (const MipLevel& level : levels)
+		{
+			bool isConstant = true;
+			for (size_t index{}; index < level.pixels.size(); ++index)
+			{
+				isConstant &= level.pixels[index] == color[index % 4];
+			}
+			isPassing &= Check(isConstant, "A constant color changed at " + std::to_string(level.width) + "x" + std::to_string(level.height));
+		}
+	}
+
+	//A black and white checkerboard averages to half the light, in sRGB that is 188 and not the 128 a filter on the encoded values gives
+	{
+		std::vector<uint8_t> pixels{};
+		for (uint32_t y{}; y < 4; ++y)
+		{
+			for (uint32_t x{}; x < 4; ++x)
+			{
+				const uint8_t value = (x + y) % 2 == 0 ? 255 : 0;
+				pixels.insert(pixels.end(), {value, value, value, 255});
+			}
+		}
+
+		const std::vector<MipLevel> srgbLevels = GenerateReference(pixels, 4, 4, true);
+		const std::vector<MipLevel> linearLevels = GenerateReference(pixels, 4, 4, false);
+		isPassing &= Check(srgbLevels[1].pixels[0] == 188, "sRGB checkerboard gave " + std::to_string(srgbLevels[1].pixels[0]) + " instead of 188");
+		isPassing &= Check(linearLevels[1].pixels[0] == 128, "Linear checkerboard gave " + std::to_string(linearLevels[1].pixels[0]) + " instead of 128");
+		isPassing &= Check(srgbLevels[1].pixels[3] == 255, "Alpha got sRGB encoded");
+	}
+
+	//Even sizes are a box filter, the light of the whole image stays the same up to the 8 bit rounding
+	{
+		constexpr uint32_t size = 64;
+		std::vector<uint8_t> pixels(size * size * 4);
+		uint32_t state = 12345;
+		for (uint8_t& value : pixels)
+		{
+			state = state * 1664525u + 1013904223u;
+			value = static_cast<uint8_t>(state >> 24);
+		}
+
+		for (const bool isSrgb : {true, false})
+		{
+			const std::vector<MipLevel> levels = GenerateReference(pixels, size, size, isSrgb);
+			const float baseMean = GetLinearMean(levels.front(), isSrgb);
+			for (const MipLevel& level : levels)
+			{
+				const float error = std::abs(GetLinearMean(level, isSrgb) - baseMean);
+				isPassing &= Check(error < 0.01f, "Level " + std::to_string(level.width) + " lost light, off by " + std::to_string(error));
+			}
+		}
+	}
+
+	for (const std::string& imagePath : imagePaths)
+	{
+		int width{};
+		int height{};
+		int channels{};
+		stbi_uc* pixels = stbi_load(imagePath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+		if (!pixels)
+		{
+			isPassing &= Check(false, "Failed to load " + imagePath);
+			continue;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		const std::vector<MipLevel> levels = GenerateReference(std::span(pixels, static_cast<size_t>(width) * height * 4), width, height, true);
+		const float generateMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		stbi_image_free(pixels);
+
+		const float baseMean = GetLinearMean(levels.front(), true);
+		float worstError{};
+		for (const MipLevel& level : levels)
+		{
+			worstError = std::max(worstError, std::abs(GetLinearMean(level, true) - baseMean));
+		}
+
+		LogInfo(imagePath + ": " + std::to_string(width) + "x" + std::to_string(height) + ", " + std::to_string(levels.size()) + " levels in " + std::to_string(generateMs) + " ms, worst linear mean drift " + std::to_string(worstError));
+	}
+
+	LogInfo(std::string("MipGenerator self test: ") + (isPassing ? "Passed" : "Failed"));
+	return isPassing;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+class VulkanContext;
+
+// Builds the mip chain of uploaded textures on the GPU, every level gets blitted from the one above it
+// Blits of _SRGB formats filter in linear space, so the chain of a ColorType::SRGB texture does not darken
+// The CPU reference filters the same way as a linear blit, it checks the chain without a device
+namespace MipGenerator
+{
+	struct MipLevel
+	{
+		uint32_t width{};
+		uint32_t height{};
+		// RGBA8, tightly packed
+		std::vector<uint8_t> pixels{};
+	};
+
+	// Down to 1x1, every level halves the size rounded down
+	[[nodiscard]] uint32_t GetMipLevelCount(uint32_t width, uint32_t height);
+
+	// Linear blits need the format to be blittable and filterable with optimal tiling
+	[[nodiscard]] bool IsBlitSupported(const VulkanContext* vulkanContext, VkFormat format);
+
+	// Level 0 has to be written and every level of subresourceRange has to be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+	// Leaves every level in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, the image needs VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+	void RecordBlitChain(VkCommandBuffer commandBuffer, VkImage image, VkExtent2D extent, const VkImageSubresourceRange& subresourceRange);
+
+	// Bilinear at the center of every destination texel, a 2x2 box filter for even sizes, like a VK_FILTER_LINEAR blit
+	// isSrgb decodes the color channels before filtering and encodes them again after, alpha is always linear
+	[[nodiscard]] std::vector<MipLevel> GenerateReference(std::span<const uint8_t> pixels, uint32_t width, uint32_t height, bool isSrgb);
+
+	// Offline mode, checks the level counts and the filtering of the reference on synthetic images and logs the chain of every image in imagePaths
+	bool SelfTest(const std::vector<std::string>& imagePaths);
+}
@@ -1,16 +1,27 @@
 #include "Texture.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <utility>
 
 #include "ImGuiFileDialog.h"
 #include "Core/CommandBuffer.h"
+#include "Core/FrameRing.h"
 #include "Core/SwapChain.h"
+#include "Core/UploadBatch.h"
+#include "Core/Image/MipGenerator.h"
+#include "Core/Image/TextureBaker.h"
 #include "Patterns/ServiceLocator.h"
 #include "vulkanbase/VulkanTypes.h"
 #include "vulkanbase/VulkanUtil.h"
 
 
+namespace
+{
+	//Allow both storage and sampling, Transfer bit is for clearing the image.
+	constexpr VkImageUsageFlags OutputTextureUsage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+}
+
 Texture::Texture(const std::variant<std::filesystem::path, ImageInMemory> &pathOrImage, VulkanContext *vulkanContext, ColorType colorType, TextureType textureType):
 	m_pContext(vulkanContext), m_ColorType(colorType), m_TextureType(textureType)
 {
@@ -57,6 +68,8 @@ void Texture::OnImGui()
 				std::string filePathName = ImGuiFileDialog::Instance()->GetCurrentFileName();
 				std::string filePath = ImGuiFileDialog::Instance()->GetCurrentPath();
 
+				//The frames in flight can still sample the old image
+				FrameRing::WaitForAllFrames();
 				Cleanup(m_pContext->device);
 				InitTexture(filePath + "\\" + filePathName);
 			}
@@ -83,15 +96,23 @@ void Texture::Cleanup(VkDevice device)
 	}
 
 	//Cleanup the image and the memory
-	std::visit([this](auto &&arg)
+	if (m_IsAliased)
+	{
+		vkDestroyImage(device, m_Image, nullptr);
+	}
+	else
 	{
-		this->CleanupImage(arg, this->m_Image);
-	}, m_ImageMemory);
+		std::visit([this](auto &&arg)
+		{
+			this->CleanupImage(arg, this->m_Image);
+		}, m_ImageMemory);
+	}
 
 	vkDestroySampler(device, m_Sampler, nullptr);
 	vkDestroyImageView(device, m_ImageView, nullptr);
 
 	m_IsPendingKill = true;
+	++m_Version;
 }
 
 void Texture::InitTexture(const TextureData &loadedImage)
@@ -105,23 +126,35 @@ void Texture::InitTexture(const TextureData &loadedImage)
 		m_ImageSize = {kTexture.width, kTexture.height};
 		m_MipLevels = kTexture.levelCount;
 
-		//TODO: Figure out how i can use ktx to make VK_FORMAT_R8G8B8A8_SRGB images (i think it needs to be set in the actual image metadata)
-		Image::CreateImageView(m_pContext->device, m_Image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, m_ImageView, m_TextureType);
+		//The format comes from the ktx header, baked albedo is already an _SRGB block format
+		Image::CreateImageView(m_pContext->device, m_Image, kTexture.imageFormat, VK_IMAGE_ASPECT_COLOR_BIT, m_ImageView, m_TextureType);
 	}
 	else
 	{
 		const auto &imageInMemory = std::get<ImageInMemory>(loadedImage);
 		m_ImageSize = imageInMemory.imageSize;
 		m_MipLevels = imageInMemory.mipLevels;
+		const VkFormat format = imageInMemory.format != VK_FORMAT_UNDEFINED ? imageInMemory.format : static_cast<VkFormat>(m_ColorType);
+
+		//The blits read the level above, so the image is a transfer source as well
+		VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		bool generateMips = imageInMemory.generateMips && m_MipLevels > 1;
+		if (generateMips && !MipGenerator::IsBlitSupported(m_pContext, format))
+		{
+			LogWarning("The texture format can not be blitted with a linear filter, the texture gets no mips");
+			generateMips = false;
+			m_MipLevels = 1;
+		}
+		if (generateMips) usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 
 		VmaAllocation allocation{};
-		Image::CreateImage(m_ImageSize.x, m_ImageSize.y, m_MipLevels, VK_SAMPLE_COUNT_1_BIT, static_cast<VkFormat>(m_ColorType), VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, m_Image, allocation, m_TextureType);
+		Image::CreateImage(m_ImageSize.x, m_ImageSize.y, m_MipLevels, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, usage, m_Image, allocation, m_TextureType);
 		m_ImageMemory = allocation;
 
-		TransitionAndCopyImageBuffer(imageInMemory.stagingBuffer);
-		vmaDestroyBuffer(Allocator::vmaAllocator, imageInMemory.stagingBuffer, imageInMemory.stagingBufferMemory);
+		//The upload batch destroys the staging buffer once the copy is done
+		TransitionAndCopyImageBuffer(imageInMemory, generateMips);
 
-		Image::CreateImageView(m_pContext->device, m_Image, static_cast<VkFormat>(m_ColorType), VK_IMAGE_ASPECT_COLOR_BIT, m_ImageView, m_TextureType);
+		Image::CreateImageView(m_pContext->device, m_Image, format, VK_IMAGE_ASPECT_COLOR_BIT, m_ImageView, m_TextureType);
 	}
 
 	Image::CreateSampler(m_pContext, m_Sampler, m_MipLevels);
@@ -139,11 +172,20 @@ void Texture::InitTexture(const std::filesystem::path &path)
 
 	TextureData textureData;
 
+	//A baked .ktx already has the whole compressed mip chain, m_Path stays the source so a reload picks up a new bake
+	std::filesystem::path ktxPath = m_Path.value();
+	if (m_TextureType == TextureType::TEXTURE_2D && ktxPath.extension() != ".ktx")
+	{
+		if (const std::optional<std::filesystem::path> bakedPath = TextureBaker::FindBaked(ktxPath))
+		{
+			ktxPath = bakedPath.value();
+		}
+	}
 
 	//Note: For now we only support .ktx files for a cubemap
-	if (m_Path.value().extension() == ".ktx" || m_TextureType == TextureType::TEXTURE_CUBE)
+	if (ktxPath.extension() == ".ktx" || m_TextureType == TextureType::TEXTURE_CUBE)
 	{
-		textureData = ktx::CreateImage(m_Path.value());
+		textureData = ktx::CreateImage(ktxPath);
 
 		//The CreateImage already transfers the image to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
 		m_BindImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -154,6 +196,7 @@ void Texture::InitTexture(const std::filesystem::path &path)
 		auto bufferPair = stbi::CreateImage(m_Path.value(), stagingSources.imageSize, stagingSources.mipLevels);
 		stagingSources.stagingBuffer = bufferPair.first;
 		stagingSources.stagingBufferMemory = bufferPair.second;
+		stagingSources.generateMips = true;
 
 		textureData = stagingSources;
 	}
@@ -168,7 +211,7 @@ void Texture::InitEmptyTexture()
 	VmaAllocation allocation{};
 
 	// Create an image that is writable by compute shaders
-	Image::CreateImage(m_ImageSize.x, m_ImageSize.y, m_MipLevels, VK_SAMPLE_COUNT_1_BIT, static_cast<VkFormat>(m_ColorType), VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, // Allow both storage and sampling, Transfer bit is for clearing the image.
+	Image::CreateImage(m_ImageSize.x, m_ImageSize.y, m_MipLevels, VK_SAMPLE_COUNT_1_BIT, static_cast<VkFormat>(m_ColorType), VK_IMAGE_TILING_OPTIMAL, OutputTextureUsage,
 	                   m_Image, allocation, m_TextureType);
 
 	m_ImageMemory = allocation;
@@ -195,29 +238,27 @@ void Texture::InitEmptyTexture()
 	}
 }
 
-void Texture::TransitionAndCopyImageBuffer(VkBuffer srcBuffer)
+void Texture::TransitionAndCopyImageBuffer(const ImageInMemory &imageInMemory, bool generateMips)
 {
-	// Create Command Buffer
-	CommandBuffer commandBuffer{};
-	CommandBufferManager::CreateCommandBufferSingleUse(m_pContext, commandBuffer);
 	std::vector<VkBufferImageCopy> bufferCopyRegions;
 
+	//Generated mips only copy the first level, the blits fill the rest
+	const uint32_t copiedMipLevels = generateMips ? 1 : m_MipLevels;
 	uint32_t faces = m_TextureType == TextureType::TEXTURE_CUBE ? 6 : 1;
 	for (uint32_t face{}; face < faces; ++face)
 	{
-		for (uint32_t mipLevel{}; mipLevel < m_MipLevels; ++mipLevel)
+		for (uint32_t mipLevel{}; mipLevel < copiedMipLevels; ++mipLevel)
 		{
-			VkDeviceSize offset = 0;
 			VkBufferImageCopy region{};
-			region.bufferOffset = offset;
+			region.bufferOffset = mipLevel < imageInMemory.levelOffsets.size() ? imageInMemory.levelOffsets[mipLevel] : 0;
 
 			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 			region.imageSubresource.mipLevel = mipLevel;
 			region.imageSubresource.baseArrayLayer = face;
 			region.imageSubresource.layerCount = 1;
 
-			region.imageExtent.width = m_ImageSize.x >> mipLevel;
-			region.imageExtent.height = m_ImageSize.y >> mipLevel;
+			region.imageExtent.width = std::max(static_cast<uint32_t>(m_ImageSize.x) >> mipLevel, 1u);
+			region.imageExtent.height = std::max(static_cast<uint32_t>(m_ImageSize.y) >> mipLevel, 1u);
 			region.imageExtent.depth = 1;
 
 			bufferCopyRegions.emplace_back(region);
@@ -229,18 +270,19 @@ void Texture::TransitionAndCopyImageBuffer(VkBuffer srcBuffer)
 	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	subresourceRange.baseMipLevel = 0;
 	subresourceRange.levelCount = m_MipLevels;
-	subresourceRange.layerCount = static_cast<uint32_t>(bufferCopyRegions.size() / m_MipLevels);
-
-	// Transition the image to transfer destination
-	tools::InsertImageMemoryBarrier(commandBuffer.Handle, m_Image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange);
-
-	vkCmdCopyBufferToImage(commandBuffer.Handle, srcBuffer, m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(bufferCopyRegions.size()), bufferCopyRegions.data());
-
-	// Transition the image to shader read
-	tools::InsertImageMemoryBarrier(commandBuffer.Handle, m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresourceRange);
+	subresourceRange.layerCount = faces;
 
-
-	CommandBufferManager::EndCommandBufferSingleUse(m_pContext, commandBuffer);
+	// Records the transitions and the copy into the active upload batch (or its own batch if there is none)
+	const std::optional<VkExtent2D> mipExtent = generateMips ? std::optional(VkExtent2D{static_cast<uint32_t>(m_ImageSize.x), static_cast<uint32_t>(m_ImageSize.y)}) : std::nullopt;
+	if (imageInMemory.stagingBufferMemory)
+	{
+		UploadBatch::UploadImage(imageInMemory.stagingBuffer, imageInMemory.stagingBufferMemory, m_Image, bufferCopyRegions, subresourceRange, mipExtent);
+	}
+	else
+	{
+		const StagingAllocation staging{imageInMemory.stagingBuffer, imageInMemory.stagingOffset};
+		UploadBatch::UploadImage(staging, imageInMemory.stagingSize, m_Image, bufferCopyRegions, subresourceRange, mipExtent);
+	}
 
 	m_BindImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 }
@@ -293,6 +335,55 @@ void Texture::ClearImage(VkCommandBuffer commandBuffer)
 	vkCmdClearColorImage(commandBuffer, m_Image, m_BindImageLayout, &clearColor, 1, &subresourceRange);
 }
 
+void Texture::SetImageLayout(VkImageLayout imageLayout)
+{
+	m_BindImageLayout = imageLayout;
+	m_DescriptorImageType = imageLayout == VK_IMAGE_LAYOUT_GENERAL ? DescriptorImageType::STORAGE_IMAGE : DescriptorImageType::SAMPLED_IMAGE;
+}
+
+void Texture::AliasMemory(VmaAllocation memory)
+{
+	if (!m_IsOutputTexture)
+	{
+		LogError("Only output textures can share their memory");
+		return;
+	}
+
+	//An image can only be bound to memory once, so it gets created again on top of the shared memory
+	vkDestroyImageView(m_pContext->device, m_ImageView, nullptr);
+	if (m_IsAliased)
+	{
+		vkDestroyImage(m_pContext->device, m_Image, nullptr);
+	}
+	else
+	{
+		std::visit([this](auto &&arg)
+		{
+			this->CleanupImage(arg, this->m_Image);
+		}, m_ImageMemory);
+	}
+
+	Image::CreateAliasingImage(m_ImageSize.x, m_ImageSize.y, m_MipLevels, static_cast<VkFormat>(m_ColorType), OutputTextureUsage, memory, m_Image, m_TextureType);
+	Image::CreateImageView(m_pContext->device, m_Image, static_cast<VkFormat>(m_ColorType), VK_IMAGE_ASPECT_COLOR_BIT, m_ImageView, m_TextureType);
+
+	m_IsAliased = true;
+	m_BindImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	++m_Version;
+
+	if (m_ImGuiTexture)
+	{
+		m_ImGuiTexture->Cleanup();
+		m_ImGuiTexture = std::make_unique<ImGuiTexture>(m_Sampler, m_ImageView, ImVec2(m_ImageSize.x / 2.0f, m_ImageSize.y / 2.0f));
+	}
+}
+
+VkMemoryRequirements Texture::GetMemoryRequirements() const
+{
+	VkMemoryRequirements memoryRequirements{};
+	vkGetImageMemoryRequirements(m_pContext->device, m_Image, &memoryRequirements);
+	return memoryRequirements;
+}
+
 void Texture::SetOutputTexture(bool isOutputTexture)
 {
 	m_IsOutputTexture = isOutputTexture;
@@ -1,6 +1,7 @@
 #pragma once
 #include <filesystem>
 #include <variant>
+#include <vector>
 #include <glm/vec2.hpp>
 
 #include "ImageLoader.h"
@@ -31,10 +32,18 @@ enum class DescriptorImageType : uint8_t
 
 struct ImageInMemory
 {
+	// Without stagingBufferMemory the staging is a slice of the UploadBatch ring, its copy has to be recorded before the ring gets allocated from again
 	VkBuffer stagingBuffer;
 	VmaAllocation stagingBufferMemory;
+	VkDeviceSize stagingOffset{};
+	VkDeviceSize stagingSize{};
 	glm::ivec2 imageSize;
 	uint32_t mipLevels;
+	// The staging buffer only holds the first level, the other mipLevels get blitted from it on upload
+	bool generateMips{};
+	// Set for .ktx data, the staging holds every level at levelOffsets. Undefined means RGBA8 in the ColorType of the texture
+	VkFormat format{VK_FORMAT_UNDEFINED};
+	std::vector<VkDeviceSize> levelOffsets{};
 };
 
 using TextureData = std::variant<ktxVulkanTexture, ImageInMemory>;
@@ -67,18 +76,30 @@ public:
 
 	void ClearImage(VkCommandBuffer commandBuffer);
 
+	//Set by the render graph after its barriers, storage images get bound in the general layout, everything else as sampled
+	void SetImageLayout(VkImageLayout imageLayout);
+	//Moves an output texture into memory it shares with other images, the contents are gone after this
+	void AliasMemory(VmaAllocation memory);
+
 	void SetOutputTexture(bool isOutputTexture);
 	[[nodiscard]] bool IsOutputTexture() const;
 	[[nodiscard]] DescriptorImageType GetDescriptorImageType() const;
+	[[nodiscard]] VkImage GetImage() const { return m_Image; }
+	[[nodiscard]] VkMemoryRequirements GetMemoryRequirements() const;
 
 	[[nodiscard]] bool IsPendingKill() const;
+	//Cached textures belong to the TextureCache, descriptor sets only drop their reference
+	void SetCached(bool isCached) { m_IsCached = isCached; }
+	[[nodiscard]] bool IsCached() const { return m_IsCached; }
+	//Changes whenever the image gets destroyed, descriptor sets that point at the old one have to be rewritten
+	[[nodiscard]] uint32_t GetVersion() const { return m_Version; }
 
 private:
 	void InitTexture(const TextureData &loadedImage);
 	void InitTexture(const std::filesystem::path &path);
 	void InitEmptyTexture();
 
-	void TransitionAndCopyImageBuffer(VkBuffer srcBuffer);
+	void TransitionAndCopyImageBuffer(const ImageInMemory &imageInMemory, bool generateMips);
 
 	static void CleanupImage(VkDeviceMemory deviceMemory, VkImage image);
 	static void CleanupImage(VmaAllocation deviceMemory, VkImage image);
@@ -106,4 +127,8 @@ private:
 
 	bool m_IsOutputTexture{false};
 	bool m_IsPendingKill{false};
+	//The memory belongs to the render graph, only the image is ours to destroy
+	bool m_IsAliased{false};
+	bool m_IsCached{false};
+	uint32_t m_Version{};
 };
\ No newline at end of file
@@ -0,0 +1,537 @@
+#include "TextureBaker.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <map>
+#include <span>
+#include <ktx.h>
+#include <glm/glm.hpp>
+#include <stb/stb_image.h>
+
+#include "MipGenerator.h"
+#include "Core/Logger.h"
+#include "Mesh/ModelLoader.h"
+#include "Patterns/ThreadPool.h"
+#include "vulkanbase/VulkanTypes.h"
+
+
+namespace
+{
+	//OpenGL internal formats of the KTX header, libktx turns them into the VkFormat on upload
+	constexpr uint32_t GlCompressedRgbS3tcDxt1 = 0x83F0;
+	constexpr uint32_t GlCompressedSrgbS3tcDxt1 = 0x8C4C;
+	constexpr uint32_t GlCompressedSrgbAlphaS3tcDxt5 = 0x8C4F;
+	constexpr uint32_t GlCompressedRgRgtc2 = 0x8DBD;
+
+	enum class BlockFormat : uint8_t
+	{
+		BC1,
+		BC3,
+		BC5
+	};
+
+	//4x4 RGBA8 texels
+	using Block = std::array<std::array<uint8_t, 4>, 16>;
+
+	uint32_t GetBlockSize(const BlockFormat format)
+	{
+		return format == BlockFormat::BC1 ? 8 : 16;
+	}
+
+	Block GetBlock(const MipGenerator::MipLevel& level, const uint32_t blockX, const uint32_t blockY)
+	{
+		Block block{};
+		for (uint32_t y{}; y < 4; ++y)
+		{
+			for (uint32_t x{}; x < 4; ++x)
+			{
+				//Levels smaller than a block repeat their last texel
+				const uint32_t sourceX = std::min(blockX * 4 + x, level.width - 1);
+				const uint32_t sourceY = std::min(blockY * 4 + y, level.height - 1);
+				std::memcpy(block[y * 4 + x].data(), &level.pixels[(static_cast<size_t>(sourceY) * level.width + sourceX) * 4], 4);
+			}
+		}
+		return block;
+	}
+
+	void AppendLittleEndian(std::vector<uint8_t>& output, const uint64_t value, const uint32_t byteCount)
+	{
+		for (uint32_t byte{}; byte < byteCount; ++byte)
+		{
+			output.push_back(static_cast<uint8_t>(value >> (byte * 8) & 0xFF));
+		}
+	}
+
+	uint16_t PackRgb565(const glm::vec3& color)
+	{
+		const glm::vec3 clamped = glm::clamp(color, glm::vec3{0}, glm::vec3{255});
+		const uint32_t red = static_cast<uint32_t>(clamped.r * 31.f / 255.f + 0.5f);
+		const uint32_t green = static_cast<uint32_t>(clamped.g * 63.f / 255.f + 0.5f);
+		const uint32_t blue = static_cast<uint32_t>(clamped.b * 31.f / 255.f + 0.5f);
+		return static_cast<uint16_t>(red << 11 | green << 5 | blue);
+	}
+
+	glm::vec3 UnpackRgb565(const uint16_t packed)
+	{
+		const uint32_t red = packed >> 11 & 31;
+		const uint32_t green = packed >> 5 & 63;
+		const uint32_t blue = packed & 31;
+		return {red << 3 | red >> 2, green << 2 | green >> 4, blue << 3 | blue >> 2};
+	}
+
+	//Picks the nearest of the 4 palette colors for every texel, returns the summed squared error
+	float GetColorIndices(const std::array<glm::vec3, 16>& colors, const uint16_t color0, const uint16_t color1, std::array<uint32_t, 16>& indices)
+	{
+		const glm::vec3 endpoint0 = UnpackRgb565(color0);
+		const glm::vec3 endpoint1 = UnpackRgb565(color1);
+		const std::array<glm::vec3, 4> palette{endpoint0, endpoint1, (2.f * endpoint0 + endpoint1) / 3.f, (endpoint0 + 2.f * endpoint1) / 3.f};
+
+		float error{};
+		for (size_t texel{}; texel < colors.size(); ++texel)
+		{
+			float bestDistance = std::numeric_limits<float>::max();
+			for (uint32_t index{}; index < palette.size(); ++index)
+			{
+				const glm::vec3 difference = colors[texel] - palette[index];
+				const float distance = glm::dot(difference, difference);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					indices[texel] = index;
+				}
+			}
+			error += bestDistance;
+		}
+		return error;
+	}
+
+	//Least squares endpoints for the current indices, returns false when every texel picked the same weight
+	bool RefineEndpoints(const std::array<glm::vec3, 16>& colors, const std::array<uint32_t, 16>& indices, glm::vec3& endpoint0, glm::vec3& endpoint1)
+	{
+		constexpr std::array<float, 4> weights0{1.f, 0.f, 2.f / 3.f, 1.f / 3.f};
+
+		float weight00{}, weight01{}, weight11{};
+		glm::vec3 color0{}, color1{};
+		for (size_t texel{}; texel < colors.size(); ++texel)
+		{
+			const float weight0 = weights0[indices[texel]];
+			const float weight1 = 1.f - weight0;
+			weight00 += weight0 * weight0;
+			weight01 += weight0 * weight1;
+			weight11 += weight1 * weight1;
+			color0 += weight0 * colors[texel];
+			color1 += weight1 * colors[texel];
+		}
+
+		const float determinant = weight00 * weight11 - weight01 * weight01;
+		if (std::abs(determinant) < 1e-6f) return false;
+
+		endpoint0 = (weight11 * color0 - weight01 * color1) / determinant;
+		endpoint1 = (weight00 * color1 - weight01 * color0) / determinant;
+		return true;
+	}
+
+	//BC1 color block, the endpoints are the ends of the principal axis of the colors, refined once with least squares
+	void EncodeColorBlock(const Block& block, std::vector<uint8_t>& output)
+	{
+		std::array<glm::vec3, 16> colors{};
+		glm::vec3 mean{};
+		glm::vec3 minColor{255};
+		glm::vec3 maxColor{0};
+		for (size_t texel{}; texel < colors.size(); ++texel)
+		{
+			colors[texel] = {block[texel][0], block[texel][1], block[texel][2]};
+			mean += colors[texel];
+			minColor = glm::min(minColor, colors[texel]);
+			maxColor = glm::max(maxColor, colors[texel]);
+		}
+		mean /= 16.f;
+
+		glm::mat3 covariance{0};
+		for (const glm::vec3& color : colors)
+		{
+			const glm::vec3 offset = color - mean;
+			covariance += glm::outerProduct(offset, offset);
+		}
+
+		//Power iteration, starts along the bounding box diagonal
+		glm::vec3 axis = maxColor - minColor;
+		for (uint32_t iteration{}; iteration < 8; ++iteration)
+		{
+			const glm::vec3 nextAxis = covariance * axis;
+			const float largest = std::max({std::abs(nextAxis.x), std::abs(nextAxis.y), std::abs(nextAxis.z)});
+			if (largest < 1e-6f) break;
+			axis = nextAxis / largest;
+		}
+		if (glm::dot(axis, axis) > 1e-12f) axis = glm::normalize(axis);
+
+		float minProjection{};
+		float maxProjection{};
+		for (const glm::vec3& color : colors)
+		{
+			const float projection = glm::dot(color - mean, axis);
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		//Pull the ends in a bit, the extremes are rarely hit exactly and the inner palette colors matter more
+		const float inset = (maxProjection - minProjection) / 16.f;
+		glm::vec3 endpoint0 = mean + axis * (maxProjection - inset);
+		glm::vec3 endpoint1 = mean + axis * (minProjection + inset);
+
+		uint16_t color0 = PackRgb565(endpoint0);
+		uint16_t color1 = PackRgb565(endpoint1);
+		std::array<uint32_t, 16> indices{};
+		const float error = GetColorIndices(colors, color0, color1, indices);
+
+		if (RefineEndpoints(colors, indices, endpoint0, endpoint1))
+		{
+			const uint16_t refinedColor0 = PackRgb565(endpoint0);
+			const uint16_t refinedColor1 = PackRgb565(endpoint1);
+			std::array<uint32_t, 16> refinedIndices{};
+			const float refinedError = GetColorIndices(colors, refinedColor0, refinedColor1, refinedIndices);
+			if (refinedError < error)
+			{
+				color0 = refinedColor0;
+				color1 = refinedColor1;
+				indices = refinedIndices;
+			}
+		}
+
+		//color0 > color1 selects the 4 color mode, swapping the endpoints swaps index 0 with 1 and 2 with 3
+		if (color0 < color1)
+		{
+			std::swap(color0, color1);
+			for (uint32_t& index : indices) index ^= 1;
+		}
+		//Equal endpoints are the 3 color mode where index 3 is transparent, every texel is color0 anyway
+		else if (color0 == color1)
+		{
+			indices.fill(0);
+		}
+
+		uint32_t indexBits{};
+		for (uint32_t texel{}; texel < indices.size(); ++texel)
+		{
+			indexBits |= indices[texel] << (texel * 2);
+		}
+
+		AppendLittleEndian(output, color0, 2);
+		AppendLittleEndian(output, color1, 2);
+		AppendLittleEndian(output, indexBits, 4);
+	}
+
+	//BC4 block of one channel, the endpoints are the min and max with 6 values between them
+	void EncodeChannelBlock(const Block& block, const uint32_t channel, std::vector<uint8_t>& output)
+	{
+		int minValue{255};
+		int maxValue{0};
+		for (const std::array<uint8_t, 4>& texel : block)
+		{
+			minValue = std::min<int>(minValue, texel[channel]);
+			maxValue = std::max<int>(maxValue, texel[channel]);
+		}
+
+		//value0 > value1 selects the 8 value mode, equal values decode every index to value0
+		std::array<int, 8> palette{maxValue, minValue};
+		for (int step{1}; step < 7; ++step)
+		{
+			palette[step + 1] = ((7 - step) * maxValue + step * minValue + 3) / 7;
+		}
+
+		uint64_t indexBits{};
+		for (uint32_t texel{}; texel < block.size(); ++texel)
+		{
+			uint64_t bestIndex{};
+			int bestDistance = std::numeric_limits<int>::max();
+			for (uint32_t index{}; index < palette.size(); ++index)
+			{
+				const int distance = std::abs(palette[index] - block[texel][channel]);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = index;
+				}
+			}
+			indexBits |= bestIndex << (texel * 3);
+		}
+
+		output.push_back(static_cast<uint8_t>(maxValue));
+		output.push_back(static_cast<uint8_t>(minValue));
+		AppendLittleEndian(output, indexBits, 6);
+	}
+
+	std::vector<uint8_t> CompressLevel(const MipGenerator::MipLevel& level, const BlockFormat format)
+	{
+		const uint32_t blocksX = (level.width + 3) / 4;
+		const uint32_t blocksY = (level.height + 3) / 4;
+
+		std::vector<uint8_t> compressed{};
+		compressed.reserve(static_cast<size_t>(blocksX) * blocksY * GetBlockSize(format));
+		for (uint32_t blockY{}; blockY < blocksY; ++blockY)
+		{
+			for (uint32_t blockX{}; blockX < blocksX; ++blockX)
+			{
+				const Block block = GetBlock(level, blockX, blockY);
+				switch (format)
+				{
+				case BlockFormat::BC1:
+					EncodeColorBlock(block, compressed);
+					break;
+				case BlockFormat::BC3:
+					EncodeChannelBlock(block, 3, compressed);
+					EncodeColorBlock(block, compressed);
+					break;
+				case BlockFormat::BC5:
+					EncodeChannelBlock(block, 0, compressed);
+					EncodeChannelBlock(block, 1, compressed);
+					break;
+				}
+			}
+		}
+		return compressed;
+	}
+
+	//Averaging shortens the normals, the shading expects unit length on every level
+	void RenormalizeNormals(MipGenerator::MipLevel& level)
+	{
+		for (size_t texel{}; texel < level.pixels.size(); texel += 4)
+		{
+			glm::vec3 normal = glm::vec3{level.pixels[texel], level.pixels[texel + 1], level.pixels[texel + 2]} / 255.f * 2.f - 1.f;
+			if (glm::dot(normal, normal) < 1e-8f) continue;
+
+			normal = glm::normalize(normal) * 0.5f + 0.5f;
+			for (uint32_t channel{}; channel < 3; ++channel)
+			{
+				level.pixels[texel + channel] = static_cast<uint8_t>(normal[channel] * 255.f + 0.5f);
+			}
+		}
+	}
+
+	bool IsUpToDate(const std::filesystem::path& sourcePath, const std::filesystem::path& bakedPath)
+	{
+		std::error_code error;
+		const std::filesystem::file_time_type bakedWriteTime = std::filesystem::last_write_time(bakedPath, error);
+		if (error) return false;
+
+		//A bake without its source is still usable
+		const std::filesystem::file_time_type sourceWriteTime = std::filesystem::last_write_time(sourcePath, error);
+		if (error) return true;
+
+		return bakedWriteTime >= sourceWriteTime;
+	}
+}
+
+std::filesystem::path TextureBaker::GetBakedPath(const std::filesystem::path& sourcePath)
+{
+	const std::filesystem::path assetPath = VulkanContext::GetAssetPath();
+	std::filesystem::path relativePath = sourcePath.lexically_normal().lexically_relative(assetPath);
+
+	//Images outside the asset folder only keep their name
+	if (relativePath.empty() || *relativePath.begin() == "..")
+	{
+		relativePath = sourcePath.filename();
+	}
+
+	return assetPath / "Cache" / "Textures" / (relativePath.generic_string() + ".ktx");
+}
+
+std::optional<std::filesystem::path> TextureBaker::FindBaked(const std::filesystem::path& sourcePath)
+{
+	if (!UseBakedTextures || !IsBlockCompressionSupported) return std::nullopt;
+
+	std::filesystem::path bakedPath = GetBakedPath(sourcePath);
+	if (!IsUpToDate(sourcePath, bakedPath)) return std::nullopt;
+
+	return bakedPath;
+}
+
+bool TextureBaker::BakeTexture(const std::filesystem::path& sourcePath, const TextureRole role)
+{
+	int width{};
+	int height{};
+	int channels{};
+	stbi_uc* pixels = stbi_load(sourcePath.generic_string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
+	if (!pixels)
+	{
+		LogError("Failed to load texture image: " + sourcePath.generic_string());
+		return false;
+	}
+
+	//Albedo filters in linear space like the sRGB blits at runtime
+	std::vector<MipGenerator::MipLevel> levels = MipGenerator::GenerateReference(std::span(pixels, static_cast<size_t>(width) * height * 4), width, height, role == TextureRole::Albedo);
+	stbi_image_free(pixels);
+
+	BlockFormat format{BlockFormat::BC1};
+	uint32_t glInternalformat{GlCompressedRgbS3tcDxt1};
+	switch (role)
+	{
+	case TextureRole::Albedo:
+	{
+		const std::vector<uint8_t>& basePixels = levels.front().pixels;
+		bool hasAlpha{};
+		for (size_t texel{3}; texel < basePixels.size() && !hasAlpha; texel += 4)
+		{
+			hasAlpha = basePixels[texel] != 255;
+		}
+		format = hasAlpha ? BlockFormat::BC3 : BlockFormat::BC1;
+		glInternalformat = hasAlpha ? GlCompressedSrgbAlphaS3tcDxt5 : GlCompressedSrgbS3tcDxt1;
+		break;
+	}
+	case TextureRole::Normal:
+		//Only x and y are stored, the shader rebuilds z
+		for (size_t levelIndex{1}; levelIndex < levels.size(); ++levelIndex)
+		{
+			RenormalizeNormals(levels[levelIndex]);
+		}
+		format = BlockFormat::BC5;
+		glInternalformat = GlCompressedRgRgtc2;
+		break;
+	case TextureRole::MetalRoughness:
+		//Roughness is in green and metal in blue, both fit the 565 endpoints of BC1
+		break;
+	}
+
+	ktxTextureCreateInfo createInfo{};
+	createInfo.glInternalformat = glInternalformat;
+	createInfo.baseWidth = static_cast<ktx_uint32_t>(width);
+	createInfo.baseHeight = static_cast<ktx_uint32_t>(height);
+	createInfo.baseDepth = 1;
+	createInfo.numDimensions = 2;
+	createInfo.numLevels = static_cast<ktx_uint32_t>(levels.size());
+	createInfo.numLayers = 1;
+	createInfo.numFaces = 1;
+	createInfo.isArray = KTX_FALSE;
+	createInfo.generateMipmaps = KTX_FALSE;
+
+	ktxTexture* texture{};
+	KTX_error_code errorCode = ktxTexture_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE, &texture);
+	if (errorCode != KTX_SUCCESS)
+	{
+		LogError("Failed to create the baked texture of " + sourcePath.generic_string() + ": " + ktxErrorString(errorCode));
+		return false;
+	}
+
+	size_t uncompressedSize{};
+	size_t compressedSize{};
+	for (uint32_t levelIndex{}; levelIndex < levels.size() && errorCode == KTX_SUCCESS; ++levelIndex)
+	{
+		const std::vector<uint8_t> compressed = CompressLevel(levels[levelIndex], format);
+		errorCode = ktxTexture_SetImageFromMemory(texture, levelIndex, 0, 0, compressed.data(), compressed.size());
+
+		uncompressedSize += levels[levelIndex].pixels.size();
+		compressedSize += compressed.size();
+	}
+
+	//Write to a temporary file first, a half written bake should never be picked up
+	const std::filesystem::path bakedPath = GetBakedPath(sourcePath);
+	std::filesystem::path temporaryPath = bakedPath;
+	temporaryPath += ".tmp";
+
+	std::error_code error;
+	std::filesystem::create_directories(bakedPath.parent_path(), error);
+
+	if (errorCode == KTX_SUCCESS)
+	{
+		errorCode = ktxTexture_WriteToNamedFile(texture, temporaryPath.generic_string().c_str());
+	}
+	ktxTexture_Destroy(texture);
+
+	if (errorCode != KTX_SUCCESS)
+	{
+		LogError("Failed to write the baked texture: " + bakedPath.generic_string() + " " + ktxErrorString(errorCode));
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+
+	std::filesystem::rename(temporaryPath, bakedPath, error);
+	if (error)
+	{
+		LogError("Failed to write the baked texture: " + bakedPath.generic_string() + " " + error.message());
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+
+	LogInfo("Baked texture: " + bakedPath.generic_string() + " (" + std::to_string(levels.size()) + " levels, " + std::to_string(uncompressedSize) + " -> " + std::to_string(compressedSize) + " bytes)");
+	return true;
+}
+
+void TextureBaker::Bake(const std::vector<std::string>& modelPaths)
+{
+	const std::filesystem::path assetPath = VulkanContext::GetAssetPath();
+
+	std::vector<std::string> gltfPaths = modelPaths;
+	if (gltfPaths.empty())
+	{
+		std::error_code error;
+		for (const auto& entry : std::filesystem::directory_iterator(assetPath, error))
+		{
+			const std::string extension = entry.path().extension().string();
+			if (extension == ".gltf" || extension == ".glb")
+			{
+				gltfPaths.push_back(entry.path().filename().string());
+			}
+		}
+	}
+
+	//Every image gets one role, an image that materials use for more than one keeps the first
+	std::map<std::filesystem::path, TextureRole> textures{};
+	//Images embedded in a .glb are not baked, they get decoded out of the mapped file at load
+	auto addTexture = [&textures, &assetPath](const ParsedImage& image, const TextureRole role)
+	{
+		if (image.IsEmpty() || image.IsEmbedded()) return;
+
+		const auto [iterator, isNew] = textures.try_emplace(assetPath / image.path, role);
+		if (!isNew && iterator->second != role)
+		{
+			LogWarning(image.path + " is used for more than one texture role, it gets baked for the first one");
+		}
+	};
+
+	for (const std::string& gltfPath : gltfPaths)
+	{
+		const std::optional<fastgltf::Asset> gltf = GLTFLoader::Load((assetPath / gltfPath).generic_string());
+		if (!gltf)
+		{
+			LogError("Failed to load: " + gltfPath);
+			continue;
+		}
+
+		for (const ParsedMaterial& material : GLTFLoader::ParseMaterials(gltf.value(), gltfPath))
+		{
+			addTexture(material.baseColorTexture, TextureRole::Albedo);
+			addTexture(material.normalTexture, TextureRole::Normal);
+			addTexture(material.metallicRoughnessTexture, TextureRole::MetalRoughness);
+		}
+	}
+
+	const auto bakeStart = std::chrono::steady_clock::now();
+
+	//Every texture is independent, they get compressed on the ThreadPool
+	uint32_t upToDateCount{};
+	std::vector<std::future<bool>> bakes{};
+	for (const auto& [sourcePath, role] : textures)
+	{
+		if (IsUpToDate(sourcePath, GetBakedPath(sourcePath)))
+		{
+			++upToDateCount;
+			continue;
+		}
+
+		bakes.push_back(ThreadPool::Enqueue([&sourcePath, role] { return BakeTexture(sourcePath, role); }));
+	}
+
+	uint32_t bakedCount{};
+	for (std::future<bool>& bake : bakes)
+	{
+		bakedCount += bake.get() ? 1 : 0;
+	}
+
+	const float bakeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - bakeStart).count();
+	LogInfo("Baked " + std::to_string(bakedCount) + "/" + std::to_string(bakes.size()) + " textures in " + std::to_string(bakeMs) + "ms, " + std::to_string(upToDateCount) + " were up to date");
+}
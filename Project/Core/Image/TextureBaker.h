@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+// Offline bake of the textures that glTF materials reference into block compressed .ktx files under Assets/Cache/Textures
+// Albedo becomes BC1 (BC3 when it has alpha) in sRGB, normal maps BC5 with only x and y, metal/roughness BC1
+// The whole mip chain is in the file, so the loader uploads it as is instead of decoding and blitting at startup
+namespace TextureBaker
+{
+	enum class TextureRole : uint8_t
+	{
+		Albedo,
+		Normal,
+		MetalRoughness
+	};
+
+	// Turn off to always decode the source images
+	inline bool UseBakedTextures = true;
+
+	// Set on device creation, without textureCompressionBC the loader keeps decoding the source images
+	inline bool IsBlockCompressionSupported = false;
+
+	[[nodiscard]] std::filesystem::path GetBakedPath(const std::filesystem::path& sourcePath);
+
+	// Returns nothing when there is no bake, when it is older than the source or when the device can not sample it
+	[[nodiscard]] std::optional<std::filesystem::path> FindBaked(const std::filesystem::path& sourcePath);
+
+	// Decodes the source, builds the mip chain on the CPU, compresses every level and writes the .ktx
+	bool BakeTexture(const std::filesystem::path& sourcePath, TextureRole role);
+
+	// Bakes every texture of the given glTF models that has no up to date bake, used by the --bake-textures command line mode
+	// No paths means every .gltf/.glb in the asset folder
+	void Bake(const std::vector<std::string>& modelPaths);
+}
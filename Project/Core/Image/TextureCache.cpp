@@ -0,0 +1,163 @@
+#include "TextureCache.h"
+
+#include <vector>
+
+#include "Core/FrameRing.h"
+#include "Core/Logger.h"
+#include "vulkanbase/VulkanTypes.h"
+
+
+void TextureCache::Cleanup(const VulkanContext* vulkanContext)
+{
+	for (Entry& entry : m_Entries)
+	{
+		if (!entry.texture->IsPendingKill())
+		{
+			entry.texture->Cleanup(vulkanContext->device);
+		}
+	}
+
+	m_Entries.clear();
+	m_Lookup.clear();
+	m_ResidentBytes = 0;
+}
+
+std::shared_ptr<Texture> TextureCache::Load(const std::filesystem::path& path, VulkanContext* vulkanContext, ColorType colorType, TextureType textureType)
+{
+	if (std::shared_ptr<Texture> texture = Find(path, colorType, textureType))
+	{
+		return texture;
+	}
+
+	auto texture = std::make_shared<Texture>(path, vulkanContext, colorType, textureType);
+	Insert(path, vulkanContext, colorType, textureType, texture);
+	return texture;
+}
+
+std::shared_ptr<Texture> TextureCache::Find(const std::filesystem::path& path, ColorType colorType, TextureType textureType)
+{
+	const auto lookup = m_Lookup.find(GetKey(path, colorType, textureType));
+	if (lookup == m_Lookup.end()) return nullptr;
+
+	//Destroyed by someone else, it gets loaded again
+	const EntryList::iterator entry = lookup->second;
+	if (entry->texture->IsPendingKill())
+	{
+		Erase(entry);
+		return nullptr;
+	}
+
+	++m_Stats.hits;
+	Touch(entry);
+	return entry->texture;
+}
+
+void TextureCache::Insert(const std::filesystem::path& path, VulkanContext* vulkanContext, ColorType colorType, TextureType textureType, const std::shared_ptr<Texture>& texture)
+{
+	m_pContext = vulkanContext;
+	++m_Stats.misses;
+
+	std::string key = GetKey(path, colorType, textureType);
+	if (const auto lookup = m_Lookup.find(key); lookup != m_Lookup.end())
+	{
+		LogWarning("Texture is already cached, the old one gets replaced: " + path.generic_string());
+		Erase(lookup->second);
+	}
+
+	texture->SetCached(true);
+
+	Entry& entry = m_Entries.emplace_front();
+	entry.key = key;
+	entry.texture = texture;
+	entry.sizeBytes = texture->GetMemoryRequirements().size;
+	entry.lastUsedFrame = FrameRing::GetFrameNumber();
+
+	m_Lookup.emplace(std::move(key), m_Entries.begin());
+	m_ResidentBytes += entry.sizeBytes;
+
+	Trim();
+}
+
+void TextureCache::Trim()
+{
+	if (m_ResidentBytes <= BudgetBytes) return;
+
+	//Oldest first, only textures no descriptor set holds anymore
+	const uint64_t frameNumber = FrameRing::GetFrameNumber();
+	VkDeviceSize residentBytes = m_ResidentBytes;
+	std::vector<EntryList::iterator> evictions;
+	for (auto entry = m_Entries.end(); entry != m_Entries.begin() && residentBytes > BudgetBytes;)
+	{
+		--entry;
+		if (entry->texture.use_count() > 1 || entry->lastUsedFrame >= frameNumber) continue;
+
+		residentBytes -= entry->sizeBytes;
+		evictions.push_back(entry);
+	}
+
+	if (evictions.empty()) return;
+
+	//The frames in flight can still sample a texture of a material that is gone
+	FrameRing::WaitForAllFrames();
+	for (const EntryList::iterator entry : evictions)
+	{
+		Erase(entry);
+		++m_Stats.evictions;
+	}
+}
+
+void TextureCache::OnImGui()
+{
+	constexpr double megabyte = 1024.0 * 1024.0;
+
+	ImGui::Begin("Info");
+	ImGui::SeparatorText("Texture Cache");
+	ImGui::Text("Resident: %u textures, %.2f / %.2f MB", static_cast<uint32_t>(m_Entries.size()), static_cast<double>(m_ResidentBytes) / megabyte, static_cast<double>(BudgetBytes) / megabyte);
+	ImGui::Text("Hits: %u, misses: %u, evictions: %u", m_Stats.hits, m_Stats.misses, m_Stats.evictions);
+
+	int budgetMegabytes = static_cast<int>(BudgetBytes / (1024 * 1024));
+	if (ImGui::SliderInt("Budget (MB)", &budgetMegabytes, 16, 4096))
+	{
+		BudgetBytes = static_cast<VkDeviceSize>(budgetMegabytes) * 1024 * 1024;
+		Trim();
+	}
+
+	if (ImGui::TreeNode("Resident textures"))
+	{
+		for (const Entry& entry : m_Entries)
+		{
+			//The cache holds one reference itself
+			ImGui::Text("%s: %.2f MB, %ld users", entry.key.c_str(), static_cast<double>(entry.sizeBytes) / megabyte, entry.texture.use_count() - 1);
+		}
+		ImGui::TreePop();
+	}
+	ImGui::End();
+}
+
+std::string TextureCache::GetKey(const std::filesystem::path& path, ColorType colorType, TextureType textureType)
+{
+	//The same file reached through different relative paths has to end up in one entry
+	std::error_code error;
+	const std::filesystem::path canonicalPath = std::filesystem::weakly_canonical(VulkanContext::GetAssetPath() / path, error);
+	const std::string pathKey = error ? (VulkanContext::GetAssetPath() / path).lexically_normal().generic_string() : canonicalPath.generic_string();
+
+	return pathKey + ":" + std::to_string(static_cast<int>(colorType)) + ":" + std::to_string(static_cast<int>(textureType));
+}
+
+void TextureCache::Touch(EntryList::iterator entry)
+{
+	entry->lastUsedFrame = FrameRing::GetFrameNumber();
+	m_Entries.splice(m_Entries.begin(), m_Entries, entry);
+}
+
+void TextureCache::Erase(EntryList::iterator entry)
+{
+	if (!entry->texture->IsPendingKill())
+	{
+		entry->texture->Cleanup(m_pContext->device);
+	}
+
+	m_ResidentBytes -= entry->sizeBytes;
+	m_Lookup.erase(entry->key);
+	m_Entries.erase(entry);
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vulkan/vulkan.h>
+
+#include "Texture.h"
+
+class VulkanContext;
+
+struct TextureCacheStats
+{
+	uint32_t hits{};
+	uint32_t misses{};
+	uint32_t evictions{};
+};
+
+// Textures loaded from a file, shared by everything that asks for the same file in the same ColorType and TextureType
+// The cache owns them: descriptor sets only drop their reference, the cache destroys them on eviction or Cleanup
+// Once the resident textures go over the budget the least recently used ones that nothing references anymore get evicted
+// Main thread only, like the uploads
+class TextureCache final
+{
+public:
+	TextureCache() = default;
+	~TextureCache() = default;
+	TextureCache(const TextureCache&) = delete;
+	TextureCache& operator=(const TextureCache&) = delete;
+	TextureCache(TextureCache&&) = delete;
+	TextureCache& operator=(TextureCache&&) = delete;
+
+	inline static VkDeviceSize BudgetBytes{512ull * 1024 * 1024};
+
+	static void Cleanup(const VulkanContext* vulkanContext);
+
+	// The path is relative to the asset folder or absolute
+	static std::shared_ptr<Texture> Load(const std::filesystem::path& path, VulkanContext* vulkanContext, ColorType colorType, TextureType textureType = TextureType::TEXTURE_2D);
+	// Counts as a hit, nothing when the file is not resident
+	[[nodiscard]] static std::shared_ptr<Texture> Find(const std::filesystem::path& path, ColorType colorType, TextureType textureType = TextureType::TEXTURE_2D);
+	// For a texture of the file that got created elsewhere (a decode on the ThreadPool), counts as a miss
+	static void Insert(const std::filesystem::path& path, VulkanContext* vulkanContext, ColorType colorType, TextureType textureType, const std::shared_ptr<Texture>& texture);
+
+	// Evicts until the resident textures fit the budget again or everything left is still referenced
+	// Textures used this frame are never evicted, their uploads can still be in the open UploadBatch
+	static void Trim();
+
+	[[nodiscard]] static VkDeviceSize GetResidentBytes() { return m_ResidentBytes; }
+	[[nodiscard]] static const TextureCacheStats& GetStats() { return m_Stats; }
+
+	static void OnImGui();
+
+private:
+	struct Entry
+	{
+		std::string key;
+		std::shared_ptr<Texture> texture;
+		VkDeviceSize sizeBytes{};
+		uint64_t lastUsedFrame{};
+	};
+
+	using EntryList = std::list<Entry>;
+
+	[[nodiscard]] static std::string GetKey(const std::filesystem::path& path, ColorType colorType, TextureType textureType);
+	static void Touch(EntryList::iterator entry);
+	static void Erase(EntryList::iterator entry);
+
+	// Most recently used at the front
+	inline static EntryList m_Entries{};
+	inline static std::unordered_map<std::string, EntryList::iterator> m_Lookup{};
+	inline static const VulkanContext* m_pContext{};
+
+	inline static VkDeviceSize m_ResidentBytes{};
+	inline static TextureCacheStats m_Stats{};
+};
@@ -0,0 +1,151 @@
+#include "IndirectRenderer.h"
+
+#include <algorithm>
+#include <bit>
+#include <string>
+
+#include "Buffer.h"
+#include "Descriptor.h"
+#include "Logger.h"
+
+
+void IndirectRenderer::Init(VulkanContext* vulkanContext)
+{
+	m_pContext = vulkanContext;
+
+	for (uint32_t frameIndex{}; frameIndex < FrameRing::GetFrameCount(); ++frameIndex)
+	{
+		CreateBuffers(m_Frames[frameIndex], 1024, 64);
+	}
+
+	LogInfo(std::string("GPU driven rendering ") + (m_IsSupported ? "supported" : "not supported, every draw gets recorded on the CPU"));
+}
+
+void IndirectRenderer::Cleanup()
+{
+	for (FrameBuffers& frame : m_Frames)
+	{
+		DestroyBuffers(frame);
+	}
+}
+
+GpuInstance* IndirectRenderer::MapInstances(uint32_t instanceCount, uint32_t batchCount)
+{
+	FrameBuffers& frame = m_Frames[FrameRing::GetFrameIndex()];
+
+	//The fence of this frame signaled, so the counts it wrote last time are final
+	if (frame.wasCulled)
+	{
+		vmaInvalidateAllocation(Allocator::vmaAllocator, frame.countMemory, 0, VK_WHOLE_SIZE);
+
+		m_LastVisibleCount = 0;
+		for (uint32_t batch{}; batch < frame.batchCount; ++batch)
+		{
+			m_LastVisibleCount += frame.pCounts[batch];
+		}
+		frame.wasCulled = false;
+	}
+
+	//Only this frame's copies get replaced, the GPU is done with them and the other frames keep theirs
+	if (instanceCount > frame.instanceCapacity || batchCount > frame.batchCapacity)
+	{
+		const uint32_t instanceCapacity = std::max(frame.instanceCapacity, std::bit_ceil(instanceCount));
+		const uint32_t batchCapacity = std::max(frame.batchCapacity, std::bit_ceil(batchCount));
+
+		DestroyBuffers(frame);
+		CreateBuffers(frame, instanceCapacity, batchCapacity);
+	}
+
+	frame.batchCount = batchCount;
+	m_InstanceCount = instanceCount;
+	return frame.pInstances;
+}
+
+void IndirectRenderer::WriteDescriptors(Descriptor::DescriptorWriter& writer)
+{
+	const FrameBuffers& frame = m_Frames[FrameRing::GetFrameIndex()];
+
+	writer.WriteBuffer(1, frame.instanceBuffer, sizeof(GpuInstance) * frame.instanceCapacity, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+	writer.WriteBuffer(2, frame.commandBuffer, sizeof(VkDrawIndexedIndirectCommand) * frame.instanceCapacity, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+	writer.WriteBuffer(3, frame.countBuffer, sizeof(uint32_t) * frame.batchCapacity, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+}
+
+void IndirectRenderer::BeginCulling(VkCommandBuffer commandBuffer)
+{
+	FrameBuffers& frame = m_Frames[FrameRing::GetFrameIndex()];
+	frame.wasCulled = true;
+
+	vkCmdFillBuffer(commandBuffer, frame.countBuffer, 0, VK_WHOLE_SIZE, 0);
+
+	VkMemoryBarrier memoryBarrier{};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+}
+
+void IndirectRenderer::EndCulling(VkCommandBuffer commandBuffer)
+{
+	VkMemoryBarrier memoryBarrier{};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+}
+
+void IndirectRenderer::DrawBatch(VkCommandBuffer commandBuffer, uint32_t batch, uint32_t firstCommand, uint32_t maxDrawCount)
+{
+	const FrameBuffers& frame = m_Frames[FrameRing::GetFrameIndex()];
+
+	vkCmdDrawIndexedIndirectCount(commandBuffer,
+		frame.commandBuffer, sizeof(VkDrawIndexedIndirectCommand) * firstCommand,
+		frame.countBuffer, sizeof(uint32_t) * batch,
+		maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void IndirectRenderer::OnImGui()
+{
+	ImGui::Begin("Info");
+	ImGui::SeparatorText("GPU Culling");
+	if (!m_IsSupported)
+	{
+		ImGui::Text("Not supported by this device");
+	}
+	else
+	{
+		ImGui::Checkbox("Cull and draw on the GPU", &GpuCulling);
+	}
+	ImGui::Text("Instances: %u", m_InstanceCount);
+	if (IsEnabled())
+	{
+		ImGui::Text("Visible after culling: %u", m_LastVisibleCount);
+	}
+	ImGui::End();
+}
+
+void IndirectRenderer::CreateBuffers(FrameBuffers& frame, uint32_t instanceCapacity, uint32_t batchCapacity)
+{
+	frame.instanceCapacity = instanceCapacity;
+	frame.batchCapacity = batchCapacity;
+
+	VmaAllocationInfo allocInfo;
+	Core::Buffer::CreateBuffer(sizeof(GpuInstance) * instanceCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, frame.instanceBuffer, frame.instanceMemory, true, true);
+	vmaGetAllocationInfo(Allocator::vmaAllocator, frame.instanceMemory, &allocInfo);
+	frame.pInstances = static_cast<GpuInstance*>(allocInfo.pMappedData);
+
+	Core::Buffer::CreateBuffer(sizeof(VkDrawIndexedIndirectCommand) * instanceCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, frame.commandBuffer, frame.commandMemory);
+
+	Core::Buffer::CreateBuffer(sizeof(uint32_t) * batchCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, frame.countBuffer, frame.countMemory, true, true);
+	vmaGetAllocationInfo(Allocator::vmaAllocator, frame.countMemory, &allocInfo);
+	frame.pCounts = static_cast<uint32_t*>(allocInfo.pMappedData);
+}
+
+void IndirectRenderer::DestroyBuffers(FrameBuffers& frame)
+{
+	if (frame.instanceBuffer == VK_NULL_HANDLE) return;
+
+	vmaDestroyBuffer(Allocator::vmaAllocator, frame.instanceBuffer, frame.instanceMemory);
+	vmaDestroyBuffer(Allocator::vmaAllocator, frame.commandBuffer, frame.commandMemory);
+	vmaDestroyBuffer(Allocator::vmaAllocator, frame.countBuffer, frame.countMemory);
+	frame = {};
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include "FrameRing.h"
+#include "VmaUsage.h"
+
+class VulkanContext;
+namespace Descriptor { class DescriptorWriter; }
+
+// Per draw data the shaders read through gl_InstanceIndex, has to match Instance in shaders/Instance.glsl
+struct GpuInstance
+{
+	glm::mat4 transform{1};
+	// Local space center and radius, a negative radius never gets culled
+	glm::vec4 boundingSphere{0, 0, 0, -1};
+	uint32_t indexCount{};
+	uint32_t firstIndex{};
+	int32_t vertexOffset{};
+	uint32_t batch{};
+	uint32_t firstCommand{};
+	uint32_t padding[3]{};
+};
+static_assert(sizeof(GpuInstance) == 112, "GpuInstance has to keep the std430 layout of shaders/Instance.glsl");
+
+// Owns the per frame buffers of the GPU driven path
+// Instances: written by the CPU every frame, read by the culling pass and by every mesh vertex shader
+// Commands: one VkDrawIndexedIndirectCommand slot per instance, the culling pass compacts the visible ones to the front of their batch
+// Counts: one draw count per batch, read by vkCmdDrawIndexedIndirectCount
+// All three are bound in the global set (bindings 1 to 3), a frame only ever touches its own copies
+class IndirectRenderer final
+{
+public:
+	IndirectRenderer() = default;
+	~IndirectRenderer() = default;
+	IndirectRenderer(const IndirectRenderer&) = delete;
+	IndirectRenderer& operator=(const IndirectRenderer&) = delete;
+	IndirectRenderer(IndirectRenderer&&) = delete;
+	IndirectRenderer& operator=(IndirectRenderer&&) = delete;
+
+	// Turn off to record every draw from the CPU again, the instance buffer is used either way
+	inline static bool GpuCulling{true};
+
+	static void Init(VulkanContext* vulkanContext);
+	static void Cleanup();
+
+	// Set while creating the device, needs drawIndirectCount, multiDrawIndirect and drawIndirectFirstInstance
+	static void SetSupported(bool isSupported) { m_IsSupported = isSupported; }
+	[[nodiscard]] static bool IsEnabled() { return m_IsSupported && GpuCulling; }
+
+	// Grows the buffers of this frame if needed and returns the mapped instances, call before GlobalDescriptor::UpdateFrameConstants
+	[[nodiscard]] static GpuInstance* MapInstances(uint32_t instanceCount, uint32_t batchCount);
+	[[nodiscard]] static uint32_t GetInstanceCount() { return m_InstanceCount; }
+
+	static void WriteDescriptors(Descriptor::DescriptorWriter& writer);
+
+	// Clears the draw counts, the culling dispatch goes between these two
+	static void BeginCulling(VkCommandBuffer commandBuffer);
+	// Makes the written commands visible to the indirect draws
+	static void EndCulling(VkCommandBuffer commandBuffer);
+
+	static void DrawBatch(VkCommandBuffer commandBuffer, uint32_t batch, uint32_t firstCommand, uint32_t maxDrawCount);
+
+	static void OnImGui();
+
+private:
+	struct FrameBuffers
+	{
+		VkBuffer instanceBuffer{VK_NULL_HANDLE};
+		VmaAllocation instanceMemory{};
+		GpuInstance* pInstances{};
+		uint32_t instanceCapacity{};
+
+		VkBuffer commandBuffer{VK_NULL_HANDLE};
+		VmaAllocation commandMemory{};
+
+		//Host visible so the visible count can be read back once the frame fence signaled
+		VkBuffer countBuffer{VK_NULL_HANDLE};
+		VmaAllocation countMemory{};
+		uint32_t* pCounts{};
+		uint32_t batchCapacity{};
+		uint32_t batchCount{};
+		bool wasCulled{false};
+	};
+
+	static void CreateBuffers(FrameBuffers& frame, uint32_t instanceCapacity, uint32_t batchCapacity);
+	static void DestroyBuffers(FrameBuffers& frame);
+
+	inline static VulkanContext* m_pContext{};
+	inline static bool m_IsSupported{false};
+
+	inline static std::array<FrameBuffers, FrameRing::MaxFramesInFlight> m_Frames{};
+	inline static uint32_t m_InstanceCount{};
+	inline static uint32_t m_LastVisibleCount{};
+};
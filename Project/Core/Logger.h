@@ -3,6 +3,7 @@
 #include <string>
 #include <csignal>
 #include <cstdint>
+#include <mutex>
 
 #include "imgui.h"
 
@@ -50,6 +51,7 @@ namespace VulkanLogger
         ImGuiTextBuffer     Buf;
         ImGuiTextFilter     Filter;
         ImVector<int>       LineOffsets; // Index to lines offset. We maintain this with AddLog() calls.
+        std::recursive_mutex Mutex;      // Worker threads log too, Render reads the buffer on the main thread
 
         ImguiLogging()
         {
@@ -58,6 +60,7 @@ namespace VulkanLogger
 
         void ClearWindow()
         {
+            std::scoped_lock lock(Mutex);
             Buf.clear();
             LineOffsets.clear();
             LineOffsets.push_back(0);
@@ -65,6 +68,7 @@ namespace VulkanLogger
 
         void AddLog(const char* fmt, ...) IM_FMTARGS(2)
         {
+            std::scoped_lock lock(Mutex);
             int old_size = Buf.size();
             va_list args;
             va_start(args, fmt);
@@ -89,6 +93,8 @@ namespace VulkanLogger
                 return;
             }
 
+            std::scoped_lock lock(Mutex);
+
             // Main window
             const bool clear = ImGui::Button("Clear");
             ImGui::SameLine();
@@ -162,6 +168,7 @@ namespace VulkanLogger
         }
 
 
+        std::scoped_lock lock(Log.Mutex);
         Log.AddLog("%s %s\n", prefix.c_str(), message.c_str());
         std::cout << colorCode << prefix << " " << message << "\033[0m" << std::endl;
 
@@ -0,0 +1,64 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& filePath)
+{
+	HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return;
+	m_FileHandle = file;
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) return;
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) return;
+	m_MappingHandle = mapping;
+
+	m_pData = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	m_Size = m_pData ? static_cast<size_t>(fileSize.QuadPart) : 0;
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_pData) UnmapViewOfFile(m_pData);
+	if (m_MappingHandle) CloseHandle(m_MappingHandle);
+	if (m_FileHandle) CloseHandle(m_FileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& filePath)
+{
+	m_FileDescriptor = open(filePath.c_str(), O_RDONLY);
+	if (m_FileDescriptor < 0) return;
+
+	struct stat fileStats{};
+	if (fstat(m_FileDescriptor, &fileStats) != 0 || fileStats.st_size == 0) return;
+
+	void* data = mmap(nullptr, static_cast<size_t>(fileStats.st_size), PROT_READ, MAP_PRIVATE, m_FileDescriptor, 0);
+	if (data == MAP_FAILED) return;
+
+	m_pData = static_cast<const uint8_t*>(data);
+	m_Size = static_cast<size_t>(fileStats.st_size);
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_pData) munmap(const_cast<uint8_t*>(m_pData), m_Size);
+	if (m_FileDescriptor >= 0) close(m_FileDescriptor);
+}
+
+#endif
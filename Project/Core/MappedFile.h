@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+
+// Read only memory mapping of a whole file, the pages get loaded by the OS on first access
+class MappedFile final
+{
+public:
+	explicit MappedFile(const std::filesystem::path& filePath);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&&) = delete;
+	MappedFile& operator=(MappedFile&&) = delete;
+
+	[[nodiscard]] bool IsValid() const { return m_pData != nullptr; }
+	[[nodiscard]] const uint8_t* GetData() const { return m_pData; }
+	[[nodiscard]] size_t GetSize() const { return m_Size; }
+
+private:
+	const uint8_t* m_pData{};
+	size_t m_Size{};
+
+#ifdef _WIN32
+	void* m_FileHandle{};
+	void* m_MappingHandle{};
+#else
+	int m_FileDescriptor{-1};
+#endif
+};
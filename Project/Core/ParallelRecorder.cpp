@@ -0,0 +1,132 @@
+#include "ParallelRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+#include "Logger.h"
+#include "QueueFamilyIndices.h"
+#include "SwapChain.h"
+#include "Patterns/ThreadPool.h"
+#include "vulkanbase/VulkanTypes.h"
+
+
+void ParallelRecorder::Init(const VulkanContext* vulkanContext)
+{
+	m_pContext = vulkanContext;
+	m_ChunkCount = std::clamp(ThreadPool::GetThreadCount() + 1, 1u, MaxChunkCount);
+
+	const QueueFamilyIndices queueFamilyIndices = QueueFamilyIndices::FindQueueFamilies(vulkanContext->physicalDevice, SwapChain::GetSurface());
+
+	//Transient, the command buffers only live for one frame
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+
+	for (uint32_t frameIndex{}; frameIndex < FrameRing::GetFrameCount(); ++frameIndex)
+	{
+		FrameData& frame = m_Frames[frameIndex];
+		frame.chunks.resize(m_ChunkCount);
+		for (ChunkPool& chunk : frame.chunks)
+		{
+			VulkanCheck(vkCreateCommandPool(vulkanContext->device, &poolInfo, nullptr, &chunk.commandPool), "Failed to create a recording command pool")
+		}
+	}
+
+	LogInfo("Command recording on " + std::to_string(m_ChunkCount) + " threads");
+}
+
+void ParallelRecorder::Cleanup(const VulkanContext* vulkanContext)
+{
+	//Destroying the pool frees its command buffers
+	for (FrameData& frame : m_Frames)
+	{
+		for (const ChunkPool& chunk : frame.chunks)
+		{
+			vkDestroyCommandPool(vulkanContext->device, chunk.commandPool, nullptr);
+		}
+		frame = {};
+	}
+}
+
+void ParallelRecorder::BeginFrame()
+{
+	m_LastRecordMs = m_RecordMs;
+	m_RecordMs = 0.0f;
+
+	FrameData& frame = m_Frames[FrameRing::GetFrameIndex()];
+	m_LastSecondaryCount = frame.usedCommandBuffers * m_ChunkCount;
+	frame.usedCommandBuffers = 0;
+
+	for (ChunkPool& chunk : frame.chunks)
+	{
+		vkResetCommandPool(m_pContext->device, chunk.commandPool, 0);
+		for (CommandBuffer& commandBuffer : chunk.commandBuffers)
+		{
+			commandBuffer.State = CommandBufferState::Ready;
+		}
+	}
+}
+
+void ParallelRecorder::Record(VkCommandBuffer primaryCommandBuffer, const RenderingFormats& formats, const std::function<void(VkCommandBuffer, uint32_t)>& recordChunk)
+{
+	const auto recordStart = std::chrono::steady_clock::now();
+	FrameData& frame = m_Frames[FrameRing::GetFrameIndex()];
+
+	//Allocating from a pool is not thread safe either, so it happens here before any task starts
+	const uint32_t commandBufferIndex = frame.usedCommandBuffers++;
+	for (ChunkPool& chunk : frame.chunks)
+	{
+		if (chunk.commandBuffers.size() > commandBufferIndex) continue;
+
+		chunk.commandBuffers.emplace_back();
+		CommandBufferManager::CreateCommandBuffer(m_pContext, chunk.commandBuffers.back(), false, chunk.commandPool);
+	}
+
+	VkCommandBufferInheritanceRenderingInfo renderingInheritance{};
+	renderingInheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+	renderingInheritance.colorAttachmentCount = formats.colorFormat != VK_FORMAT_UNDEFINED ? 1 : 0;
+	renderingInheritance.pColorAttachmentFormats = &formats.colorFormat;
+	renderingInheritance.depthAttachmentFormat = formats.depthFormat;
+	renderingInheritance.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkCommandBufferInheritanceInfo inheritanceInfo{};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.pNext = &renderingInheritance;
+
+	//The main thread records a chunk as well, a ThreadPool busy with asset loads only makes this slower
+	ThreadPool::ParallelFor(m_ChunkCount, [&](size_t chunkIndex)
+	{
+		CommandBuffer& commandBuffer = frame.chunks[chunkIndex].commandBuffers[commandBufferIndex];
+		CommandBufferManager::BeginCommandBufferRecording(commandBuffer, true, false, true, &inheritanceInfo);
+		recordChunk(commandBuffer.Handle, static_cast<uint32_t>(chunkIndex));
+		CommandBufferManager::EndCommandBufferRecording(commandBuffer);
+	});
+
+	std::array<VkCommandBuffer, MaxChunkCount> secondaryCommandBuffers{};
+	for (uint32_t chunkIndex{}; chunkIndex < m_ChunkCount; ++chunkIndex)
+	{
+		secondaryCommandBuffers[chunkIndex] = frame.chunks[chunkIndex].commandBuffers[commandBufferIndex].Handle;
+	}
+	vkCmdExecuteCommands(primaryCommandBuffer, m_ChunkCount, secondaryCommandBuffers.data());
+
+	m_RecordMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - recordStart).count();
+}
+
+void ParallelRecorder::OnImGui()
+{
+	ImGui::Begin("Info");
+	ImGui::SeparatorText("Command Recording");
+	if (m_ChunkCount > 1)
+	{
+		const std::string label = "Record on " + std::to_string(m_ChunkCount) + " threads";
+		ImGui::Checkbox(label.c_str(), &UseSecondaryCommandBuffers);
+	}
+	else
+	{
+		ImGui::Text("Single threaded, the ThreadPool has no workers");
+	}
+	ImGui::Text("Secondary command buffers: %u (recorded in %.3f ms)", m_LastSecondaryCount, m_LastRecordMs);
+	ImGui::End();
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "CommandBuffer.h"
+#include "FrameRing.h"
+
+class VulkanContext;
+
+// Attachment formats of the rendering scope the secondary command buffers continue, have to match the vkCmdBeginRendering they get executed in
+struct RenderingFormats
+{
+	VkFormat colorFormat{VK_FORMAT_UNDEFINED};
+	VkFormat depthFormat{VK_FORMAT_UNDEFINED};
+};
+
+// Records the draws of a pass on the ThreadPool, every chunk into its own secondary command buffer
+// Every chunk has its own command pool per frame in flight, only the task recording that chunk touches it
+// The pools of a frame get reset together once its fence signaled, so no command buffer gets freed one by one
+class ParallelRecorder final
+{
+public:
+	ParallelRecorder() = default;
+	~ParallelRecorder() = default;
+	ParallelRecorder(const ParallelRecorder&) = delete;
+	ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+	ParallelRecorder(ParallelRecorder&&) = delete;
+	ParallelRecorder& operator=(ParallelRecorder&&) = delete;
+
+	// Turn off to record every pass straight into the primary command buffer again
+	inline static bool UseSecondaryCommandBuffers{true};
+
+	// One chunk per worker of the ThreadPool plus the main thread
+	static void Init(const VulkanContext* vulkanContext);
+	static void Cleanup(const VulkanContext* vulkanContext);
+	// Resets the pools of this frame, call after FrameRing::BeginFrame
+	static void BeginFrame();
+
+	[[nodiscard]] static bool IsEnabled() { return UseSecondaryCommandBuffers && m_ChunkCount > 1; }
+	[[nodiscard]] static uint32_t GetChunkCount() { return m_ChunkCount; }
+	// A rendering scope that contains a Record can not contain any other command
+	[[nodiscard]] static VkRenderingFlags GetRenderingFlags() { return IsEnabled() ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0; }
+
+	// Calls recordChunk for every chunk in parallel, then executes the secondary command buffers in chunk order
+	// Secondary command buffers inherit no state, recordChunk has to set the viewport and bind everything it draws with
+	static void Record(VkCommandBuffer primaryCommandBuffer, const RenderingFormats& formats, const std::function<void(VkCommandBuffer, uint32_t)>& recordChunk);
+
+	static void OnImGui();
+
+private:
+	struct ChunkPool
+	{
+		VkCommandPool commandPool{VK_NULL_HANDLE};
+		// One per Record of the frame, they stay allocated and get reused once the pool got reset
+		std::vector<CommandBuffer> commandBuffers{};
+	};
+
+	struct FrameData
+	{
+		std::vector<ChunkPool> chunks{};
+		uint32_t usedCommandBuffers{};
+	};
+
+	static constexpr uint32_t MaxChunkCount = 16;
+
+	inline static const VulkanContext* m_pContext{};
+	inline static uint32_t m_ChunkCount{};
+	inline static std::array<FrameData, FrameRing::MaxFramesInFlight> m_Frames{};
+
+	inline static float m_RecordMs{};
+	inline static float m_LastRecordMs{};
+	inline static uint32_t m_LastSecondaryCount{};
+};
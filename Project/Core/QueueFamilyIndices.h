@@ -6,6 +6,8 @@ struct QueueFamilyIndices
 {
 	std::optional<uint32_t> graphicsFamily;
 	std::optional<uint32_t> presentFamily;
+	// A family with compute but no graphics, its queue runs next to the graphics queue
+	std::optional<uint32_t> computeFamily;
 
 	static QueueFamilyIndices FindQueueFamilies(const VkPhysicalDevice& physicalDevice, const VkSurfaceKHR& surface) 
 	{
@@ -32,6 +34,16 @@ struct QueueFamilyIndices
 			++i;
 		}
 
+		for (uint32_t familyIndex{}; familyIndex < queueFamilyCount; ++familyIndex)
+		{
+			const VkQueueFlags flags = queueFamilies[familyIndex].queueFlags;
+			if (flags & VK_QUEUE_COMPUTE_BIT && !(flags & VK_QUEUE_GRAPHICS_BIT))
+			{
+				indices.computeFamily = familyIndex;
+				break;
+			}
+		}
+
 		return indices;
 	}
 
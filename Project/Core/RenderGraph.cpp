@@ -0,0 +1,1284 @@
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <queue>
+#include <type_traits>
+
+#include "ColorAttachment.h"
+#include "DepthResource.h"
+#include "Logger.h"
+#include "Image/Texture.h"
+
+
+namespace
+{
+	VkImage GetVkImage(const GraphImage& image)
+	{
+		return std::visit([]<typename T>(const T& object) -> VkImage
+		{
+			if constexpr (std::is_same_v<T, std::monostate>) return VK_NULL_HANDLE;
+			else if constexpr (std::is_same_v<T, VkImage>) return object;
+			else return object ? object->GetImage() : VK_NULL_HANDLE;
+		}, image);
+	}
+
+	//The objects keep track of their layout themselves, their descriptors and attachment infos get written with it
+	void ApplyLayout(const GraphImage& image, VkImageLayout layout, bool isDiscard)
+	{
+		if (ColorAttachment* const* colorAttachment = std::get_if<ColorAttachment*>(&image); colorAttachment && *colorAttachment)
+		{
+			(*colorAttachment)->SetImageLayout(layout, isDiscard);
+		}
+		else if (DepthAttachment* const* depthAttachment = std::get_if<DepthAttachment*>(&image); depthAttachment && *depthAttachment)
+		{
+			(*depthAttachment)->SetImageLayout(layout, isDiscard);
+		}
+		else if (Texture* const* texture = std::get_if<Texture*>(&image); texture && *texture)
+		{
+			(*texture)->SetImageLayout(layout);
+		}
+	}
+
+	std::string ToMiB(VkDeviceSize bytes)
+	{
+		return std::to_string(static_cast<float>(bytes) / (1024.0f * 1024.0f)) + " MiB";
+	}
+}
+
+
+ImageHandle RenderGraph::Import(const std::string& name, const GraphImage& image, VkImageAspectFlags aspect, VkImageLayout finalLayout, VkPipelineStageFlags2 waitStage)
+{
+	Resource resource{};
+	resource.name = name;
+	resource.image = image;
+	resource.aspect = aspect;
+	resource.finalLayout = finalLayout;
+	resource.waitStage = waitStage;
+	m_Resources.emplace_back(std::move(resource));
+
+	m_Versions.push_back({static_cast<uint32_t>(m_Resources.size() - 1)});
+	m_IsCompiled = false;
+	return {static_cast<uint32_t>(m_Versions.size() - 1)};
+}
+
+ImageHandle RenderGraph::CreateTransient(const std::string& name, const GraphImage& image, const VkMemoryRequirements& memoryRequirements)
+{
+	Resource resource{};
+	resource.name = name;
+	resource.image = image;
+	resource.aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+	resource.memoryRequirements = memoryRequirements;
+	resource.isTransient = true;
+	m_Resources.emplace_back(std::move(resource));
+
+	m_Versions.push_back({static_cast<uint32_t>(m_Resources.size() - 1)});
+	m_IsCompiled = false;
+	return {static_cast<uint32_t>(m_Versions.size() - 1)};
+}
+
+void RenderGraph::SetImage(ImageHandle image, const GraphImage& graphImage)
+{
+	if (!IsValidImage(image, "SetImage")) return;
+	m_Resources[m_Versions[image.version].resource].image = graphImage;
+}
+
+void RenderGraph::SetConcurrent(ImageHandle image)
+{
+	if (!IsValidImage(image, "SetConcurrent")) return;
+
+	m_Resources[m_Versions[image.version].resource].isConcurrent = true;
+	m_IsCompiled = false;
+}
+
+RenderGraph::PassHandle RenderGraph::AddPass(const std::string& name, PassType type, ExecuteFunction execute)
+{
+	Pass pass{};
+	pass.name = name;
+	pass.type = type;
+	pass.execute = std::move(execute);
+	m_Passes.emplace_back(std::move(pass));
+
+	m_IsCompiled = false;
+	return static_cast<PassHandle>(m_Passes.size() - 1);
+}
+
+void RenderGraph::Read(PassHandle pass, ImageHandle image, ImageUsage usage)
+{
+	if (!IsValidPass(pass, "Read") || !IsValidImage(image, "Read")) return;
+	if (!AddAccess(pass, image, usage, false)) return;
+
+	m_Versions[image.version].readers.push_back(pass);
+}
+
+ImageHandle RenderGraph::Write(PassHandle pass, ImageHandle image, ImageUsage usage)
+{
+	if (!IsValidPass(pass, "Write") || !IsValidImage(image, "Write")) return {};
+
+	const Version& version = m_Versions[image.version];
+	if (version.isWritten)
+	{
+		LogError("RenderGraph: " + m_Passes[pass].name + " writes a version of " + m_Resources[version.resource].name + " that already got written, write the version the last Write returned");
+		m_HasDeclarationErrors = true;
+		return {};
+	}
+
+	if (!AddAccess(pass, image, usage, true)) return {};
+
+	m_Versions[image.version].isWritten = true;
+	m_Versions.push_back({m_Versions[image.version].resource, pass});
+	return {static_cast<uint32_t>(m_Versions.size() - 1)};
+}
+
+void RenderGraph::SetSideEffect(PassHandle pass)
+{
+	if (!IsValidPass(pass, "SetSideEffect")) return;
+
+	m_Passes[pass].hasSideEffect = true;
+	m_IsCompiled = false;
+}
+
+void RenderGraph::SetAsyncCompute(PassHandle pass)
+{
+	if (!IsValidPass(pass, "SetAsyncCompute")) return;
+
+	if (m_Passes[pass].type != PassType::Compute)
+	{
+		LogError("RenderGraph: " + m_Passes[pass].name + " is not a compute pass, only those can run on the compute queue");
+		m_HasDeclarationErrors = true;
+		return;
+	}
+
+	m_Passes[pass].isAsync = true;
+	m_IsCompiled = false;
+}
+
+void RenderGraph::EnableAsyncCompute(uint32_t graphicsFamily, uint32_t computeFamily)
+{
+	m_HasAsyncQueue = true;
+	m_QueueFamilies = {graphicsFamily, computeFamily};
+	m_IsCompiled = false;
+}
+
+bool RenderGraph::Compile()
+{
+	m_IsCompiled = false;
+
+	if (m_HasDeclarationErrors)
+	{
+		LogError("RenderGraph: Not compiled, the passes got declared with errors");
+		return false;
+	}
+
+	if (std::ranges::any_of(m_AliasSlots, [](const AliasSlot& slot) { return slot.memory != VK_NULL_HANDLE; }))
+	{
+		LogError("RenderGraph: Not compiled, the transients are still allocated, call Cleanup first");
+		return false;
+	}
+
+	CullPasses();
+
+	//Nothing gets loaded into a transient, a pass that reads one before anything wrote it reads garbage
+	bool isValid = true;
+	for (const Pass& pass : m_Passes)
+	{
+		if (pass.isCulled) continue;
+
+		for (const Access& access : pass.accesses)
+		{
+			const Version& version = m_Versions[access.version];
+			if (!access.isWrite && version.producer == NoPass && m_Resources[version.resource].isTransient)
+			{
+				LogError("RenderGraph: " + pass.name + " reads " + m_Resources[version.resource].name + " before any pass wrote it");
+				isValid = false;
+			}
+		}
+	}
+
+	if (!isValid || !SortPasses()) return false;
+
+	BuildSubmits();
+	AssignAliasSlots();
+
+	if (!DeriveBarriers() || !ValidateSchedule()) return false;
+
+	m_IsCompiled = true;
+	return true;
+}
+
+void RenderGraph::AllocateTransients()
+{
+	if (!m_IsCompiled)
+	{
+		LogError("RenderGraph: Compile the graph before allocating its transients");
+		return;
+	}
+
+	VmaAllocationCreateInfo allocationInfo{};
+	allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	for (AliasSlot& slot : m_AliasSlots)
+	{
+		//A transient that has a slot to itself keeps the memory it got created with
+		if (slot.resources.size() < 2 || slot.memory != VK_NULL_HANDLE) continue;
+
+		VulkanCheck(vmaAllocateMemory(Allocator::vmaAllocator, &slot.memoryRequirements, &allocationInfo, &slot.memory, nullptr), "Failed to allocate the memory of an alias slot!")
+
+		for (const uint32_t resourceIndex : slot.resources)
+		{
+			const Resource& resource = m_Resources[resourceIndex];
+			if (Texture* const* texture = std::get_if<Texture*>(&resource.image); texture && *texture)
+			{
+				(*texture)->AliasMemory(slot.memory);
+			}
+			else
+			{
+				LogWarning("RenderGraph: " + resource.name + " is not a texture, it keeps its own memory");
+			}
+		}
+	}
+}
+
+void RenderGraph::Execute(uint32_t submitIndex, VkCommandBuffer commandBuffer)
+{
+	if (!m_IsCompiled || submitIndex >= m_Submits.size())
+	{
+		LogError("RenderGraph: Executed without a compiled schedule");
+		return;
+	}
+
+	const Submit& submit = m_Submits[submitIndex];
+	for (const uint32_t scheduleIndex : submit.passes)
+	{
+		const ScheduledPass& scheduledPass = m_Schedule[scheduleIndex];
+		RecordBarriers(commandBuffer, std::span(m_Barriers).subspan(scheduledPass.firstBarrier, scheduledPass.barrierCount));
+		m_Passes[scheduledPass.pass].execute(commandBuffer);
+	}
+
+	RecordBarriers(commandBuffer, submit.releaseBarriers);
+	if (submitIndex == m_Submits.size() - 1) RecordBarriers(commandBuffer, m_FinalBarriers);
+}
+
+void RenderGraph::Cleanup()
+{
+	//The images bound to the memory only get destroyed with their textures, they just can not be used anymore after this
+	for (AliasSlot& slot : m_AliasSlots)
+	{
+		if (slot.memory == VK_NULL_HANDLE) continue;
+
+		vmaFreeMemory(Allocator::vmaAllocator, slot.memory);
+		slot.memory = VK_NULL_HANDLE;
+	}
+}
+
+void RenderGraph::LogSchedule() const
+{
+	for (uint32_t scheduleIndex{}; scheduleIndex < m_Schedule.size(); ++scheduleIndex)
+	{
+		const ScheduledPass& scheduledPass = m_Schedule[scheduleIndex];
+		LogInfo("RenderGraph: " + std::to_string(scheduleIndex) + " " + m_Passes[scheduledPass.pass].name + ", " + std::to_string(scheduledPass.barrierCount) + " barriers");
+	}
+
+	for (uint32_t submitIndex{}; submitIndex < m_Submits.size(); ++submitIndex)
+	{
+		const Submit& submit = m_Submits[submitIndex];
+		std::string passes{};
+		for (const uint32_t scheduleIndex : submit.passes)
+		{
+			passes += " " + m_Passes[m_Schedule[scheduleIndex].pass].name;
+		}
+
+		const std::string queue = submit.queue == QueueType::Compute ? "compute" : "graphics";
+		const std::string wait = submit.waitSubmit != NoSubmit ? ", waits on submit " + std::to_string(submit.waitSubmit) : "";
+		LogInfo("RenderGraph: Submit " + std::to_string(submitIndex) + " on the " + queue + " queue" + wait + ":" + passes);
+	}
+
+	for (const Pass& pass : m_Passes)
+	{
+		if (pass.isCulled) LogInfo("RenderGraph: Culled " + pass.name + ", nothing reads what it writes");
+	}
+
+	const Stats stats = GetStats();
+	LogInfo("RenderGraph: " + std::to_string(stats.barrierCount) + " barriers in " + std::to_string(stats.batchCount) + " batches");
+	LogInfo("RenderGraph: Transients take " + ToMiB(stats.aliasedBytes) + " in " + std::to_string(m_AliasSlots.size()) + " alias slots, " + ToMiB(stats.transientBytes) + " without aliasing");
+}
+
+void RenderGraph::OnImGui() const
+{
+	const Stats stats = GetStats();
+
+	ImGui::Begin("Info");
+	ImGui::SeparatorText("Render Graph");
+	ImGui::Text("Passes: %u, culled: %u", stats.scheduledCount, stats.culledCount);
+	ImGui::Text("Barriers: %u in %u batches", stats.barrierCount, stats.batchCount);
+	ImGui::Text("Submits: %u, %u passes on the compute queue", stats.submitCount, stats.asyncCount);
+	ImGui::Text("Transients: %.2f MiB, %.2f MiB without aliasing", static_cast<float>(stats.aliasedBytes) / (1024.0f * 1024.0f), static_cast<float>(stats.transientBytes) / (1024.0f * 1024.0f));
+	ImGui::End();
+}
+
+RenderGraph::UsageState RenderGraph::GetUsageState(ImageUsage usage, PassType type, bool isWrite, VkImageAspectFlags aspect)
+{
+	const VkPipelineStageFlags2 shaderStage = type == PassType::Compute ? VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+
+	switch (usage)
+	{
+	case ImageUsage::ColorAttachment:
+		return {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT,
+			isWrite ? VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT : VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+	case ImageUsage::DepthAttachment:
+		return {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+			isWrite ? VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : VK_ACCESS_2_NONE, isWrite ? VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL};
+	case ImageUsage::Sampled:
+		return {shaderStage, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_ACCESS_2_NONE,
+			(aspect & VK_IMAGE_ASPECT_DEPTH_BIT) != 0 ? VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+	case ImageUsage::Storage:
+		return {shaderStage, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, isWrite ? VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT : VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_GENERAL};
+	}
+
+	return {};
+}
+
+QueueType RenderGraph::GetQueue(uint32_t passIndex) const
+{
+	return m_HasAsyncQueue && m_Passes[passIndex].isAsync ? QueueType::Compute : QueueType::Graphics;
+}
+
+bool RenderGraph::IsValidPass(PassHandle pass, const std::string& caller)
+{
+	if (pass < m_Passes.size()) return true;
+
+	LogError("RenderGraph: " + caller + " got a pass that does not exist");
+	m_HasDeclarationErrors = true;
+	return false;
+}
+
+bool RenderGraph::IsValidImage(ImageHandle image, const std::string& caller)
+{
+	if (image.IsValid() && image.version < m_Versions.size()) return true;
+
+	LogError("RenderGraph: " + caller + " got an image that does not exist");
+	m_HasDeclarationErrors = true;
+	return false;
+}
+
+bool RenderGraph::AddAccess(PassHandle pass, ImageHandle image, ImageUsage usage, bool isWrite)
+{
+	Pass& graphPass = m_Passes[pass];
+	const uint32_t resourceIndex = m_Versions[image.version].resource;
+	const std::string& resourceName = m_Resources[resourceIndex].name;
+
+	std::string error{};
+	if (std::ranges::any_of(graphPass.accesses, [&](const Access& access) { return m_Versions[access.version].resource == resourceIndex; }))
+	{
+		error = "uses " + resourceName + " twice, an image can only be declared once per pass";
+	}
+	else if (isWrite && usage == ImageUsage::Sampled)
+	{
+		error = "writes " + resourceName + " through a sampler";
+	}
+	else if (graphPass.type == PassType::Compute && (usage == ImageUsage::ColorAttachment || usage == ImageUsage::DepthAttachment))
+	{
+		error = "uses " + resourceName + " as an attachment in a compute pass";
+	}
+
+	if (!error.empty())
+	{
+		LogError("RenderGraph: " + graphPass.name + " " + error);
+		m_HasDeclarationErrors = true;
+		return false;
+	}
+
+	graphPass.accesses.push_back({image.version, usage, isWrite});
+	m_IsCompiled = false;
+	return true;
+}
+
+void RenderGraph::CullPasses()
+{
+	//Passes that write something outside the graph are what the frame is for, the rest only stays when those need it
+	std::vector<uint32_t> neededPasses{};
+	for (uint32_t passIndex{}; passIndex < m_Passes.size(); ++passIndex)
+	{
+		Pass& pass = m_Passes[passIndex];
+		const bool writesImport = std::ranges::any_of(pass.accesses, [this](const Access& access)
+		{
+			return access.isWrite && !m_Resources[m_Versions[access.version].resource].isTransient;
+		});
+
+		pass.isCulled = !pass.hasSideEffect && !writesImport;
+		if (!pass.isCulled) neededPasses.push_back(passIndex);
+	}
+
+	//Reads need the pass that wrote the version, so do writes that load what was there
+	while (!neededPasses.empty())
+	{
+		const uint32_t passIndex = neededPasses.back();
+		neededPasses.pop_back();
+
+		for (const Access& access : m_Passes[passIndex].accesses)
+		{
+			const uint32_t producer = m_Versions[access.version].producer;
+			if (producer == NoPass || !m_Passes[producer].isCulled) continue;
+
+			m_Passes[producer].isCulled = false;
+			neededPasses.push_back(producer);
+		}
+	}
+}
+
+bool RenderGraph::SortPasses()
+{
+	const uint32_t passCount = static_cast<uint32_t>(m_Passes.size());
+	std::vector<std::vector<uint32_t>> successors(passCount);
+	std::vector<uint32_t> dependencyCounts(passCount);
+
+	const auto addEdge = [&](uint32_t from, uint32_t to)
+	{
+		if (from == NoPass || from == to || m_Passes[from].isCulled) return;
+
+		successors[from].push_back(to);
+		++dependencyCounts[to];
+	};
+
+	uint32_t keptCount{};
+	for (uint32_t passIndex{}; passIndex < passCount; ++passIndex)
+	{
+		if (m_Passes[passIndex].isCulled) continue;
+		++keptCount;
+
+		for (const Access& access : m_Passes[passIndex].accesses)
+		{
+			const Version& version = m_Versions[access.version];
+			addEdge(version.producer, passIndex);
+
+			//Whoever still reads the version this pass writes over has to be done with it first
+			if (!access.isWrite) continue;
+			for (const uint32_t reader : version.readers)
+			{
+				addEdge(reader, passIndex);
+			}
+		}
+	}
+
+	//Kahn's algorithm, passes that are ready at the same time go in the order they got added
+	//Compute queue passes go first, the graphics submit they wait on gets cut as early as possible and the graphics passes after it overlap them
+	using ReadyPass = std::pair<uint32_t, uint32_t>;
+	std::priority_queue<ReadyPass, std::vector<ReadyPass>, std::greater<>> readyPasses{};
+	const auto pushReady = [&](uint32_t passIndex)
+	{
+		readyPasses.emplace(GetQueue(passIndex) == QueueType::Compute ? 0 : 1, passIndex);
+	};
+
+	for (uint32_t passIndex{}; passIndex < passCount; ++passIndex)
+	{
+		if (!m_Passes[passIndex].isCulled && dependencyCounts[passIndex] == 0) pushReady(passIndex);
+	}
+
+	m_Schedule.clear();
+	while (!readyPasses.empty())
+	{
+		const uint32_t passIndex = readyPasses.top().second;
+		readyPasses.pop();
+		m_Schedule.push_back({passIndex});
+
+		for (const uint32_t successor : successors[passIndex])
+		{
+			if (--dependencyCounts[successor] == 0) pushReady(successor);
+		}
+	}
+
+	if (m_Schedule.size() == keptCount) return true;
+
+	std::string cyclePasses{};
+	for (uint32_t passIndex{}; passIndex < passCount; ++passIndex)
+	{
+		if (!m_Passes[passIndex].isCulled && dependencyCounts[passIndex] > 0) cyclePasses += " " + m_Passes[passIndex].name;
+	}
+	LogError("RenderGraph: The passes depend on each other in a cycle:" + cyclePasses);
+	return false;
+}
+
+void RenderGraph::BuildSubmits()
+{
+	m_Submits.clear();
+	std::vector<uint32_t> passSubmits(m_Passes.size(), NoSubmit);
+	std::array<uint32_t, QueueCount> openSubmits{NoSubmit, NoSubmit};
+
+	for (uint32_t scheduleIndex{}; scheduleIndex < m_Schedule.size(); ++scheduleIndex)
+	{
+		const uint32_t passIndex = m_Schedule[scheduleIndex].pass;
+		const QueueType queue = GetQueue(passIndex);
+
+		//The last submit of the other queue that writes what this pass reads, or reads what it writes over
+		uint32_t waitSubmit = NoSubmit;
+		const auto addDependency = [&](uint32_t dependency)
+		{
+			if (dependency == NoPass || m_Passes[dependency].isCulled || GetQueue(dependency) == queue) return;
+			if (waitSubmit == NoSubmit || passSubmits[dependency] > waitSubmit) waitSubmit = passSubmits[dependency];
+		};
+
+		for (const Access& access : m_Passes[passIndex].accesses)
+		{
+			const Version& version = m_Versions[access.version];
+			addDependency(version.producer);
+
+			if (!access.isWrite) continue;
+			for (const uint32_t reader : version.readers)
+			{
+				addDependency(reader);
+			}
+		}
+
+		uint32_t& openSubmit = openSubmits[static_cast<size_t>(queue)];
+		if (waitSubmit != NoSubmit)
+		{
+			//Nothing can get added to a submit once another one waits on its signal
+			Submit& signalSubmit = m_Submits[waitSubmit];
+			signalSubmit.isSignaled = true;
+			if (uint32_t& otherSubmit = openSubmits[static_cast<size_t>(signalSubmit.queue)]; otherSubmit == waitSubmit) otherSubmit = NoSubmit;
+
+			//The wait sits in front of the whole submit, one that waits on less has to end here
+			if (openSubmit != NoSubmit && (m_Submits[openSubmit].waitSubmit == NoSubmit || m_Submits[openSubmit].waitSubmit < waitSubmit)) openSubmit = NoSubmit;
+		}
+
+		if (openSubmit == NoSubmit)
+		{
+			openSubmit = static_cast<uint32_t>(m_Submits.size());
+			m_Submits.push_back({queue, waitSubmit});
+		}
+
+		m_Submits[openSubmit].passes.push_back(scheduleIndex);
+		m_Schedule[scheduleIndex].submit = openSubmit;
+		passSubmits[passIndex] = openSubmit;
+	}
+
+	//The frame ends on the graphics queue, its fence and the present have to come after the compute work
+	uint32_t lastComputeSubmit = NoSubmit;
+	for (uint32_t submitIndex{}; submitIndex < m_Submits.size(); ++submitIndex)
+	{
+		if (m_Submits[submitIndex].queue == QueueType::Compute) lastComputeSubmit = submitIndex;
+	}
+
+	const bool isComputeCovered = lastComputeSubmit == NoSubmit || std::ranges::any_of(m_Submits, [lastComputeSubmit](const Submit& submit)
+	{
+		return submit.queue == QueueType::Graphics && submit.waitSubmit == lastComputeSubmit;
+	});
+	if (!isComputeCovered)
+	{
+		m_Submits[lastComputeSubmit].isSignaled = true;
+		m_Submits.push_back({QueueType::Graphics, lastComputeSubmit});
+	}
+	if (m_Submits.empty()) m_Submits.push_back({QueueType::Graphics});
+
+	//The semaphore of an imported image gets waited on by the submit that uses it first
+	std::vector<bool> isWaitedOn(m_Resources.size(), false);
+	for (const ScheduledPass& scheduledPass : m_Schedule)
+	{
+		for (const Access& access : m_Passes[scheduledPass.pass].accesses)
+		{
+			const uint32_t resourceIndex = m_Versions[access.version].resource;
+			if (isWaitedOn[resourceIndex]) continue;
+
+			isWaitedOn[resourceIndex] = true;
+			m_Submits[scheduledPass.submit].waitStages |= m_Resources[resourceIndex].waitStage;
+		}
+	}
+
+	//A submit comes after the one before it on the same queue and after the one it waits on, and after everything those come after
+	const size_t submitCount = m_Submits.size();
+	m_IsSubmitOrdered.assign(submitCount * submitCount, false);
+	std::array<uint32_t, QueueCount> lastSubmits{NoSubmit, NoSubmit};
+	for (uint32_t submitIndex{}; submitIndex < submitCount; ++submitIndex)
+	{
+		const Submit& submit = m_Submits[submitIndex];
+		uint32_t& lastSubmit = lastSubmits[static_cast<size_t>(submit.queue)];
+
+		for (const uint32_t predecessor : {lastSubmit, submit.waitSubmit})
+		{
+			if (predecessor == NoSubmit) continue;
+
+			m_IsSubmitOrdered[predecessor * submitCount + submitIndex] = true;
+			for (size_t earlier{}; earlier < submitCount; ++earlier)
+			{
+				if (m_IsSubmitOrdered[earlier * submitCount + predecessor]) m_IsSubmitOrdered[earlier * submitCount + submitIndex] = true;
+			}
+		}
+
+		lastSubmit = submitIndex;
+	}
+}
+
+bool RenderGraph::IsOrdered(uint32_t first, uint32_t second) const
+{
+	const uint32_t firstSubmit = m_Schedule[first].submit;
+	const uint32_t secondSubmit = m_Schedule[second].submit;
+	if (firstSubmit == secondSubmit) return first < second;
+
+	return m_IsSubmitOrdered[firstSubmit * m_Submits.size() + secondSubmit];
+}
+
+bool RenderGraph::AreLifetimesOverlapping(uint32_t firstResource, uint32_t secondResource) const
+{
+	const auto isBefore = [this](const Resource& first, const Resource& second)
+	{
+		return std::ranges::all_of(first.uses, [&](uint32_t firstUse)
+		{
+			return std::ranges::all_of(second.uses, [&](uint32_t secondUse) { return IsOrdered(firstUse, secondUse); });
+		});
+	};
+
+	const Resource& first = m_Resources[firstResource];
+	const Resource& second = m_Resources[secondResource];
+	return !isBefore(first, second) && !isBefore(second, first);
+}
+
+void RenderGraph::AssignAliasSlots()
+{
+	for (Resource& resource : m_Resources)
+	{
+		resource.firstUse = UINT32_MAX;
+		resource.lastUse = 0;
+		resource.uses.clear();
+	}
+
+	for (uint32_t scheduleIndex{}; scheduleIndex < m_Schedule.size(); ++scheduleIndex)
+	{
+		for (const Access& access : m_Passes[m_Schedule[scheduleIndex].pass].accesses)
+		{
+			Resource& resource = m_Resources[m_Versions[access.version].resource];
+			resource.firstUse = std::min(resource.firstUse, scheduleIndex);
+			resource.lastUse = std::max(resource.lastUse, scheduleIndex);
+			resource.uses.push_back(scheduleIndex);
+		}
+	}
+
+	//Biggest first, the smaller ones then fit in the gaps of the slots that already exist
+	std::vector<uint32_t> transients{};
+	for (uint32_t resourceIndex{}; resourceIndex < m_Resources.size(); ++resourceIndex)
+	{
+		const Resource& resource = m_Resources[resourceIndex];
+		if (resource.isTransient && resource.firstUse != UINT32_MAX) transients.push_back(resourceIndex);
+	}
+	std::ranges::stable_sort(transients, std::greater<>{}, [this](uint32_t resourceIndex) { return m_Resources[resourceIndex].memoryRequirements.size; });
+
+	m_AliasSlots.clear();
+	for (const uint32_t resourceIndex : transients)
+	{
+		Resource& resource = m_Resources[resourceIndex];
+
+		const auto slot = std::ranges::find_if(m_AliasSlots, [&](const AliasSlot& aliasSlot)
+		{
+			return (aliasSlot.memoryRequirements.memoryTypeBits & resource.memoryRequirements.memoryTypeBits) != 0 &&
+				std::ranges::none_of(aliasSlot.resources, [&](uint32_t occupant) { return AreLifetimesOverlapping(occupant, resourceIndex); });
+		});
+
+		if (slot == m_AliasSlots.end())
+		{
+			resource.memoryIndex = static_cast<uint32_t>(m_AliasSlots.size());
+			m_AliasSlots.push_back({resource.memoryRequirements, {resourceIndex}});
+			continue;
+		}
+
+		VkMemoryRequirements& slotRequirements = slot->memoryRequirements;
+		slotRequirements.size = std::max(slotRequirements.size, resource.memoryRequirements.size);
+		slotRequirements.alignment = std::max(slotRequirements.alignment, resource.memoryRequirements.alignment);
+		slotRequirements.memoryTypeBits &= resource.memoryRequirements.memoryTypeBits;
+		slot->resources.push_back(resourceIndex);
+		resource.memoryIndex = static_cast<uint32_t>(slot - m_AliasSlots.begin());
+	}
+
+	//Everything else gets memory of its own behind the slots
+	for (uint32_t resourceIndex{}; resourceIndex < m_Resources.size(); ++resourceIndex)
+	{
+		Resource& resource = m_Resources[resourceIndex];
+		if (!resource.isTransient || resource.firstUse == UINT32_MAX) resource.memoryIndex = static_cast<uint32_t>(m_AliasSlots.size()) + resourceIndex;
+	}
+}
+
+bool RenderGraph::DeriveBarriers()
+{
+	const size_t memoryCount = m_AliasSlots.size() + m_Resources.size();
+	std::array<std::vector<MemoryState>, QueueCount> memoryStates{};
+	for (std::vector<MemoryState>& queueMemoryStates : memoryStates)
+	{
+		queueMemoryStates.assign(memoryCount, {});
+	}
+	//Queue that touched the memory last
+	std::vector<QueueType> memoryQueues(memoryCount, QueueType::Graphics);
+	std::vector<VkImageLayout> layouts(m_Resources.size(), VK_IMAGE_LAYOUT_UNDEFINED);
+
+	bool isValid = true;
+
+	//The first run only finds the state the frame ends in, the barriers at the start of the frame have to wait on it
+	for (int run{}; run < 2; ++run)
+	{
+		const bool isRecording = run == 1;
+		m_Barriers.clear();
+		m_FinalBarriers.clear();
+		for (Submit& submit : m_Submits)
+		{
+			submit.releaseBarriers.clear();
+		}
+
+		//Which queues already got the content of a version handed over, and the last submit per queue that used an image
+		std::vector<std::array<bool, QueueCount>> isHandedOver(m_Versions.size());
+		std::array<std::vector<uint32_t>, QueueCount> lastSubmits{};
+		for (std::vector<uint32_t>& queueLastSubmits : lastSubmits)
+		{
+			queueLastSubmits.assign(m_Resources.size(), NoSubmit);
+		}
+
+		//The submit waits on a semaphore before it touches these, the first barrier chains to that wait
+		for (const Resource& resource : m_Resources)
+		{
+			if (resource.waitStage == VK_PIPELINE_STAGE_2_NONE) continue;
+
+			memoryStates[static_cast<size_t>(QueueType::Graphics)][resource.memoryIndex] = {.readStages = resource.waitStage};
+			memoryQueues[resource.memoryIndex] = QueueType::Graphics;
+		}
+
+		for (ScheduledPass& scheduledPass : m_Schedule)
+		{
+			scheduledPass.firstBarrier = static_cast<uint32_t>(m_Barriers.size());
+			const Pass& pass = m_Passes[scheduledPass.pass];
+			const QueueType queue = GetQueue(scheduledPass.pass);
+
+			for (const Access& access : pass.accesses)
+			{
+				const Version& version = m_Versions[access.version];
+				const Resource& resource = m_Resources[version.resource];
+				const UsageState usage = GetUsageState(access.usage, pass.type, access.isWrite, resource.aspect);
+				MemoryState& memoryState = memoryStates[static_cast<size_t>(queue)][resource.memoryIndex];
+				VkImageLayout& layout = layouts[version.resource];
+				const bool isDiscard = access.isWrite && version.producer == NoPass;
+
+				//The other queue used the memory last, a semaphore wait orders this use after it, the barriers here chain to that wait
+				if (memoryQueues[resource.memoryIndex] != queue)
+				{
+					memoryState = {.readStages = SubmitWaitStage};
+					memoryQueues[resource.memoryIndex] = queue;
+				}
+
+				lastSubmits[static_cast<size_t>(queue)][version.resource] = scheduledPass.submit;
+
+				//The other queue wrote what this pass needs, that queue hands it over at the end of the submit it wrote it in
+				const QueueType producerQueue = version.producer != NoPass ? GetQueue(version.producer) : queue;
+				if (!isDiscard && producerQueue != queue && !isHandedOver[access.version][static_cast<size_t>(queue)])
+				{
+					isHandedOver[access.version][static_cast<size_t>(queue)] = true;
+					const uint32_t producerSubmit = m_Schedule[std::ranges::find(m_Schedule, version.producer, &ScheduledPass::pass) - m_Schedule.begin()].submit;
+					MemoryState& producerState = memoryStates[static_cast<size_t>(producerQueue)][resource.memoryIndex];
+
+					Barrier release{};
+					release.resource = version.resource;
+					release.srcStages = producerState.writeStages | producerState.readStages;
+					release.srcAccess = producerState.writeAccess;
+					release.oldLayout = layout;
+					release.newLayout = usage.layout;
+					release.isOwnershipTransfer = !resource.isConcurrent;
+					release.srcQueue = producerQueue;
+					release.dstQueue = queue;
+
+					//Without a transfer the other queue can keep using the image, its later passes see the transition
+					if (!release.isOwnershipTransfer)
+					{
+						release.dstStages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+						release.dstAccess = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+					}
+
+					if (release.isOwnershipTransfer || release.oldLayout != release.newLayout)
+					{
+						if (lastSubmits[static_cast<size_t>(producerQueue)][version.resource] != producerSubmit)
+						{
+							LogError("RenderGraph: " + resource.name + " gets handed to another queue after the submit that wrote it used it again");
+							isValid = false;
+						}
+
+						producerState = {};
+						if (isRecording) m_Submits[producerSubmit].releaseBarriers.push_back(release);
+					}
+
+					//The acquire repeats the release, it is what the access waits on
+					if (release.isOwnershipTransfer && isRecording)
+					{
+						Barrier acquire = release;
+						acquire.srcStages = memoryState.readStages;
+						acquire.srcAccess = VK_ACCESS_2_NONE;
+						acquire.dstStages = usage.stages;
+						acquire.dstAccess = usage.readAccess | usage.writeAccess;
+						acquire.isAcquire = true;
+						m_Barriers.push_back(acquire);
+					}
+
+					layout = usage.layout;
+					if (access.isWrite) memoryState = {.writeStages = usage.stages, .writeAccess = usage.writeAccess};
+					else memoryState = {.readStages = usage.stages, .visibleStages = usage.stages, .visibleAccess = usage.readAccess};
+					continue;
+				}
+
+				Barrier barrier{};
+				barrier.resource = version.resource;
+				barrier.dstStages = usage.stages;
+				barrier.dstAccess = usage.readAccess | usage.writeAccess;
+				barrier.isDiscard = isDiscard;
+				barrier.oldLayout = barrier.isDiscard ? VK_IMAGE_LAYOUT_UNDEFINED : layout;
+				barrier.newLayout = usage.layout;
+
+				const bool isTransition = barrier.oldLayout != barrier.newLayout;
+				bool needsBarrier = isTransition;
+
+				if (access.isWrite || isTransition)
+				{
+					//Waits for everything that touched the memory since its last write, a layout transition writes too
+					barrier.srcStages = memoryState.writeStages | memoryState.readStages;
+					barrier.srcAccess = memoryState.writeAccess;
+					needsBarrier = needsBarrier || barrier.srcStages != VK_PIPELINE_STAGE_2_NONE;
+
+					if (access.isWrite) memoryState = {.writeStages = usage.stages, .writeAccess = usage.writeAccess};
+					else memoryState = {memoryState.writeStages, memoryState.writeAccess, usage.stages, usage.stages, usage.readAccess};
+				}
+				else
+				{
+					//Reads in the same layout only need a barrier when the last write is not visible to them yet
+					const bool isVisible = (memoryState.visibleStages & usage.stages) == usage.stages && (memoryState.visibleAccess & usage.readAccess) == usage.readAccess;
+					if (memoryState.writeStages != VK_PIPELINE_STAGE_2_NONE && !isVisible)
+					{
+						barrier.srcStages = memoryState.writeStages | memoryState.readStages;
+						barrier.srcAccess = memoryState.writeAccess;
+						needsBarrier = true;
+
+						memoryState.visibleStages |= usage.stages;
+						memoryState.visibleAccess |= usage.readAccess;
+					}
+					memoryState.readStages |= usage.stages;
+				}
+
+				layout = usage.layout;
+				if (needsBarrier && isRecording) m_Barriers.push_back(barrier);
+			}
+
+			scheduledPass.barrierCount = static_cast<uint32_t>(m_Barriers.size()) - scheduledPass.firstBarrier;
+		}
+
+		//Recorded at the end of the last submit, that one is on the graphics queue
+		for (uint32_t resourceIndex{}; resourceIndex < m_Resources.size(); ++resourceIndex)
+		{
+			const Resource& resource = m_Resources[resourceIndex];
+			if (resource.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED || resource.firstUse == UINT32_MAX) continue;
+
+			MemoryState& memoryState = memoryStates[static_cast<size_t>(QueueType::Graphics)][resource.memoryIndex];
+
+			//Nothing inside the frame waits on the final transition of an image a semaphore hands over
+			Barrier barrier{};
+			barrier.resource = resourceIndex;
+			barrier.srcStages = memoryState.writeStages | memoryState.readStages;
+			barrier.srcAccess = memoryState.writeAccess;
+			barrier.dstStages = resource.waitStage != VK_PIPELINE_STAGE_2_NONE ? VK_PIPELINE_STAGE_2_NONE : VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+			barrier.oldLayout = layouts[resourceIndex];
+			barrier.newLayout = resource.finalLayout;
+
+			memoryState = {.readStages = barrier.dstStages};
+			layouts[resourceIndex] = resource.finalLayout;
+			if (isRecording) m_FinalBarriers.push_back(barrier);
+		}
+	}
+
+	return isValid;
+}
+
+bool RenderGraph::ValidateSchedule() const
+{
+	bool isValid = true;
+
+	std::vector<uint32_t> schedulePositions(m_Passes.size(), UINT32_MAX);
+	for (uint32_t scheduleIndex{}; scheduleIndex < m_Schedule.size(); ++scheduleIndex)
+	{
+		schedulePositions[m_Schedule[scheduleIndex].pass] = scheduleIndex;
+	}
+
+	//Producers before their readers, readers before whoever writes over what they read
+	for (uint32_t scheduleIndex{}; scheduleIndex < m_Schedule.size(); ++scheduleIndex)
+	{
+		const Pass& pass = m_Passes[m_Schedule[scheduleIndex].pass];
+		for (const Access& access : pass.accesses)
+		{
+			const Version& version = m_Versions[access.version];
+			const std::string& resourceName = m_Resources[version.resource].name;
+
+			if (version.producer != NoPass && schedulePositions[version.producer] >= scheduleIndex)
+			{
+				LogError("RenderGraph: " + pass.name + " runs before " + m_Passes[version.producer].name + " wrote " + resourceName);
+				isValid = false;
+			}
+
+			if (!access.isWrite) continue;
+			for (const uint32_t reader : version.readers)
+			{
+				if (schedulePositions[reader] != UINT32_MAX && schedulePositions[reader] > scheduleIndex)
+				{
+					LogError("RenderGraph: " + pass.name + " writes over " + resourceName + " before " + m_Passes[reader].name + " read it");
+					isValid = false;
+				}
+			}
+		}
+	}
+
+	//Every access finds its image in the layout it needs, the transitions start from the layout the last one left
+	std::vector<VkImageLayout> layouts(m_Resources.size(), VK_IMAGE_LAYOUT_UNDEFINED);
+	std::vector<bool> isUsed(m_Resources.size(), false);
+	const auto replayBarriers = [&](std::span<const Barrier> barriers, const std::string& position)
+	{
+		for (const Barrier& barrier : barriers)
+		{
+			//The release already did the transition
+			if (barrier.isAcquire) continue;
+
+			if (isUsed[barrier.resource] && !barrier.isDiscard && barrier.oldLayout != layouts[barrier.resource])
+			{
+				LogError("RenderGraph: The barrier " + position + " transitions " + m_Resources[barrier.resource].name + " from a layout it is not in");
+				isValid = false;
+			}
+			layouts[barrier.resource] = barrier.newLayout;
+			isUsed[barrier.resource] = true;
+		}
+	};
+
+	for (uint32_t scheduleIndex{}; scheduleIndex < m_Schedule.size(); ++scheduleIndex)
+	{
+		const ScheduledPass& scheduledPass = m_Schedule[scheduleIndex];
+		const Pass& pass = m_Passes[scheduledPass.pass];
+		replayBarriers(std::span(m_Barriers).subspan(scheduledPass.firstBarrier, scheduledPass.barrierCount), "in front of " + pass.name);
+
+		for (const Access& access : pass.accesses)
+		{
+			const uint32_t resourceIndex = m_Versions[access.version].resource;
+			if (layouts[resourceIndex] != GetUsageState(access.usage, pass.type, access.isWrite, m_Resources[resourceIndex].aspect).layout)
+			{
+				LogError("RenderGraph: " + pass.name + " uses " + m_Resources[resourceIndex].name + " in the wrong layout");
+				isValid = false;
+			}
+		}
+
+		const Submit& submit = m_Submits[scheduledPass.submit];
+		if (submit.passes.back() == scheduleIndex) replayBarriers(submit.releaseBarriers, "at the end of submit " + std::to_string(scheduledPass.submit));
+	}
+
+	//Transients in the same slot can never be alive at the same time
+	for (const AliasSlot& slot : m_AliasSlots)
+	{
+		for (size_t first{}; first < slot.resources.size(); ++first)
+		{
+			for (size_t second{first + 1}; second < slot.resources.size(); ++second)
+			{
+				if (AreLifetimesOverlapping(slot.resources[first], slot.resources[second]))
+				{
+					LogError("RenderGraph: " + m_Resources[slot.resources[first]].name + " and " + m_Resources[slot.resources[second]].name + " share memory while both are alive");
+					isValid = false;
+				}
+			}
+		}
+	}
+
+	//An image only belongs to one queue family at a time, unless it got created to be shared
+	for (const Version& version : m_Versions)
+	{
+		const Resource& resource = m_Resources[version.resource];
+		std::array<bool, QueueCount> isReadOn{};
+		std::array<VkImageLayout, QueueCount> readLayouts{};
+		for (const uint32_t reader : version.readers)
+		{
+			if (m_Passes[reader].isCulled) continue;
+
+			const auto access = std::ranges::find_if(m_Passes[reader].accesses, [&](const Access& readAccess) { return m_Versions[readAccess.version].resource == version.resource; });
+			const size_t queue = static_cast<size_t>(GetQueue(reader));
+			isReadOn[queue] = true;
+			readLayouts[queue] = GetUsageState(access->usage, m_Passes[reader].type, false, resource.aspect).layout;
+		}
+
+		if (!isReadOn[0] || !isReadOn[1]) continue;
+
+		if (!resource.isConcurrent)
+		{
+			LogError("RenderGraph: Both queues read " + resource.name + ", create it with VK_SHARING_MODE_CONCURRENT and call SetConcurrent");
+			isValid = false;
+		}
+		else if (readLayouts[0] != readLayouts[1])
+		{
+			LogError("RenderGraph: Both queues read " + resource.name + " at the same time, but in different layouts");
+			isValid = false;
+		}
+	}
+
+	//The semaphores of the frame and its final transitions are on the graphics queue
+	for (const ScheduledPass& scheduledPass : m_Schedule)
+	{
+		if (GetQueue(scheduledPass.pass) != QueueType::Compute) continue;
+
+		for (const Access& access : m_Passes[scheduledPass.pass].accesses)
+		{
+			const Resource& resource = m_Resources[m_Versions[access.version].resource];
+			if (resource.finalLayout != VK_IMAGE_LAYOUT_UNDEFINED || resource.waitStage != VK_PIPELINE_STAGE_2_NONE)
+			{
+				LogError("RenderGraph: " + m_Passes[scheduledPass.pass].name + " uses " + resource.name + " on the compute queue, images with a final layout or a semaphore stay on the graphics queue");
+				isValid = false;
+			}
+		}
+	}
+
+	return isValid;
+}
+
+void RenderGraph::RecordBarriers(VkCommandBuffer commandBuffer, std::span<const Barrier> barriers)
+{
+	m_ImageBarriers.clear();
+
+	for (const Barrier& barrier : barriers)
+	{
+		const Resource& resource = m_Resources[barrier.resource];
+		if (!barrier.isAcquire) ApplyLayout(resource.image, barrier.newLayout, barrier.isDiscard);
+
+		const VkImage image = GetVkImage(resource.image);
+		if (image == VK_NULL_HANDLE) continue;
+
+		VkImageMemoryBarrier2 imageBarrier{};
+		imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+		imageBarrier.srcStageMask = barrier.srcStages;
+		imageBarrier.srcAccessMask = barrier.srcAccess;
+		imageBarrier.dstStageMask = barrier.dstStages;
+		imageBarrier.dstAccessMask = barrier.dstAccess;
+		imageBarrier.oldLayout = barrier.oldLayout;
+		imageBarrier.newLayout = barrier.newLayout;
+		imageBarrier.srcQueueFamilyIndex = barrier.isOwnershipTransfer ? m_QueueFamilies[static_cast<size_t>(barrier.srcQueue)] : VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.dstQueueFamilyIndex = barrier.isOwnershipTransfer ? m_QueueFamilies[static_cast<size_t>(barrier.dstQueue)] : VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.image = image;
+		imageBarrier.subresourceRange = {resource.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+		m_ImageBarriers.push_back(imageBarrier);
+	}
+
+	if (m_ImageBarriers.empty()) return;
+
+	VkDependencyInfo dependencyInfo{};
+	dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+	dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(m_ImageBarriers.size());
+	dependencyInfo.pImageMemoryBarriers = m_ImageBarriers.data();
+	vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+}
+
+RenderGraph::Stats RenderGraph::GetStats() const
+{
+	Stats stats{};
+	stats.scheduledCount = static_cast<uint32_t>(m_Schedule.size());
+	stats.culledCount = static_cast<uint32_t>(std::ranges::count_if(m_Passes, [](const Pass& pass) { return pass.isCulled; }));
+	stats.barrierCount = static_cast<uint32_t>(m_Barriers.size() + m_FinalBarriers.size());
+	stats.batchCount = static_cast<uint32_t>(std::ranges::count_if(m_Schedule, [](const ScheduledPass& scheduledPass) { return scheduledPass.barrierCount > 0; }));
+	if (!m_FinalBarriers.empty()) ++stats.batchCount;
+
+	stats.submitCount = static_cast<uint32_t>(m_Submits.size());
+	stats.asyncCount = static_cast<uint32_t>(std::ranges::count_if(m_Schedule, [this](const ScheduledPass& scheduledPass) { return GetQueue(scheduledPass.pass) == QueueType::Compute; }));
+	for (const Submit& submit : m_Submits)
+	{
+		stats.barrierCount += static_cast<uint32_t>(submit.releaseBarriers.size());
+		if (!submit.releaseBarriers.empty()) ++stats.batchCount;
+	}
+
+	for (const Resource& resource : m_Resources)
+	{
+		if (resource.isTransient && resource.firstUse != UINT32_MAX) stats.transientBytes += resource.memoryRequirements.size;
+	}
+	for (const AliasSlot& slot : m_AliasSlots)
+	{
+		stats.aliasedBytes += slot.memoryRequirements.size;
+	}
+
+	return stats;
+}
+
+bool RenderGraph::SelfTest()
+{
+	bool isPassing = true;
+	const auto check = [&isPassing](bool condition, const std::string& message)
+	{
+		if (condition) return;
+		LogError("RenderGraph self test: " + message);
+		isPassing = false;
+	};
+
+	//Same passes and images as the frame, at 1920x1080 with made up memory requirements
+	const auto requirements = [](uint32_t width, uint32_t height, uint32_t bytesPerPixel)
+	{
+		return VkMemoryRequirements{static_cast<VkDeviceSize>(width) * height * bytesPerPixel, 65536, 1};
+	};
+
+	struct FramePasses
+	{
+		PassHandle color{};
+		PassHandle histogram{};
+		PassHandle present{};
+		ImageHandle histogramImage{};
+	};
+
+	//Same passes, images and declaration order as the frame
+	const auto addFrame = [&requirements](RenderGraph& graph, bool isDepthConcurrent)
+	{
+		FramePasses passes{};
+		ImageHandle swapChain = graph.Import("SwapChain", {}, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+		ImageHandle depth = graph.Import("Depth", {}, VK_IMAGE_ASPECT_DEPTH_BIT);
+		ImageHandle normal = graph.Import("Normal", {}, VK_IMAGE_ASPECT_COLOR_BIT);
+		ImageHandle albedo = graph.Import("Albedo", {}, VK_IMAGE_ASPECT_COLOR_BIT);
+		ImageHandle downSample = graph.CreateTransient("DownSample", {}, requirements(960, 540, 2));
+		ImageHandle occlusion = graph.CreateTransient("SSAO", {}, requirements(960, 540, 4));
+		ImageHandle blur = graph.CreateTransient("Blur", {}, requirements(960, 540, 4));
+		ImageHandle upSample = graph.CreateTransient("UpSample", {}, requirements(1920, 1080, 4));
+		passes.histogramImage = graph.CreateTransient("Histogram", {}, requirements(256, 1, 4));
+		if (isDepthConcurrent) graph.SetConcurrent(depth);
+
+		const PassHandle cullingPass = graph.AddPass("Culling", PassType::Compute, {});
+		graph.SetSideEffect(cullingPass);
+
+		const PassHandle depthPass = graph.AddPass("Depth", PassType::Graphics, {});
+		depth = graph.Write(depthPass, depth, ImageUsage::DepthAttachment);
+		normal = graph.Write(depthPass, normal, ImageUsage::ColorAttachment);
+
+		const PassHandle downSamplePass = graph.AddPass("DownSample", PassType::Compute, {});
+		graph.Read(downSamplePass, depth, ImageUsage::Sampled);
+		downSample = graph.Write(downSamplePass, downSample, ImageUsage::Storage);
+
+		const PassHandle occlusionPass = graph.AddPass("SSAO", PassType::Compute, {});
+		graph.Read(occlusionPass, depth, ImageUsage::Sampled);
+		graph.Read(occlusionPass, normal, ImageUsage::Sampled);
+		graph.Read(occlusionPass, downSample, ImageUsage::Sampled);
+		occlusion = graph.Write(occlusionPass, occlusion, ImageUsage::Storage);
+
+		const PassHandle blurPass = graph.AddPass("Blur", PassType::Compute, {});
+		graph.Read(blurPass, occlusion, ImageUsage::Sampled);
+		graph.Read(blurPass, downSample, ImageUsage::Sampled);
+		blur = graph.Write(blurPass, blur, ImageUsage::Storage);
+
+		const PassHandle upSamplePass = graph.AddPass("UpSample", PassType::Compute, {});
+		graph.Read(upSamplePass, depth, ImageUsage::Sampled);
+		graph.Read(upSamplePass, normal, ImageUsage::Sampled);
+		graph.Read(upSamplePass, blur, ImageUsage::Sampled);
+		upSample = graph.Write(upSamplePass, upSample, ImageUsage::Storage);
+
+		for (const PassHandle computePass : {downSamplePass, occlusionPass, blurPass, upSamplePass})
+		{
+			graph.SetAsyncCompute(computePass);
+		}
+
+		//Only depth tests, it reads the depth the compute passes sample
+		passes.color = graph.AddPass("Color", PassType::Graphics, {});
+		graph.Read(passes.color, depth, ImageUsage::DepthAttachment);
+		albedo = graph.Write(passes.color, albedo, ImageUsage::ColorAttachment);
+
+		//Nothing reads the histogram, it has to get culled
+		passes.histogram = graph.AddPass("Histogram", PassType::Compute, {});
+		graph.Read(passes.histogram, albedo, ImageUsage::Sampled);
+		passes.histogramImage = graph.Write(passes.histogram, passes.histogramImage, ImageUsage::Storage);
+
+		passes.present = graph.AddPass("Present", PassType::Graphics, {});
+		graph.Read(passes.present, albedo, ImageUsage::Sampled);
+		graph.Read(passes.present, upSample, ImageUsage::Sampled);
+		graph.Read(passes.present, depth, ImageUsage::DepthAttachment);
+		swapChain = graph.Write(passes.present, swapChain, ImageUsage::ColorAttachment);
+
+		return passes;
+	};
+
+	const auto getOrder = [](const RenderGraph& graph)
+	{
+		std::vector<std::string> order{};
+		for (const ScheduledPass& scheduledPass : graph.m_Schedule)
+		{
+			order.push_back(graph.m_Passes[scheduledPass.pass].name);
+		}
+		return order;
+	};
+	const std::vector<std::string> frameOrder{"Culling", "Depth", "DownSample", "SSAO", "Blur", "UpSample", "Color", "Present"};
+
+	{
+		RenderGraph graph{};
+		const FramePasses passes = addFrame(graph, false);
+
+		check(graph.Compile(), "The frame does not compile");
+		graph.LogSchedule();
+
+		check(getOrder(graph) == frameOrder, "The passes got scheduled in the wrong order");
+		check(graph.m_Submits.size() == 1, "The frame got split in submits without a compute queue");
+		check(graph.m_Passes[passes.histogram].isCulled, "The histogram pass did not get culled");
+
+		const Stats stats = graph.GetStats();
+		check(stats.aliasedBytes < stats.transientBytes, "No transient shares memory");
+		check(graph.m_FinalBarriers.size() == 1 && graph.m_FinalBarriers.front().newLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, "The swap chain image does not end up ready to present");
+		check(graph.m_Resources[graph.m_Versions[passes.histogramImage.version].resource].firstUse == UINT32_MAX, "The histogram image is alive without a pass using it");
+	}
+	{
+		RenderGraph graph{};
+		graph.EnableAsyncCompute(0, 1);
+		const FramePasses passes = addFrame(graph, true);
+
+		check(graph.Compile(), "The frame does not compile with async compute");
+		graph.LogSchedule();
+
+		check(getOrder(graph) == frameOrder, "The passes got scheduled in the wrong order with async compute");
+
+		//Depth prepass, the compute passes, the color pass next to them and the present once they are done
+		const std::vector<Submit>& submits = graph.m_Submits;
+		const bool isSplit = submits.size() == 4 && submits[1].queue == QueueType::Compute && submits[1].waitSubmit == 0 && submits[0].isSignaled;
+		check(isSplit, "The compute passes did not get their own submit after the depth prepass");
+		if (isSplit)
+		{
+			check(graph.m_Schedule[std::ranges::find(graph.m_Schedule, passes.color, &ScheduledPass::pass) - graph.m_Schedule.begin()].submit == 2 && submits[2].waitSubmit == NoSubmit, "The color pass waits on the compute queue");
+			check(submits[3].waitSubmit == 1 && submits[1].isSignaled && submits[3].waitStages == VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, "The present does not wait on the compute queue and the swap chain image");
+
+			const auto hasTransfer = [&](const std::vector<Barrier>& barriers, const std::string& name, bool isAcquire)
+			{
+				return std::ranges::any_of(barriers, [&](const Barrier& barrier)
+				{
+					return barrier.isOwnershipTransfer && barrier.isAcquire == isAcquire && graph.m_Resources[barrier.resource].name == name;
+				});
+			};
+			check(hasTransfer(submits[0].releaseBarriers, "Normal", false) && hasTransfer(graph.m_Barriers, "Normal", true), "The normals do not get handed to the compute queue");
+			check(hasTransfer(submits[1].releaseBarriers, "UpSample", false) && hasTransfer(graph.m_Barriers, "UpSample", true), "The occlusion does not get handed back to the graphics queue");
+			check(!hasTransfer(submits[0].releaseBarriers, "Depth", false), "The concurrent depth got an ownership transfer");
+		}
+	}
+
+	LogInfo("RenderGraph self test: The next errors are expected");
+	{
+		//Both queues read the depth at the same time, that needs concurrent sharing
+		RenderGraph graph{};
+		graph.EnableAsyncCompute(0, 1);
+		addFrame(graph, false);
+
+		check(!graph.Compile(), "An exclusive image got read on both queues");
+	}
+	{
+		//The color pass reads what the depth pass writes, and has to run before the depth pass writes over the image it reads
+		RenderGraph graph{};
+		ImageHandle color = graph.Import("Color", {}, VK_IMAGE_ASPECT_COLOR_BIT);
+		ImageHandle depth = graph.Import("Depth", {}, VK_IMAGE_ASPECT_DEPTH_BIT);
+		const ImageHandle previousColor = color;
+
+		const PassHandle depthPass = graph.AddPass("Depth", PassType::Graphics, {});
+		depth = graph.Write(depthPass, depth, ImageUsage::DepthAttachment);
+		color = graph.Write(depthPass, color, ImageUsage::ColorAttachment);
+
+		const PassHandle colorPass = graph.AddPass("Color", PassType::Graphics, {});
+		graph.Read(colorPass, depth, ImageUsage::Sampled);
+		graph.Read(colorPass, previousColor, ImageUsage::Sampled);
+		graph.SetSideEffect(colorPass);
+
+		check(!graph.Compile(), "A cycle compiled");
+	}
+	{
+		RenderGraph graph{};
+		const ImageHandle transient = graph.CreateTransient("Transient", {}, requirements(64, 64, 4));
+		const PassHandle readPass = graph.AddPass("Read", PassType::Compute, {});
+		graph.Read(readPass, transient, ImageUsage::Sampled);
+		graph.SetSideEffect(readPass);
+
+		check(!graph.Compile(), "A transient got read before anything wrote it");
+	}
+
+	LogInfo(isPassing ? "RenderGraph self test: Passed" : "RenderGraph self test: Failed");
+	return isPassing;
+}
@@ -0,0 +1,283 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <variant>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "Core/VmaUsage.h"
+
+class ColorAttachment;
+class DepthAttachment;
+class Texture;
+
+// How a pass uses an image, decides the layout, stages and access of the barrier in front of the pass
+enum class ImageUsage : uint8_t
+{
+	ColorAttachment,
+	DepthAttachment,
+	Sampled,
+	Storage,
+};
+
+enum class PassType : uint8_t
+{
+	Graphics,
+	Compute,
+};
+
+enum class QueueType : uint8_t
+{
+	Graphics,
+	Compute,
+};
+
+// The object behind a graph image, asked for its VkImage while recording and told the layout the graph left it in
+// std::monostate images only exist on the CPU, they let a schedule get compiled and validated without a device
+using GraphImage = std::variant<std::monostate, ColorAttachment*, DepthAttachment*, Texture*, VkImage>;
+
+// Every write of an image makes a new version of it, reads name the version they need
+// The dependencies between the passes follow from those versions
+struct ImageHandle
+{
+	uint32_t version{UINT32_MAX};
+
+	[[nodiscard]] bool IsValid() const { return version != UINT32_MAX; }
+};
+
+// Passes declare the images they read and write, Compile orders them, drops the ones nothing depends on and
+// derives the barriers in between, every pass gets at most one vkCmdPipelineBarrier2 in front of it
+// The first write of an image in a frame discards what was in it, attachments clear instead of load
+// With async compute the schedule gets split in submits per queue, a submit waits on the submit of the other queue it depends on
+class RenderGraph final
+{
+public:
+	using PassHandle = uint32_t;
+	using ExecuteFunction = std::function<void(VkCommandBuffer)>;
+
+	static constexpr uint32_t NoSubmit = UINT32_MAX;
+
+	struct Barrier
+	{
+		uint32_t resource{};
+		VkPipelineStageFlags2 srcStages{};
+		VkAccessFlags2 srcAccess{};
+		VkPipelineStageFlags2 dstStages{};
+		VkAccessFlags2 dstAccess{};
+		VkImageLayout oldLayout{};
+		VkImageLayout newLayout{};
+		// First write of the frame
+		bool isDiscard{};
+		// Queue family ownership transfers come in pairs, the release does the layout transition, the acquire only repeats it
+		bool isOwnershipTransfer{};
+		bool isAcquire{};
+		QueueType srcQueue{};
+		QueueType dstQueue{};
+	};
+
+	// The passes of one queue between two semaphore operations
+	struct Submit
+	{
+		QueueType queue{};
+		// Submit of the other queue that has to finish first
+		uint32_t waitSubmit{NoSubmit};
+		// Stages that wait on the semaphores of imported images, like the acquire of the swap chain image
+		VkPipelineStageFlags2 waitStages{VK_PIPELINE_STAGE_2_NONE};
+		// A submit of the other queue waits on this one
+		bool isSignaled{};
+		// Positions in the schedule
+		std::vector<uint32_t> passes{};
+		// Hand images over to the other queue, recorded after the last pass
+		std::vector<Barrier> releaseBarriers{};
+	};
+
+	RenderGraph() = default;
+	~RenderGraph() = default;
+	RenderGraph(const RenderGraph&) = delete;
+	RenderGraph& operator=(const RenderGraph&) = delete;
+	RenderGraph(RenderGraph&&) = delete;
+	RenderGraph& operator=(RenderGraph&&) = delete;
+
+	// Images that outlive the frame, a pass that writes one never gets culled
+	// finalLayout gets applied after the last pass, waitStage is the stage the semaphore wait of the submit covers
+	ImageHandle Import(const std::string& name, const GraphImage& image, VkImageAspectFlags aspect, VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED, VkPipelineStageFlags2 waitStage = VK_PIPELINE_STAGE_2_NONE);
+	// Images that only hold something from their first write to their last read, the ones whose lifetimes do not overlap share memory
+	ImageHandle CreateTransient(const std::string& name, const GraphImage& image, const VkMemoryRequirements& memoryRequirements);
+	// The swap chain hands out another image every frame, any version of the image works
+	void SetImage(ImageHandle image, const GraphImage& graphImage);
+	// The image got created with VK_SHARING_MODE_CONCURRENT, both queues can read it at the same time without ownership transfers
+	void SetConcurrent(ImageHandle image);
+
+	PassHandle AddPass(const std::string& name, PassType type, ExecuteFunction execute);
+	void Read(PassHandle pass, ImageHandle image, ImageUsage usage);
+	// Returns the version the passes after this one read
+	ImageHandle Write(PassHandle pass, ImageHandle image, ImageUsage usage);
+	// Kept even when nothing reads what it writes
+	void SetSideEffect(PassHandle pass);
+	// Only compute passes, they run on the compute queue once EnableAsyncCompute got called and inline on the graphics queue otherwise
+	void SetAsyncCompute(PassHandle pass);
+	// Call before Compile, the families are the ones the ownership transfers hand the images between
+	void EnableAsyncCompute(uint32_t graphicsFamily, uint32_t computeFamily);
+
+	// Sorts, culls, assigns the alias slots and derives the barriers, only runs on the CPU
+	// Returns false and logs why when the passes can not be scheduled
+	bool Compile();
+	// Rebinds the transients that share an alias slot to one allocation, needs a compiled graph
+	void AllocateTransients();
+	// Records the passes of one submit, the submits have to go to their queues in order
+	void Execute(uint32_t submitIndex, VkCommandBuffer commandBuffer);
+	void Cleanup();
+
+	// The last submit is always on the graphics queue and comes after every compute submit
+	[[nodiscard]] const std::vector<Submit>& GetSubmits() const { return m_Submits; }
+
+	void LogSchedule() const;
+	void OnImGui() const;
+
+	// Offline mode, compiles the passes of a frame with CPU only images and checks the schedule, sorting, culling, aliasing and the queue split
+	static bool SelfTest();
+
+private:
+	static constexpr uint32_t NoPass = UINT32_MAX;
+
+	struct Resource
+	{
+		std::string name{};
+		GraphImage image{};
+		VkImageAspectFlags aspect{};
+		VkImageLayout finalLayout{VK_IMAGE_LAYOUT_UNDEFINED};
+		VkPipelineStageFlags2 waitStage{VK_PIPELINE_STAGE_2_NONE};
+		VkMemoryRequirements memoryRequirements{};
+		bool isTransient{};
+		bool isConcurrent{};
+
+		// Transients share the memory of their alias slot, every other image has memory of its own
+		uint32_t memoryIndex{};
+		// Positions in the schedule
+		uint32_t firstUse{UINT32_MAX};
+		uint32_t lastUse{};
+		std::vector<uint32_t> uses{};
+	};
+
+	struct Version
+	{
+		uint32_t resource{};
+		uint32_t producer{NoPass};
+		std::vector<uint32_t> readers{};
+		bool isWritten{};
+	};
+
+	struct Access
+	{
+		// The version that gets read, or the one that gets written over
+		uint32_t version{};
+		ImageUsage usage{};
+		bool isWrite{};
+	};
+
+	struct Pass
+	{
+		std::string name{};
+		PassType type{};
+		ExecuteFunction execute{};
+		std::vector<Access> accesses{};
+		bool hasSideEffect{};
+		bool isAsync{};
+		bool isCulled{};
+	};
+
+	struct ScheduledPass
+	{
+		uint32_t pass{};
+		uint32_t submit{};
+		uint32_t firstBarrier{};
+		uint32_t barrierCount{};
+	};
+
+	struct AliasSlot
+	{
+		VkMemoryRequirements memoryRequirements{};
+		std::vector<uint32_t> resources{};
+		VmaAllocation memory{};
+	};
+
+	// What the barriers know about a block of memory, the last write and who saw it since
+	struct MemoryState
+	{
+		VkPipelineStageFlags2 writeStages{};
+		VkAccessFlags2 writeAccess{};
+		VkPipelineStageFlags2 readStages{};
+		VkPipelineStageFlags2 visibleStages{};
+		VkAccessFlags2 visibleAccess{};
+	};
+
+	struct Stats
+	{
+		uint32_t scheduledCount{};
+		uint32_t culledCount{};
+		uint32_t barrierCount{};
+		uint32_t batchCount{};
+		uint32_t submitCount{};
+		uint32_t asyncCount{};
+		VkDeviceSize transientBytes{};
+		VkDeviceSize aliasedBytes{};
+	};
+
+	struct UsageState
+	{
+		VkPipelineStageFlags2 stages{};
+		VkAccessFlags2 readAccess{};
+		VkAccessFlags2 writeAccess{};
+		VkImageLayout layout{};
+	};
+
+	static constexpr size_t QueueCount = 2;
+	// The submits wait on each other at every stage, a wait only ever sits in front of the passes that need it
+	static constexpr VkPipelineStageFlags2 SubmitWaitStage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+	// Depth gets sampled in the read only depth layout, a depth test can read it in the same layout at the same time
+	[[nodiscard]] static UsageState GetUsageState(ImageUsage usage, PassType type, bool isWrite, VkImageAspectFlags aspect);
+	[[nodiscard]] QueueType GetQueue(uint32_t passIndex) const;
+
+	[[nodiscard]] bool IsValidPass(PassHandle pass, const std::string& caller);
+	[[nodiscard]] bool IsValidImage(ImageHandle image, const std::string& caller);
+	[[nodiscard]] bool AddAccess(PassHandle pass, ImageHandle image, ImageUsage usage, bool isWrite);
+
+	void CullPasses();
+	[[nodiscard]] bool SortPasses();
+	// Cuts the schedule where a pass depends on the other queue, a submit only signals at its end so the one it depends on gets closed
+	void BuildSubmits();
+	// Whether the first position in the schedule finishes before the second starts, passes of different queues only when a wait orders them
+	[[nodiscard]] bool IsOrdered(uint32_t first, uint32_t second) const;
+	[[nodiscard]] bool AreLifetimesOverlapping(uint32_t firstResource, uint32_t secondResource) const;
+	void AssignAliasSlots();
+	// Runs the schedule twice, the second run starts from the state the first one ended in, like the next frame would
+	[[nodiscard]] bool DeriveBarriers();
+	[[nodiscard]] bool ValidateSchedule() const;
+
+	// One vkCmdPipelineBarrier2 for all of them, also tells the images the layout they end up in
+	void RecordBarriers(VkCommandBuffer commandBuffer, std::span<const Barrier> barriers);
+	[[nodiscard]] Stats GetStats() const;
+
+	std::vector<Resource> m_Resources{};
+	std::vector<Version> m_Versions{};
+	std::vector<Pass> m_Passes{};
+	bool m_HasDeclarationErrors{false};
+
+	std::vector<ScheduledPass> m_Schedule{};
+	std::vector<Submit> m_Submits{};
+	// m_IsSubmitOrdered[first * submit count + second]
+	std::vector<bool> m_IsSubmitOrdered{};
+	std::vector<Barrier> m_Barriers{};
+	std::vector<Barrier> m_FinalBarriers{};
+	std::vector<AliasSlot> m_AliasSlots{};
+	bool m_IsCompiled{false};
+
+	bool m_HasAsyncQueue{false};
+	std::array<uint32_t, QueueCount> m_QueueFamilies{};
+
+	std::vector<VkImageMemoryBarrier2> m_ImageBarriers{};
+};
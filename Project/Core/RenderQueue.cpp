@@ -0,0 +1,407 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <random>
+#include <string>
+
+#include "GeometryPool.h"
+#include "GlobalDescriptor.h"
+#include "IndirectRenderer.h"
+#include "Logger.h"
+#include "ParallelRecorder.h"
+#include "Mesh/Material.h"
+#include "vulkanbase/VulkanTypes.h"
+
+
+void RenderQueue::Clear()
+{
+	m_Items.clear();
+}
+
+void RenderQueue::Push(const DrawItem& item)
+{
+	m_Items.push_back(item);
+}
+
+void RenderQueue::Sort(const glm::mat4& viewMatrix)
+{
+	const auto sortStart = std::chrono::steady_clock::now();
+
+	m_SortEntries.resize(m_Items.size());
+	for (uint32_t itemIndex{}; itemIndex < m_Items.size(); ++itemIndex)
+	{
+		m_SortEntries[itemIndex] = {MakeSortKey(m_Items[itemIndex], viewMatrix), itemIndex};
+	}
+	RadixSort(m_SortEntries, m_SortScratch);
+
+	m_LastSortMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - sortStart).count();
+
+	BuildInstances();
+}
+
+void RenderQueue::Submit(VulkanContext* vulkanContext, VkCommandBuffer commandBuffer, const RenderingFormats& formats)
+{
+	SubmitBatches(vulkanContext, commandBuffer, false, formats);
+}
+
+void RenderQueue::SubmitDepth(VulkanContext* vulkanContext, VkCommandBuffer commandBuffer, const RenderingFormats& formats)
+{
+	SubmitBatches(vulkanContext, commandBuffer, true, formats);
+}
+
+void RenderQueue::BuildInstances()
+{
+	m_Batches.clear();
+	for (uint32_t instanceIndex{}; instanceIndex < m_SortEntries.size(); ++instanceIndex)
+	{
+		const DrawItem& item = m_Items[m_SortEntries[instanceIndex].itemIndex];
+		if (m_Batches.empty() || m_Batches.back().material != item.material || m_Batches.back().indexType != item.indexType)
+		{
+			m_Batches.push_back({item.material, item.depthMaterial, item.indexType, instanceIndex, 0});
+		}
+		++m_Batches.back().instanceCount;
+	}
+
+	//Instance i is the i-th sorted draw, the CPU path draws it with firstInstance i and the culling pass writes that same value
+	GpuInstance* pInstances = IndirectRenderer::MapInstances(static_cast<uint32_t>(m_SortEntries.size()), static_cast<uint32_t>(m_Batches.size()));
+	for (uint32_t batchIndex{}; batchIndex < m_Batches.size(); ++batchIndex)
+	{
+		const Batch& batch = m_Batches[batchIndex];
+		for (uint32_t instanceIndex{batch.firstInstance}; instanceIndex < batch.firstInstance + batch.instanceCount; ++instanceIndex)
+		{
+			const DrawItem& item = m_Items[m_SortEntries[instanceIndex].itemIndex];
+
+			GpuInstance& instance = pInstances[instanceIndex];
+			instance.transform = item.transform;
+			instance.boundingSphere = item.boundingSphere;
+			instance.indexCount = item.indexCount;
+			instance.firstIndex = item.firstIndex;
+			instance.vertexOffset = item.vertexOffset;
+			instance.batch = batchIndex;
+			instance.firstCommand = batch.firstInstance;
+		}
+	}
+}
+
+void RenderQueue::SubmitBatches(VulkanContext* vulkanContext, VkCommandBuffer commandBuffer, bool isDepthPass, const RenderingFormats& formats)
+{
+	PrepareDescriptorSets(isDepthPass);
+	const uint32_t batchCount = static_cast<uint32_t>(m_Batches.size());
+
+	Stats stats{};
+	if (!ParallelRecorder::IsEnabled())
+	{
+		stats = RecordBatches(vulkanContext, commandBuffer, isDepthPass, 0, batchCount);
+	}
+	else
+	{
+		const uint32_t chunkCount = ParallelRecorder::GetChunkCount();
+		SplitBatches(chunkCount);
+
+		std::vector<Stats> chunkStats(chunkCount);
+		ParallelRecorder::Record(commandBuffer, formats, [&](VkCommandBuffer secondaryCommandBuffer, uint32_t chunkIndex)
+		{
+			VulkanWindow::SetViewportCmd(secondaryCommandBuffer);
+			chunkStats[chunkIndex] = RecordBatches(vulkanContext, secondaryCommandBuffer, isDepthPass, m_ChunkStarts[chunkIndex], m_ChunkStarts[chunkIndex + 1]);
+		});
+
+		for (const Stats& chunk : chunkStats)
+		{
+			stats.draws += chunk.draws;
+			stats.instances += chunk.instances;
+			stats.pipelineBinds += chunk.pipelineBinds;
+			stats.pipelineBindsAvoided += chunk.pipelineBindsAvoided;
+			stats.setBinds += chunk.setBinds;
+			stats.setBindsAvoided += chunk.setBindsAvoided;
+		}
+	}
+
+	if (!isDepthPass) m_LastStats = stats;
+}
+
+void RenderQueue::PrepareDescriptorSets(bool isDepthPass)
+{
+	m_BatchSets.resize(m_Batches.size());
+	Material* previousMaterial{};
+	for (uint32_t batchIndex{}; batchIndex < m_Batches.size(); ++batchIndex)
+	{
+		Material* material = isDepthPass ? m_Batches[batchIndex].depthMaterial : m_Batches[batchIndex].material;
+		if (material != previousMaterial)
+		{
+			m_BatchSets[batchIndex] = material->PrepareDescriptorSet();
+			previousMaterial = material;
+		}
+		else m_BatchSets[batchIndex] = m_BatchSets[batchIndex - 1];
+	}
+}
+
+void RenderQueue::SplitBatches(uint32_t chunkCount)
+{
+	const uint32_t instanceCount = static_cast<uint32_t>(m_SortEntries.size());
+
+	//A chunk ends at the first batch boundary past its share of the instances, so a chunk can also stay empty
+	m_ChunkStarts.assign(chunkCount + 1, static_cast<uint32_t>(m_Batches.size()));
+	m_ChunkStarts[0] = 0;
+	uint32_t chunkIndex{1};
+	for (uint32_t batchIndex{}; batchIndex < m_Batches.size() && chunkIndex < chunkCount; ++batchIndex)
+	{
+		const Batch& batch = m_Batches[batchIndex];
+		while (chunkIndex < chunkCount && batch.firstInstance + batch.instanceCount >= static_cast<uint64_t>(instanceCount) * chunkIndex / chunkCount)
+		{
+			m_ChunkStarts[chunkIndex++] = batchIndex + 1;
+		}
+	}
+}
+
+RenderQueue::Stats RenderQueue::RecordBatches(VulkanContext* vulkanContext, VkCommandBuffer commandBuffer, bool isDepthPass, uint32_t firstBatch, uint32_t endBatch)
+{
+	Stats stats{};
+	if (firstBatch >= endBatch) return stats;
+
+	const auto getMaterial = [isDepthPass](const Batch& batch) { return isDepthPass ? batch.depthMaterial : batch.material; };
+	GeometryPool::Bind(commandBuffer);
+	GlobalDescriptor::Bind(vulkanContext, commandBuffer, getMaterial(m_Batches[firstBatch])->GetPipelineLayout());
+
+	const bool drawIndirect = IndirectRenderer::IsEnabled();
+	int32_t boundPipeline{-1};
+	VkDescriptorSet boundSet{VK_NULL_HANDLE};
+	VkIndexType boundIndexType{VK_INDEX_TYPE_UINT32};
+	for (uint32_t batchIndex{firstBatch}; batchIndex < endBatch; ++batchIndex)
+	{
+		const Batch& batch = m_Batches[batchIndex];
+		const Material* material = getMaterial(batch);
+
+		//Without culling every run of the same primitive is its own draw, with the same pipeline and set as the rest of the batch
+		const uint32_t drawCount = drawIndirect ? 1 : CountInstancedDraws(batch);
+		stats.draws += drawCount;
+		stats.instances += batch.instanceCount;
+
+		if (boundPipeline != material->GetPipelineSortId())
+		{
+			material->BindPipeline(commandBuffer);
+			boundPipeline = material->GetPipelineSortId();
+			++stats.pipelineBinds;
+			stats.pipelineBindsAvoided += drawCount - 1;
+		}
+		else stats.pipelineBindsAvoided += drawCount;
+
+		if (boundSet != m_BatchSets[batchIndex])
+		{
+			material->BindDescriptorSet(commandBuffer, m_BatchSets[batchIndex]);
+			boundSet = m_BatchSets[batchIndex];
+			++stats.setBinds;
+			stats.setBindsAvoided += drawCount - 1;
+		}
+		else stats.setBindsAvoided += drawCount;
+
+		if (boundIndexType != batch.indexType)
+		{
+			GeometryPool::BindIndexBuffer(commandBuffer, batch.indexType);
+			boundIndexType = batch.indexType;
+		}
+		if (drawIndirect)
+		{
+			IndirectRenderer::DrawBatch(commandBuffer, batchIndex, batch.firstInstance, batch.instanceCount);
+			continue;
+		}
+
+		const uint32_t batchEnd = batch.firstInstance + batch.instanceCount;
+		for (uint32_t instanceIndex{batch.firstInstance}; instanceIndex < batchEnd;)
+		{
+			const uint32_t runEnd = FindRunEnd(instanceIndex, batchEnd);
+			const DrawItem& item = m_Items[m_SortEntries[instanceIndex].itemIndex];
+			vkCmdDrawIndexed(commandBuffer, item.indexCount, runEnd - instanceIndex, item.firstIndex, item.vertexOffset, instanceIndex);
+			instanceIndex = runEnd;
+		}
+	}
+
+	//The global set stays bound across every pipeline of the queue
+	stats.setBindsAvoided += stats.draws - 1;
+	return stats;
+}
+
+uint32_t RenderQueue::FindRunEnd(uint32_t firstInstance, uint32_t batchEnd)
+{
+	const DrawItem& first = m_Items[m_SortEntries[firstInstance].itemIndex];
+
+	uint32_t runEnd{firstInstance + 1};
+	for (; runEnd < batchEnd; ++runEnd)
+	{
+		//The geometry id can collide, the draw parameters decide
+		const DrawItem& item = m_Items[m_SortEntries[runEnd].itemIndex];
+		if (item.firstIndex != first.firstIndex || item.indexCount != first.indexCount || item.vertexOffset != first.vertexOffset) break;
+	}
+	return runEnd;
+}
+
+uint32_t RenderQueue::CountInstancedDraws(const Batch& batch)
+{
+	uint32_t drawCount{};
+	const uint32_t batchEnd = batch.firstInstance + batch.instanceCount;
+	for (uint32_t instanceIndex{batch.firstInstance}; instanceIndex < batchEnd; instanceIndex = FindRunEnd(instanceIndex, batchEnd))
+	{
+		++drawCount;
+	}
+	return drawCount;
+}
+
+void RenderQueue::OnImGui()
+{
+	ImGui::Begin("Info");
+	ImGui::SeparatorText("Render Queue");
+	ImGui::Text("Draws: %u for %u instances (sorted in %.3f ms)", m_LastStats.draws, m_LastStats.instances, m_LastSortMs);
+	ImGui::Text("Pipeline binds: %u, avoided %u", m_LastStats.pipelineBinds, m_LastStats.pipelineBindsAvoided);
+	ImGui::Text("Descriptor set binds: %u, avoided %u", m_LastStats.setBinds, m_LastStats.setBindsAvoided);
+	ImGui::End();
+}
+
+void RenderQueue::Benchmark(uint32_t drawCount)
+{
+	constexpr uint16_t pipelineCount = 16;
+	constexpr uint16_t materialCount = 256;
+
+	//Meshes get added in file order, which has nothing to do with their material
+	std::mt19937 random{1337};
+	std::uniform_int_distribution<uint32_t> materialDistribution{0, materialCount - 1};
+	std::uniform_real_distribution<float> positionDistribution{-100.0f, 100.0f};
+
+	std::vector<DrawItem> items(drawCount);
+	for (DrawItem& item : items)
+	{
+		item.materialId = static_cast<uint16_t>(materialDistribution(random));
+		item.pipelineId = item.materialId % pipelineCount;
+		item.transform[3] = glm::vec4(positionDistribution(random), positionDistribution(random), positionDistribution(random), 1.0f);
+	}
+
+	const glm::mat4 viewMatrix{1};
+	constexpr int iterations = 100;
+
+	std::vector<SortEntry> entries(drawCount);
+	std::vector<SortEntry> scratch{};
+	float radixMs{};
+	float stdSortMs{};
+	for (int iteration{}; iteration < iterations; ++iteration)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t itemIndex{}; itemIndex < drawCount; ++itemIndex)
+		{
+			entries[itemIndex] = {MakeSortKey(items[itemIndex], viewMatrix), itemIndex};
+		}
+		RadixSort(entries, scratch);
+		radixMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		for (uint32_t itemIndex{}; itemIndex < drawCount; ++itemIndex)
+		{
+			entries[itemIndex] = {MakeSortKey(items[itemIndex], viewMatrix), itemIndex};
+		}
+		std::sort(entries.begin(), entries.end(), [](const SortEntry& a, const SortEntry& b) { return a.key < b.key; });
+		stdSortMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	std::vector<SortEntry> insertionOrder(drawCount);
+	for (uint32_t itemIndex{}; itemIndex < drawCount; ++itemIndex)
+	{
+		insertionOrder[itemIndex] = {0, itemIndex};
+	}
+	const Stats unsortedStats = CountStateChanges(items, insertionOrder);
+	const Stats sortedStats = CountStateChanges(items, entries);
+
+	LogInfo("Render queue with " + std::to_string(drawCount) + " draws, " + std::to_string(pipelineCount) + " pipelines, " + std::to_string(materialCount) + " materials");
+	LogInfo("  Build keys + radix sort: " + std::to_string(radixMs / iterations) + "ms, std::sort: " + std::to_string(stdSortMs / iterations) + "ms");
+	LogInfo("  Pipeline binds: " + std::to_string(unsortedStats.pipelineBinds) + " -> " + std::to_string(sortedStats.pipelineBinds));
+	LogInfo("  Material set binds: " + std::to_string(unsortedStats.setBinds) + " -> " + std::to_string(sortedStats.setBinds));
+}
+
+uint64_t RenderQueue::MakeSortKey(const DrawItem& item, const glm::mat4& viewMatrix)
+{
+	//The camera looks down -z, positive floats keep their order when compared as integers and never set the top bit
+	//The top 15 bits are the exponent and 7 bits of mantissa, enough to draw roughly front to back
+	const float viewDepth = std::max(-(viewMatrix * item.transform[3]).z, 0.0f);
+	const uint64_t indexTypeBit = item.indexType == VK_INDEX_TYPE_UINT16 ? 1ull << 31 : 0;
+
+	return static_cast<uint64_t>(item.pipelineId) << 48
+		| static_cast<uint64_t>(item.materialId) << 32
+		| indexTypeBit
+		| static_cast<uint64_t>(item.geometryId) << 15
+		| std::bit_cast<uint32_t>(viewDepth) >> 16;
+}
+
+void RenderQueue::RadixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch)
+{
+	constexpr uint32_t digitCount = sizeof(uint64_t);
+	constexpr uint32_t bucketCount = 256;
+	if (entries.size() < 2) return;
+
+	//All histograms in one pass over the keys
+	std::array<std::array<uint32_t, bucketCount>, digitCount> histograms{};
+	for (const SortEntry& entry : entries)
+	{
+		for (uint32_t digit{}; digit < digitCount; ++digit)
+		{
+			++histograms[digit][(entry.key >> (digit * 8)) & 0xFF];
+		}
+	}
+
+	scratch.resize(entries.size());
+	std::vector<SortEntry>* source = &entries;
+	std::vector<SortEntry>* destination = &scratch;
+	for (uint32_t digit{}; digit < digitCount; ++digit)
+	{
+		std::array<uint32_t, bucketCount>& histogram = histograms[digit];
+
+		//Most of the high bits are the same for every draw, the pass would only copy
+		const uint32_t firstBucket = (entries.front().key >> (digit * 8)) & 0xFF;
+		if (histogram[firstBucket] == entries.size()) continue;
+
+		uint32_t offset{};
+		for (uint32_t& bucket : histogram)
+		{
+			const uint32_t count = bucket;
+			bucket = offset;
+			offset += count;
+		}
+
+		for (const SortEntry& entry : *source)
+		{
+			(*destination)[histogram[(entry.key >> (digit * 8)) & 0xFF]++] = entry;
+		}
+		std::swap(source, destination);
+	}
+
+	if (source != &entries)
+	{
+		entries.swap(scratch);
+	}
+}
+
+RenderQueue::Stats RenderQueue::CountStateChanges(const std::vector<DrawItem>& items, const std::vector<SortEntry>& order)
+{
+	Stats stats{};
+	int32_t boundPipeline{-1};
+	int32_t boundMaterial{-1};
+	for (const SortEntry& entry : order)
+	{
+		const DrawItem& item = items[entry.itemIndex];
+		++stats.draws;
+		++stats.instances;
+
+		if (boundPipeline != item.pipelineId)
+		{
+			boundPipeline = item.pipelineId;
+			++stats.pipelineBinds;
+		}
+		else ++stats.pipelineBindsAvoided;
+
+		if (boundMaterial != item.materialId)
+		{
+			boundMaterial = item.materialId;
+			++stats.setBinds;
+		}
+		else ++stats.setBindsAvoided;
+	}
+	return stats;
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/mat4x4.hpp>
+#include <vulkan/vulkan.h>
+
+class Material;
+class VulkanContext;
+struct RenderingFormats;
+
+// Everything needed to record one indexed draw, collected by the meshes before any command gets recorded
+struct DrawItem
+{
+	Material* material{};
+	// Used by the depth pass, has to match the vertex format of the material
+	Material* depthMaterial{};
+	uint16_t pipelineId{};
+	uint16_t materialId{};
+	// Same for every copy of a primitive, keeps them next to each other so they become one instanced draw
+	uint16_t geometryId{};
+
+	VkIndexType indexType{VK_INDEX_TYPE_UINT32};
+	uint32_t indexCount{};
+	uint32_t firstIndex{};
+	int32_t vertexOffset{};
+
+	glm::mat4 transform{1};
+	// Local space center and radius, a negative radius never gets culled
+	glm::vec4 boundingSphere{0, 0, 0, -1};
+};
+
+// Collects the draws of the frame, sorts them on a 64 bit key and records them with as few state changes as possible
+// Key layout, high to low: pipeline (16 bits) | material (16 bits) | index type (1 bit) | geometry (16 bits) | view depth (15 bits, front to back)
+// Consecutive draws of the same primitive get recorded as one instanced draw, the instance index picks the transform
+// Every material pipeline layout shares set 0 and the push constant range, so the global set is bound once for the whole queue
+// The sorted draws become the instances of IndirectRenderer, runs of the same material and index type form a batch
+// With GPU culling every batch is one vkCmdDrawIndexedIndirectCount, otherwise every draw gets recorded here
+// With ParallelRecorder enabled the batches get split in chunks of about the same instance count, each recorded on its own thread
+class RenderQueue final
+{
+public:
+	RenderQueue() = default;
+	~RenderQueue() = default;
+	RenderQueue(const RenderQueue&) = delete;
+	RenderQueue& operator=(const RenderQueue&) = delete;
+	RenderQueue(RenderQueue&&) = delete;
+	RenderQueue& operator=(RenderQueue&&) = delete;
+
+	static void Clear();
+	static void Push(const DrawItem& item);
+
+	// Builds the keys with the depth along the view direction, radix sorts them and writes the instances of this frame
+	// Call before GlobalDescriptor::UpdateFrameConstants, the instance buffer can get replaced
+	static void Sort(const glm::mat4& viewMatrix);
+	// Expects GlobalDescriptor::UpdateFrameConstants to have happened already, binds the geometry itself
+	// The formats are the attachments of the rendering scope, the secondary command buffers need them
+	static void Submit(VulkanContext* vulkanContext, VkCommandBuffer commandBuffer, const RenderingFormats& formats);
+	// Same draws with the depth material of every batch
+	static void SubmitDepth(VulkanContext* vulkanContext, VkCommandBuffer commandBuffer, const RenderingFormats& formats);
+
+	static void OnImGui();
+
+	// Offline mode, times the sort on a synthetic scene and counts the state changes it saves
+	static void Benchmark(uint32_t drawCount);
+
+private:
+	struct SortEntry
+	{
+		uint64_t key{};
+		uint32_t itemIndex{};
+	};
+
+	struct Batch
+	{
+		Material* material{};
+		Material* depthMaterial{};
+		VkIndexType indexType{VK_INDEX_TYPE_UINT32};
+		uint32_t firstInstance{};
+		uint32_t instanceCount{};
+	};
+
+	struct Stats
+	{
+		uint32_t draws{};
+		uint32_t instances{};
+		uint32_t pipelineBinds{};
+		uint32_t pipelineBindsAvoided{};
+		uint32_t setBinds{};
+		uint32_t setBindsAvoided{};
+	};
+
+	static void BuildInstances();
+	// Records the batches with either the material or the depth material of each
+	static void SubmitBatches(VulkanContext* vulkanContext, VkCommandBuffer commandBuffer, bool isDepthPass, const RenderingFormats& formats);
+	// Writes the material sets on the calling thread, recording only binds them
+	static void PrepareDescriptorSets(bool isDepthPass);
+	// Splits the batches in chunkCount ranges of about the same instance count
+	static void SplitBatches(uint32_t chunkCount);
+	// Thread safe, only reads the queue and records into commandBuffer
+	[[nodiscard]] static Stats RecordBatches(VulkanContext* vulkanContext, VkCommandBuffer commandBuffer, bool isDepthPass, uint32_t firstBatch, uint32_t endBatch);
+	// First sorted draw after firstInstance that is not a copy of the same primitive
+	[[nodiscard]] static uint32_t FindRunEnd(uint32_t firstInstance, uint32_t batchEnd);
+	[[nodiscard]] static uint32_t CountInstancedDraws(const Batch& batch);
+
+	[[nodiscard]] static uint64_t MakeSortKey(const DrawItem& item, const glm::mat4& viewMatrix);
+	// LSD radix sort on 8 bit digits, digits that are equal for every key get skipped
+	static void RadixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch);
+	[[nodiscard]] static Stats CountStateChanges(const std::vector<DrawItem>& items, const std::vector<SortEntry>& order);
+
+	inline static std::vector<DrawItem> m_Items{};
+	inline static std::vector<SortEntry> m_SortEntries{};
+	inline static std::vector<SortEntry> m_SortScratch{};
+	inline static std::vector<Batch> m_Batches{};
+	inline static std::vector<VkDescriptorSet> m_BatchSets{};
+	inline static std::vector<uint32_t> m_ChunkStarts{};
+
+	inline static Stats m_LastStats{};
+	inline static float m_LastSortMs{};
+};
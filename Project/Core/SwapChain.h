@@ -129,10 +129,12 @@ public:
 		if (!m_NeedsRecreation) return;
 
 	    LogInfo("Recreating SwapChain");
+		//Frames in flight can still render to the old images
+		vkDeviceWaitIdle(vulkanContext->device);
 		DestroySwapChain(vulkanContext);
 		Init(vulkanContext);
-		vkDeviceWaitIdle(vulkanContext->device);
 
+		++m_RecreationCount;
 	    OnSwapChainRecreated.Broadcast(vulkanContext);
 		m_NeedsRecreation = false;
 	}
@@ -140,6 +142,9 @@ public:
 
 
 	static void SetImageIndex(uint32_t index) { m_ImageIndex = index; }
+	static uint32_t GetImageIndex() { return m_ImageIndex; }
+	//Everything sized to the swapchain gets new handles on a recreation, cached descriptor sets use this to notice
+	static uint32_t GetRecreationCount() { return m_RecreationCount; }
 	static void Bind(Descriptor::DescriptorWriter& descriptorWriter, int binding);
 private:
 	struct SwapChainSupportDetails
@@ -150,6 +155,7 @@ private:
 	};
 
 	static inline uint32_t m_ImageIndex = 0;
+	static inline uint32_t m_RecreationCount = 0;
 
 	static SwapChainSupportDetails GetSupportDetails(VkPhysicalDevice device)
 	{
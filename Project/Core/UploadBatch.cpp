@@ -0,0 +1,384 @@
+#include "UploadBatch.h"
+
+#include <cstring>
+#include <string>
+
+#include "Buffer.h"
+#include "Logger.h"
+#include "Image/MipGenerator.h"
+#include "vulkanbase/VulkanTypes.h"
+#include "vulkanbase/VulkanUtil.h"
+
+
+void UploadBatch::Init(VulkanContext* vulkanContext, VkDeviceSize ringSize)
+{
+	m_pContext = vulkanContext;
+	m_RingSize = ringSize;
+	m_RingHead = 0;
+	m_RingTail = 0;
+
+	Core::Buffer::CreateBuffer(m_RingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, m_RingBuffer, m_RingMemory, true, true);
+
+	VmaAllocationInfo allocationInfo{};
+	vmaGetAllocationInfo(Allocator::vmaAllocator, m_RingMemory, &allocationInfo);
+	m_pRingData = static_cast<uint8_t*>(allocationInfo.pMappedData);
+}
+
+void UploadBatch::Cleanup(const VulkanContext* vulkanContext)
+{
+	if (m_Recording)
+	{
+		Flush();
+	}
+	RetireAll();
+
+	for (Submission& submission : m_FreeSubmissions)
+	{
+		CommandBufferManager::FreeCommandBuffer(vulkanContext->device, vulkanContext->commandPool, submission.commandBuffer);
+		vkDestroyFence(vulkanContext->device, submission.fence, nullptr);
+	}
+	m_FreeSubmissions.clear();
+
+	vmaDestroyBuffer(Allocator::vmaAllocator, m_RingBuffer, m_RingMemory);
+	m_RingBuffer = VK_NULL_HANDLE;
+	m_pRingData = nullptr;
+}
+
+void UploadBatch::Begin()
+{
+	if (m_Depth++ > 0) return;
+
+	m_BatchStats = {};
+	m_BatchStartTime = std::chrono::steady_clock::now();
+	StartRecording();
+}
+
+void UploadBatch::End()
+{
+	if (m_Depth == 0)
+	{
+		LogError("UploadBatch::End called without a matching Begin");
+		return;
+	}
+
+	if (--m_Depth > 0) return;
+
+	Flush();
+
+	m_BatchStats.wallTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_BatchStartTime).count();
+	m_LastBatchStats = m_BatchStats;
+
+	m_TotalStats.bytesUploaded += m_BatchStats.bytesUploaded;
+	m_TotalStats.copies += m_BatchStats.copies;
+	m_TotalStats.submits += m_BatchStats.submits;
+	m_TotalStats.wallTimeMs += m_BatchStats.wallTimeMs;
+
+	LogInfo("Upload batch: " + std::to_string(m_BatchStats.copies) + " copies, " + std::to_string(m_BatchStats.bytesUploaded) + " bytes, " + std::to_string(m_BatchStats.submits) + " submits in " + std::to_string(m_BatchStats.wallTimeMs) + "ms");
+}
+
+void UploadBatch::WaitIdle()
+{
+	RetireAll();
+}
+
+StagingAllocation UploadBatch::AllocateStaging(VkDeviceSize size, VkDeviceSize alignment)
+{
+	LogAssert(m_Depth > 0, "Staging memory can only be allocated inside an UploadBatch", true)
+
+	//Too big for the ring, give it its own staging buffer that lives as long as this batch
+	if (size > m_RingSize)
+	{
+		StagingAllocation staging{};
+		VmaAllocation stagingMemory{};
+		Core::Buffer::CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, staging.buffer, stagingMemory, true, true);
+
+		VmaAllocationInfo allocationInfo{};
+		vmaGetAllocationInfo(Allocator::vmaAllocator, stagingMemory, &allocationInfo);
+		staging.mappedData = allocationInfo.pMappedData;
+
+		m_Recording->releasedBuffers.emplace_back(staging.buffer, stagingMemory);
+		return staging;
+	}
+
+	VkDeviceSize offset{};
+	while (!TryAllocateRing(size, alignment, offset))
+	{
+		if (!m_PendingSubmissions.empty())
+		{
+			RetireOldest();
+			continue;
+		}
+
+		//The batch that is being recorded filled the whole ring, submit what we have and start over
+		Flush();
+		RetireAll();
+		StartRecording();
+	}
+
+	return {m_RingBuffer, offset, m_pRingData + offset};
+}
+
+void UploadBatch::UploadBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset)
+{
+	if (size == 0) return;
+
+	const bool isImplicitBatch = m_Depth == 0;
+	if (isImplicitBatch) Begin();
+
+	const StagingAllocation staging = AllocateStaging(size);
+	memcpy(staging.mappedData, data, size);
+	CopyBuffer(staging, size, dstBuffer, dstOffset);
+
+	if (isImplicitBatch) End();
+}
+
+void UploadBatch::CopyBuffer(const StagingAllocation& staging, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset)
+{
+	VkBufferCopy copyRegion{};
+	copyRegion.srcOffset = staging.offset;
+	copyRegion.dstOffset = dstOffset;
+	copyRegion.size = size;
+
+	vkCmdCopyBuffer(GetRecordingCommandBuffer(), staging.buffer, dstBuffer, 1, &copyRegion);
+
+	m_BatchStats.bytesUploaded += size;
+	++m_BatchStats.copies;
+}
+
+void UploadBatch::CopyBufferRegions(VkBuffer srcBuffer, VkBuffer dstBuffer, const std::vector<VkBufferCopy>& regions)
+{
+	if (regions.empty()) return;
+
+	const bool isImplicitBatch = m_Depth == 0;
+	if (isImplicitBatch) Begin();
+
+	VkCommandBuffer commandBuffer = GetRecordingCommandBuffer();
+
+	VkMemoryBarrier memoryBarrier{};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+	vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, static_cast<uint32_t>(regions.size()), regions.data());
+
+	for (const VkBufferCopy& region : regions)
+	{
+		m_BatchStats.bytesUploaded += region.size;
+	}
+	++m_BatchStats.copies;
+
+	if (isImplicitBatch) End();
+}
+
+void UploadBatch::ReleaseAfterBatch(VkBuffer buffer, VmaAllocation memory)
+{
+	const bool isImplicitBatch = m_Depth == 0;
+	if (isImplicitBatch) Begin();
+
+	m_Recording->releasedBuffers.emplace_back(buffer, memory);
+
+	if (isImplicitBatch) End();
+}
+
+void UploadBatch::UploadImage(VkBuffer stagingBuffer, VmaAllocation stagingMemory, VkImage image, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange, std::optional<VkExtent2D> mipExtent)
+{
+	const bool isImplicitBatch = m_Depth == 0;
+	if (isImplicitBatch) Begin();
+
+	RecordImageCopy(stagingBuffer, image, regions, subresourceRange, mipExtent);
+
+	VmaAllocationInfo allocationInfo{};
+	vmaGetAllocationInfo(Allocator::vmaAllocator, stagingMemory, &allocationInfo);
+	m_BatchStats.bytesUploaded += allocationInfo.size;
+
+	m_Recording->releasedBuffers.emplace_back(stagingBuffer, stagingMemory);
+
+	if (isImplicitBatch) End();
+}
+
+void UploadBatch::UploadImage(const StagingAllocation& staging, VkDeviceSize size, VkImage image, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange, std::optional<VkExtent2D> mipExtent)
+{
+	//The regions are relative to the staging allocation
+	std::vector<VkBufferImageCopy> offsetRegions = regions;
+	for (VkBufferImageCopy& region : offsetRegions)
+	{
+		region.bufferOffset += staging.offset;
+	}
+
+	RecordImageCopy(staging.buffer, image, offsetRegions, subresourceRange, mipExtent);
+	m_BatchStats.bytesUploaded += size;
+}
+
+void UploadBatch::OnImGui()
+{
+	ImGui::Begin("Info");
+	ImGui::SeparatorText("Uploads");
+	ImGui::Text("Last batch: %u copies, %.2f MB, %u submits, %.3f ms", m_LastBatchStats.copies, static_cast<double>(m_LastBatchStats.bytesUploaded) / (1024.0 * 1024.0), m_LastBatchStats.submits, m_LastBatchStats.wallTimeMs);
+	ImGui::Text("Total: %u copies, %.2f MB, %u submits, %.3f ms", m_TotalStats.copies, static_cast<double>(m_TotalStats.bytesUploaded) / (1024.0 * 1024.0), m_TotalStats.submits, m_TotalStats.wallTimeMs);
+	ImGui::End();
+}
+
+void UploadBatch::StartRecording()
+{
+	VkDevice device = m_pContext->device;
+
+	//Reclaim everything the GPU already finished without blocking
+	while (!m_PendingSubmissions.empty() && vkGetFenceStatus(device, m_PendingSubmissions.front().fence) == VK_SUCCESS)
+	{
+		RetireOldest();
+	}
+
+	Submission submission{};
+	if (!m_FreeSubmissions.empty())
+	{
+		submission = std::move(m_FreeSubmissions.back());
+		m_FreeSubmissions.pop_back();
+
+		CommandBufferManager::ResetCommandBuffer(submission.commandBuffer);
+		vkResetFences(device, 1, &submission.fence);
+	}
+	else
+	{
+		CommandBufferManager::CreateCommandBuffer(m_pContext, submission.commandBuffer);
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		VulkanCheck(vkCreateFence(device, &fenceInfo, nullptr, &submission.fence), "Failed to create upload fence")
+	}
+
+	CommandBufferManager::BeginCommandBufferRecording(submission.commandBuffer, false, false, true);
+	m_Recording = std::move(submission);
+}
+
+void UploadBatch::Flush()
+{
+	if (!m_Recording) return;
+
+	Submission& submission = m_Recording.value();
+	VkCommandBuffer commandBuffer = submission.commandBuffer.Handle;
+
+	//Make the copies visible to everything that reads them in later submissions on this queue
+	VkMemoryBarrier memoryBarrier{};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+	const VkPipelineStageFlags dstStages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStages, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+	CommandBufferManager::EndCommandBufferRecording(submission.commandBuffer);
+
+	//The ring might not be host coherent
+	vmaFlushAllocation(Allocator::vmaAllocator, m_RingMemory, 0, VK_WHOLE_SIZE);
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	CommandBufferManager::SubmitCommandBuffer(m_pContext, submission.commandBuffer, &submitInfo, submission.fence);
+
+	submission.ringEnd = m_RingHead;
+	m_PendingSubmissions.push_back(std::move(submission));
+	m_Recording.reset();
+
+	++m_BatchStats.submits;
+}
+
+void UploadBatch::RetireOldest()
+{
+	if (m_PendingSubmissions.empty()) return;
+
+	Submission submission = std::move(m_PendingSubmissions.front());
+	m_PendingSubmissions.pop_front();
+
+	vkWaitForFences(m_pContext->device, 1, &submission.fence, VK_TRUE, UINT64_MAX);
+
+	for (const auto& [buffer, memory] : submission.releasedBuffers)
+	{
+		vmaDestroyBuffer(Allocator::vmaAllocator, buffer, memory);
+	}
+	submission.releasedBuffers.clear();
+
+	m_RingTail = submission.ringEnd;
+	m_FreeSubmissions.push_back(std::move(submission));
+
+	//Nothing is using the ring anymore, start at the front again so big allocations fit
+	if (m_RingTail == m_RingHead)
+	{
+		m_RingHead = 0;
+		m_RingTail = 0;
+	}
+}
+
+void UploadBatch::RetireAll()
+{
+	while (!m_PendingSubmissions.empty())
+	{
+		RetireOldest();
+	}
+}
+
+bool UploadBatch::TryAllocateRing(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+{
+	const VkDeviceSize alignedHead = (m_RingHead + alignment - 1) / alignment * alignment;
+
+	if (m_RingHead >= m_RingTail)
+	{
+		//Free space is [head, end) and [0, tail)
+		if (alignedHead + size <= m_RingSize)
+		{
+			offset = alignedHead;
+			m_RingHead = alignedHead + size;
+			return true;
+		}
+
+		//Wrap around, the head is never allowed to catch up with the tail
+		if (size < m_RingTail)
+		{
+			offset = 0;
+			m_RingHead = size;
+			return true;
+		}
+
+		return false;
+	}
+
+	//Free space is [head, tail)
+	if (alignedHead + size < m_RingTail)
+	{
+		offset = alignedHead;
+		m_RingHead = alignedHead + size;
+		return true;
+	}
+
+	return false;
+}
+
+VkCommandBuffer UploadBatch::GetRecordingCommandBuffer()
+{
+	LogAssert(m_Recording.has_value(), "No UploadBatch is being recorded", true)
+	return m_Recording->commandBuffer.Handle;
+}
+
+void UploadBatch::RecordImageCopy(VkBuffer srcBuffer, VkImage image, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange, std::optional<VkExtent2D> mipExtent)
+{
+	VkCommandBuffer commandBuffer = GetRecordingCommandBuffer();
+
+	//Transition the image to transfer destination
+	tools::InsertImageMemoryBarrier(commandBuffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange);
+
+	vkCmdCopyBufferToImage(commandBuffer, srcBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+
+	//Transition the image to shader read, the blits do that level by level
+	if (mipExtent && subresourceRange.levelCount > 1)
+	{
+		MipGenerator::RecordBlitChain(commandBuffer, image, mipExtent.value(), subresourceRange);
+	}
+	else
+	{
+		tools::InsertImageMemoryBarrier(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresourceRange);
+	}
+
+	++m_BatchStats.copies;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "CommandBuffer.h"
+#include "VmaUsage.h"
+
+class VulkanContext;
+
+struct UploadStats
+{
+	uint64_t bytesUploaded{};
+	uint32_t copies{};
+	uint32_t submits{};
+	float wallTimeMs{};
+};
+
+// A slice of the persistently mapped staging ring
+// Record its copy before allocating again, a full ring can submit the batch early
+struct StagingAllocation
+{
+	VkBuffer buffer{VK_NULL_HANDLE};
+	VkDeviceSize offset{};
+	void* mappedData{};
+};
+
+// Collects all staging copies between Begin and End into one command buffer with a single fence
+// Uploads outside of a Begin/End pair get their own small batch, so callers never have to care
+// Main thread only, End does not wait on the GPU. Ring space gets reclaimed once a fence is signaled
+class UploadBatch final
+{
+public:
+	UploadBatch() = default;
+	~UploadBatch() = default;
+	UploadBatch(const UploadBatch&) = delete;
+	UploadBatch& operator=(const UploadBatch&) = delete;
+	UploadBatch(UploadBatch&&) = delete;
+	UploadBatch& operator=(UploadBatch&&) = delete;
+
+	static void Init(VulkanContext* vulkanContext, VkDeviceSize ringSize = 64ull * 1024 * 1024);
+	static void Cleanup(const VulkanContext* vulkanContext);
+
+	// Batches can be nested, only the outer End submits
+	static void Begin();
+	static void End();
+
+	// Waits for every submitted batch, used before anything reads back or gets destroyed
+	static void WaitIdle();
+
+	static StagingAllocation AllocateStaging(VkDeviceSize size, VkDeviceSize alignment = 16);
+
+	static void UploadBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+	static void CopyBuffer(const StagingAllocation& staging, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+
+	// GPU side copy, waits on the transfers recorded before it so freshly uploaded data gets moved too
+	static void CopyBufferRegions(VkBuffer srcBuffer, VkBuffer dstBuffer, const std::vector<VkBufferCopy>& regions);
+	// Destroys the buffer once everything recorded so far in the batch is done on the GPU
+	static void ReleaseAfterBatch(VkBuffer buffer, VmaAllocation memory);
+
+	// Copies the regions into the image and leaves it in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	// Takes ownership of the staging buffer, it gets destroyed when the batch is done on the GPU
+	// With a mipExtent the regions only fill the first level, the other levels of subresourceRange get blitted from it in the same batch
+	static void UploadImage(VkBuffer stagingBuffer, VmaAllocation stagingMemory, VkImage image, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange, std::optional<VkExtent2D> mipExtent = std::nullopt);
+	static void UploadImage(const StagingAllocation& staging, VkDeviceSize size, VkImage image, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange, std::optional<VkExtent2D> mipExtent = std::nullopt);
+
+	[[nodiscard]] static const UploadStats& GetLastBatchStats() { return m_LastBatchStats; }
+	[[nodiscard]] static const UploadStats& GetTotalStats() { return m_TotalStats; }
+
+	static void OnImGui();
+
+private:
+	struct Submission
+	{
+		CommandBuffer commandBuffer{};
+		VkFence fence{VK_NULL_HANDLE};
+		VkDeviceSize ringEnd{};
+		std::vector<std::pair<VkBuffer, VmaAllocation>> releasedBuffers{};
+	};
+
+	static void StartRecording();
+	static void Flush();
+	static void RetireOldest();
+	static void RetireAll();
+	static bool TryAllocateRing(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+	static VkCommandBuffer GetRecordingCommandBuffer();
+	static void RecordImageCopy(VkBuffer srcBuffer, VkImage image, const std::vector<VkBufferImageCopy>& regions, const VkImageSubresourceRange& subresourceRange, std::optional<VkExtent2D> mipExtent = std::nullopt);
+
+	inline static VulkanContext* m_pContext{};
+
+	inline static VkBuffer m_RingBuffer{VK_NULL_HANDLE};
+	inline static VmaAllocation m_RingMemory{};
+	inline static uint8_t* m_pRingData{};
+	inline static VkDeviceSize m_RingSize{};
+	inline static VkDeviceSize m_RingHead{};
+	inline static VkDeviceSize m_RingTail{};
+
+	inline static std::optional<Submission> m_Recording{};
+	inline static std::deque<Submission> m_PendingSubmissions{};
+	inline static std::vector<Submission> m_FreeSubmissions{};
+
+	inline static uint32_t m_Depth{};
+	inline static std::chrono::steady_clock::time_point m_BatchStartTime{};
+	inline static UploadStats m_BatchStats{};
+	inline static UploadStats m_LastBatchStats{};
+	inline static UploadStats m_TotalStats{};
+};
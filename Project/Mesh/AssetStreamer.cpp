@@ -0,0 +1,204 @@
+#include "AssetStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+
+#include "MaterialManager.h"
+#include "Mesh.h"
+#include "ModelLoader.h"
+#include "Vertex.h"
+#include "VertexQuantizer.h"
+#include "Core/Logger.h"
+#include "Patterns/ThreadPool.h"
+#include "Scene/Scene.h"
+#include "vulkanbase/VulkanTypes.h"
+
+
+void AssetStreamer::RequestGLTF(const std::string& filePath, Scene* scene, VertexFormat vertexFormat, const glm::mat4& transform)
+{
+	std::string modelKey = GetModelKey(filePath, vertexFormat == VertexFormat::Packed ? "Packed" : "Full");
+	if (TryAddInstances(modelKey, scene, transform))
+	{
+		LogInfo("Added an instance of: " + filePath);
+		return;
+	}
+
+	MeshInstance* placeholder = AddPlaceholder(scene, transform);
+
+	std::future<FinishLoad> result = ThreadPool::Enqueue([filePath, vertexFormat]() -> FinishLoad
+	{
+		std::optional<ParsedModel> parsed = GLTFLoader::ParseGLTF(filePath);
+		if (!parsed) return {};
+
+		if (vertexFormat == VertexFormat::Packed) VertexQuantizer::QuantizeModel(parsed.value());
+		//The images get decoded here as well, the main thread only copies the pixels into the staging ring
+		GLTFLoader::DecodeImages(parsed.value());
+
+		//std::function needs a copyable callable
+		auto parsedGLTF = std::make_shared<ParsedModel>(std::move(parsed.value()));
+		return [parsedGLTF](Scene* targetScene, VulkanContext* vulkanContext)
+		{
+			return GLTFLoader::CreateGLTF(*parsedGLTF, targetScene, vulkanContext);
+		};
+	});
+
+	m_PendingLoads.push_back({std::move(modelKey), filePath, scene, transform, {}, {placeholder}, std::move(result)});
+}
+
+void AssetStreamer::RequestObj(const std::string& filePath, const std::string& materialName, const std::string& meshName, Scene* scene, const glm::mat4& transform)
+{
+	std::string modelKey = GetModelKey(filePath, materialName);
+	if (TryAddInstances(modelKey, scene, transform))
+	{
+		LogInfo("Added an instance of: " + filePath);
+		return;
+	}
+
+	MeshInstance* placeholder = AddPlaceholder(scene, transform);
+
+	std::future<FinishLoad> result = ThreadPool::Enqueue([filePath, materialName, meshName]() -> FinishLoad
+	{
+		std::optional<ParsedModel> parsed = ObjLoader::ParseObj(filePath);
+		if (!parsed) return {};
+
+		auto parsedObj = std::make_shared<ParsedModel>(std::move(parsed.value()));
+		return [parsedObj, filePath, materialName, meshName](Scene* targetScene, VulkanContext*)
+		{
+			const ParsedMesh& meshData = parsedObj->meshes.front();
+
+			Primitive primitive{};
+			primitive.firstIndex = 0;
+			primitive.indexCount = static_cast<uint32_t>(meshData.indices.size());
+			primitive.material = MaterialManager::GetMaterial(materialName);
+
+			auto mesh = std::make_unique<Mesh>(meshData.vertices, meshData.indices, meshName.empty() ? filePath : meshName, std::vector<Primitive>{primitive});
+			Mesh* meshPtr = mesh.get();
+			targetScene->AddMesh(std::move(mesh));
+			return std::vector<Mesh*>{meshPtr};
+		};
+	});
+
+	m_PendingLoads.push_back({std::move(modelKey), filePath, scene, transform, {}, {placeholder}, std::move(result)});
+}
+
+void AssetStreamer::ProcessCompleted(VulkanContext* vulkanContext)
+{
+	uint32_t finishedThisFrame{};
+	for (auto it = m_PendingLoads.begin(); it != m_PendingLoads.end() && finishedThisFrame < m_MaxFinishedPerFrame;)
+	{
+		if (it->result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			++it;
+			continue;
+		}
+
+		const FinishLoad finishLoad = it->result.get();
+		for (const MeshInstance* placeholder : it->placeholders)
+		{
+			it->scene->RemoveInstance(placeholder);
+		}
+
+		if (finishLoad)
+		{
+			LoadedModel loadedModel{it->scene};
+			for (Mesh* mesh : finishLoad(it->scene, vulkanContext))
+			{
+				loadedModel.meshes.emplace_back(mesh, mesh->GetTransform());
+				mesh->SetTransform(it->transform * mesh->GetTransform());
+			}
+
+			for (const glm::mat4& instanceTransform : it->instanceTransforms)
+			{
+				AddInstances(it->scene, loadedModel, instanceTransform);
+			}
+
+			m_LoadedModels.insert_or_assign(it->modelKey, std::move(loadedModel));
+			LogInfo("Streamed in: " + it->filePath);
+		}
+		else
+		{
+			LogError("Failed to stream in: " + it->filePath);
+		}
+
+		it = m_PendingLoads.erase(it);
+		++finishedThisFrame;
+	}
+}
+
+void AssetStreamer::Cleanup()
+{
+	//Let the workers finish, the placeholder meshes are cleaned up with the scene
+	for (PendingLoad& pendingLoad : m_PendingLoads)
+	{
+		pendingLoad.result.wait();
+	}
+
+	m_PendingLoads.clear();
+	m_LoadedModels.clear();
+	m_Placeholders.clear();
+}
+
+std::string AssetStreamer::GetModelKey(const std::string& filePath, const std::string& variant)
+{
+	std::error_code error;
+	const std::filesystem::path canonicalPath = std::filesystem::weakly_canonical(VulkanContext::GetAssetPath() / filePath, error);
+	const std::string pathKey = error ? (VulkanContext::GetAssetPath() / filePath).lexically_normal().generic_string() : canonicalPath.generic_string();
+
+	return pathKey + ":" + variant;
+}
+
+bool AssetStreamer::TryAddInstances(const std::string& modelKey, Scene* scene, const glm::mat4& transform)
+{
+	//Still loading, the instances get added once it is in the scene
+	const auto pendingLoad = std::ranges::find_if(m_PendingLoads, [&modelKey, scene](const PendingLoad& load) { return load.modelKey == modelKey && load.scene == scene; });
+	if (pendingLoad != m_PendingLoads.end())
+	{
+		pendingLoad->instanceTransforms.push_back(transform);
+		pendingLoad->placeholders.push_back(AddPlaceholder(scene, transform));
+		return true;
+	}
+
+	const auto loadedModel = m_LoadedModels.find(modelKey);
+	if (loadedModel == m_LoadedModels.end() || loadedModel->second.scene != scene) return false;
+
+	//The meshes can have been removed from the scene since, then the model gets loaded again
+	const std::vector<Mesh*> sceneMeshes = scene->GetMeshes();
+	const bool isAlive = std::ranges::all_of(loadedModel->second.meshes, [&sceneMeshes](const std::pair<Mesh*, glm::mat4>& mesh)
+	{
+		return std::ranges::find(sceneMeshes, mesh.first) != sceneMeshes.end();
+	});
+	if (!isAlive)
+	{
+		m_LoadedModels.erase(loadedModel);
+		return false;
+	}
+
+	AddInstances(scene, loadedModel->second, transform);
+	return true;
+}
+
+void AssetStreamer::AddInstances(Scene* scene, const LoadedModel& model, const glm::mat4& transform)
+{
+	for (const auto& [mesh, meshTransform] : model.meshes)
+	{
+		scene->AddInstance(mesh, transform * meshTransform);
+	}
+}
+
+MeshInstance* AssetStreamer::AddPlaceholder(Scene* scene, const glm::mat4& transform)
+{
+	//Only the first request of a scene reads and uploads the cube, the scene can have removed it since
+	Mesh*& placeholder = m_Placeholders[scene];
+	const std::vector<Mesh*> sceneMeshes = scene->GetMeshes();
+	if (placeholder == nullptr || std::ranges::find(sceneMeshes, placeholder) == sceneMeshes.end())
+	{
+		auto placeholderMesh = std::make_unique<Mesh>("Cube.obj", "PlaceholderMaterial", "Loading");
+		placeholderMesh->SetInstancesOnly(true);
+		placeholder = placeholderMesh.get();
+		scene->AddMesh(std::move(placeholderMesh));
+	}
+
+	return scene->AddInstance(placeholder, transform);
+}
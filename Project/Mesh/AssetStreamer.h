@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <glm/mat4x4.hpp>
+
+#include "Vertex.h"
+
+class Mesh;
+class MeshInstance;
+class Scene;
+class VulkanContext;
+
+// Parses models on the ThreadPool and hands the finished meshes to the scene at a frame boundary
+// Until a request is finished an instance of a placeholder cube stands in for it, the cube gets loaded once per scene
+// Models are known by their canonical path and what the request builds from it (vertex format, material)
+// Requesting one that is loaded or still loading the same way only adds instances of its meshes
+class AssetStreamer final
+{
+public:
+	AssetStreamer() = default;
+	~AssetStreamer() = default;
+	AssetStreamer(const AssetStreamer&) = delete;
+	AssetStreamer& operator=(const AssetStreamer&) = delete;
+	AssetStreamer(AssetStreamer&&) = delete;
+	AssetStreamer& operator=(AssetStreamer&&) = delete;
+
+	// Packed quantizes the vertices on the worker as well
+	// The transform places the whole model, the meshes keep their transform inside the model on top of it
+	static void RequestGLTF(const std::string& filePath, Scene* scene, VertexFormat vertexFormat = VertexFormat::Full, const glm::mat4& transform = glm::mat4{1});
+	static void RequestObj(const std::string& filePath, const std::string& materialName, const std::string& meshName, Scene* scene, const glm::mat4& transform = glm::mat4{1});
+
+	// Has to be called while no frame is in flight, the meshes get uploaded in here
+	static void ProcessCompleted(VulkanContext* vulkanContext);
+	static void Cleanup();
+
+	[[nodiscard]] static size_t GetPendingCount() { return m_PendingLoads.size(); }
+
+private:
+	// The main thread half of a request, creates the materials and uploads the meshes, returns the meshes it added
+	using FinishLoad = std::function<std::vector<Mesh*>(Scene*, VulkanContext*)>;
+
+	struct PendingLoad
+	{
+		std::string modelKey;
+		std::string filePath;
+		Scene* scene;
+		glm::mat4 transform;
+		// Requests for the same model that came in while it was still loading
+		std::vector<glm::mat4> instanceTransforms;
+		// One for the request and one for every queued instance
+		std::vector<MeshInstance*> placeholders;
+		std::future<FinishLoad> result;
+	};
+
+	struct LoadedModel
+	{
+		Scene* scene;
+		// With their transform inside the model, the instances get placed relative to that
+		std::vector<std::pair<Mesh*, glm::mat4>> meshes;
+	};
+
+	// The same file reached through different paths has to end up as one model
+	// The variant tells requests of one file apart that build different meshes, the glTF vertex format or the obj material
+	[[nodiscard]] static std::string GetModelKey(const std::string& filePath, const std::string& variant);
+	// False when the model is neither loaded nor loading in the scene
+	static bool TryAddInstances(const std::string& modelKey, Scene* scene, const glm::mat4& transform);
+	static void AddInstances(Scene* scene, const LoadedModel& model, const glm::mat4& transform);
+	// Loads the placeholder cube the first time the scene needs it
+	static MeshInstance* AddPlaceholder(Scene* scene, const glm::mat4& transform);
+
+	// Spread finished requests over multiple frames so a big upload does not stall a single frame
+	static constexpr uint32_t m_MaxFinishedPerFrame{1};
+
+	inline static std::vector<PendingLoad> m_PendingLoads{};
+	inline static std::unordered_map<std::string, LoadedModel> m_LoadedModels{};
+	inline static std::unordered_map<Scene*, Mesh*> m_Placeholders{};
+};
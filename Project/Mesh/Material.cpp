@@ -36,22 +36,29 @@ void Material::OnImGui()
 }
 
 void Material::Bind(const VkCommandBuffer commandBuffer)
+{
+    BindPipeline(commandBuffer);
+    BindDescriptorSet(commandBuffer);
+}
+
+void Material::BindPipeline(VkCommandBuffer commandBuffer) const
 {
     m_pGraphicsPipeline->BindPipeline(commandBuffer, m_PipelineType);
-    m_DescriptorSet.Bind(m_pContext, commandBuffer, m_pGraphicsPipeline->GetPipelineLayout(), 1, m_PipelineType);
+}
 
+void Material::BindDescriptorSet(VkCommandBuffer commandBuffer)
+{
+    m_DescriptorSet.Bind(m_pContext, commandBuffer, m_pGraphicsPipeline->GetPipelineLayout(), 1, m_PipelineType);
+}
 
-    // TODO: This would be a better solution:
-    //  for each material
-    //  {
-    //      bind material resources  // material parameters and textures
-    //      for each mesh
-    //      {
-    //          bind mesh resources  // object transforms
-    //          draw mesh
-    //      }
-    //  }
+VkDescriptorSet Material::PrepareDescriptorSet()
+{
+    return m_DescriptorSet.Prepare(m_pContext);
+}
 
+void Material::BindDescriptorSet(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet) const
+{
+    vkCmdBindDescriptorSets(commandBuffer, static_cast<VkPipelineBindPoint>(m_PipelineType), m_pGraphicsPipeline->GetPipelineLayout(), 1, 1, &descriptorSet, 0, nullptr);
 }
 
 void Material::BindPushConstant(VkCommandBuffer commandBuffer, const glm::mat4x4 &pushConstantMatrix) const
@@ -119,6 +126,7 @@ VkPipelineLayoutCreateInfo Material::GetPipelineLayoutCreateInfo() {
     return pipelineLayoutInfo;
 }
 std::string Material::GetMaterialName() const { return m_MaterialName; }
+uint16_t Material::GetPipelineSortId() const { return m_pGraphicsPipeline->GetSortId(); }
 DescriptorSet *Material::GetDescriptorSet() { return &m_DescriptorSet; }
 VkCullModeFlags Material::GetCullModeBit() const {
     return m_CullMode;
@@ -157,6 +165,16 @@ void Material::SetDepthOnly(bool depthOnly)
     m_IsDepthOnly = depthOnly;
 }
 
+VertexFormat Material::GetVertexFormat() const
+{
+	return m_VertexFormat;
+}
+
+void Material::SetVertexFormat(VertexFormat vertexFormat)
+{
+	m_VertexFormat = vertexFormat;
+}
+
 void Material::SetSSAOPass(bool isSSAO)
 {
 	m_IsSSAO = isSSAO;
@@ -6,6 +6,7 @@
 #include <vulkan/vulkan.h>
 #include "Core/DescriptorSet.h"
 #include "Core/GraphicsPipeline.h"
+#include "Mesh/Vertex.h"
 
 
 enum class ShaderType;
@@ -27,6 +28,12 @@ public:
 	void OnImGui();
 
     void Bind(VkCommandBuffer commandBuffer);
+    //The halves of Bind, the render queue skips the ones that are already bound
+    void BindPipeline(VkCommandBuffer commandBuffer) const;
+    void BindDescriptorSet(VkCommandBuffer commandBuffer);
+    //BindDescriptorSet split for recording on other threads, prepare on the main thread and bind the result anywhere
+    [[nodiscard]] VkDescriptorSet PrepareDescriptorSet();
+    void BindDescriptorSet(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet) const;
 	void BindPushConstant(VkCommandBuffer commandBuffer, const glm::mat4x4& pushConstantMatrix) const;
 
     //Checks if a shader with the same type already exists,
@@ -43,6 +50,10 @@ public:
     [[nodiscard]] VkPipelineLayoutCreateInfo GetPipelineLayoutCreateInfo();
     [[nodiscard]] std::string GetMaterialName() const;
 
+    //Small ids for the render queue sort keys
+    [[nodiscard]] uint16_t GetSortId() const { return m_SortId; }
+    [[nodiscard]] uint16_t GetPipelineSortId() const;
+
     [[nodiscard]] DescriptorSet* GetDescriptorSet();
 
     [[nodiscard]] VkCullModeFlags GetCullModeBit() const;
@@ -57,6 +68,10 @@ public:
 	void SetSSAOPass(bool isSSAO);
 	void SetIsComposite(bool isComposite);
 
+	//Has to match the meshes that get drawn with this material, set before CreatePipeline
+	[[nodiscard]] VertexFormat GetVertexFormat() const;
+	void SetVertexFormat(VertexFormat vertexFormat);
+
 private:
 	friend class MaterialManager;
 
@@ -81,4 +96,8 @@ private:
 
 
     PipelineType m_PipelineType = PipelineType::Graphics;
+	VertexFormat m_VertexFormat = VertexFormat::Full;
+
+	inline static uint16_t m_NextSortId{};
+	uint16_t m_SortId{m_NextSortId++};
 };
\ No newline at end of file
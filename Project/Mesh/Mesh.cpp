@@ -1,4 +1,5 @@
 #include "Mesh.h"
+#include <algorithm>
 #include <chrono>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/rotate_vector.hpp>
@@ -6,8 +7,9 @@
 #include <utility>
 
 #include "Camera/Camera.h"
-#include "Core/GlobalDescriptor.h"
+#include "Core/GeometryPool.h"
 #include "Core/ImGuiWrapper.h"
+#include "Core/RenderQueue.h"
 #include "ImGuizmo.h"
 #include "MaterialManager.h"
 #include "ModelLoader.h"
@@ -17,22 +19,33 @@
 #include "Core/Logger.h"
 #include "vulkanbase/VulkanTypes.h"
 
-Mesh::Mesh(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, std::string meshName, const std::vector<Primitive> &primitives, uint32_t firstDrawIndex, int32_t vertexOffset)
-	: m_FirstDrawIndex(firstDrawIndex)
-	, m_VertexOffset(vertexOffset)
-	, m_Primitives(primitives)
+Mesh::Mesh(std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::string meshName, const std::vector<Primitive> &primitives)
+	: m_Primitives(primitives)
 	, m_pDepthMaterial(MaterialManager::GetMaterial("DepthOnlyMaterial"))
 	, m_MeshName(std::move(meshName))
 {
 	m_pContext = ServiceLocator::GetService<VulkanContext>();
 
-	m_IndexCount = indices.size();
+	m_IndexCount = static_cast<uint32_t>(indices.size());
 
-	CreateVertexBuffer(vertices);
-	CreateIndexBuffer(indices);
+	CreateGeometry(vertices, indices);
 }
 
 
+Mesh::Mesh(std::span<const PackedVertex> vertices, std::span<const uint32_t> indices, std::string meshName, const std::vector<Primitive>& primitives, const glm::mat4& dequantizeMatrix)
+	: m_Primitives(primitives)
+	, m_VertexFormat(VertexFormat::Packed)
+	, m_DequantizeMatrix(dequantizeMatrix)
+	, m_pDepthMaterial(MaterialManager::GetMaterial("DepthOnlyMaterial_Packed"))
+	, m_MeshName(std::move(meshName))
+{
+	m_pContext = ServiceLocator::GetService<VulkanContext>();
+
+	m_IndexCount = static_cast<uint32_t>(indices.size());
+
+	CreateGeometry(vertices, indices);
+}
+
 Mesh::Mesh(const std::string& modelPath,const std::string& materialName, const std::string& meshName)
 	: m_pDepthMaterial(MaterialManager::GetMaterial("DepthOnlyMaterial"))
 	, m_MeshName(std::move(meshName))
@@ -40,50 +53,75 @@ Mesh::Mesh(const std::string& modelPath,const std::string& materialName, const s
 	m_pContext = ServiceLocator::GetService<VulkanContext>();
 	m_MeshName = meshName.empty() ? m_MeshName = modelPath : m_MeshName = meshName;
 
-	//Load the .obj file
-	std::vector<Vertex> vertices;
-	std::vector<uint32_t> indices;
-	ObjLoader::LoadObj(modelPath, vertices, indices);
+	//Load the .obj file, or its mesh cache
+	const std::optional<ParsedModel> parsed = ObjLoader::ParseObj(modelPath);
+	if (!parsed) return;
+
+	const ParsedMesh& meshData = parsed->meshes.front();
 
 	Primitive primitive{};
 	primitive.firstIndex = 0;
-	primitive.indexCount = static_cast<uint32_t>(indices.size());
+	primitive.indexCount = static_cast<uint32_t>(meshData.indices.size());
 	primitive.material = MaterialManager::GetMaterial(materialName);
 	m_Primitives.push_back(primitive);
 
-	CreateVertexBuffer(vertices);
-	CreateIndexBuffer(indices);
+	m_IndexCount = static_cast<uint32_t>(meshData.indices.size());
+	CreateGeometry(meshData.vertices, meshData.indices);
 }
 
 
-void Mesh::Render(VkCommandBuffer commandBuffer)
+void Mesh::Update()
 {
 	if(m_Rotate)
 	m_ModelMatrix = glm::rotate(m_ModelMatrix, GameTimer::GetDeltaTime() * glm::radians(m_RotationSpeed), MathConstants::UP);
 
 	m_Visible = m_VisibleBuffer;
-	if (!m_Visible) return;
-
-	m_IndexBuffer.BindAsIndexBuffer(commandBuffer);
-	m_VertexBuffer.BindAsVertexBuffer(commandBuffer);
+}
 
-	for(const auto& primitive: m_Primitives)
+void Mesh::QueueDraws()
+{
+	for (uint32_t primitiveIndex{}; primitiveIndex < m_Primitives.size(); ++primitiveIndex)
 	{
-		GlobalDescriptor::Bind(m_pContext, commandBuffer, primitive.material->GetPipelineLayout());
-		primitive.Render(commandBuffer, m_ModelMatrix);
+		QueueDraw(primitiveIndex);
 	}
 }
 
-void Mesh::RenderDepth(VkCommandBuffer commandBuffer)
+void Mesh::QueueDraw(uint32_t primitiveIndex)
 {
-    if (!m_Visible) return;
+	QueueDraw(primitiveIndex, m_ModelMatrix);
+}
+
+void Mesh::QueueDraw(uint32_t primitiveIndex, const glm::mat4& modelMatrix)
+{
+	if (!m_Visible || m_Geometry == InvalidGeometryHandle) return;
+
+	const GeometryRange& geometry = GeometryPool::GetRange(m_Geometry);
+	const Primitive& primitive = m_Primitives[primitiveIndex];
+
+	DrawItem item{};
+	item.material = primitive.material.get();
+	item.depthMaterial = m_pDepthMaterial.get();
+	item.pipelineId = item.material->GetPipelineSortId();
+	item.materialId = item.material->GetSortId();
+	item.indexType = geometry.indexType;
+	item.indexCount = primitive.indexCount;
+	item.firstIndex = geometry.firstIndex + primitive.firstIndex;
+	item.vertexOffset = geometry.vertexOffset + primitive.vertexOffset;
+	//The first index is unique per primitive in the geometry pool, every copy of the primitive gets the same id
+	item.geometryId = static_cast<uint16_t>((item.firstIndex * 2654435761u) >> 16);
+	item.transform = modelMatrix * m_DequantizeMatrix;
+	item.boundingSphere = m_IsFrustumCulled ? primitive.boundingSphere : glm::vec4{0, 0, 0, -1};
+	RenderQueue::Push(item);
+}
 
-    GlobalDescriptor::Bind(m_pContext, commandBuffer, m_pDepthMaterial->GetPipelineLayout());
-	m_pDepthMaterial->BindPushConstant(commandBuffer, m_ModelMatrix);
-    m_pDepthMaterial->Bind(commandBuffer);
-	m_IndexBuffer.BindAsIndexBuffer(commandBuffer);
-	m_VertexBuffer.BindAsVertexBuffer(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, m_IndexCount, 1, m_FirstDrawIndex, m_VertexOffset, 0);
+AABB Mesh::GetWorldBounds(uint32_t primitiveIndex) const
+{
+	return GetWorldBounds(primitiveIndex, m_ModelMatrix);
+}
+
+AABB Mesh::GetWorldBounds(uint32_t primitiveIndex, const glm::mat4& modelMatrix) const
+{
+	return m_Primitives[primitiveIndex].bounds.Transform(modelMatrix * m_DequantizeMatrix);
 }
 
 
@@ -98,6 +136,11 @@ void Mesh::OnImGui()
 		ImGui::Text("Mesh Name: %s", m_MeshName.c_str());
 		//ImGui::Text("Vertex Count: %d", m_VertexCount);
 		ImGui::Text("Index Count: %d", m_IndexCount);
+		ImGui::Text("Vertex Format: %s", m_VertexFormat == VertexFormat::Packed ? "Packed" : "Full");
+		if (m_Geometry != InvalidGeometryHandle)
+		{
+			ImGui::Text("Index Type: %s", GeometryPool::GetRange(m_Geometry).indexType == VK_INDEX_TYPE_UINT16 ? "uint16" : "uint32");
+		}
 	    //ImGui::Text("Active Material: %s", m_pMaterial->GetMaterialName().c_str());
 
 		//TODO: Fix this
@@ -145,8 +188,8 @@ void Mesh::OnImGui()
 
 void Mesh::CleanUp()
 {
-	m_IndexBuffer.Cleanup();
-	m_VertexBuffer.Cleanup();
+	GeometryPool::Free(m_Geometry);
+	m_Geometry = InvalidGeometryHandle;
 }
 
 void Mesh::SetPosition(const glm::vec3& position)
@@ -166,50 +209,89 @@ void Mesh::SetRotation(const glm::vec3 &rotation) {
     m_ModelMatrix = glm::rotate(m_ModelMatrix, glm::radians(rotation.z), MathConstants::FORWARD);
 }
 
-void Mesh::CreateVertexBuffer(const std::vector<Vertex>& vertices)
+template<typename VertexType>
+void Mesh::CreateGeometry(std::span<const VertexType> vertices, std::span<const uint32_t> indices)
 {
-	//Store the vertex count
-	m_VertexBuffer.count = static_cast<uint32_t>(vertices.size());
+	//Check if the mesh has at least 3 vertices and indices
+	LogAssert(vertices.size() >= 3, "Mesh has less then 3 vertices", false);
+	LogAssert(indices.size() >= 3, "Mesh has less then 3 indices", false);
 
+	ComputeBounds(vertices, indices);
 
-	//Check if the mesh has at least 3 vertices
-	LogAssert(m_VertexBuffer.count >= 3,"Mesh has less then 3 vertices", false);
+	//Sub allocate from the shared buffers, the copy is part of the active upload batch if there is one
+	std::vector<uint16_t> shortIndices{};
+	if (UseShortIndices && RebaseToShortIndices(indices, shortIndices))
+	{
+		m_Geometry = GeometryPool::Allocate(vertices, std::span<const uint16_t>(shortIndices));
+		return;
+	}
 
-	//Get the buffer size
-	const VkDeviceSize bufferSize = sizeof(vertices[0]) * (m_VertexBuffer.count);
+	for (Primitive& primitive : m_Primitives)
+	{
+		primitive.vertexOffset = 0;
+	}
+	m_Geometry = GeometryPool::Allocate(vertices, indices);
+}
 
-	//Create a staging buffer
-	VkBuffer stagingBuffer;
-	VmaAllocation stagingBufferMemory;
-	Core::Buffer::CreateStagingBuffer<Vertex>(bufferSize, stagingBuffer, stagingBufferMemory, vertices.data());
+namespace
+{
+	glm::vec3 GetShaderPosition(const Vertex& vertex) { return vertex.pos; }
 
+	//The positions are SNORM, the dequantize matrix in the transform brings them back to model space
+	glm::vec3 GetShaderPosition(const PackedVertex& vertex)
+	{
+		return glm::max(glm::vec3{static_cast<float>(vertex.pos[0]), static_cast<float>(vertex.pos[1]), static_cast<float>(vertex.pos[2])} / 32767.0f, glm::vec3{-1.0f});
+	}
+}
 
-	//Create a Vertex buffer
-	Core::Buffer::CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, m_VertexBuffer.buffer, m_VertexBuffer.bufferMemory);
+template<typename VertexType>
+void Mesh::ComputeBounds(std::span<const VertexType> vertices, std::span<const uint32_t> indices)
+{
+	//Sphere around the bounding box, looser than a minimal sphere but a single pass over the indices
+	for (Primitive& primitive : m_Primitives)
+	{
+		if (primitive.indexCount == 0 || static_cast<size_t>(primitive.firstIndex) + primitive.indexCount > indices.size()) continue;
+
+		AABB bounds{};
+		for (const uint32_t index : indices.subspan(primitive.firstIndex, primitive.indexCount))
+		{
+			bounds.Grow(GetShaderPosition(vertices[index]));
+		}
 
-	//Copy the staging buffer to the vertex buffer
-	Core::Buffer::CopyBuffer(m_pContext, stagingBuffer, m_VertexBuffer.buffer, bufferSize);
-    vmaDestroyBuffer(Allocator::vmaAllocator, stagingBuffer, stagingBufferMemory);
+		primitive.bounds = bounds;
+		primitive.boundingSphere = glm::vec4{bounds.GetCenter(), glm::length(bounds.GetExtent())};
+	}
 }
 
-void Mesh::CreateIndexBuffer(const std::vector<uint32_t>& indices)
+bool Mesh::RebaseToShortIndices(std::span<const uint32_t> indices, std::vector<uint16_t>& shortIndices)
 {
-	m_IndexBuffer.count = indices.size();
-	LogAssert(m_IndexBuffer.count >= 3, "Mesh has less then 3 indices", false);
-
-	//Get the buffer size
-	const VkDeviceSize bufferSize = sizeof(indices[0]) * (m_IndexBuffer.count);
+	//Find the vertex range of every primitive first, nothing gets written unless all of them fit
+	std::vector<uint32_t> lowestVertices(m_Primitives.size());
+	for (size_t primitiveIndex{}; primitiveIndex < m_Primitives.size(); ++primitiveIndex)
+	{
+		const Primitive& primitive = m_Primitives[primitiveIndex];
+		if (primitive.indexCount == 0) continue;
+		if (static_cast<size_t>(primitive.firstIndex) + primitive.indexCount > indices.size()) return false;
 
-	//Create a staging buffer
-	VkBuffer stagingBuffer;
-	VmaAllocation stagingBufferMemory;
-	Core::Buffer::CreateStagingBuffer<uint32_t>(bufferSize, stagingBuffer, stagingBufferMemory, indices.data());
+		const auto [lowest, highest] = std::ranges::minmax(indices.subspan(primitive.firstIndex, primitive.indexCount));
+		if (highest - lowest > UINT16_MAX) return false;
 
+		lowestVertices[primitiveIndex] = lowest;
+	}
 
-	//Create A index buffer
-	Core::Buffer::CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, m_IndexBuffer.buffer, m_IndexBuffer.bufferMemory);
+	//Indices outside every primitive are never drawn, they stay 0
+	shortIndices.assign(indices.size(), 0);
+	for (size_t primitiveIndex{}; primitiveIndex < m_Primitives.size(); ++primitiveIndex)
+	{
+		Primitive& primitive = m_Primitives[primitiveIndex];
+		const uint32_t lowest = lowestVertices[primitiveIndex];
+		for (uint32_t index{primitive.firstIndex}; index < primitive.firstIndex + primitive.indexCount; ++index)
+		{
+			shortIndices[index] = static_cast<uint16_t>(indices[index] - lowest);
+		}
+
+		primitive.vertexOffset = static_cast<int32_t>(lowest);
+	}
 
-	//Copy the staging buffer to the index buffer
-	Core::Buffer::CopyBuffer(m_pContext, stagingBuffer, m_IndexBuffer.buffer, bufferSize);
-    vmaDestroyBuffer(Allocator::vmaAllocator, stagingBuffer, stagingBufferMemory);
-}
\ No newline at end of file
+	return true;
+}
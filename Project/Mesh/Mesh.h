@@ -1,8 +1,11 @@
 #pragma once
 #include <memory>
+#include <span>
 #include <vector>
 #include <vulkan/vulkan.h>
 #include "Material.h"
+#include "Core/Frustum.h"
+#include "Core/GeometryPool.h"
 
 class Material;
 class VulkanContext;
@@ -13,31 +16,41 @@ struct Primitive
 	uint32_t firstIndex;
 	uint32_t indexCount;
 	std::shared_ptr<Material> material;
-
-	inline void Render(VkCommandBuffer commandBuffer, const glm::mat4& modelMatrix) const
-	{
-		material->BindPushConstant(commandBuffer, modelMatrix);
-		material->Bind(commandBuffer);
-		vkCmdDrawIndexed(commandBuffer, indexCount, 1, firstIndex, 0, 0);
-	}
+	//Lowest vertex the primitive uses, its indices get rebased on it when the mesh uses 16 bit indices
+	int32_t vertexOffset{};
+	//Both in the space the vertex shader reads the positions in, filled in when the geometry gets created
+	AABB bounds{};
+	//Center and radius
+	glm::vec4 boundingSphere{0, 0, 0, -1};
 };
 
 class Mesh final
 {
 public:
-    Mesh(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, std::string meshName, const std::vector<Primitive>& primitives, uint32_t firstDrawIndex = 0, int32_t vertexOffset = 0);
+    Mesh(std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::string meshName, const std::vector<Primitive>& primitives);
+    // Quantized vertices, the dequantize matrix gets applied on top of the model matrix when drawing
+    Mesh(std::span<const PackedVertex> vertices, std::span<const uint32_t> indices, std::string meshName, const std::vector<Primitive>& primitives, const glm::mat4& dequantizeMatrix);
     Mesh(const std::string& modelPath,const std::string& materialName, const std::string& meshName = "");
 
 
     ~Mesh() = default;
 
+	// Store the indices as uint16 when every primitive spans less than 65536 vertices, turn off to always use uint32
+	inline static bool UseShortIndices{true};
+
 	Mesh(const Mesh&) = delete;
 	explicit Mesh(Mesh&& other) noexcept = delete;
 	Mesh& operator=(const Mesh&) = delete;
 	Mesh& operator=(Mesh&&) = delete;
 
-	void Render(VkCommandBuffer commandBuffer);
-	void RenderDepth(VkCommandBuffer commandBuffer);
+	//Animation and visibility of this frame, call once per frame before queueing any draw
+	void Update();
+	//Pushes a draw item per primitive, the render queue sorts and records them for the depth and the color pass
+	void QueueDraws();
+	//Pushes the draw item of a single primitive, for primitives that survived the frustum culling
+	void QueueDraw(uint32_t primitiveIndex);
+	//Same with the transform of a MeshInstance
+	void QueueDraw(uint32_t primitiveIndex, const glm::mat4& modelMatrix);
 
 	void OnImGui();
 	void CleanUp();
@@ -53,20 +66,35 @@ public:
     glm::mat4 GetTransform() const { return m_ModelMatrix; }
     void SetTransform(const glm::mat4& transform) { m_ModelMatrix = transform; }
 
+	//Meshes that are drawn around the camera (the skybox) have to opt out of frustum culling
+	void SetFrustumCulled(bool isFrustumCulled) { m_IsFrustumCulled = isFrustumCulled; }
+	[[nodiscard]] bool IsFrustumCulled() const { return m_IsFrustumCulled; }
+
+	//Only the instances get drawn, for a mesh that is just shared geometry (the streaming placeholder)
+	void SetInstancesOnly(bool isInstancesOnly) { m_IsInstancesOnly = isInstancesOnly; }
+	[[nodiscard]] bool IsInstancesOnly() const { return m_IsInstancesOnly; }
+
+	[[nodiscard]] uint32_t GetPrimitiveCount() const { return static_cast<uint32_t>(m_Primitives.size()); }
+	//World space box of the primitive with the current model matrix
+	[[nodiscard]] AABB GetWorldBounds(uint32_t primitiveIndex) const;
+	[[nodiscard]] AABB GetWorldBounds(uint32_t primitiveIndex, const glm::mat4& modelMatrix) const;
+
 private:
-	void CreateVertexBuffer(const std::vector<Vertex>& vertices);
-	void CreateIndexBuffer(const std::vector<uint32_t>& indices);
+	template<typename VertexType>
+	void CreateGeometry(std::span<const VertexType> vertices, std::span<const uint32_t> indices);
+	template<typename VertexType>
+	void ComputeBounds(std::span<const VertexType> vertices, std::span<const uint32_t> indices);
+	// Rebases every primitive on its lowest vertex, returns false when one of them spans too many vertices for uint16
+	bool RebaseToShortIndices(std::span<const uint32_t> indices, std::vector<uint16_t>& shortIndices);
 
 	uint32_t m_IndexCount{};
-    uint32_t m_FirstDrawIndex{};
-    int32_t m_VertexOffset{};
 
 	VulkanContext* m_pContext;
 
-	//TODO: Store the vertex and index buffer in 1 VkBuffer to reduce cache misses
 	std::vector<Primitive> m_Primitives{};
-    Buffer m_VertexBuffer{};
-	Buffer m_IndexBuffer{};
+	GeometryHandle m_Geometry{InvalidGeometryHandle};
+	VertexFormat m_VertexFormat{VertexFormat::Full};
+	glm::mat4 m_DequantizeMatrix{1};
 
 	//std::shared_ptr<Material> m_pMaterial;
     std::shared_ptr<Material> m_pDepthMaterial;
@@ -81,6 +109,8 @@ private:
 
 	bool m_Visible = true;
 	bool m_VisibleBuffer = true;
+	bool m_IsFrustumCulled = true;
+	bool m_IsInstancesOnly = false;
 
     DescriptorSet m_MeshDescriptorSet{};
 };
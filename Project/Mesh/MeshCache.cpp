@@ -0,0 +1,392 @@
+#include "MeshCache.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "Vertex.h"
+#include "Core/Logger.h"
+#include "Core/MappedFile.h"
+#include "vulkanbase/VulkanTypes.h"
+
+
+namespace MeshCache
+{
+	// Blob layout: header, mesh table, material table, strings, then per mesh its vertices, indices and primitives
+	// Every data block starts on a 16 byte boundary so the spans can point into the mapping directly
+	constexpr uint32_t Magic = 0x43484D56;
+	constexpr size_t BlockAlignment = 16;
+
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vertexSize;
+		uint32_t meshCount;
+		uint64_t sourceSize;
+		int64_t sourceWriteTime;
+		uint64_t sourceHash;
+		uint32_t materialCount;
+		uint32_t stringsSize;
+	};
+
+	struct FileString
+	{
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	struct FileMesh
+	{
+		uint64_t vertexOffset;
+		uint64_t indexOffset;
+		uint64_t primitiveOffset;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t primitiveCount;
+		FileString name;
+		uint32_t padding;
+		float transform[16];
+	};
+
+	struct FileImage
+	{
+		FileString path;
+		uint64_t byteOffset;
+		uint64_t byteLength;
+	};
+
+	struct FileMaterial
+	{
+		FileString name;
+		FileImage baseColorTexture;
+		FileImage normalTexture;
+		FileImage metallicRoughnessTexture;
+	};
+
+	// Stored for a primitive without a material
+	constexpr uint32_t NoMaterial = UINT32_MAX;
+
+	struct FilePrimitive
+	{
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		uint32_t materialIndex;
+	};
+
+	struct SourceInfo
+	{
+		uint64_t size;
+		int64_t writeTime;
+	};
+
+	std::optional<SourceInfo> GetSourceInfo(const std::filesystem::path& sourcePath)
+	{
+		std::error_code error;
+		const uintmax_t size = std::filesystem::file_size(sourcePath, error);
+		if (error) return std::nullopt;
+
+		const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(sourcePath, error);
+		if (error) return std::nullopt;
+
+		return SourceInfo{static_cast<uint64_t>(size), static_cast<int64_t>(writeTime.time_since_epoch().count())};
+	}
+
+	// FNV-1a over the whole file
+	std::optional<uint64_t> HashFile(const std::filesystem::path& sourcePath)
+	{
+		const MappedFile file(sourcePath);
+		if (!file.IsValid()) return std::nullopt;
+
+		uint64_t hash = 14695981039346656037ull;
+		const uint8_t* data = file.GetData();
+		for (size_t i{}; i < file.GetSize(); ++i)
+		{
+			hash ^= data[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	std::filesystem::path GetCachePath(std::string_view filePath)
+	{
+		return VulkanContext::GetAssetPath() / "Cache" / (std::string(filePath) + ".meshcache");
+	}
+
+	std::optional<ParsedModel> Load(std::string_view filePath)
+	{
+		if (!UseCache) return std::nullopt;
+
+		const auto loadStart = std::chrono::steady_clock::now();
+
+		const std::filesystem::path cachePath = GetCachePath(filePath);
+		if (!std::filesystem::exists(cachePath)) return std::nullopt;
+
+		const std::filesystem::path sourcePath = VulkanContext::GetAssetPath() / filePath;
+		const std::optional<SourceInfo> sourceInfo = GetSourceInfo(sourcePath);
+		if (!sourceInfo) return std::nullopt;
+
+		auto file = std::make_shared<const MappedFile>(cachePath);
+		if (!file->IsValid() || file->GetSize() < sizeof(FileHeader)) return std::nullopt;
+
+		const uint8_t* data = file->GetData();
+		const size_t fileSize = file->GetSize();
+
+		FileHeader header{};
+		std::memcpy(&header, data, sizeof(FileHeader));
+
+		if (header.magic != Magic || header.version != Version || header.vertexSize != sizeof(Vertex))
+		{
+			LogInfo("Mesh cache is from an older version: " + std::string(filePath));
+			return std::nullopt;
+		}
+
+		if (header.sourceSize != sourceInfo->size) return std::nullopt;
+
+		//A touched file with the same content is still valid
+		if (header.sourceWriteTime != sourceInfo->writeTime)
+		{
+			const std::optional<uint64_t> sourceHash = HashFile(sourcePath);
+			if (!sourceHash || sourceHash.value() != header.sourceHash) return std::nullopt;
+		}
+
+		auto isInFile = [fileSize](uint64_t offset, uint64_t size) { return offset <= fileSize && size <= fileSize - offset; };
+
+		const uint64_t meshTableOffset = sizeof(FileHeader);
+		const uint64_t materialTableOffset = meshTableOffset + sizeof(FileMesh) * static_cast<uint64_t>(header.meshCount);
+		const uint64_t stringsOffset = materialTableOffset + sizeof(FileMaterial) * static_cast<uint64_t>(header.materialCount);
+		if (!isInFile(stringsOffset, header.stringsSize))
+		{
+			LogWarning("Mesh cache is corrupt: " + cachePath.generic_string());
+			return std::nullopt;
+		}
+
+		const char* strings = reinterpret_cast<const char*>(data + stringsOffset);
+		auto readString = [strings, &header](const FileString& string) -> std::string
+		{
+			if (string.offset > header.stringsSize || string.length > header.stringsSize - string.offset) return {};
+			return {strings + string.offset, string.length};
+		};
+		auto readImage = [&readString](const FileImage& image) -> ParsedImage
+		{
+			return {readString(image.path), image.byteOffset, image.byteLength};
+		};
+
+		ParsedModel model{};
+		model.filePath = std::string(filePath);
+		model.mappedCache = file;
+
+		model.materials.reserve(header.materialCount);
+		for (uint32_t materialIndex{}; materialIndex < header.materialCount; ++materialIndex)
+		{
+			FileMaterial fileMaterial{};
+			std::memcpy(&fileMaterial, data + materialTableOffset + sizeof(FileMaterial) * materialIndex, sizeof(FileMaterial));
+
+			ParsedMaterial& material = model.materials.emplace_back();
+			material.name = readString(fileMaterial.name);
+			material.baseColorTexture = readImage(fileMaterial.baseColorTexture);
+			material.normalTexture = readImage(fileMaterial.normalTexture);
+			material.metallicRoughnessTexture = readImage(fileMaterial.metallicRoughnessTexture);
+		}
+
+		model.meshes.reserve(header.meshCount);
+		for (uint32_t meshIndex{}; meshIndex < header.meshCount; ++meshIndex)
+		{
+			FileMesh fileMesh{};
+			std::memcpy(&fileMesh, data + meshTableOffset + sizeof(FileMesh) * meshIndex, sizeof(FileMesh));
+
+			if (!isInFile(fileMesh.vertexOffset, sizeof(Vertex) * static_cast<uint64_t>(fileMesh.vertexCount)) ||
+				!isInFile(fileMesh.indexOffset, sizeof(uint32_t) * static_cast<uint64_t>(fileMesh.indexCount)) ||
+				!isInFile(fileMesh.primitiveOffset, sizeof(FilePrimitive) * static_cast<uint64_t>(fileMesh.primitiveCount)))
+			{
+				LogWarning("Mesh cache is corrupt: " + cachePath.generic_string());
+				return std::nullopt;
+			}
+
+			ParsedMesh& mesh = model.meshes.emplace_back();
+			mesh.name = readString(fileMesh.name);
+			mesh.vertices = {reinterpret_cast<const Vertex*>(data + fileMesh.vertexOffset), fileMesh.vertexCount};
+			mesh.indices = {reinterpret_cast<const uint32_t*>(data + fileMesh.indexOffset), fileMesh.indexCount};
+			std::memcpy(&mesh.transform, fileMesh.transform, sizeof(fileMesh.transform));
+
+			mesh.primitives.reserve(fileMesh.primitiveCount);
+			for (uint32_t primitiveIndex{}; primitiveIndex < fileMesh.primitiveCount; ++primitiveIndex)
+			{
+				FilePrimitive filePrimitive{};
+				std::memcpy(&filePrimitive, data + fileMesh.primitiveOffset + sizeof(FilePrimitive) * primitiveIndex, sizeof(FilePrimitive));
+				const std::optional<size_t> materialIndex = filePrimitive.materialIndex != NoMaterial ? std::optional<size_t>(filePrimitive.materialIndex) : std::nullopt;
+				mesh.primitives.push_back({filePrimitive.firstIndex, filePrimitive.indexCount, materialIndex});
+			}
+		}
+
+		const float loadMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+		LogInfo("Loaded mesh cache of " + std::string(filePath) + " in " + std::to_string(loadMs) + "ms");
+
+		return model;
+	}
+
+	bool Save(std::string_view filePath, const ParsedModel& model)
+	{
+		if (!UseCache) return false;
+
+		const std::filesystem::path sourcePath = VulkanContext::GetAssetPath() / filePath;
+		const std::optional<SourceInfo> sourceInfo = GetSourceInfo(sourcePath);
+		const std::optional<uint64_t> sourceHash = HashFile(sourcePath);
+		if (!sourceInfo || !sourceHash) return false;
+
+		std::vector<uint8_t> blob;
+		auto append = [&blob](const void* source, size_t size)
+		{
+			const size_t offset = blob.size();
+			blob.resize(offset + size);
+			if (size > 0) std::memcpy(blob.data() + offset, source, size);
+			return offset;
+		};
+		auto align = [&blob] { blob.resize((blob.size() + BlockAlignment - 1) / BlockAlignment * BlockAlignment); };
+
+		std::string strings;
+		auto addString = [&strings](const std::string& string)
+		{
+			const FileString fileString{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(string.size())};
+			strings += string;
+			return fileString;
+		};
+		auto addImage = [&addString](const ParsedImage& image)
+		{
+			return FileImage{addString(image.path), image.byteOffset, image.byteLength};
+		};
+
+		std::vector<FileMesh> fileMeshes(model.meshes.size());
+		for (size_t meshIndex{}; meshIndex < model.meshes.size(); ++meshIndex)
+		{
+			const ParsedMesh& mesh = model.meshes[meshIndex];
+			FileMesh& fileMesh = fileMeshes[meshIndex];
+			fileMesh.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+			fileMesh.indexCount = static_cast<uint32_t>(mesh.indices.size());
+			fileMesh.primitiveCount = static_cast<uint32_t>(mesh.primitives.size());
+			fileMesh.name = addString(mesh.name);
+			std::memcpy(fileMesh.transform, &mesh.transform, sizeof(fileMesh.transform));
+		}
+
+		std::vector<FileMaterial> fileMaterials(model.materials.size());
+		for (size_t materialIndex{}; materialIndex < model.materials.size(); ++materialIndex)
+		{
+			const ParsedMaterial& material = model.materials[materialIndex];
+			FileMaterial& fileMaterial = fileMaterials[materialIndex];
+			fileMaterial.name = addString(material.name);
+			fileMaterial.baseColorTexture = addImage(material.baseColorTexture);
+			fileMaterial.normalTexture = addImage(material.normalTexture);
+			fileMaterial.metallicRoughnessTexture = addImage(material.metallicRoughnessTexture);
+		}
+
+		FileHeader header{};
+		header.magic = Magic;
+		header.version = Version;
+		header.vertexSize = sizeof(Vertex);
+		header.meshCount = static_cast<uint32_t>(fileMeshes.size());
+		header.sourceSize = sourceInfo->size;
+		header.sourceWriteTime = sourceInfo->writeTime;
+		header.sourceHash = sourceHash.value();
+		header.materialCount = static_cast<uint32_t>(fileMaterials.size());
+		header.stringsSize = static_cast<uint32_t>(strings.size());
+
+		//The tables get written again once the data offsets are known
+		append(&header, sizeof(FileHeader));
+		const size_t meshTableOffset = append(fileMeshes.data(), sizeof(FileMesh) * fileMeshes.size());
+		append(fileMaterials.data(), sizeof(FileMaterial) * fileMaterials.size());
+		append(strings.data(), strings.size());
+
+		for (size_t meshIndex{}; meshIndex < model.meshes.size(); ++meshIndex)
+		{
+			const ParsedMesh& mesh = model.meshes[meshIndex];
+			FileMesh& fileMesh = fileMeshes[meshIndex];
+
+			align();
+			fileMesh.vertexOffset = append(mesh.vertices.data(), mesh.vertices.size_bytes());
+			align();
+			fileMesh.indexOffset = append(mesh.indices.data(), mesh.indices.size_bytes());
+			align();
+			fileMesh.primitiveOffset = blob.size();
+			for (const ParsedPrimitive& primitive : mesh.primitives)
+			{
+				const FilePrimitive filePrimitive{primitive.firstIndex, primitive.indexCount, primitive.materialIndex ? static_cast<uint32_t>(primitive.materialIndex.value()) : NoMaterial};
+				append(&filePrimitive, sizeof(FilePrimitive));
+			}
+		}
+
+		if (!fileMeshes.empty())
+		{
+			std::memcpy(blob.data() + meshTableOffset, fileMeshes.data(), sizeof(FileMesh) * fileMeshes.size());
+		}
+
+		//Write to a temporary file first, a half written cache should never be picked up
+		const std::filesystem::path cachePath = GetCachePath(filePath);
+		std::filesystem::path temporaryPath = cachePath;
+		temporaryPath += ".tmp";
+
+		std::error_code error;
+		std::filesystem::create_directories(cachePath.parent_path(), error);
+
+		{
+			std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!output)
+			{
+				LogWarning("Failed to write mesh cache: " + cachePath.generic_string());
+				return false;
+			}
+			output.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+		}
+
+		std::filesystem::rename(temporaryPath, cachePath, error);
+		if (error)
+		{
+			LogWarning("Failed to write mesh cache: " + cachePath.generic_string() + " " + error.message());
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+
+		LogInfo("Wrote mesh cache: " + cachePath.generic_string() + " (" + std::to_string(blob.size()) + " bytes)");
+		return true;
+	}
+
+	void Bake(const std::vector<std::string>& filePaths)
+	{
+		std::vector<std::string> modelPaths = filePaths;
+		if (modelPaths.empty())
+		{
+			std::error_code error;
+			for (const auto& entry : std::filesystem::directory_iterator(VulkanContext::GetAssetPath(), error))
+			{
+				const std::string extension = entry.path().extension().string();
+				if (extension == ".obj" || extension == ".gltf" || extension == ".glb")
+				{
+					modelPaths.push_back(entry.path().filename().string());
+				}
+			}
+		}
+
+		const auto bakeStart = std::chrono::steady_clock::now();
+
+		uint32_t bakedCount{};
+		for (const std::string& modelPath : modelPaths)
+		{
+			//Parsing writes the cache when it is missing or stale
+			const bool isObj = std::filesystem::path(modelPath).extension() == ".obj";
+			const std::optional<ParsedModel> model = isObj ? ObjLoader::ParseObj(modelPath) : GLTFLoader::ParseGLTF(modelPath);
+
+			if (model)
+			{
+				++bakedCount;
+			}
+			else
+			{
+				LogError("Failed to bake: " + modelPath);
+			}
+		}
+
+		const float bakeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - bakeStart).count();
+		LogInfo("Baked " + std::to_string(bakedCount) + "/" + std::to_string(modelPaths.size()) + " mesh caches in " + std::to_string(bakeMs) + "ms");
+	}
+}
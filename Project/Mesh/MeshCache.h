@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ModelLoader.h"
+
+
+// Binary cache of the final vertex/index data of a model, stored under Assets/Cache
+// A cache file is one blob that gets memory mapped, the mesh spans point straight into it
+// It is keyed on the source size + write time, a changed write time falls back to a content hash
+namespace MeshCache
+{
+	// Bump when the layout of the blob or of Vertex changes
+	inline constexpr uint32_t Version = 5;
+
+	// Turn off to always parse the source files
+	inline bool UseCache = true;
+
+	[[nodiscard]] std::filesystem::path GetCachePath(std::string_view filePath);
+
+	// Returns nothing when there is no cache or when it does not match the source anymore
+	std::optional<ParsedModel> Load(std::string_view filePath);
+	bool Save(std::string_view filePath, const ParsedModel& model);
+
+	// Parses every model that has no up to date cache, used by the --bake-meshes command line mode
+	// No paths means every .obj/.gltf/.glb in the asset folder
+	void Bake(const std::vector<std::string>& filePaths);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <glm/glm.hpp>
+
+class Mesh;
+
+// Another copy of a mesh with its own transform, shares the geometry and the materials of that mesh
+// Copies of the same primitive end up next to each other in the render queue and get drawn as one instanced draw
+class MeshInstance final
+{
+public:
+	MeshInstance(Mesh* pMesh, const glm::mat4& transform) : m_pMesh(pMesh), m_Transform(transform) {}
+	~MeshInstance() = default;
+	MeshInstance(const MeshInstance&) = delete;
+	MeshInstance& operator=(const MeshInstance&) = delete;
+	MeshInstance(MeshInstance&&) = delete;
+	MeshInstance& operator=(MeshInstance&&) = delete;
+
+	[[nodiscard]] Mesh* GetMesh() const { return m_pMesh; }
+
+	[[nodiscard]] glm::mat4 GetTransform() const { return m_Transform; }
+	void SetTransform(const glm::mat4& transform) { m_Transform = transform; }
+
+private:
+	Mesh* m_pMesh;
+	glm::mat4 m_Transform;
+};
@@ -0,0 +1,356 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "Core/Logger.h"
+
+
+namespace MeshOptimizer
+{
+	constexpr uint32_t Unused = UINT32_MAX;
+
+	// FIFO post transform cache, a vertex is cached when it got transformed less than CacheSize misses ago
+	class FifoCache final
+	{
+	public:
+		explicit FifoCache(size_t vertexCount)
+			: m_Timestamps(vertexCount, 0)
+		{
+		}
+
+		// Returns true on a miss
+		bool Access(uint32_t vertex)
+		{
+			if (m_Time - m_Timestamps[vertex] <= CacheSize) return false;
+
+			m_Timestamps[vertex] = m_Time++;
+			return true;
+		}
+
+		void Flush() { m_Time += CacheSize + 1; }
+
+	private:
+		std::vector<uint32_t> m_Timestamps;
+		uint32_t m_Time{CacheSize + 1};
+	};
+
+	glm::vec3 GetPosition(std::span<const Vertex> vertices, std::span<const uint32_t> indices, size_t index, uint32_t baseVertex)
+	{
+		return vertices[indices[index] - baseVertex].pos;
+	}
+
+	CacheStatistics AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t baseVertex)
+	{
+		CacheStatistics statistics{};
+		statistics.triangleCount = indices.size() / 3;
+
+		FifoCache cache(vertexCount);
+		std::vector<bool> isReferenced(vertexCount, false);
+		for (const uint32_t index : indices)
+		{
+			const uint32_t vertex = index - baseVertex;
+			if (cache.Access(vertex)) ++statistics.cacheMisses;
+
+			if (!isReferenced[vertex])
+			{
+				isReferenced[vertex] = true;
+				++statistics.vertexCount;
+			}
+		}
+
+		return statistics;
+	}
+
+	void OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t baseVertex)
+	{
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0 || vertexCount == 0) return;
+
+		// Triangles per vertex, the live count drops as triangles get emitted
+		std::vector<uint32_t> liveTriangles(vertexCount, 0);
+		for (size_t i{}; i < triangleCount * 3; ++i)
+		{
+			++liveTriangles[indices[i] - baseVertex];
+		}
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		std::inclusive_scan(liveTriangles.begin(), liveTriangles.end(), adjacencyOffsets.begin() + 1);
+
+		std::vector<uint32_t> adjacency(adjacencyOffsets.back());
+		std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i{}; i < triangleCount * 3; ++i)
+		{
+			adjacency[fillOffsets[indices[i] - baseVertex]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		std::vector<bool> isEmitted(triangleCount, false);
+		std::vector<uint32_t> deadEndStack;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> output;
+		output.reserve(triangleCount * 3);
+
+		uint32_t time = CacheSize + 1;
+		uint32_t scanCursor = 0;
+
+		const auto skipDeadEnd = [&]() -> uint32_t
+		{
+			// Recently used vertices first, then the first vertex in input order that still has triangles
+			while (!deadEndStack.empty())
+			{
+				const uint32_t vertex = deadEndStack.back();
+				deadEndStack.pop_back();
+				if (liveTriangles[vertex] > 0) return vertex;
+			}
+
+			for (; scanCursor < vertexCount; ++scanCursor)
+			{
+				if (liveTriangles[scanCursor] > 0) return scanCursor;
+			}
+
+			return Unused;
+		};
+
+		uint32_t fanVertex = skipDeadEnd();
+		while (fanVertex != Unused)
+		{
+			candidates.clear();
+
+			for (uint32_t adjacent = adjacencyOffsets[fanVertex]; adjacent < adjacencyOffsets[fanVertex + 1]; ++adjacent)
+			{
+				const uint32_t triangle = adjacency[adjacent];
+				if (isEmitted[triangle]) continue;
+				isEmitted[triangle] = true;
+
+				for (size_t corner{}; corner < 3; ++corner)
+				{
+					const uint32_t index = indices[triangle * 3 + corner];
+					const uint32_t vertex = index - baseVertex;
+					output.push_back(index);
+					deadEndStack.push_back(vertex);
+					candidates.push_back(vertex);
+					--liveTriangles[vertex];
+
+					if (time - cacheTimestamps[vertex] > CacheSize)
+					{
+						cacheTimestamps[vertex] = time++;
+					}
+				}
+			}
+
+			// Prefer the candidate that stays in the cache the longest while its remaining triangles get emitted
+			uint32_t bestVertex = Unused;
+			int bestPriority = -1;
+			for (const uint32_t vertex : candidates)
+			{
+				if (liveTriangles[vertex] == 0) continue;
+
+				int priority = 0;
+				const uint32_t age = time - cacheTimestamps[vertex];
+				if (age + 2 * liveTriangles[vertex] <= CacheSize) priority = static_cast<int>(age);
+
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					bestVertex = vertex;
+				}
+			}
+
+			fanVertex = bestVertex != Unused ? bestVertex : skipDeadEnd();
+		}
+
+		std::ranges::copy(output, indices.begin());
+	}
+
+	void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const Vertex> vertices, uint32_t baseVertex, float threshold)
+	{
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount < 2) return;
+
+		// Hard boundaries, the cache optimized order restarts wherever a triangle misses all 3 vertices
+		std::vector<size_t> hardBoundaries;
+		{
+			FifoCache cache(vertices.size());
+			for (size_t triangle{}; triangle < triangleCount; ++triangle)
+			{
+				uint32_t misses{};
+				for (size_t corner{}; corner < 3; ++corner)
+				{
+					misses += cache.Access(indices[triangle * 3 + corner] - baseVertex);
+				}
+
+				if (misses == 3 || triangle == 0) hardBoundaries.push_back(triangle);
+			}
+			hardBoundaries.push_back(triangleCount);
+		}
+
+		// Soft boundaries, split a cluster where its running ACMR is already within the threshold of the whole cluster
+		std::vector<size_t> clusters;
+		for (size_t hardIndex{}; hardIndex + 1 < hardBoundaries.size(); ++hardIndex)
+		{
+			const size_t start = hardBoundaries[hardIndex];
+			const size_t end = hardBoundaries[hardIndex + 1];
+
+			const CacheStatistics clusterStatistics = AnalyzeVertexCache(indices.subspan(start * 3, (end - start) * 3), vertices.size(), baseVertex);
+			const float maxAcmr = clusterStatistics.GetAcmr() * threshold;
+
+			FifoCache cache(vertices.size());
+			size_t clusterStart = start;
+			size_t clusterMisses{};
+			clusters.push_back(start);
+			for (size_t triangle = start; triangle < end; ++triangle)
+			{
+				for (size_t corner{}; corner < 3; ++corner)
+				{
+					clusterMisses += cache.Access(indices[triangle * 3 + corner] - baseVertex);
+				}
+
+				const size_t clusterTriangles = triangle - clusterStart + 1;
+				if (triangle + 1 < end && static_cast<float>(clusterMisses) <= maxAcmr * static_cast<float>(clusterTriangles))
+				{
+					clusters.push_back(triangle + 1);
+					clusterStart = triangle + 1;
+					clusterMisses = 0;
+					cache.Flush();
+				}
+			}
+		}
+		clusters.push_back(triangleCount);
+
+		// Area weighted centroid and normal per cluster
+		const size_t clusterCount = clusters.size() - 1;
+		std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3{0.0f});
+		std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3{0.0f});
+		std::vector<float> clusterAreas(clusterCount, 0.0f);
+
+		glm::vec3 meshCentroid{0.0f};
+		float meshArea{};
+		for (size_t cluster{}; cluster < clusterCount; ++cluster)
+		{
+			for (size_t triangle = clusters[cluster]; triangle < clusters[cluster + 1]; ++triangle)
+			{
+				const glm::vec3 p0 = GetPosition(vertices, indices, triangle * 3, baseVertex);
+				const glm::vec3 p1 = GetPosition(vertices, indices, triangle * 3 + 1, baseVertex);
+				const glm::vec3 p2 = GetPosition(vertices, indices, triangle * 3 + 2, baseVertex);
+
+				const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				const float area = glm::length(normal);
+				const glm::vec3 centroid = (p0 + p1 + p2) / 3.0f;
+
+				clusterCentroids[cluster] += centroid * area;
+				clusterNormals[cluster] += normal;
+				clusterAreas[cluster] += area;
+				meshCentroid += centroid * area;
+				meshArea += area;
+			}
+		}
+		if (meshArea > 0.0f) meshCentroid /= meshArea;
+
+		std::vector<float> sortKeys(clusterCount, 0.0f);
+		for (size_t cluster{}; cluster < clusterCount; ++cluster)
+		{
+			if (clusterAreas[cluster] <= 0.0f) continue;
+
+			const glm::vec3 centroid = clusterCentroids[cluster] / clusterAreas[cluster];
+			const float normalLength = glm::length(clusterNormals[cluster]);
+			if (normalLength > 0.0f) sortKeys[cluster] = glm::dot(centroid - meshCentroid, clusterNormals[cluster] / normalLength);
+		}
+
+		// Clusters that face away from the center are likely in front, draw them first
+		std::vector<uint32_t> clusterOrder(clusterCount);
+		std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+		std::ranges::stable_sort(clusterOrder, [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<uint32_t> output;
+		output.reserve(triangleCount * 3);
+		for (const uint32_t cluster : clusterOrder)
+		{
+			output.insert(output.end(), indices.begin() + clusters[cluster] * 3, indices.begin() + clusters[cluster + 1] * 3);
+		}
+
+		std::ranges::copy(output, indices.begin());
+	}
+
+	void OptimizeVertexFetch(std::span<Vertex> vertices, std::span<uint32_t> indices, uint32_t baseVertex)
+	{
+		std::vector<uint32_t> remap(vertices.size(), Unused);
+		uint32_t nextVertex{};
+		for (uint32_t& index : indices)
+		{
+			uint32_t& newVertex = remap[index - baseVertex];
+			if (newVertex == Unused) newVertex = nextVertex++;
+
+			index = newVertex + baseVertex;
+		}
+
+		for (uint32_t& newVertex : remap)
+		{
+			if (newVertex == Unused) newVertex = nextVertex++;
+		}
+
+		const std::vector<Vertex> source(vertices.begin(), vertices.end());
+		for (size_t vertex{}; vertex < source.size(); ++vertex)
+		{
+			vertices[remap[vertex]] = source[vertex];
+		}
+	}
+
+	OptimizationResult Optimize(std::span<Vertex> vertices, std::span<uint32_t> indices, uint32_t baseVertex)
+	{
+		OptimizationResult result{};
+		result.before = AnalyzeVertexCache(indices, vertices.size(), baseVertex);
+
+		OptimizeVertexCache(indices, vertices.size(), baseVertex);
+		OptimizeOverdraw(indices, vertices, baseVertex);
+		OptimizeVertexFetch(vertices, indices, baseVertex);
+
+		result.after = AnalyzeVertexCache(indices, vertices.size(), baseVertex);
+		return result;
+	}
+
+	void LogResult(const OptimizationResult& result, std::string_view name)
+	{
+		LogInfo("Optimized " + std::to_string(result.before.triangleCount) + " triangles of " + std::string(name) +
+			": ACMR " + std::to_string(result.before.GetAcmr()) + " -> " + std::to_string(result.after.GetAcmr()) +
+			", ATVR " + std::to_string(result.before.GetAtvr()) + " -> " + std::to_string(result.after.GetAtvr()));
+	}
+
+	void Benchmark(const ParsedModel& model)
+	{
+		OptimizationResult total{};
+		float optimizeMs{};
+
+		for (const ParsedMesh& mesh : model.meshes)
+		{
+			std::vector<Vertex> vertices(mesh.vertices.begin(), mesh.vertices.end());
+			std::vector<uint32_t> indices(mesh.indices.begin(), mesh.indices.end());
+
+			const auto start = std::chrono::steady_clock::now();
+
+			// The primitives of a mesh can share vertices, so only the triangle order is per primitive
+			for (const ParsedPrimitive& primitive : mesh.primitives)
+			{
+				const std::span<uint32_t> primitiveIndices = std::span<uint32_t>(indices).subspan(primitive.firstIndex, primitive.indexCount);
+				total.before += AnalyzeVertexCache(primitiveIndices, vertices.size());
+
+				OptimizeVertexCache(primitiveIndices, vertices.size());
+				OptimizeOverdraw(primitiveIndices, vertices);
+			}
+			OptimizeVertexFetch(vertices, indices);
+
+			optimizeMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			for (const ParsedPrimitive& primitive : mesh.primitives)
+			{
+				total.after += AnalyzeVertexCache(std::span<const uint32_t>(indices).subspan(primitive.firstIndex, primitive.indexCount), vertices.size());
+			}
+		}
+
+		LogResult(total, model.filePath);
+		LogInfo("  in " + std::to_string(optimizeMs) + "ms, cache size " + std::to_string(CacheSize));
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "ModelLoader.h"
+#include "Vertex.h"
+
+
+// Import time reordering of triangles and vertices, runs on the CPU only
+// Like TangentGenerator the indices are relative to baseVertex, so a primitive can pass only its own vertex range
+namespace MeshOptimizer
+{
+	// Turn off to upload the index order of the source file
+	inline bool OptimizeOnImport = true;
+
+	// Size of the simulated FIFO post transform cache
+	inline constexpr uint32_t CacheSize = 16;
+
+	struct CacheStatistics
+	{
+		size_t triangleCount{};
+		size_t vertexCount{};
+		size_t cacheMisses{};
+
+		// Average cache miss ratio, transformed vertices per triangle (0.5 is the best a regular grid can do, 3 the worst)
+		[[nodiscard]] float GetAcmr() const { return triangleCount > 0 ? static_cast<float>(cacheMisses) / static_cast<float>(triangleCount) : 0.0f; }
+		// Average transform to vertex ratio, 1 means every vertex gets transformed once
+		[[nodiscard]] float GetAtvr() const { return vertexCount > 0 ? static_cast<float>(cacheMisses) / static_cast<float>(vertexCount) : 0.0f; }
+
+		CacheStatistics& operator+=(const CacheStatistics& other)
+		{
+			triangleCount += other.triangleCount;
+			vertexCount += other.vertexCount;
+			cacheMisses += other.cacheMisses;
+			return *this;
+		}
+	};
+
+	struct OptimizationResult
+	{
+		CacheStatistics before{};
+		CacheStatistics after{};
+
+		OptimizationResult& operator+=(const OptimizationResult& other)
+		{
+			before += other.before;
+			after += other.after;
+			return *this;
+		}
+	};
+
+	[[nodiscard]] CacheStatistics AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t baseVertex = 0);
+
+	// Tipsify (Sander et al. 2007), reorders the triangles for the post transform cache
+	void OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t baseVertex = 0);
+
+	// Splits the cache optimized order into clusters and draws the outward facing ones first
+	// A cluster only ends where restarting the cache costs at most threshold times the cluster ACMR
+	void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const Vertex> vertices, uint32_t baseVertex = 0, float threshold = 1.05f);
+
+	// Orders the vertices by first use so the vertex fetch walks memory linearly, unused vertices end up at the back
+	void OptimizeVertexFetch(std::span<Vertex> vertices, std::span<uint32_t> indices, uint32_t baseVertex = 0);
+
+	// All three of the above
+	OptimizationResult Optimize(std::span<Vertex> vertices, std::span<uint32_t> indices, uint32_t baseVertex = 0);
+
+	void LogResult(const OptimizationResult& result, std::string_view name);
+
+	// Optimizes a copy of every mesh and logs the time and ACMR/ATVR before and after
+	void Benchmark(const ParsedModel& model);
+}
@@ -1,4 +1,10 @@
 #include "ModelLoader.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <limits>
 #include <unordered_map>
 
 
@@ -22,14 +28,77 @@
 #include "Mesh.h"
 #include "Vertex.h"
 #include "Core/Logger.h"
+#include "Core/MappedFile.h"
+#include "Core/Image/ImageLoader.h"
+#include "Core/Image/Texture.h"
+#include "Core/Image/TextureBaker.h"
+#include "Core/Image/TextureCache.h"
+#include "Core/UploadBatch.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "ObjVertexMap.h"
+#include "TangentGenerator.h"
+#include "VertexQuantizer.h"
+#include "Patterns/ThreadPool.h"
 #include "Scene/Scene.h"
 #include "Scene/SceneManager.h"
 
 
+namespace
+{
+	// Offset and length of the binary chunk data in a .glb, nothing when the file has none
+	std::optional<std::pair<uint64_t, uint64_t>> GetGlbBinaryChunk(const std::filesystem::path &glbPath)
+	{
+		constexpr uint32_t GlbMagic = 0x46546C67;
+		constexpr uint32_t BinaryChunkType = 0x004E4942;
+
+		std::ifstream file(glbPath, std::ios::binary);
+
+		// magic, version, length, then the length and type of the json chunk
+		std::array<uint32_t, 5> header{};
+		if (!file.read(reinterpret_cast<char *>(header.data()), sizeof(header)) || header[0] != GlbMagic) return std::nullopt;
+
+		const uint64_t binaryChunkStart = sizeof(header) + header[3];
+		file.seekg(static_cast<std::streamoff>(binaryChunkStart));
+
+		std::array<uint32_t, 2> chunkHeader{};
+		if (!file.read(reinterpret_cast<char *>(chunkHeader.data()), sizeof(chunkHeader)) || chunkHeader[1] != BinaryChunkType) return std::nullopt;
+
+		return std::pair{binaryChunkStart + sizeof(chunkHeader), static_cast<uint64_t>(chunkHeader[0])};
+	}
+
+	// The same file can hold many embedded images, the offset tells them apart
+	std::string GetImageKey(const ParsedImage &image)
+	{
+		return image.path + ":" + std::to_string(image.byteOffset);
+	}
+
+	std::string GetImageName(const ParsedImage &image)
+	{
+		return image.IsEmbedded() ? image.path + "@" + std::to_string(image.byteOffset) : image.path;
+	}
+}
+
 namespace GLTFLoader
 {
-	void LoadGLTF(std::string_view filePath, Scene *scene, VulkanContext *vulkanContext)
+	void LoadGLTF(std::string_view filePath, Scene *scene, VulkanContext *vulkanContext, VertexFormat vertexFormat)
 	{
+		std::optional<ParsedModel> parsed = ParseGLTF(filePath);
+		if (!parsed) return;
+
+		if (vertexFormat == VertexFormat::Packed) VertexQuantizer::QuantizeModel(parsed.value());
+		DecodeImages(parsed.value());
+
+		CreateGLTF(parsed.value(), scene, vulkanContext);
+	}
+
+	std::optional<ParsedModel> ParseGLTF(std::string_view filePath)
+	{
+		if (std::optional<ParsedModel> cached = MeshCache::Load(filePath))
+		{
+			return cached;
+		}
+
 		LogInfo("Loading GLTF: " + std::string(filePath));
 
 		const std::filesystem::path fullfilePath = VulkanContext::GetAssetPath() / filePath;
@@ -38,43 +107,98 @@ namespace GLTFLoader
 		if (!gltfOpt)
 		{
 			LogError("Failed to load GLTF: " + std::string(filePath));
-			return;
+			return std::nullopt;
 		}
 
 		fastgltf::Asset &gltf = gltfOpt.value();
 
-		std::vector<std::string> createdMaterialNames;
-		CreateMaterials(gltf, vulkanContext, createdMaterialNames);
+		ParsedModel parsed{};
+		parsed.filePath = std::string(filePath);
+		parsed.materials = ParseMaterials(gltf, filePath);
 
-		// Structure for holding shared buffers and mesh processing context
-		struct MeshData
+		// One decode job per primitive with its offsets into the shared storage
+		struct PrimitiveJob
 		{
-			std::vector<Mesh *> meshes;
-			std::vector<uint32_t> indices;
-			std::vector<Vertex> vertices;
-			std::vector<Primitive> primitives;
-		} meshData;
+			size_t meshIndex;
+			size_t primitiveIndex;
+			size_t meshVertexStart;
+			size_t vertexOffset;
+			size_t indexOffset;
+			size_t vertexCount;
+			size_t indexCount;
+			MeshOptimizer::OptimizationResult optimization{};
+		};
+
+		const auto decodeStart = std::chrono::steady_clock::now();
 
-		auto processSubMesh = [&](fastgltf::Primitive &subMesh, size_t vertexOffset, size_t indexOffset)
+		std::vector<ParsedMesh> &meshDatas = parsed.meshes;
+		meshDatas.resize(gltf.meshes.size());
+		std::vector<PrimitiveJob> jobs;
+
+		// Mesh ranges in the storage, the spans can only be set once the storage has its final size
+		std::vector<std::pair<size_t, size_t>> meshVertexRanges(gltf.meshes.size());
+		std::vector<std::pair<size_t, size_t>> meshIndexRanges(gltf.meshes.size());
+
+		// Prefix sum over the accessor counts so every primitive knows where to write before decoding
+		size_t vertexOffset{}, indexOffset{};
+		for (size_t meshIndex{}; meshIndex < gltf.meshes.size(); ++meshIndex)
 		{
-			Primitive primitive{};
-			primitive.material = MaterialManager::GetMaterial(createdMaterialNames[subMesh.materialIndex.value()]);
-			primitive.firstIndex = static_cast<uint32_t>(indexOffset);
+			fastgltf::Mesh &mesh = gltf.meshes[meshIndex];
+			ParsedMesh &meshData = meshDatas[meshIndex];
+			meshData.name = mesh.name.c_str();
+			meshData.primitives.resize(mesh.primitives.size());
+
+			const size_t meshVertexStart = vertexOffset;
+			const size_t meshIndexStart = indexOffset;
+			for (size_t primitiveIndex{}; primitiveIndex < mesh.primitives.size(); ++primitiveIndex)
+			{
+				fastgltf::Primitive &subMesh = mesh.primitives[primitiveIndex];
+
+				const auto position = subMesh.findAttribute("POSITION");
+				const size_t vertexCount = position != subMesh.attributes.end() ? gltf.accessors[position->second].count : 0;
+				const size_t indexCount = subMesh.indicesAccessor.has_value() ? gltf.accessors[subMesh.indicesAccessor.value()].count : 0;
 
-			// Load indices
-			fastgltf::Accessor &indexAccessor = gltf.accessors[subMesh.indicesAccessor.value()];
-			meshData.indices.reserve(indexOffset + indexAccessor.count);
-			fastgltf::iterateAccessor<std::uint32_t>(gltf, indexAccessor, [&](std::uint32_t idx)
+				ParsedPrimitive &primitive = meshData.primitives[primitiveIndex];
+				primitive.materialIndex = subMesh.materialIndex;
+				primitive.firstIndex = static_cast<uint32_t>(indexOffset - meshIndexStart);
+				primitive.indexCount = static_cast<uint32_t>(indexCount);
+
+				jobs.push_back({meshIndex, primitiveIndex, meshVertexStart, vertexOffset, indexOffset, vertexCount, indexCount});
+				vertexOffset += vertexCount;
+				indexOffset += indexCount;
+			}
+
+			meshVertexRanges[meshIndex] = {meshVertexStart, vertexOffset - meshVertexStart};
+			meshIndexRanges[meshIndex] = {meshIndexStart, indexOffset - meshIndexStart};
+		}
+
+		parsed.vertexStorage.resize(vertexOffset);
+		parsed.indexStorage.resize(indexOffset);
+		for (size_t meshIndex{}; meshIndex < meshDatas.size(); ++meshIndex)
+		{
+			meshDatas[meshIndex].vertices = std::span<const Vertex>(parsed.vertexStorage).subspan(meshVertexRanges[meshIndex].first, meshVertexRanges[meshIndex].second);
+			meshDatas[meshIndex].indices = std::span<const uint32_t>(parsed.indexStorage).subspan(meshIndexRanges[meshIndex].first, meshIndexRanges[meshIndex].second);
+		}
+
+		auto processSubMesh = [&](PrimitiveJob &job)
+		{
+			fastgltf::Primitive &subMesh = gltf.meshes[job.meshIndex].primitives[job.primitiveIndex];
+
+			if (job.vertexCount == 0 || job.indexCount == 0) return;
+
+			// Load indices, they are relative to the start of the owning mesh
+			uint32_t *indices = parsed.indexStorage.data() + job.indexOffset;
+			const size_t meshLocalVertexOffset = job.vertexOffset - job.meshVertexStart;
+			fastgltf::iterateAccessorWithIndex<std::uint32_t>(gltf, gltf.accessors[subMesh.indicesAccessor.value()], [&](std::uint32_t idx, size_t index)
 			{
-				meshData.indices.push_back(idx + vertexOffset);
+				indices[index] = static_cast<uint32_t>(idx + meshLocalVertexOffset);
 			});
 
 			// Load vertex positions
-			fastgltf::Accessor &posAccessor = gltf.accessors[subMesh.findAttribute("POSITION")->second];
-			meshData.vertices.resize(vertexOffset + posAccessor.count);
-			fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, posAccessor, [&](const glm::vec3 &pos, size_t index)
+			Vertex *vertices = parsed.vertexStorage.data() + job.vertexOffset;
+			fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, gltf.accessors[subMesh.findAttribute("POSITION")->second], [&](const glm::vec3 &pos, size_t index)
 			{
-				meshData.vertices[vertexOffset + index].pos = pos;
+				vertices[index].pos = pos;
 			});
 
 			// Load vertex normals
@@ -82,7 +206,7 @@ namespace GLTFLoader
 			{
 				fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, gltf.accessors[normals->second], [&](const glm::vec3 &normal, size_t index)
 				{
-					meshData.vertices[vertexOffset + index].normal = normal;
+					vertices[index].normal = normal;
 				});
 			}
 
@@ -91,54 +215,46 @@ namespace GLTFLoader
 			{
 				fastgltf::iterateAccessorWithIndex<glm::vec2>(gltf, gltf.accessors[uv->second], [&](const glm::vec2 &uvCoord, size_t index)
 				{
-					meshData.vertices[vertexOffset + index].texCoord = uvCoord;
+					vertices[index].texCoord = uvCoord;
 				});
 			}
 
-			// Calculate tangents
-			for (size_t i = indexOffset; i < meshData.indices.size(); i += 3)
-			{
-				const Vertex &v0 = meshData.vertices[meshData.indices[i]];
-				const Vertex &v1 = meshData.vertices[meshData.indices[i + 1]];
-				const Vertex &v2 = meshData.vertices[meshData.indices[i + 2]];
-
-				glm::vec3 edge1 = v1.pos - v0.pos;
-				glm::vec3 edge2 = v2.pos - v0.pos;
-				glm::vec2 deltaUV1 = v1.texCoord - v0.texCoord;
-				glm::vec2 deltaUV2 = v2.texCoord - v0.texCoord;
+			// The indices of a primitive only reference its own vertex range
+			TangentGenerator::Generate(std::span<Vertex>(vertices, job.vertexCount), std::span<const uint32_t>(indices, job.indexCount), static_cast<uint32_t>(meshLocalVertexOffset));
 
-				float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
-				glm::vec3 tangent{f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x), f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y), f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z)};
-
-				tangent = glm::normalize(tangent);
-
-				meshData.vertices[meshData.indices[i]].tangent += tangent;
-				meshData.vertices[meshData.indices[i + 1]].tangent += tangent;
-				meshData.vertices[meshData.indices[i + 2]].tangent += tangent;
+			// Reorders the triangles and vertices of this primitive for the post transform cache, overdraw and vertex fetch
+			if (MeshOptimizer::OptimizeOnImport)
+			{
+				job.optimization = MeshOptimizer::Optimize(std::span<Vertex>(vertices, job.vertexCount), std::span<uint32_t>(indices, job.indexCount), static_cast<uint32_t>(meshLocalVertexOffset));
 			}
-
-			primitive.indexCount = static_cast<uint32_t>(meshData.indices.size() - indexOffset);
-			meshData.primitives.emplace_back(std::move(primitive));
 		};
 
-		// Iterate through all meshes
-		for (fastgltf::Mesh &mesh : gltf.meshes)
+		// Decode all primitives, every job writes to disjoint ranges so no locking is needed
+		if (ParallelPrimitiveDecode)
 		{
-			meshData.indices.clear();
-			meshData.vertices.clear();
-			meshData.primitives.clear();
-
-			size_t vertexOffset = 0, indexOffset = 0;
-			for (auto &subMesh : mesh.primitives)
+			ThreadPool::ParallelFor(jobs.size(), [&](size_t jobIndex) { processSubMesh(jobs[jobIndex]); });
+		}
+		else
+		{
+			for (PrimitiveJob &job : jobs)
 			{
-				processSubMesh(subMesh, vertexOffset, indexOffset);
-				vertexOffset = meshData.vertices.size();
-				indexOffset = meshData.indices.size();
+				processSubMesh(job);
 			}
+		}
 
-			auto newMesh = std::make_unique<Mesh>(meshData.vertices, meshData.indices, mesh.name.c_str(), meshData.primitives, 0);
-			meshData.meshes.push_back(newMesh.get());
-			scene->AddMesh(std::move(newMesh));
+		const auto decodeEnd = std::chrono::steady_clock::now();
+		const float decodeMs = std::chrono::duration<float, std::milli>(decodeEnd - decodeStart).count();
+		const std::string decodeMode = ParallelPrimitiveDecode ? std::to_string(ThreadPool::GetThreadCount() + 1) + " threads" : "serial";
+		LogInfo("Decoded " + std::to_string(jobs.size()) + " primitives of " + std::string(filePath) + " in " + std::to_string(decodeMs) + "ms (" + decodeMode + ")");
+
+		if (MeshOptimizer::OptimizeOnImport)
+		{
+			MeshOptimizer::OptimizationResult optimization{};
+			for (const PrimitiveJob &job : jobs)
+			{
+				optimization += job.optimization;
+			}
+			MeshOptimizer::LogResult(optimization, filePath);
 		}
 
 		// Setup Transform, Rotation, and Scale (TRS)
@@ -146,17 +262,160 @@ namespace GLTFLoader
 		{
 			if (node.meshIndex)
 			{
-				Mesh *meshNode = meshData.meshes[node.meshIndex.value()];
 				auto transform = node.transform;
 
 				glm::mat4 transformMatrix = std::holds_alternative<fastgltf::TRS>(transform) ? ComputeTransformMatrix(std::get<fastgltf::TRS>(transform)) : glm::make_mat4(std::get<std::array<float, 16>>(transform).data());
 
 				// Rotate 90 degrees around the x-axis
-				transformMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)) * transformMatrix;
+				meshDatas[node.meshIndex.value()].transform = glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)) * transformMatrix;
+			}
+		}
+
+		MeshCache::Save(filePath, parsed);
+		return parsed;
+	}
 
-				meshNode->SetTransform(transformMatrix);
+	void BenchmarkPrimitiveDecode(const std::string &filePath, uint32_t runCount)
+	{
+		// Both paths have to decode the file, a cache hit would skip the decode
+		const bool useCache = MeshCache::UseCache;
+		const bool parallelPrimitiveDecode = ParallelPrimitiveDecode;
+		MeshCache::UseCache = false;
+
+		auto parseBest = [&filePath, runCount](bool isParallel, std::optional<ParsedModel> &result)
+		{
+			ParallelPrimitiveDecode = isParallel;
+			float bestMs = std::numeric_limits<float>::max();
+			for (uint32_t run{}; run < std::max(runCount, 1u); ++run)
+			{
+				const auto start = std::chrono::steady_clock::now();
+				result = ParseGLTF(filePath);
+				bestMs = std::min(bestMs, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+				if (!result) break;
 			}
+			return bestMs;
+		};
+
+		std::optional<ParsedModel> serial;
+		std::optional<ParsedModel> parallel;
+		const float serialMs = parseBest(false, serial);
+		const float parallelMs = parseBest(true, parallel);
+
+		MeshCache::UseCache = useCache;
+		ParallelPrimitiveDecode = parallelPrimitiveDecode;
+
+		if (!serial || !parallel)
+		{
+			LogError("Failed to parse: " + filePath);
+			return;
+		}
+
+		const bool isSame = serial->vertexStorage == parallel->vertexStorage && serial->indexStorage == parallel->indexStorage;
+		size_t primitiveCount{};
+		for (const ParsedMesh &mesh : serial->meshes)
+		{
+			primitiveCount += mesh.primitives.size();
+		}
+
+		LogInfo("Parsed " + std::to_string(primitiveCount) + " primitives of " + filePath + ", best of " + std::to_string(std::max(runCount, 1u)) + " runs");
+		LogInfo("  Serial: " + std::to_string(serialMs) + "ms");
+		LogInfo("  Parallel (" + std::to_string(ThreadPool::GetThreadCount() + 1) + " threads): " + std::to_string(parallelMs) + "ms, " + std::to_string(serialMs / parallelMs) + "x, " + (isSame ? "same result" : "DIFFERENT result"));
+	}
+
+	std::vector<Mesh *> CreateGLTF(const ParsedModel &parsed, Scene *scene, VulkanContext *vulkanContext)
+	{
+		// All texture and mesh uploads of this file go out in one submit
+		UploadBatch::Begin();
+
+		// Primitives without a material share a white default one, it comes after the materials of the file
+		std::vector<ParsedMaterial> materials = parsed.materials;
+		const size_t defaultMaterialIndex = materials.size();
+		const bool needsDefaultMaterial = std::ranges::any_of(parsed.meshes, [](const ParsedMesh &mesh)
+		{
+			return std::ranges::any_of(mesh.primitives, [](const ParsedPrimitive &primitive) { return !primitive.materialIndex.has_value(); });
+		});
+		if (needsDefaultMaterial) materials.push_back({"DefaultMaterial"});
+
+		std::vector<std::string> createdMaterialNames;
+		CreateMaterials(materials, vulkanContext, createdMaterialNames, parsed.vertexFormat, parsed.images);
+
+		const auto uploadStart = std::chrono::steady_clock::now();
+
+		// Upload stays serial on the main thread
+		std::vector<Mesh *> createdMeshes;
+		createdMeshes.reserve(parsed.meshes.size());
+		for (const ParsedMesh &meshData : parsed.meshes)
+		{
+			std::vector<Primitive> primitives;
+			primitives.reserve(meshData.primitives.size());
+			for (const ParsedPrimitive &parsedPrimitive : meshData.primitives)
+			{
+				Primitive primitive{};
+				primitive.firstIndex = parsedPrimitive.firstIndex;
+				primitive.indexCount = parsedPrimitive.indexCount;
+				primitive.material = MaterialManager::GetMaterial(createdMaterialNames[parsedPrimitive.materialIndex.value_or(defaultMaterialIndex)]);
+				primitives.emplace_back(std::move(primitive));
+			}
+
+			std::unique_ptr<Mesh> newMesh = parsed.vertexFormat == VertexFormat::Packed
+				? std::make_unique<Mesh>(meshData.packedVertices, meshData.indices, meshData.name, primitives, meshData.dequantizeMatrix)
+				: std::make_unique<Mesh>(meshData.vertices, meshData.indices, meshData.name, primitives);
+			newMesh->SetTransform(meshData.transform);
+			createdMeshes.push_back(newMesh.get());
+			scene->AddMesh(std::move(newMesh));
+		}
+
+		UploadBatch::End();
+
+		const float uploadMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - uploadStart).count();
+		LogInfo("Uploaded " + std::to_string(parsed.meshes.size()) + " meshes of " + parsed.filePath + " in " + std::to_string(uploadMs) + "ms");
+		return createdMeshes;
+	}
+
+	std::vector<ParsedMaterial> ParseMaterials(const fastgltf::Asset &gltf, std::string_view filePath)
+	{
+		// Images in a buffer view only work for the binary chunk of a .glb, that is a plain range of the file
+		const std::optional<std::pair<uint64_t, uint64_t>> binaryChunk = std::filesystem::path(filePath).extension() == ".glb" ? GetGlbBinaryChunk(VulkanContext::GetAssetPath() / filePath) : std::nullopt;
+
+		auto getImage = [&gltf, &binaryChunk, filePath](const auto &textureInfo) -> ParsedImage
+		{
+			if (!textureInfo.has_value()) return {};
+
+			const fastgltf::Texture &texture = gltf.textures[textureInfo.value().textureIndex];
+			if (!texture.imageIndex.has_value()) return {};
+
+			const fastgltf::Image &image = gltf.images[texture.imageIndex.value()];
+			if (const auto uri = std::get_if<fastgltf::sources::URI>(&image.data))
+			{
+				return {std::string(uri->uri.string())};
+			}
+
+			if (const auto bufferView = std::get_if<fastgltf::sources::BufferView>(&image.data))
+			{
+				// The binary chunk is always the first buffer, the ones after it are external files
+				const fastgltf::BufferView &view = gltf.bufferViews[bufferView->bufferViewIndex];
+				if (binaryChunk && view.bufferIndex == 0 && view.byteOffset + view.byteLength <= binaryChunk->second)
+				{
+					return {std::string(filePath), binaryChunk->first + view.byteOffset, view.byteLength};
+				}
+			}
+
+			LogError("Only gltf images referenced by uri or in the binary chunk of a .glb are supported: " + std::string(image.name.c_str()));
+			return {};
+		};
+
+		std::vector<ParsedMaterial> materials;
+		materials.reserve(gltf.materials.size());
+		for (const fastgltf::Material &mat : gltf.materials)
+		{
+			ParsedMaterial &material = materials.emplace_back();
+			material.name = mat.name.c_str();
+			material.baseColorTexture = getImage(mat.pbrData.baseColorTexture);
+			material.normalTexture = getImage(mat.normalTexture);
+			material.metallicRoughnessTexture = getImage(mat.pbrData.metallicRoughnessTexture);
 		}
+
+		return materials;
 	}
 
 	// Helper function to compute a transform matrix from TRS
@@ -220,111 +479,184 @@ namespace GLTFLoader
 	}
 
 
-	void CreateMaterials(const fastgltf::Asset &gltf, VulkanContext *vulkanContext, std::vector<std::string> &createdMaterialNames)
+	void DecodeImages(ParsedModel &model)
 	{
-		createdMaterialNames.reserve(gltf.materials.size());
-
-		// Load Textures
-		std::vector<std::variant<std::filesystem::path, ImageInMemory>> images;
-
-		for (const fastgltf::Image &texture : gltf.images)
+		// Every distinct image gets read once, no matter how many materials or color spaces use it
+		std::unordered_map<std::string, size_t> imageLookup;
+		for (const ParsedMaterial &material : model.materials)
 		{
-			fastgltf::DataSource dataa = texture.data;
-			if (const auto uri = std::get_if<fastgltf::sources::URI>(&dataa))
+			for (const ParsedImage *image : {&material.baseColorTexture, &material.normalTexture, &material.metallicRoughnessTexture})
 			{
-				images.emplace_back(VulkanContext::GetAssetPath() / std::string(uri->uri.string()));
-			}
+				if (image->IsEmpty()) continue;
 
-			//TODO: Fix this
-			else if (auto array = std::get_if<fastgltf::sources::Array>(&dataa))
-			{
-				LogError("Array not supported yet");
-				// ImageInMemory loadedImage{};
-				// if(array->mimeType == fastgltf::MimeType::KTX2)
-				// {
-				//     auto pD = array->bytes;
-				//     ktxTexture* texturePtr{};
-				//     auto sources = ktx::CreateImageFromMemory(array->bytes.data(), array->bytes.size(),loadedImage.imageSize, loadedImage.mipLevels, &texturePtr);
-				//
-				//     loadedImage.texture = texturePtr;
-				//     loadedImage.staginBuffer = sources.first;
-				//     loadedImage.stagingBufferMemory = sources.second;
-				//
-				// }else if(array->mimeType == fastgltf::MimeType::PNG || array->mimeType == fastgltf::MimeType::JPEG ||array->mimeType == fastgltf::MimeType::None)
-				// {
-				//     auto sources = stbi::CreateImageFromMemory(array->bytes.data(), array->bytes.size(), loadedImage.imageSize, loadedImage.mipLevels);
-				//     loadedImage.staginBuffer = sources.first;
-				//      loadedImage.stagingBufferMemory = sources.second;
-				// }else {
-				//     LogError("Unsuported embeded texture format in gtlf");
-				// }
-				//
-				// images.emplace_back(loadedImage);
+				// .ktx files and baked textures are uploaded as is by the Texture
+				const std::filesystem::path fullPath = VulkanContext::GetAssetPath() / image->path;
+				if (!image->IsEmbedded() && (fullPath.extension() == ".ktx" || TextureBaker::FindBaked(fullPath))) continue;
 
+				const auto [iterator, isNew] = imageLookup.try_emplace(GetImageKey(*image), model.images.size());
+				if (isNew) model.images.push_back({*image});
 			}
+		}
 
-			else if (auto customBuffer = std::get_if<fastgltf::sources::CustomBuffer>(&dataa))
-			{
-				LogError("CustomBuffer not supported yet");
-			}
-			else if (auto byteView = std::get_if<fastgltf::sources::ByteView>(&dataa))
-			{
-				LogError("ByteView not supported yet");
-			}
-			else if (auto fallback = std::get_if<fastgltf::sources::Fallback>(&dataa))
+		// Every file gets mapped once, the decoders read straight out of the mapping
+		std::unordered_map<std::string, std::shared_ptr<const MappedFile>> mappedFiles;
+		std::vector<size_t> decodeJobs;
+		for (size_t imageIndex{}; imageIndex < model.images.size(); ++imageIndex)
+		{
+			ParsedImageData &imageData = model.images[imageIndex];
+			const std::filesystem::path fullPath = VulkanContext::GetAssetPath() / imageData.image.path;
+
+			std::shared_ptr<const MappedFile> &mappedFile = mappedFiles[fullPath.generic_string()];
+			if (!mappedFile) mappedFile = std::make_shared<const MappedFile>(fullPath);
+
+			const uint64_t byteOffset = imageData.image.byteOffset;
+			const uint64_t byteLength = imageData.image.IsEmbedded() ? imageData.image.byteLength : mappedFile->GetSize();
+			if (!mappedFile->IsValid() || byteOffset + byteLength > mappedFile->GetSize())
 			{
-				LogError("Fallback not supported yet");
+				LogError("Failed to read image: " + imageData.image.path);
+				continue;
 			}
-			else if (auto bufferView = std::get_if<fastgltf::sources::BufferView>(&dataa))
+
+			imageData.file = mappedFile;
+			imageData.encoded = std::span<const uint8_t>(mappedFile->GetData() + byteOffset, byteLength);
+			imageData.isKtx = ktx::IsKtx(imageData.encoded);
+			if (!imageData.isKtx) decodeJobs.push_back(imageIndex);
+		}
+
+		// Decoding only touches CPU memory, every job writes to its own image so no locking is needed
+		const auto decodeStart = std::chrono::steady_clock::now();
+		auto decodeImage = [&model, &decodeJobs](size_t jobIndex)
+		{
+			ParsedImageData &imageData = model.images[decodeJobs[jobIndex]];
+			const auto start = std::chrono::steady_clock::now();
+			imageData.decoded = stbi::Decode(imageData.encoded);
+			imageData.decodeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		};
+		if (ParallelImageDecode)
+		{
+			ThreadPool::ParallelFor(decodeJobs.size(), decodeImage);
+		}
+		else
+		{
+			for (size_t jobIndex{}; jobIndex < decodeJobs.size(); ++jobIndex)
 			{
-				LogError("BufferView not supported yet");
+				decodeImage(jobIndex);
 			}
 		}
+		const float decodeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - decodeStart).count();
 
+		float summedDecodeMs{};
+		for (const ParsedImageData &imageData : model.images)
+		{
+			summedDecodeMs += imageData.decodeMs;
+			if (imageData.decoded) LogInfo("  " + GetImageName(imageData.image) + ": decode " + std::to_string(imageData.decodeMs) + "ms");
+		}
 
-		for (const fastgltf::Material &mat : gltf.materials)
+		const std::string decodeMode = ParallelImageDecode ? std::to_string(ThreadPool::GetThreadCount() + 1) + " threads" : "serial";
+		LogInfo("Decoded " + std::to_string(decodeJobs.size()) + " images of " + model.filePath + " in " + std::to_string(decodeMs) + "ms (" + decodeMode + ", " + std::to_string(summedDecodeMs) + "ms summed)");
+	}
+
+	void CreateMaterials(const std::vector<ParsedMaterial> &materials, VulkanContext *vulkanContext, std::vector<std::string> &createdMaterialNames, VertexFormat vertexFormat,
+	                     std::span<const ParsedImageData> images)
+	{
+		createdMaterialNames.reserve(materials.size());
+
+		// The pipeline vertex input depends on the format, so packed meshes get their own materials
+		const bool isPacked = vertexFormat == VertexFormat::Packed;
+		const std::string vertexShader = isPacked ? "shader_packed.vert" : "shader.vert";
+
+		std::unordered_map<std::string, const ParsedImageData *> imageData;
+		for (const ParsedImageData &data : images)
 		{
-			auto newMaterial = MaterialManager::CreateMaterial(vulkanContext, "shader.vert", "PBR_Graypacked.frag", mat.name.c_str());
-			createdMaterialNames.emplace_back(mat.name.c_str());
+			imageData.emplace(GetImageKey(data.image), &data);
+		}
 
-			auto *ubo = newMaterial->GetDescriptorSet()->AddBuffer(0, DescriptorType::UniformBuffer);
-			ubo->AddVariable(glm::vec4{1});
-			ubo->AddVariable(glm::vec4{1});
+		// Every distinct image in a color space becomes one texture that all materials using it share
+		std::unordered_map<std::string, std::shared_ptr<Texture>> textures;
+		uint32_t cachedCount{};
+		float uploadMs{};
 
-			// Load Albedo
-			if (mat.pbrData.baseColorTexture.has_value())
-			{
-				size_t img = gltf.textures[mat.pbrData.baseColorTexture.value().textureIndex].imageIndex.value();
-				newMaterial->GetDescriptorSet()->AddTexture(1, images[img], vulkanContext, ColorType::SRGB);
-			}
-			else
+		// Only the copy into the staging ring and the texture creation happen here, the decode already ran on the worker
+		// A ring slice is only valid until the next allocation, so every texture is created right after its staging gets filled
+		auto getTexture = [&](const ParsedImage &parsedImage, ColorType colorType) -> std::shared_ptr<Texture>
+		{
+			const ParsedImage image = parsedImage.IsEmpty() ? ParsedImage{"white.ktx"} : parsedImage;
+			std::shared_ptr<Texture> &texture = textures[GetImageKey(image) + ":" + std::to_string(static_cast<int>(colorType))];
+			if (texture) return texture;
+
+			// Embedded images have no file of their own to be cached under, they are only shared within this model
+			const std::filesystem::path fullPath = VulkanContext::GetAssetPath() / image.path;
+			if (!image.IsEmbedded())
 			{
-				newMaterial->GetDescriptorSet()->AddTexture(1, "white.ktx", vulkanContext, ColorType::LINEAR);
+				texture = TextureCache::Find(fullPath, colorType);
+				if (texture)
+				{
+					++cachedCount;
+					return texture;
+				}
 			}
 
-			// Load Normal
-			if (mat.normalTexture.has_value())
+			const auto start = std::chrono::steady_clock::now();
+
+			const auto data = imageData.find(GetImageKey(image));
+			std::optional<ImageInMemory> imageInMemory{};
+			if (data != imageData.end() && data->second->decoded)
 			{
-				size_t img = gltf.textures[mat.normalTexture.value().textureIndex].imageIndex.value();
-				newMaterial->GetDescriptorSet()->AddTexture(2, images[img], vulkanContext, ColorType::LINEAR);
+				imageInMemory = stbi::CreateImageFromPixels(data->second->decoded.value());
 			}
-			else
+			else if (data != imageData.end() && data->second->isKtx)
 			{
-				newMaterial->GetDescriptorSet()->AddTexture(2, "white.ktx", vulkanContext, ColorType::LINEAR);
+				imageInMemory = ktx::CreateImageFromMemory(data->second->encoded);
 			}
 
-			// Load graypacked metal/roughness
-			if (mat.pbrData.metallicRoughnessTexture.has_value())
+			if (imageInMemory)
 			{
-				size_t img = gltf.textures[mat.pbrData.metallicRoughnessTexture.value().textureIndex].imageIndex.value();
-
-				newMaterial->GetDescriptorSet()->AddTexture(3, images[img], vulkanContext, ColorType::LINEAR);
+				texture = std::make_shared<Texture>(std::move(imageInMemory.value()), vulkanContext, colorType, TextureType::TEXTURE_2D);
+				if (!image.IsEmbedded()) TextureCache::Insert(fullPath, vulkanContext, colorType, TextureType::TEXTURE_2D, texture);
+			}
+			else if (data != imageData.end() || image.IsEmbedded())
+			{
+				// The read or decode failed, it has already been logged
+				texture = TextureCache::Load("white.ktx", vulkanContext, colorType);
 			}
 			else
 			{
-				newMaterial->GetDescriptorSet()->AddTexture(3, "white.ktx", vulkanContext, ColorType::LINEAR);
+				texture = TextureCache::Load(fullPath, vulkanContext, colorType);
 			}
 
+			const float imageUploadMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+			uploadMs += imageUploadMs;
+			LogInfo("  " + GetImageName(image) + ": upload " + std::to_string(imageUploadMs) + "ms");
+			return texture;
+		};
+
+		std::vector<std::array<std::shared_ptr<Texture>, 3>> materialTextures;
+		materialTextures.reserve(materials.size());
+		for (const ParsedMaterial &mat : materials)
+		{
+			materialTextures.push_back({getTexture(mat.baseColorTexture, ColorType::SRGB), getTexture(mat.normalTexture, ColorType::LINEAR), getTexture(mat.metallicRoughnessTexture, ColorType::LINEAR)});
+		}
+
+		LogInfo("Created " + std::to_string(textures.size()) + " textures (" + std::to_string(cachedCount) + " already cached), uploads " + std::to_string(uploadMs) + "ms");
+
+		for (size_t materialIndex{}; materialIndex < materials.size(); ++materialIndex)
+		{
+			const ParsedMaterial &mat = materials[materialIndex];
+			auto newMaterial = MaterialManager::CreateMaterial(vulkanContext, vertexShader, "PBR_Graypacked.frag", isPacked ? mat.name + "_Packed" : mat.name);
+			newMaterial->SetVertexFormat(vertexFormat);
+			// The manager renames duplicates, look the material up by the name it actually got
+			createdMaterialNames.emplace_back(newMaterial->GetMaterialName());
+
+			auto *ubo = newMaterial->GetDescriptorSet()->AddBuffer(0, DescriptorType::UniformBuffer);
+			ubo->AddVariable(glm::vec4{1});
+			ubo->AddVariable(glm::vec4{1});
+
+			// Albedo, normal and graypacked metal/roughness
+			const std::array<std::shared_ptr<Texture>, 3> &textureSet = materialTextures[materialIndex];
+			newMaterial->GetDescriptorSet()->AddTexture(1, textureSet[0], vulkanContext);
+			newMaterial->GetDescriptorSet()->AddTexture(2, textureSet[1], vulkanContext);
+			newMaterial->GetDescriptorSet()->AddTexture(3, textureSet[2], vulkanContext);
+
 			newMaterial->GetDescriptorSet()->AddTexture(4, "cubemap_vulkan.ktx", vulkanContext, ColorType::SRGB, TextureType::TEXTURE_CUBE);
 			newMaterial->CreatePipeline();
 		}
@@ -367,110 +699,291 @@ namespace GLTFLoader
 } // namespace GLTFLoader
 
 
-// TODO Move to a seperate thread
+// Thread safe, the AssetStreamer calls this from its workers
 namespace ObjLoader
 {
-	void LoadObj(const std::string &filePath, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices)
-	{
-		const auto path = VulkanContext::GetAssetPath() / filePath;
+	constexpr size_t VertexChunkSize = 16384;
 
+	ObjVertexMap::Key ToKey(const tinyobj::index_t &objIndex)
+	{
+		return {objIndex.vertex_index, objIndex.normal_index, objIndex.texcoord_index};
+	}
 
-		tinyobj::attrib_t attributes;
-		std::vector<tinyobj::shape_t> shapes;
+	bool ReadObj(const std::filesystem::path &path, tinyobj::attrib_t &attributes, std::vector<tinyobj::shape_t> &shapes)
+	{
 		std::vector<tinyobj::material_t> materials;
 		std::string errors;
 		std::string warnings;
 
 		const bool success = tinyobj::LoadObj(&attributes, &shapes, &materials, &warnings, &errors, path.generic_string().c_str());
-
-
 		if (!success)
 		{
 			LogError("Failed to load: " + path.generic_string() + " with the following errors: " + errors);
-			return;
+			return false;
 		}
 
 		LogWarning(warnings);
+		return true;
+	}
 
-		std::unordered_map<Vertex, uint32_t, VertexHasher> uniqueVertices{};
-		for (auto &shape : shapes)
+	// Adds the index triples of objIndices to the map, new triples get the next vertex index
+	void DeduplicateIndices(const std::vector<tinyobj::index_t> &objIndices, ObjVertexMap &vertexMap, std::vector<ObjVertexMap::Key> &uniqueKeys, std::vector<uint32_t> &indices)
+	{
+		for (const tinyobj::index_t &objIndex : objIndices)
+		{
+			const ObjVertexMap::Key key = ToKey(objIndex);
+			const auto [vertexIndex, isNew] = vertexMap.FindOrInsert(key, static_cast<uint32_t>(uniqueKeys.size()));
+			if (isNew) uniqueKeys.push_back(key);
+
+			indices.push_back(vertexIndex);
+		}
+	}
+
+	void DeduplicateSerial(const std::vector<tinyobj::shape_t> &shapes, std::vector<ObjVertexMap::Key> &uniqueKeys, std::vector<uint32_t> &indices)
+	{
+		size_t indexCount{};
+		for (const tinyobj::shape_t &shape : shapes)
+		{
+			indexCount += shape.mesh.indices.size();
+		}
+
+		ObjVertexMap vertexMap;
+		vertexMap.Reserve(indexCount);
+		indices.reserve(indexCount);
+
+		for (const tinyobj::shape_t &shape : shapes)
+		{
+			DeduplicateIndices(shape.mesh.indices, vertexMap, uniqueKeys, indices);
+		}
+	}
+
+	// Every shape gets its own map on the ThreadPool, the merge afterwards only walks the unique triples of every shape
+	// Merging in shape order gives exactly the same vertices and indices as the serial version
+	void DeduplicateParallel(const std::vector<tinyobj::shape_t> &shapes, std::vector<ObjVertexMap::Key> &uniqueKeys, std::vector<uint32_t> &indices)
+	{
+		struct ShapeResult
+		{
+			std::vector<ObjVertexMap::Key> uniqueKeys;
+			std::vector<uint32_t> indices;
+			std::vector<uint32_t> remap;
+			size_t indexOffset{};
+		};
+
+		std::vector<ShapeResult> results(shapes.size());
+		ThreadPool::ParallelFor(shapes.size(), [&](size_t shapeIndex)
 		{
-			tinyobj::mesh_t &mesh = shape.mesh;
+			const std::vector<tinyobj::index_t> &objIndices = shapes[shapeIndex].mesh.indices;
+			ShapeResult &result = results[shapeIndex];
 
-			for (auto i : mesh.indices)
+			ObjVertexMap vertexMap;
+			vertexMap.Reserve(objIndices.size());
+			result.indices.reserve(objIndices.size());
+			DeduplicateIndices(objIndices, vertexMap, result.uniqueKeys, result.indices);
+		});
+
+		size_t uniqueCount{};
+		for (const ShapeResult &result : results)
+		{
+			uniqueCount += result.uniqueKeys.size();
+		}
+
+		ObjVertexMap vertexMap;
+		vertexMap.Reserve(uniqueCount);
+		uniqueKeys.reserve(uniqueCount);
+
+		size_t indexCount{};
+		for (ShapeResult &result : results)
+		{
+			result.remap.resize(result.uniqueKeys.size());
+			for (size_t i{}; i < result.uniqueKeys.size(); ++i)
 			{
-				glm::vec3 position = {attributes.vertices[3 * i.vertex_index], attributes.vertices[3 * i.vertex_index + 1], attributes.vertices[3 * i.vertex_index + 2]};
+				const auto [vertexIndex, isNew] = vertexMap.FindOrInsert(result.uniqueKeys[i], static_cast<uint32_t>(uniqueKeys.size()));
+				if (isNew) uniqueKeys.push_back(result.uniqueKeys[i]);
 
-				glm::vec3 normal{};
-				if (i.normal_index != -1)
-				{
-					if (3 * i.normal_index + 2 >= attributes.vertices.size())
-					{
-						LogError("This is not a supported .Obj file! The Normals Index is out of bounds!");
-						return;
-					}
+				result.remap[i] = vertexIndex;
+			}
 
-					normal = {attributes.vertices[3 * i.normal_index], attributes.vertices[3 * i.normal_index + 1], attributes.vertices[3 * i.normal_index + 2]};
-				}
-				else
+			result.indexOffset = indexCount;
+			indexCount += result.indices.size();
+		}
+
+		indices.resize(indexCount);
+		ThreadPool::ParallelFor(results.size(), [&](size_t shapeIndex)
+		{
+			const ShapeResult &result = results[shapeIndex];
+			for (size_t i{}; i < result.indices.size(); ++i)
+			{
+				indices[result.indexOffset + i] = result.remap[result.indices[i]];
+			}
+		});
+	}
+
+	void Deduplicate(const std::vector<tinyobj::shape_t> &shapes, std::vector<ObjVertexMap::Key> &uniqueKeys, std::vector<uint32_t> &indices)
+	{
+		if (ParallelShapeDeduplication && shapes.size() > 1)
+		{
+			DeduplicateParallel(shapes, uniqueKeys, indices);
+		}
+		else
+		{
+			DeduplicateSerial(shapes, uniqueKeys, indices);
+		}
+	}
+
+	// Returns false when a triple points outside of the attribute arrays
+	bool BuildVertices(const tinyobj::attrib_t &attributes, const std::vector<ObjVertexMap::Key> &uniqueKeys, std::vector<Vertex> &vertices)
+	{
+		vertices.resize(uniqueKeys.size());
+
+		std::atomic<bool> isValid{true};
+		const size_t chunkCount = (uniqueKeys.size() + VertexChunkSize - 1) / VertexChunkSize;
+		ThreadPool::ParallelFor(chunkCount, [&](size_t chunkIndex)
+		{
+			const size_t begin = chunkIndex * VertexChunkSize;
+			const size_t end = std::min(begin + VertexChunkSize, uniqueKeys.size());
+			for (size_t i = begin; i < end; ++i)
+			{
+				const ObjVertexMap::Key &key = uniqueKeys[i];
+				const bool hasValidPosition = key.vertexIndex >= 0 && 3 * static_cast<size_t>(key.vertexIndex) + 2 < attributes.vertices.size();
+				const bool hasValidNormal = key.normalIndex < 0 || 3 * static_cast<size_t>(key.normalIndex) + 2 < attributes.normals.size();
+				const bool hasValidTexCoord = key.texCoordIndex < 0 || 2 * static_cast<size_t>(key.texCoordIndex) + 1 < attributes.texcoords.size();
+				if (!hasValidPosition || !hasValidNormal || !hasValidTexCoord)
 				{
-					LogInfo("Normal Index Out of bounds!");
+					isValid = false;
+					continue;
 				}
 
-				glm::vec2 texCoord{};
-				if (i.texcoord_index != -1)
+				Vertex &vertex = vertices[i];
+				vertex = {};
+				vertex.pos = {attributes.vertices[3 * key.vertexIndex], attributes.vertices[3 * key.vertexIndex + 1], attributes.vertices[3 * key.vertexIndex + 2]};
+
+				if (key.normalIndex >= 0)
 				{
-					texCoord = {attributes.texcoords[2 * i.texcoord_index + 0], 1.0f - attributes.texcoords[2 * i.texcoord_index + 1]};
+					vertex.normal = {attributes.normals[3 * key.normalIndex], attributes.normals[3 * key.normalIndex + 1], attributes.normals[3 * key.normalIndex + 2]};
 				}
-				else
+
+				if (key.texCoordIndex >= 0)
 				{
-					LogInfo("Texcoord Index Out of bounds!");
+					vertex.texCoord = {attributes.texcoords[2 * key.texCoordIndex + 0], 1.0f - attributes.texcoords[2 * key.texCoordIndex + 1]};
 				}
+			}
+		});
+
+		return isValid;
+	}
 
+	void LoadObj(const std::string &filePath, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices)
+	{
+		const auto path = VulkanContext::GetAssetPath() / filePath;
 
-				const Vertex vertex = {position, normal, {}, texCoord};
+		tinyobj::attrib_t attributes;
+		std::vector<tinyobj::shape_t> shapes;
+		if (!ReadObj(path, attributes, shapes)) return;
 
-				if (!uniqueVertices.contains(vertex))
-				{
-					uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-					vertices.emplace_back(vertex);
-				}
+		const auto deduplicateStart = std::chrono::steady_clock::now();
 
-				indices.push_back(uniqueVertices[vertex]);
-			}
+		std::vector<ObjVertexMap::Key> uniqueKeys;
+		Deduplicate(shapes, uniqueKeys, indices);
+
+		if (!BuildVertices(attributes, uniqueKeys, vertices))
+		{
+			LogError("This is not a supported .Obj file! An index is out of bounds!");
+			vertices.clear();
+			indices.clear();
+			return;
 		}
 
+		const float deduplicateMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - deduplicateStart).count();
 
-		//Caclulate Tangents
-		for (size_t i{}; i < indices.size(); i += 3)
+		if (std::ranges::any_of(uniqueKeys, [](const ObjVertexMap::Key &key) { return key.normalIndex < 0; })) LogInfo("Obj has vertices without a normal: " + filePath);
+		if (std::ranges::any_of(uniqueKeys, [](const ObjVertexMap::Key &key) { return key.texCoordIndex < 0; })) LogInfo("Obj has vertices without texture coordinates: " + filePath);
+
+		TangentGenerator::Generate(vertices, indices);
+
+		if (MeshOptimizer::OptimizeOnImport)
 		{
-			const Vertex &v0 = vertices[indices[i + 0]];
-			const Vertex &v1 = vertices[indices[i + 1]];
-			const Vertex &v2 = vertices[indices[i + 2]];
+			MeshOptimizer::LogResult(MeshOptimizer::Optimize(vertices, indices), filePath);
+		}
+
+		LogInfo("Loaded: " + path.generic_string() + " (" + std::to_string(vertices.size()) + " vertices, deduplicated in " + std::to_string(deduplicateMs) + "ms)");
+	}
 
-			const glm::vec3 edge1 = v1.pos - v0.pos;
-			const glm::vec3 edge2 = v2.pos - v0.pos;
+	void BenchmarkDeduplication(const std::string &filePath)
+	{
+		const auto path = VulkanContext::GetAssetPath() / filePath;
 
-			const glm::vec2 deltaUV1 = v1.texCoord - v0.texCoord;
-			const glm::vec2 deltaUV2 = v2.texCoord - v0.texCoord;
+		tinyobj::attrib_t attributes;
+		std::vector<tinyobj::shape_t> shapes;
+		if (!ReadObj(path, attributes, shapes)) return;
 
-			const float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
+		// The previous path, hashes the floats of every vertex
+		auto start = std::chrono::steady_clock::now();
+		std::vector<Vertex> floatVertices;
+		std::vector<uint32_t> floatIndices;
+		std::unordered_map<Vertex, uint32_t, VertexHasher> uniqueVertices{};
+		for (const tinyobj::shape_t &shape : shapes)
+		{
+			for (const tinyobj::index_t &objIndex : shape.mesh.indices)
+			{
+				Vertex vertex{};
+				vertex.pos = {attributes.vertices[3 * objIndex.vertex_index], attributes.vertices[3 * objIndex.vertex_index + 1], attributes.vertices[3 * objIndex.vertex_index + 2]};
+				if (objIndex.normal_index >= 0) vertex.normal = {attributes.normals[3 * objIndex.normal_index], attributes.normals[3 * objIndex.normal_index + 1], attributes.normals[3 * objIndex.normal_index + 2]};
+				if (objIndex.texcoord_index >= 0) vertex.texCoord = {attributes.texcoords[2 * objIndex.texcoord_index], 1.0f - attributes.texcoords[2 * objIndex.texcoord_index + 1]};
 
-			glm::vec3 tangent;
-			tangent.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-			tangent.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-			tangent.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
+				if (!uniqueVertices.contains(vertex))
+				{
+					uniqueVertices[vertex] = static_cast<uint32_t>(floatVertices.size());
+					floatVertices.emplace_back(vertex);
+				}
 
-			// Normalize the Tangent
-			tangent = glm::normalize(tangent);
+				floatIndices.push_back(uniqueVertices[vertex]);
+			}
+		}
+		const float floatMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		std::vector<ObjVertexMap::Key> serialKeys;
+		std::vector<uint32_t> serialIndices;
+		std::vector<Vertex> serialVertices;
+		DeduplicateSerial(shapes, serialKeys, serialIndices);
+		BuildVertices(attributes, serialKeys, serialVertices);
+		const float serialMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		std::vector<ObjVertexMap::Key> parallelKeys;
+		std::vector<uint32_t> parallelIndices;
+		std::vector<Vertex> parallelVertices;
+		DeduplicateParallel(shapes, parallelKeys, parallelIndices);
+		BuildVertices(attributes, parallelKeys, parallelVertices);
+		const float parallelMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		const bool isSame = serialKeys == parallelKeys && serialIndices == parallelIndices;
+
+		LogInfo("Deduplicated " + std::to_string(serialIndices.size()) + " indices in " + std::to_string(shapes.size()) + " shapes of " + filePath);
+		LogInfo("  Float hash map: " + std::to_string(floatMs) + "ms, " + std::to_string(floatVertices.size()) + " vertices");
+		LogInfo("  Index triples: " + std::to_string(serialMs) + "ms, " + std::to_string(serialVertices.size()) + " vertices");
+		LogInfo("  Index triples per shape (" + std::to_string(ThreadPool::GetThreadCount() + 1) + " threads): " + std::to_string(parallelMs) + "ms, " + (isSame ? "same result" : "DIFFERENT result"));
+	}
 
-			// Add the Tangent to the vertices
-			vertices[indices[i + 0]].tangent += tangent;
-			vertices[indices[i + 1]].tangent += tangent;
-			vertices[indices[i + 2]].tangent += tangent;
+	std::optional<ParsedModel> ParseObj(const std::string &filePath)
+	{
+		if (std::optional<ParsedModel> cached = MeshCache::Load(filePath))
+		{
+			return cached;
 		}
 
+		ParsedModel parsed{};
+		parsed.filePath = filePath;
+		LoadObj(filePath, parsed.vertexStorage, parsed.indexStorage);
+		if (parsed.indexStorage.empty()) return std::nullopt;
+
+		ParsedMesh &mesh = parsed.meshes.emplace_back();
+		mesh.name = filePath;
+		mesh.vertices = parsed.vertexStorage;
+		mesh.indices = parsed.indexStorage;
+		mesh.primitives.push_back({0, static_cast<uint32_t>(parsed.indexStorage.size()), 0});
 
-		LogInfo("Loaded: " + path.generic_string());
+		MeshCache::Save(filePath, parsed);
+		return parsed;
 	}
 }
@@ -1,6 +1,9 @@
 #pragma once
 #include <cstdint>
 
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -9,12 +12,93 @@
 #include <fastgltf/types.hpp>
 
 #include "Mesh.h"
+#include "Vertex.h"
+#include "Core/Image/ImageLoader.h"
 
 
 
+class MappedFile;
 class Scene;
 struct Vertex;
 
+// CPU side result of a model load, materials are resolved when the meshes get created
+struct ParsedPrimitive
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	// Nothing when the primitive has no material, it gets the white default material of its file
+	std::optional<size_t> materialIndex;
+};
+
+// The path is relative to the asset folder, empty means the material falls back to white
+// Images embedded in a .glb are byteLength bytes at byteOffset of that file, they get decoded straight out of a mapping of it
+struct ParsedImage
+{
+	std::string path;
+	uint64_t byteOffset{};
+	uint64_t byteLength{};
+
+	[[nodiscard]] bool IsEmpty() const { return path.empty(); }
+	[[nodiscard]] bool IsEmbedded() const { return byteLength > 0; }
+};
+
+// Encoded bytes of a material image, read on the worker that parsed the model
+// PNG/JPEG get decoded right there, .ktx data is only mapped and gets copied into the staging ring on upload
+struct ParsedImageData
+{
+	ParsedImage image;
+	std::shared_ptr<const MappedFile> file;
+	std::span<const uint8_t> encoded;
+	bool isKtx{};
+	std::optional<stbi::DecodedImage> decoded;
+	float decodeMs{};
+};
+
+struct ParsedMaterial
+{
+	std::string name;
+	ParsedImage baseColorTexture;
+	ParsedImage normalTexture;
+	ParsedImage metallicRoughnessTexture;
+};
+
+struct ParsedMesh
+{
+	std::string name;
+	std::span<const Vertex> vertices;
+	std::span<const uint32_t> indices;
+	std::vector<ParsedPrimitive> primitives;
+	glm::mat4 transform{1};
+
+	// Only filled for VertexFormat::Packed, see VertexQuantizer
+	std::span<const PackedVertex> packedVertices;
+	glm::mat4 dequantizeMatrix{1};
+};
+
+// The mesh spans point into the storage vectors or into the mapped mesh cache, so this is move only
+struct ParsedModel
+{
+	ParsedModel() = default;
+	~ParsedModel() = default;
+	ParsedModel(const ParsedModel&) = delete;
+	ParsedModel& operator=(const ParsedModel&) = delete;
+	ParsedModel(ParsedModel&&) noexcept = default;
+	ParsedModel& operator=(ParsedModel&&) noexcept = default;
+
+	std::string filePath;
+	std::vector<ParsedMaterial> materials;
+	std::vector<ParsedMesh> meshes;
+	VertexFormat vertexFormat{VertexFormat::Full};
+
+	std::vector<Vertex> vertexStorage;
+	std::vector<uint32_t> indexStorage;
+	std::vector<PackedVertex> packedVertexStorage;
+	std::shared_ptr<const MappedFile> mappedCache;
+
+	// Filled by GLTFLoader::DecodeImages, files that are uploaded as is (.ktx, baked) have no entry
+	std::vector<ParsedImageData> images;
+};
+
 // namespace ModelMath
 // {
 //
@@ -22,17 +106,46 @@ struct Vertex;
 
 namespace ObjLoader
 {
+	// Deduplicate every shape on the ThreadPool and merge afterwards, turn off to compare against the serial path
+	inline bool ParallelShapeDeduplication = true;
+
+	// Vertices are unique per (position, normal, texcoord) index triple of the obj
 	void LoadObj(const std::string& filePath, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+	// One mesh with one primitive, goes through the mesh cache
+	std::optional<ParsedModel> ParseObj(const std::string& filePath);
+
+	// Logs the time of the old float hash map, the serial and the per shape index triple deduplication
+	void BenchmarkDeduplication(const std::string& filePath);
 }
 
 namespace GLTFLoader
 {
-    void LoadGLTF(std::string_view filePath, Scene* scene, VulkanContext *vulkanContext);
+	// Decode primitives on the ThreadPool, turn off to compare against the serial path
+	inline bool ParallelPrimitiveDecode = true;
+	// Decode the material images on the ThreadPool, turn off to compare against the serial path
+	inline bool ParallelImageDecode = true;
+
+    void LoadGLTF(std::string_view filePath, Scene* scene, VulkanContext *vulkanContext, VertexFormat vertexFormat = VertexFormat::Full);
+
+	// Parse does not touch Vulkan and can run on a worker, Create has to run on the main thread
+	// Parse checks the mesh cache first and writes it when it was missing or stale
+	std::optional<ParsedModel> ParseGLTF(std::string_view filePath);
+	// Parses the model without the mesh cache with the serial and the parallel primitive decode, logs the best time of each and if the results match
+	void BenchmarkPrimitiveDecode(const std::string& filePath, uint32_t runCount = 5);
+	// Maps the material images and decodes the PNG/JPEG ones on the ThreadPool, call it on the worker that parsed the model
+	// so CreateGLTF only has to copy pixels into the staging ring
+	void DecodeImages(ParsedModel& model);
+	// Returns the meshes it added to the scene
+	std::vector<Mesh*> CreateGLTF(const ParsedModel& parsed, Scene* scene, VulkanContext* vulkanContext);
 	//inline static std::vector<std::string> m_CreatedMaterialNames;
 
     std::optional<fastgltf::Asset> Load(std::string_view filePath);
-    void CreateMaterials(const fastgltf::Asset& gltf, VulkanContext* vulkanContext,std::vector<std::string>& createdMaterialNames);
-	void LoadImage(const fastgltf::Image& image,std::vector<std::variant<std::filesystem::path, ImageInMemory>>& images);
+	// filePath is the model relative to the asset folder, embedded images point back into it
+	std::vector<ParsedMaterial> ParseMaterials(const fastgltf::Asset& gltf, std::string_view filePath);
+	// Images without data in images get loaded from their file on the main thread
+    void CreateMaterials(const std::vector<ParsedMaterial>& materials, VulkanContext* vulkanContext,std::vector<std::string>& createdMaterialNames, VertexFormat vertexFormat = VertexFormat::Full,
+                         std::span<const ParsedImageData> images = {});
 	glm::mat4 ComputeTransformMatrix(const fastgltf::TRS& trs);
 
     VkFilter GetVkFilter(fastgltf::Filter filter);
@@ -0,0 +1,82 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+// Open addressing hash map from an obj (position, normal, texcoord) index triple to a vertex index
+// The key is made of the integer indices tinyobj hands out, so no floats get hashed or compared
+// Never grows, Reserve has to be called with an upper bound of the unique keys (the index count works)
+class ObjVertexMap final
+{
+public:
+	struct Key
+	{
+		int vertexIndex;
+		int normalIndex;
+		int texCoordIndex;
+
+		bool operator==(const Key& other) const = default;
+	};
+
+	ObjVertexMap() = default;
+	~ObjVertexMap() = default;
+	ObjVertexMap(const ObjVertexMap&) = delete;
+	ObjVertexMap& operator=(const ObjVertexMap&) = delete;
+	ObjVertexMap(ObjVertexMap&&) = default;
+	ObjVertexMap& operator=(ObjVertexMap&&) = default;
+
+	// Keeps the load factor at or below 0.75 when all keys are unique
+	void Reserve(size_t maxKeyCount)
+	{
+		const size_t slotCount = std::bit_ceil(std::max<size_t>(16, maxKeyCount + maxKeyCount / 3 + 1));
+		m_Slots.assign(slotCount, Slot{{}, EmptySlot});
+		m_Mask = slotCount - 1;
+	}
+
+	// Returns the index stored for the key and whether it was just inserted with newIndex
+	std::pair<uint32_t, bool> FindOrInsert(const Key& key, uint32_t newIndex)
+	{
+		for (size_t slotIndex = Hash(key) & m_Mask;; slotIndex = (slotIndex + 1) & m_Mask)
+		{
+			Slot& slot = m_Slots[slotIndex];
+			if (slot.index == EmptySlot)
+			{
+				slot = {key, newIndex};
+				return {newIndex, true};
+			}
+
+			if (slot.key == key) return {slot.index, false};
+		}
+	}
+
+private:
+	static constexpr uint32_t EmptySlot = UINT32_MAX;
+
+	struct Slot
+	{
+		Key key;
+		uint32_t index;
+	};
+
+	static size_t Hash(const Key& key)
+	{
+		// Missing indices are -1, the +1 keeps them from all landing on the same value
+		uint64_t hash = static_cast<uint32_t>(key.vertexIndex + 1);
+		hash = hash * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(key.normalIndex + 1);
+		hash = hash * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(key.texCoordIndex + 1);
+
+		// Murmur3 finalizer so the low bits depend on every input bit
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 33;
+		hash *= 0xC4CEB9FE1A85EC53ull;
+		hash ^= hash >> 33;
+		return static_cast<size_t>(hash);
+	}
+
+	std::vector<Slot> m_Slots{};
+	size_t m_Mask{};
+};
@@ -0,0 +1,502 @@
+#include "TangentGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+
+#include "Core/Logger.h"
+#include "Patterns/ThreadPool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TANGENT_GENERATOR_SSE 1
+#include <emmintrin.h>
+#else
+#define TANGENT_GENERATOR_SSE 0
+#endif
+
+
+namespace TangentGenerator
+{
+	// Triangles are processed in blocks so the corner buffer stays small on big meshes
+	constexpr size_t TriangleBlockSize = 65536;
+	constexpr size_t TriangleChunkSize = 4096;
+	constexpr size_t VertexChunkSize = 16384;
+
+	// Below this the UV mapping of a triangle is degenerate and it does not add a tangent
+	constexpr float DegenerateEpsilon = 1e-20f;
+	constexpr float LengthEpsilon = 1e-20f;
+
+	// Weighted tangent and bitangent one triangle corner adds to its vertex
+	struct Corner
+	{
+		glm::vec3 tangent;
+		glm::vec3 bitangent;
+		float weight;
+	};
+
+	// A frame whose corners cancel out to less than this (relative to the summed weights) is ambiguous, mirrored UV seams for example
+	// Those get a fixed fallback instead of whatever the rounding noise says
+	constexpr float CancellationThreshold = 1e-3f;
+
+	// Polynomial acos (Abramowitz and Stegun 4.4.46), max error of about 2e-8 radians so it matches std::acos at float precision
+	constexpr float AcosCoefficients[8]{1.5707963050f, -0.2145988016f, 0.0889789874f, -0.0501743046f, 0.0308918810f, -0.0170881256f, 0.0066700901f, -0.0012624911f};
+
+	float FastAcos(float x)
+	{
+		const float absX = std::min(std::abs(x), 1.0f);
+
+		float polynomial = AcosCoefficients[7];
+		for (int i = 6; i >= 0; --i) polynomial = polynomial * absX + AcosCoefficients[i];
+
+		const float result = std::sqrt(1.0f - absX) * polynomial;
+		return x < 0.0f ? glm::pi<float>() - result : result;
+	}
+
+	glm::vec3 ProjectAndNormalize(const glm::vec3& direction, const glm::vec3& normal)
+	{
+		glm::vec3 projected = direction;
+
+		const float normalLengthSquared = glm::dot(normal, normal);
+		if (normalLengthSquared > 0.0f) projected -= normal * (glm::dot(normal, direction) / normalLengthSquared);
+
+		const float lengthSquared = glm::dot(projected, projected);
+		return lengthSquared > LengthEpsilon ? projected / std::sqrt(lengthSquared) : glm::vec3{0.0f};
+	}
+
+	template <typename AcosFunc>
+	void ComputeCorners(const Vertex* triangle[3], Corner* corners, AcosFunc acos)
+	{
+		const glm::vec3 edge1 = triangle[1]->pos - triangle[0]->pos;
+		const glm::vec3 edge2 = triangle[2]->pos - triangle[0]->pos;
+		const glm::vec2 deltaUV1 = triangle[1]->texCoord - triangle[0]->texCoord;
+		const glm::vec2 deltaUV2 = triangle[2]->texCoord - triangle[0]->texCoord;
+
+		const float determinant = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+		if (std::abs(determinant) < DegenerateEpsilon)
+		{
+			for (int corner{}; corner < 3; ++corner) corners[corner] = {};
+			return;
+		}
+
+		// Only the direction matters, so the sign of the determinant is enough
+		const float sign = determinant > 0.0f ? 1.0f : -1.0f;
+		const glm::vec3 tangent = (edge1 * deltaUV2.y - edge2 * deltaUV1.y) * sign;
+		const glm::vec3 bitangent = (edge2 * deltaUV1.x - edge1 * deltaUV2.x) * sign;
+
+		for (int corner{}; corner < 3; ++corner)
+		{
+			const Vertex& vertex = *triangle[corner];
+			const glm::vec3 toNext = triangle[(corner + 1) % 3]->pos - vertex.pos;
+			const glm::vec3 toPrevious = triangle[(corner + 2) % 3]->pos - vertex.pos;
+
+			const float lengthProduct = std::sqrt(glm::dot(toNext, toNext) * glm::dot(toPrevious, toPrevious));
+			const float weight = lengthProduct > LengthEpsilon ? acos(std::clamp(glm::dot(toNext, toPrevious) / lengthProduct, -1.0f, 1.0f)) : 0.0f;
+
+			corners[corner].tangent = ProjectAndNormalize(tangent, vertex.normal) * weight;
+			corners[corner].bitangent = ProjectAndNormalize(bitangent, vertex.normal) * weight;
+			corners[corner].weight = weight;
+		}
+	}
+
+	void ComputeCornersScalar(std::span<const Vertex> vertices, std::span<const uint32_t> indices, uint32_t baseVertex, size_t firstTriangle, size_t triangleCount, Corner* corners)
+	{
+		for (size_t triangle = firstTriangle; triangle < firstTriangle + triangleCount; ++triangle)
+		{
+			const Vertex* triangleVertices[3]{&vertices[indices[triangle * 3] - baseVertex], &vertices[indices[triangle * 3 + 1] - baseVertex], &vertices[indices[triangle * 3 + 2] - baseVertex]};
+			ComputeCorners(triangleVertices, corners + (triangle - firstTriangle) * 3, FastAcos);
+		}
+	}
+
+#if TANGENT_GENERATOR_SSE
+	// 4 triangles at once, one per lane
+	struct Float3x4
+	{
+		__m128 x, y, z;
+	};
+
+	Float3x4 operator+(const Float3x4& a, const Float3x4& b) { return {_mm_add_ps(a.x, b.x), _mm_add_ps(a.y, b.y), _mm_add_ps(a.z, b.z)}; }
+	Float3x4 operator-(const Float3x4& a, const Float3x4& b) { return {_mm_sub_ps(a.x, b.x), _mm_sub_ps(a.y, b.y), _mm_sub_ps(a.z, b.z)}; }
+	Float3x4 operator*(const Float3x4& a, __m128 s) { return {_mm_mul_ps(a.x, s), _mm_mul_ps(a.y, s), _mm_mul_ps(a.z, s)}; }
+
+	__m128 Dot(const Float3x4& a, const Float3x4& b)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+	}
+
+	__m128 Select(__m128 mask, __m128 a, __m128 b)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+
+	__m128 Abs(__m128 value)
+	{
+		return _mm_andnot_ps(_mm_set1_ps(-0.0f), value);
+	}
+
+	// Same polynomial as FastAcos
+	__m128 FastAcos(__m128 x)
+	{
+		const __m128 absX = _mm_min_ps(Abs(x), _mm_set1_ps(1.0f));
+
+		__m128 polynomial = _mm_set1_ps(AcosCoefficients[7]);
+		for (int i = 6; i >= 0; --i) polynomial = _mm_add_ps(_mm_mul_ps(polynomial, absX), _mm_set1_ps(AcosCoefficients[i]));
+
+		const __m128 result = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), absX)), polynomial);
+		return Select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(glm::pi<float>()), result), result);
+	}
+
+	Float3x4 ProjectAndNormalize(const Float3x4& direction, const Float3x4& normal)
+	{
+		const __m128 zero = _mm_setzero_ps();
+
+		// Lanes that get masked out can divide by zero, the select throws those results away
+		const __m128 normalLengthSquared = Dot(normal, normal);
+		const __m128 scale = Select(_mm_cmpgt_ps(normalLengthSquared, zero), _mm_div_ps(Dot(normal, direction), normalLengthSquared), zero);
+		const Float3x4 projected = direction - normal * scale;
+
+		const __m128 lengthSquared = Dot(projected, projected);
+		const __m128 inverseLength = Select(_mm_cmpgt_ps(lengthSquared, _mm_set1_ps(LengthEpsilon)), _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSquared)), zero);
+		return projected * inverseLength;
+	}
+
+	// Same math as ComputeCorners, triangleCount has to be a multiple of 4
+	void ComputeCornersSimd(std::span<const Vertex> vertices, std::span<const uint32_t> indices, uint32_t baseVertex, size_t firstTriangle, size_t triangleCount, Corner* corners)
+	{
+		enum Component { PositionX, PositionY, PositionZ, U, V, NormalX, NormalY, NormalZ, ComponentCount };
+
+		for (size_t group{}; group < triangleCount; group += 4)
+		{
+			// AoS -> SoA, [corner][component][lane]
+			alignas(16) float lanes[3][ComponentCount][4];
+			for (size_t lane{}; lane < 4; ++lane)
+			{
+				const size_t triangle = firstTriangle + group + lane;
+				for (size_t corner{}; corner < 3; ++corner)
+				{
+					const Vertex& vertex = vertices[indices[triangle * 3 + corner] - baseVertex];
+					lanes[corner][PositionX][lane] = vertex.pos.x;
+					lanes[corner][PositionY][lane] = vertex.pos.y;
+					lanes[corner][PositionZ][lane] = vertex.pos.z;
+					lanes[corner][U][lane] = vertex.texCoord.x;
+					lanes[corner][V][lane] = vertex.texCoord.y;
+					lanes[corner][NormalX][lane] = vertex.normal.x;
+					lanes[corner][NormalY][lane] = vertex.normal.y;
+					lanes[corner][NormalZ][lane] = vertex.normal.z;
+				}
+			}
+
+			Float3x4 positions[3];
+			Float3x4 normals[3];
+			__m128 us[3];
+			__m128 vs[3];
+			for (size_t corner{}; corner < 3; ++corner)
+			{
+				positions[corner] = {_mm_load_ps(lanes[corner][PositionX]), _mm_load_ps(lanes[corner][PositionY]), _mm_load_ps(lanes[corner][PositionZ])};
+				normals[corner] = {_mm_load_ps(lanes[corner][NormalX]), _mm_load_ps(lanes[corner][NormalY]), _mm_load_ps(lanes[corner][NormalZ])};
+				us[corner] = _mm_load_ps(lanes[corner][U]);
+				vs[corner] = _mm_load_ps(lanes[corner][V]);
+			}
+
+			const Float3x4 edge1 = positions[1] - positions[0];
+			const Float3x4 edge2 = positions[2] - positions[0];
+			const __m128 deltaU1 = _mm_sub_ps(us[1], us[0]);
+			const __m128 deltaV1 = _mm_sub_ps(vs[1], vs[0]);
+			const __m128 deltaU2 = _mm_sub_ps(us[2], us[0]);
+			const __m128 deltaV2 = _mm_sub_ps(vs[2], vs[0]);
+
+			const __m128 determinant = _mm_sub_ps(_mm_mul_ps(deltaU1, deltaV2), _mm_mul_ps(deltaU2, deltaV1));
+			const __m128 isValid = _mm_cmpge_ps(Abs(determinant), _mm_set1_ps(DegenerateEpsilon));
+			const __m128 sign = Select(_mm_cmpgt_ps(determinant, _mm_setzero_ps()), _mm_set1_ps(1.0f), _mm_set1_ps(-1.0f));
+
+			const Float3x4 tangent = (edge1 * deltaV2 - edge2 * deltaV1) * sign;
+			const Float3x4 bitangent = (edge2 * deltaU1 - edge1 * deltaU2) * sign;
+
+			for (size_t corner{}; corner < 3; ++corner)
+			{
+				const Float3x4 toNext = positions[(corner + 1) % 3] - positions[corner];
+				const Float3x4 toPrevious = positions[(corner + 2) % 3] - positions[corner];
+
+				const __m128 lengthProduct = _mm_sqrt_ps(_mm_mul_ps(Dot(toNext, toNext), Dot(toPrevious, toPrevious)));
+				const __m128 hasAngle = _mm_and_ps(_mm_cmpgt_ps(lengthProduct, _mm_set1_ps(LengthEpsilon)), isValid);
+				const __m128 cosine = _mm_max_ps(_mm_min_ps(_mm_div_ps(Dot(toNext, toPrevious), lengthProduct), _mm_set1_ps(1.0f)), _mm_set1_ps(-1.0f));
+				const __m128 weight = Select(hasAngle, FastAcos(cosine), _mm_setzero_ps());
+
+				const Float3x4 cornerTangent = ProjectAndNormalize(tangent, normals[corner]) * weight;
+				const Float3x4 cornerBitangent = ProjectAndNormalize(bitangent, normals[corner]) * weight;
+
+				// SoA -> AoS
+				alignas(16) float result[7][4];
+				_mm_store_ps(result[0], cornerTangent.x);
+				_mm_store_ps(result[1], cornerTangent.y);
+				_mm_store_ps(result[2], cornerTangent.z);
+				_mm_store_ps(result[3], cornerBitangent.x);
+				_mm_store_ps(result[4], cornerBitangent.y);
+				_mm_store_ps(result[5], cornerBitangent.z);
+				_mm_store_ps(result[6], weight);
+				for (size_t lane{}; lane < 4; ++lane)
+				{
+					Corner& output = corners[(group + lane) * 3 + corner];
+					output.tangent = {result[0][lane], result[1][lane], result[2][lane]};
+					output.bitangent = {result[3][lane], result[4][lane], result[5][lane]};
+					output.weight = result[6][lane];
+				}
+			}
+		}
+	}
+#endif
+
+	// Gram-Schmidt against the normal, w is the handedness
+	// While accumulating tangent.w holds the summed corner weights
+	void Orthonormalize(Vertex& vertex, const glm::vec3& bitangent)
+	{
+		const float normalLength = glm::length(vertex.normal);
+		const glm::vec3 normal = normalLength > 0.0f ? vertex.normal / normalLength : glm::vec3{0.0f, 0.0f, 1.0f};
+
+		const glm::vec3 accumulated{vertex.tangent};
+		const float minimumLength = std::max(vertex.tangent.w * CancellationThreshold, 1e-6f);
+
+		glm::vec3 tangent = accumulated - normal * glm::dot(normal, accumulated);
+		const float tangentLength = glm::length(tangent);
+
+		if (tangentLength > minimumLength)
+		{
+			tangent /= tangentLength;
+		}
+		else
+		{
+			// No usable UVs on any triangle of this vertex, any vector perpendicular to the normal works
+			const glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3{1.0f, 0.0f, 0.0f} : glm::vec3{0.0f, 1.0f, 0.0f};
+			tangent = glm::normalize(axis - normal * glm::dot(normal, axis));
+		}
+
+		const float handedness = glm::dot(glm::cross(normal, tangent), bitangent) < -minimumLength ? -1.0f : 1.0f;
+		vertex.tangent = glm::vec4{tangent, handedness};
+	}
+
+	bool HasValidIndices(size_t vertexCount, std::span<const uint32_t> indices, uint32_t baseVertex)
+	{
+		return std::ranges::all_of(indices, [vertexCount, baseVertex](uint32_t index) { return index >= baseVertex && index - baseVertex < vertexCount; });
+	}
+
+	void Generate(std::span<Vertex> vertices, std::span<const uint32_t> indices, uint32_t baseVertex)
+	{
+		if (vertices.empty()) return;
+
+		if (!HasValidIndices(vertices.size(), indices, baseVertex))
+		{
+			LogWarning("Skipped tangent generation, an index is outside of the vertex range");
+			return;
+		}
+
+		std::vector<glm::vec3> bitangents(vertices.size());
+		for (Vertex& vertex : vertices)
+		{
+			vertex.tangent = glm::vec4{0.0f};
+		}
+
+		const size_t triangleCount = indices.size() / 3;
+		const size_t vertexChunkCount = (vertices.size() + VertexChunkSize - 1) / VertexChunkSize;
+
+		// Every vertex range gets accumulated by one task, so no two tasks write the same vertex
+		const size_t rangeCount = std::clamp<size_t>(vertexChunkCount, 1, ThreadPool::GetThreadCount() + 1);
+		const size_t rangeSize = (vertices.size() + rangeCount - 1) / rangeCount;
+
+		std::vector<Corner> corners(std::min(triangleCount, TriangleBlockSize) * 3);
+		std::vector<uint32_t> rangeCornerStarts(rangeCount + 1);
+		std::vector<uint32_t> rangeCorners(corners.size());
+		for (size_t blockStart{}; blockStart < triangleCount; blockStart += TriangleBlockSize)
+		{
+			const size_t blockSize = std::min(TriangleBlockSize, triangleCount - blockStart);
+
+			// Triangle kernel, every chunk writes its own corners
+			const size_t chunkCount = (blockSize + TriangleChunkSize - 1) / TriangleChunkSize;
+			ThreadPool::ParallelFor(chunkCount, [&](size_t chunkIndex)
+			{
+				const size_t chunkStart = chunkIndex * TriangleChunkSize;
+				const size_t chunkSize = std::min(TriangleChunkSize, blockSize - chunkStart);
+				Corner* chunkCorners = corners.data() + chunkStart * 3;
+
+				size_t simdCount{};
+#if TANGENT_GENERATOR_SSE
+				if (UseSimd)
+				{
+					simdCount = chunkSize & ~size_t{3};
+					ComputeCornersSimd(vertices, indices, baseVertex, blockStart + chunkStart, simdCount, chunkCorners);
+				}
+#endif
+				ComputeCornersScalar(vertices, indices, baseVertex, blockStart + chunkStart + simdCount, chunkSize - simdCount, chunkCorners + simdCount * 3);
+			});
+
+			// Bucket the corners by the vertex range they land in, a counting sort keeps them in order so the sums do not depend on the thread count
+			const std::span<const uint32_t> blockIndices = indices.subspan(blockStart * 3, blockSize * 3);
+			std::ranges::fill(rangeCornerStarts, 0u);
+			for (const uint32_t index : blockIndices)
+			{
+				++rangeCornerStarts[(index - baseVertex) / rangeSize + 1];
+			}
+			for (size_t rangeIndex{}; rangeIndex < rangeCount; ++rangeIndex)
+			{
+				rangeCornerStarts[rangeIndex + 1] += rangeCornerStarts[rangeIndex];
+			}
+
+			std::vector<uint32_t> rangeFill(rangeCornerStarts.begin(), rangeCornerStarts.end() - 1);
+			for (size_t corner{}; corner < blockIndices.size(); ++corner)
+			{
+				rangeCorners[rangeFill[(blockIndices[corner] - baseVertex) / rangeSize]++] = static_cast<uint32_t>(corner);
+			}
+
+			// Accumulate the corners into their vertices, every range only walks its own bucket
+			ThreadPool::ParallelFor(rangeCount, [&](size_t rangeIndex)
+			{
+				for (uint32_t bucketIndex = rangeCornerStarts[rangeIndex]; bucketIndex < rangeCornerStarts[rangeIndex + 1]; ++bucketIndex)
+				{
+					const uint32_t corner = rangeCorners[bucketIndex];
+					const size_t vertexIndex = blockIndices[corner] - baseVertex;
+
+					vertices[vertexIndex].tangent += glm::vec4{corners[corner].tangent, corners[corner].weight};
+					bitangents[vertexIndex] += corners[corner].bitangent;
+				}
+			});
+		}
+
+		ThreadPool::ParallelFor(vertexChunkCount, [&](size_t chunkIndex)
+		{
+			const size_t begin = chunkIndex * VertexChunkSize;
+			const size_t end = std::min(begin + VertexChunkSize, vertices.size());
+			for (size_t i = begin; i < end; ++i)
+			{
+				Orthonormalize(vertices[i], bitangents[i]);
+			}
+		});
+	}
+
+	// Textbook version that shares no code with Generate: per triangle tangent/bitangent from the UV derivatives,
+	// projected into the tangent plane of every corner and weighted by the corner angle, then Gram-Schmidt
+	void GenerateReference(std::span<Vertex> vertices, std::span<const uint32_t> indices, uint32_t baseVertex)
+	{
+		if (vertices.empty()) return;
+		for (const uint32_t index : indices)
+		{
+			if (index < baseVertex || index - baseVertex >= vertices.size()) return;
+		}
+
+		std::vector<glm::vec3> tangents(vertices.size(), glm::vec3{0.0f});
+		std::vector<glm::vec3> bitangents(vertices.size(), glm::vec3{0.0f});
+		std::vector<float> weights(vertices.size(), 0.0f);
+
+		for (size_t i{}; i + 2 < indices.size(); i += 3)
+		{
+			const uint32_t triangle[3]{indices[i] - baseVertex, indices[i + 1] - baseVertex, indices[i + 2] - baseVertex};
+			const Vertex& v0 = vertices[triangle[0]];
+			const Vertex& v1 = vertices[triangle[1]];
+			const Vertex& v2 = vertices[triangle[2]];
+
+			const float s1 = v1.texCoord.x - v0.texCoord.x;
+			const float t1 = v1.texCoord.y - v0.texCoord.y;
+			const float s2 = v2.texCoord.x - v0.texCoord.x;
+			const float t2 = v2.texCoord.y - v0.texCoord.y;
+			const float determinant = s1 * t2 - s2 * t1;
+			if (determinant == 0.0f) continue;
+
+			const float r = 1.0f / determinant;
+			const glm::vec3 q1 = v1.pos - v0.pos;
+			const glm::vec3 q2 = v2.pos - v0.pos;
+			const glm::vec3 sDirection = (q1 * t2 - q2 * t1) * r;
+			const glm::vec3 tDirection = (q2 * s1 - q1 * s2) * r;
+
+			for (size_t corner{}; corner < 3; ++corner)
+			{
+				const Vertex& vertex = vertices[triangle[corner]];
+				const glm::vec3 a = vertices[triangle[(corner + 1) % 3]].pos - vertex.pos;
+				const glm::vec3 b = vertices[triangle[(corner + 2) % 3]].pos - vertex.pos;
+				if (glm::length(a) == 0.0f || glm::length(b) == 0.0f) continue;
+
+				const float angle = std::acos(std::clamp(glm::dot(glm::normalize(a), glm::normalize(b)), -1.0f, 1.0f));
+				const glm::vec3 n = glm::normalize(vertex.normal);
+				const glm::vec3 sPlane = sDirection - n * glm::dot(n, sDirection);
+				const glm::vec3 tPlane = tDirection - n * glm::dot(n, tDirection);
+
+				if (glm::length(sPlane) > 0.0f) tangents[triangle[corner]] += glm::normalize(sPlane) * angle;
+				if (glm::length(tPlane) > 0.0f) bitangents[triangle[corner]] += glm::normalize(tPlane) * angle;
+				weights[triangle[corner]] += angle;
+			}
+		}
+
+		// A vertex whose corners cancel out has no well defined tangent, it gets a zero tangent so the comparison skips it
+		for (size_t i{}; i < vertices.size(); ++i)
+		{
+			const glm::vec3 n = glm::normalize(vertices[i].normal);
+			const glm::vec3 t = tangents[i] - n * glm::dot(n, tangents[i]);
+			if (glm::length(t) <= weights[i] * 1e-2f || weights[i] == 0.0f)
+			{
+				vertices[i].tangent = glm::vec4{0.0f};
+				continue;
+			}
+
+			const glm::vec3 tangent = glm::normalize(t);
+			vertices[i].tangent = glm::vec4{tangent, glm::dot(glm::cross(n, tangent), bitangents[i]) < 0.0f ? -1.0f : 1.0f};
+		}
+	}
+
+	void Benchmark(const ParsedModel& model)
+	{
+		float simdMs{};
+		float scalarMs{};
+		float referenceMs{};
+		float maxAngleError{};
+		size_t handednessMismatches{};
+		size_t ambiguousCount{};
+		size_t vertexCount{};
+		size_t triangleCount{};
+
+		const bool useSimd = UseSimd;
+		for (const ParsedMesh& mesh : model.meshes)
+		{
+			std::vector<Vertex> simdVertices(mesh.vertices.begin(), mesh.vertices.end());
+			std::vector<Vertex> scalarVertices = simdVertices;
+			std::vector<Vertex> referenceVertices = simdVertices;
+
+			auto start = std::chrono::steady_clock::now();
+			UseSimd = true;
+			Generate(simdVertices, mesh.indices);
+			simdMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			start = std::chrono::steady_clock::now();
+			UseSimd = false;
+			Generate(scalarVertices, mesh.indices);
+			scalarMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			start = std::chrono::steady_clock::now();
+			GenerateReference(referenceVertices, mesh.indices);
+			referenceMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			for (size_t i{}; i < simdVertices.size(); ++i)
+			{
+				if (referenceVertices[i].tangent.w == 0.0f)
+				{
+					++ambiguousCount;
+					continue;
+				}
+
+				const float cosine = std::clamp(glm::dot(glm::vec3{simdVertices[i].tangent}, glm::vec3{referenceVertices[i].tangent}), -1.0f, 1.0f);
+				maxAngleError = std::max(maxAngleError, glm::degrees(std::acos(cosine)));
+
+				if (simdVertices[i].tangent.w != referenceVertices[i].tangent.w) ++handednessMismatches;
+			}
+
+			vertexCount += mesh.vertices.size();
+			triangleCount += mesh.indices.size() / 3;
+		}
+		UseSimd = useSimd;
+
+		const std::string simdName = TANGENT_GENERATOR_SSE ? "SSE" : "SSE (not available, scalar)";
+		LogInfo("Tangents for " + std::to_string(vertexCount) + " vertices / " + std::to_string(triangleCount) + " triangles of " + model.filePath);
+		LogInfo("  " + simdName + ": " + std::to_string(simdMs) + "ms, scalar: " + std::to_string(scalarMs) + "ms, reference: " + std::to_string(referenceMs) + "ms");
+		LogInfo("  Max angle to the reference: " + std::to_string(maxAngleError) + " degrees, handedness mismatches: " + std::to_string(handednessMismatches) +
+		        ", skipped " + std::to_string(ambiguousCount) + " vertices without a well defined reference tangent");
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <span>
+
+#include "ModelLoader.h"
+#include "Vertex.h"
+
+
+// Per vertex tangents for normal mapping, used by every model loader
+// Every triangle corner adds its tangent projected onto the vertex normal, weighted by the corner angle (like MikkTSpace, without splitting vertices)
+// Afterwards the tangents get Gram-Schmidt orthonormalized against the normal and w gets the handedness of the UV mapping
+namespace TangentGenerator
+{
+	// Turn off to compare the SSE triangle kernel against the scalar one
+	inline bool UseSimd = true;
+
+	// Indices are relative to baseVertex, so a primitive can pass only its own vertex range
+	// Normals and texture coordinates have to be filled in, the tangents get overwritten
+	void Generate(std::span<Vertex> vertices, std::span<const uint32_t> indices, uint32_t baseVertex = 0);
+
+	// Independent serial implementation that shares no code with Generate, only used to validate it
+	// Vertices without a well defined tangent (no usable UVs, corners that cancel out) get a zero tangent
+	void GenerateReference(std::span<Vertex> vertices, std::span<const uint32_t> indices, uint32_t baseVertex = 0);
+
+	// Logs the time of the SSE, scalar and reference paths and the worst difference to the reference
+	void Benchmark(const ParsedModel& model);
+}
@@ -1,14 +1,23 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <vulkan/vulkan.h>
 #include <glm/glm.hpp>
 
+// Vertex layout of a mesh, every format lives in its own vertex binding of the geometry pool
+enum class VertexFormat : uint8_t
+{
+	Full,
+	Packed,
+};
+
 struct Vertex 
 {
     glm::vec3 pos;
     glm::vec3 normal;
-    glm::vec3 tangent;
+    // w is the handedness, the bitangent is cross(normal, tangent) * w
+    glm::vec4 tangent;
 	glm::vec2 texCoord;
 
 	bool operator==(const Vertex& other) const
@@ -22,7 +31,7 @@ struct Vertex
 		bindingDescription.binding = 0;
 		bindingDescription.stride = sizeof(Vertex);
 
-		//VK_VERTEX_INPUT_RATE_INSTANCE for instanced rendering
+		//Instanced draws read their transform from the instance buffer through gl_InstanceIndex, there is no instance rate binding
 		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
 		return bindingDescription;
@@ -39,16 +48,16 @@ struct Vertex
 		attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
 		attributeDescriptions[0].offset = offsetof(Vertex, pos);
 
-		//color
+		//normal
 		attributeDescriptions[1].binding = 0;
 		attributeDescriptions[1].location = 1;
 		attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
 		attributeDescriptions[1].offset = offsetof(Vertex, normal);
 
-	    //texture coordinates
+	    //tangent + handedness
 	    attributeDescriptions[2].binding = 0;
 	    attributeDescriptions[2].location = 2;
-	    attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
+	    attributeDescriptions[2].format = VK_FORMAT_R32G32B32A32_SFLOAT;
 	    attributeDescriptions[2].offset = offsetof(Vertex, tangent);
 
 		//texture coordinates
@@ -62,6 +71,58 @@ struct Vertex
 	}
 };
 
+// Quantized vertex, 20 bytes instead of 48
+// pos is 16 bit snorm inside the mesh bounds, the dequantize matrix of the mesh maps it back to model space
+// pos.w holds the tangent handedness, normal and tangent are octahedral encoded and texCoord is a half float
+struct PackedVertex
+{
+	int16_t pos[4];
+	int16_t normal[2];
+	int16_t tangent[2];
+	uint16_t texCoord[2];
+
+	static VkVertexInputBindingDescription GetBindingDescription()
+	{
+		VkVertexInputBindingDescription bindingDescription{};
+		bindingDescription.binding = 1;
+		bindingDescription.stride = sizeof(PackedVertex);
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return bindingDescription;
+	}
+
+	static std::array<VkVertexInputAttributeDescription, 4> GetAttributeDescriptions()
+	{
+		std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions{};
+
+		//position + handedness
+		attributeDescriptions[0].binding = 1;
+		attributeDescriptions[0].location = 0;
+		attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_SNORM;
+		attributeDescriptions[0].offset = offsetof(PackedVertex, pos);
+
+		//octahedral normal
+		attributeDescriptions[1].binding = 1;
+		attributeDescriptions[1].location = 1;
+		attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+		attributeDescriptions[1].offset = offsetof(PackedVertex, normal);
+
+		//octahedral tangent
+		attributeDescriptions[2].binding = 1;
+		attributeDescriptions[2].location = 2;
+		attributeDescriptions[2].format = VK_FORMAT_R16G16_SNORM;
+		attributeDescriptions[2].offset = offsetof(PackedVertex, tangent);
+
+		//texture coordinates
+		attributeDescriptions[3].binding = 1;
+		attributeDescriptions[3].location = 3;
+		attributeDescriptions[3].format = VK_FORMAT_R16G16_SFLOAT;
+		attributeDescriptions[3].offset = offsetof(PackedVertex, texCoord);
+
+		return attributeDescriptions;
+	}
+};
+
 struct VertexHasher
 {
 	size_t operator()(Vertex const& vertex) const
@@ -0,0 +1,196 @@
+#include "VertexQuantizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "Core/Logger.h"
+#include "Patterns/ThreadPool.h"
+
+
+namespace VertexQuantizer
+{
+	constexpr size_t QuantizeChunkSize = 16384;
+
+	int16_t ToSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	// Same rule the GPU uses for SNORM formats
+	float FromSnorm16(int16_t value)
+	{
+		return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+	}
+
+	QuantizationBounds ComputeBounds(std::span<const Vertex> vertices)
+	{
+		if (vertices.empty()) return {};
+
+		glm::vec3 minimum{std::numeric_limits<float>::max()};
+		glm::vec3 maximum{std::numeric_limits<float>::lowest()};
+		for (const Vertex& vertex : vertices)
+		{
+			minimum = glm::min(minimum, vertex.pos);
+			maximum = glm::max(maximum, vertex.pos);
+		}
+
+		const glm::vec3 halfSize = (maximum - minimum) * 0.5f;
+		const float halfExtent = std::max({halfSize.x, halfSize.y, halfSize.z});
+
+		return {minimum + halfSize, halfExtent > 0.0f ? halfExtent : 1.0f};
+	}
+
+	glm::mat4 GetDequantizeMatrix(const QuantizationBounds& bounds)
+	{
+		return glm::scale(glm::translate(glm::mat4(1.0f), bounds.center), glm::vec3(bounds.halfExtent));
+	}
+
+	glm::vec2 OctahedralEncode(const glm::vec3& direction)
+	{
+		const float length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+		if (length == 0.0f) return {};
+
+		const glm::vec3 n = direction / length;
+		if (n.z >= 0.0f) return {n.x, n.y};
+
+		return {(1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f)};
+	}
+
+	glm::vec3 OctahedralDecode(const glm::vec2& encoded)
+	{
+		glm::vec3 direction{encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y)};
+		const float t = std::max(-direction.z, 0.0f);
+		direction.x += direction.x >= 0.0f ? -t : t;
+		direction.y += direction.y >= 0.0f ? -t : t;
+
+		return glm::normalize(direction);
+	}
+
+	PackedVertex Quantize(const Vertex& vertex, const QuantizationBounds& bounds)
+	{
+		const glm::vec3 position = (vertex.pos - bounds.center) / bounds.halfExtent;
+		const glm::vec2 normal = OctahedralEncode(vertex.normal);
+		const glm::vec2 tangent = OctahedralEncode(glm::vec3{vertex.tangent});
+
+		PackedVertex packed{};
+		packed.pos[0] = ToSnorm16(position.x);
+		packed.pos[1] = ToSnorm16(position.y);
+		packed.pos[2] = ToSnorm16(position.z);
+		packed.pos[3] = vertex.tangent.w < 0.0f ? -32767 : 32767;
+		packed.normal[0] = ToSnorm16(normal.x);
+		packed.normal[1] = ToSnorm16(normal.y);
+		packed.tangent[0] = ToSnorm16(tangent.x);
+		packed.tangent[1] = ToSnorm16(tangent.y);
+		packed.texCoord[0] = glm::packHalf1x16(vertex.texCoord.x);
+		packed.texCoord[1] = glm::packHalf1x16(vertex.texCoord.y);
+
+		return packed;
+	}
+
+	Vertex Dequantize(const PackedVertex& vertex, const QuantizationBounds& bounds)
+	{
+		Vertex unpacked{};
+		unpacked.pos = bounds.center + glm::vec3{FromSnorm16(vertex.pos[0]), FromSnorm16(vertex.pos[1]), FromSnorm16(vertex.pos[2])} * bounds.halfExtent;
+		unpacked.normal = OctahedralDecode({FromSnorm16(vertex.normal[0]), FromSnorm16(vertex.normal[1])});
+		unpacked.tangent = glm::vec4{OctahedralDecode({FromSnorm16(vertex.tangent[0]), FromSnorm16(vertex.tangent[1])}), vertex.pos[3] < 0 ? -1.0f : 1.0f};
+		unpacked.texCoord = {glm::unpackHalf1x16(vertex.texCoord[0]), glm::unpackHalf1x16(vertex.texCoord[1])};
+
+		return unpacked;
+	}
+
+	void Quantize(std::span<const Vertex> vertices, const QuantizationBounds& bounds, std::span<PackedVertex> output)
+	{
+		const size_t chunkCount = (vertices.size() + QuantizeChunkSize - 1) / QuantizeChunkSize;
+		ThreadPool::ParallelFor(chunkCount, [&](size_t chunkIndex)
+		{
+			const size_t begin = chunkIndex * QuantizeChunkSize;
+			const size_t end = std::min(begin + QuantizeChunkSize, vertices.size());
+			for (size_t i = begin; i < end; ++i)
+			{
+				output[i] = Quantize(vertices[i], bounds);
+			}
+		});
+	}
+
+	void QuantizeModel(ParsedModel& model)
+	{
+		size_t vertexCount{};
+		for (const ParsedMesh& mesh : model.meshes)
+		{
+			vertexCount += mesh.vertices.size();
+		}
+
+		model.packedVertexStorage.resize(vertexCount);
+
+		size_t vertexOffset{};
+		for (ParsedMesh& mesh : model.meshes)
+		{
+			const std::span<PackedVertex> output = std::span<PackedVertex>(model.packedVertexStorage).subspan(vertexOffset, mesh.vertices.size());
+			const QuantizationBounds bounds = ComputeBounds(mesh.vertices);
+			Quantize(mesh.vertices, bounds, output);
+
+			mesh.packedVertices = output;
+			mesh.dequantizeMatrix = GetDequantizeMatrix(bounds);
+			vertexOffset += mesh.vertices.size();
+		}
+
+		model.vertexFormat = VertexFormat::Packed;
+	}
+
+	void Benchmark(const ParsedModel& model)
+	{
+		size_t vertexCount{};
+		float quantizeMs{};
+		float maxPositionError{};
+		float maxRelativePositionError{};
+		float maxNormalError{};
+		float maxTexCoordError{};
+
+		for (const ParsedMesh& mesh : model.meshes)
+		{
+			std::vector<PackedVertex> packed(mesh.vertices.size());
+
+			const auto quantizeStart = std::chrono::steady_clock::now();
+			const QuantizationBounds bounds = ComputeBounds(mesh.vertices);
+			Quantize(mesh.vertices, bounds, packed);
+			quantizeMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - quantizeStart).count();
+
+			for (size_t i{}; i < mesh.vertices.size(); ++i)
+			{
+				const Vertex& original = mesh.vertices[i];
+				const Vertex unpacked = Dequantize(packed[i], bounds);
+
+				const float positionError = glm::length(unpacked.pos - original.pos);
+				maxPositionError = std::max(maxPositionError, positionError);
+				maxRelativePositionError = std::max(maxRelativePositionError, positionError / bounds.halfExtent);
+
+				if (glm::length(original.normal) > 0.0f)
+				{
+					const float cosine = std::clamp(glm::dot(glm::normalize(original.normal), unpacked.normal), -1.0f, 1.0f);
+					maxNormalError = std::max(maxNormalError, glm::degrees(std::acos(cosine)));
+				}
+
+				const glm::vec2 texCoordError = glm::abs(unpacked.texCoord - original.texCoord);
+				maxTexCoordError = std::max({maxTexCoordError, texCoordError.x, texCoordError.y});
+			}
+
+			vertexCount += mesh.vertices.size();
+		}
+
+		const float verticesPerSecond = quantizeMs > 0.0f ? static_cast<float>(vertexCount) / quantizeMs * 1000.0f : 0.0f;
+		const size_t fullBytes = vertexCount * sizeof(Vertex);
+		const size_t packedBytes = vertexCount * sizeof(PackedVertex);
+
+		LogInfo("Quantized " + std::to_string(vertexCount) + " vertices of " + model.filePath + " in " + std::to_string(quantizeMs) + "ms (" + std::to_string(verticesPerSecond / 1.0e6f) + " M vertices/s)");
+		LogInfo("  Size: " + std::to_string(fullBytes) + " -> " + std::to_string(packedBytes) + " bytes");
+		LogInfo("  Max position error: " + std::to_string(maxPositionError) + " (" + std::to_string(maxRelativePositionError) + " of the half extent)");
+		LogInfo("  Max normal error: " + std::to_string(maxNormalError) + " degrees, max uv error: " + std::to_string(maxTexCoordError));
+	}
+}
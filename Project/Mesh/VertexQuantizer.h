@@ -0,0 +1,38 @@
+#pragma once
+#include <span>
+
+#include <glm/glm.hpp>
+
+#include "ModelLoader.h"
+#include "Vertex.h"
+
+
+// Turns Vertex into PackedVertex, see PackedVertex for the layout
+namespace VertexQuantizer
+{
+	// Positions are quantized inside a cube around the mesh so the dequantize matrix only has a uniform scale
+	// That keeps mat3(model) valid for normals, the shaders normalize them anyway
+	struct QuantizationBounds
+	{
+		glm::vec3 center{};
+		float halfExtent{1.0f};
+	};
+
+	[[nodiscard]] QuantizationBounds ComputeBounds(std::span<const Vertex> vertices);
+	[[nodiscard]] glm::mat4 GetDequantizeMatrix(const QuantizationBounds& bounds);
+
+	[[nodiscard]] PackedVertex Quantize(const Vertex& vertex, const QuantizationBounds& bounds);
+	[[nodiscard]] Vertex Dequantize(const PackedVertex& vertex, const QuantizationBounds& bounds);
+
+	// Splits the work over the ThreadPool, output has to be as big as vertices
+	void Quantize(std::span<const Vertex> vertices, const QuantizationBounds& bounds, std::span<PackedVertex> output);
+
+	// Fills the packed vertices and dequantize matrix of every mesh and switches the model to VertexFormat::Packed
+	void QuantizeModel(ParsedModel& model);
+
+	[[nodiscard]] glm::vec2 OctahedralEncode(const glm::vec3& direction);
+	[[nodiscard]] glm::vec3 OctahedralDecode(const glm::vec2& encoded);
+
+	// Logs the quantization throughput and the worst position/normal/uv error of a model
+	void Benchmark(const ParsedModel& model);
+}
@@ -0,0 +1,192 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+// Small shared worker pool for CPU side asset work (decoding, parsing, ...)
+// Tasks only record Vulkan commands into command buffers they own (ParallelRecorder), uploads stay on the main thread
+class ThreadPool final
+{
+public:
+	ThreadPool() = delete;
+	~ThreadPool() = delete;
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool& operator=(ThreadPool&&) = delete;
+
+	// threadCount 0 = use all hardware threads except the main thread
+	static void Init(uint32_t threadCount = 0)
+	{
+		if (!m_Workers.empty()) return;
+
+		if (threadCount == 0)
+		{
+			const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		m_Stop = false;
+		m_Workers.reserve(threadCount);
+		for (uint32_t i{}; i < threadCount; ++i)
+		{
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop);
+		}
+	}
+
+	static void Shutdown()
+	{
+		{
+			std::scoped_lock lock(m_Mutex);
+			m_Stop = true;
+		}
+
+		m_Condition.notify_all();
+		for (std::thread& worker : m_Workers)
+		{
+			worker.join();
+		}
+
+		m_Workers.clear();
+	}
+
+	[[nodiscard]] static uint32_t GetThreadCount() { return static_cast<uint32_t>(m_Workers.size()); }
+
+	// Runs the task on a worker, runs it inline when the pool is not initialized
+	template <typename Func>
+	static auto Enqueue(Func&& task) -> std::future<std::invoke_result_t<Func>>
+	{
+		using ReturnType = std::invoke_result_t<Func>;
+
+		auto packagedTask = std::make_shared<std::packaged_task<ReturnType()>>(std::forward<Func>(task));
+		std::future<ReturnType> future = packagedTask->get_future();
+
+		if (m_Workers.empty())
+		{
+			(*packagedTask)();
+			return future;
+		}
+
+		{
+			std::scoped_lock lock(m_Mutex);
+			m_Tasks.emplace([packagedTask] { (*packagedTask)(); });
+		}
+
+		m_Condition.notify_one();
+		return future;
+	}
+
+	// Calls func(i) for every i in [0, count) and blocks until all of them are done
+	// The calling thread helps out, so this is safe to call from inside a worker as well
+	// The first exception a call throws is rethrown here once every claimed index is done, the indices after it are skipped
+	template <typename Func>
+	static void ParallelFor(size_t count, Func&& func)
+	{
+		if (count == 0) return;
+
+		if (m_Workers.empty() || count == 1)
+		{
+			for (size_t i{}; i < count; ++i)
+			{
+				func(i);
+			}
+			return;
+		}
+
+		struct Batch
+		{
+			std::atomic<size_t> next{0};
+			std::atomic<size_t> done{0};
+			std::atomic<bool> failed{false};
+			std::exception_ptr error;
+			std::mutex mutex;
+			std::condition_variable finished;
+		};
+
+		auto batch = std::make_shared<Batch>();
+
+		// Helpers that start after all work is claimed only touch the batch, never func
+		auto work = [batch, &func, count]
+		{
+			size_t processed{};
+			for (size_t i = batch->next++; i < count; i = batch->next++)
+			{
+				// Every claimed index has to count as done, or the caller waits forever
+				++processed;
+				if (batch->failed) continue;
+
+				try
+				{
+					func(i);
+				}
+				catch (...)
+				{
+					std::scoped_lock lock(batch->mutex);
+					if (!batch->error) batch->error = std::current_exception();
+					batch->failed = true;
+				}
+			}
+
+			if (processed > 0 && batch->done.fetch_add(processed) + processed == count)
+			{
+				std::scoped_lock lock(batch->mutex);
+				batch->finished.notify_all();
+			}
+		};
+
+		const size_t helperCount = std::min(m_Workers.size(), count - 1);
+		{
+			std::scoped_lock lock(m_Mutex);
+			for (size_t i{}; i < helperCount; ++i)
+			{
+				m_Tasks.emplace(work);
+			}
+		}
+		m_Condition.notify_all();
+
+		work();
+
+		std::unique_lock lock(batch->mutex);
+		batch->finished.wait(lock, [&batch, count] { return batch->done.load() == count; });
+
+		// Only rethrown once no helper can call func anymore
+		if (batch->error) std::rethrow_exception(batch->error);
+	}
+
+private:
+	static void WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock lock(m_Mutex);
+				m_Condition.wait(lock, [] { return m_Stop || !m_Tasks.empty(); });
+
+				if (m_Stop && m_Tasks.empty()) return;
+
+				task = std::move(m_Tasks.front());
+				m_Tasks.pop();
+			}
+
+			task();
+		}
+	}
+
+	inline static std::vector<std::thread> m_Workers{};
+	inline static std::queue<std::function<void()>> m_Tasks{};
+	inline static std::mutex m_Mutex{};
+	inline static std::condition_variable m_Condition{};
+	inline static bool m_Stop{false};
+};
@@ -0,0 +1,227 @@
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <random>
+#include <string>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Core/Logger.h"
+
+
+void BoundingVolumeHierarchy::Build(std::span<const AABB> leafBounds)
+{
+	m_LeafBounds.assign(leafBounds.begin(), leafBounds.end());
+	m_LeafOrder.resize(m_LeafBounds.size());
+	for (uint32_t leafIndex{}; leafIndex < m_LeafOrder.size(); ++leafIndex)
+	{
+		m_LeafOrder[leafIndex] = leafIndex;
+	}
+
+	m_Nodes.clear();
+	m_NeedsRefit = false;
+	if (m_LeafBounds.empty()) return;
+
+	//Leaf nodes end up with 2 to 4 boxes, so there are fewer nodes than boxes
+	m_Nodes.reserve(m_LeafBounds.size());
+	m_Nodes.push_back({{}, 0, static_cast<uint32_t>(m_LeafOrder.size())});
+	Subdivide(0);
+}
+
+void BoundingVolumeHierarchy::UpdateLeaf(uint32_t leafIndex, const AABB& bounds)
+{
+	m_LeafBounds[leafIndex] = bounds;
+	m_NeedsRefit = true;
+}
+
+void BoundingVolumeHierarchy::Cull(const Frustum& frustum, std::vector<uint32_t>& visibleLeaves)
+{
+	if (m_Nodes.empty()) return;
+	if (m_NeedsRefit) Refit();
+
+	//Median splits keep the depth at log2 of the leaf count
+	std::array<uint32_t, 64> stack{};
+	uint32_t stackSize{};
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node& node = m_Nodes[stack[--stackSize]];
+
+		const CullResult result = frustum.TestAABB(node.bounds);
+		if (result == CullResult::Outside) continue;
+		if (result == CullResult::Inside)
+		{
+			AddLeaves(node, visibleLeaves);
+			continue;
+		}
+
+		if (node.leafCount == 0)
+		{
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = node.first + 1;
+			continue;
+		}
+
+		for (uint32_t order{node.first}; order < node.first + node.leafCount; ++order)
+		{
+			if (frustum.TestAABB(m_LeafBounds[m_LeafOrder[order]]) != CullResult::Outside)
+			{
+				visibleLeaves.push_back(m_LeafOrder[order]);
+			}
+		}
+	}
+}
+
+void BoundingVolumeHierarchy::Subdivide(uint32_t nodeIndex)
+{
+	AABB bounds{};
+	AABB centerBounds{};
+	{
+		const Node& node = m_Nodes[nodeIndex];
+		for (uint32_t order{node.first}; order < node.first + node.leafCount; ++order)
+		{
+			bounds.Grow(m_LeafBounds[m_LeafOrder[order]]);
+			centerBounds.Grow(m_LeafBounds[m_LeafOrder[order]].GetCenter());
+		}
+	}
+	m_Nodes[nodeIndex].bounds = bounds;
+
+	const uint32_t first = m_Nodes[nodeIndex].first;
+	const uint32_t leafCount = m_Nodes[nodeIndex].leafCount;
+	if (leafCount <= MaxLeavesPerNode) return;
+
+	//Split at the median center along the longest axis of the centers
+	const glm::vec3 size = centerBounds.maximum - centerBounds.minimum;
+	const int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+	const uint32_t half = leafCount / 2;
+	std::nth_element(m_LeafOrder.begin() + first, m_LeafOrder.begin() + first + half, m_LeafOrder.begin() + first + leafCount,
+		[this, axis](uint32_t a, uint32_t b) { return m_LeafBounds[a].GetCenter()[axis] < m_LeafBounds[b].GetCenter()[axis]; });
+
+	const uint32_t firstChild = static_cast<uint32_t>(m_Nodes.size());
+	m_Nodes.push_back({{}, first, half});
+	m_Nodes.push_back({{}, first + half, leafCount - half});
+	m_Nodes[nodeIndex].first = firstChild;
+	m_Nodes[nodeIndex].leafCount = 0;
+
+	Subdivide(firstChild);
+	Subdivide(firstChild + 1);
+}
+
+void BoundingVolumeHierarchy::Refit()
+{
+	for (uint32_t nodeIndex = static_cast<uint32_t>(m_Nodes.size()); nodeIndex-- > 0;)
+	{
+		Node& node = m_Nodes[nodeIndex];
+		AABB bounds{};
+		if (node.leafCount == 0)
+		{
+			bounds.Grow(m_Nodes[node.first].bounds);
+			bounds.Grow(m_Nodes[node.first + 1].bounds);
+		}
+		else
+		{
+			for (uint32_t order{node.first}; order < node.first + node.leafCount; ++order)
+			{
+				bounds.Grow(m_LeafBounds[m_LeafOrder[order]]);
+			}
+		}
+		node.bounds = bounds;
+	}
+	m_NeedsRefit = false;
+}
+
+void BoundingVolumeHierarchy::AddLeaves(const Node& node, std::vector<uint32_t>& visibleLeaves) const
+{
+	if (node.leafCount == 0)
+	{
+		AddLeaves(m_Nodes[node.first], visibleLeaves);
+		AddLeaves(m_Nodes[node.first + 1], visibleLeaves);
+		return;
+	}
+	visibleLeaves.insert(visibleLeaves.end(), m_LeafOrder.begin() + node.first, m_LeafOrder.begin() + node.first + node.leafCount);
+}
+
+void BoundingVolumeHierarchy::Benchmark(uint32_t instanceCount)
+{
+	//Boxes scattered around a camera at the origin that looks down +y, about a quarter of them ends up in view
+	std::mt19937 random{1337};
+	std::uniform_real_distribution<float> positionDistribution{-500.0f, 500.0f};
+	std::uniform_real_distribution<float> sizeDistribution{0.5f, 5.0f};
+
+	std::vector<AABB> boxes(instanceCount);
+	for (AABB& box : boxes)
+	{
+		const glm::vec3 center{positionDistribution(random), positionDistribution(random), positionDistribution(random)};
+		const glm::vec3 extent{sizeDistribution(random), sizeDistribution(random), sizeDistribution(random)};
+		box = {center - extent, center + extent};
+	}
+
+	const glm::mat4 view = glm::lookAt(glm::vec3{0}, glm::vec3{0, 1, 0}, glm::vec3{0, 0, 1});
+	const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+	const Frustum frustum = Frustum::FromMatrix(projection * view);
+
+	constexpr int iterations = 20;
+	const auto averageMs = [](auto start) { return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations; };
+
+	std::vector<uint32_t> visible{};
+	visible.reserve(instanceCount);
+
+	auto start = std::chrono::steady_clock::now();
+	for (int iteration{}; iteration < iterations; ++iteration)
+	{
+		visible.clear();
+		for (uint32_t boxIndex{}; boxIndex < instanceCount; ++boxIndex)
+		{
+			if (frustum.TestAABBScalar(boxes[boxIndex]) != CullResult::Outside) visible.push_back(boxIndex);
+		}
+	}
+	const float scalarMs = averageMs(start);
+	const size_t bruteForceVisible = visible.size();
+
+	start = std::chrono::steady_clock::now();
+	for (int iteration{}; iteration < iterations; ++iteration)
+	{
+		visible.clear();
+		for (uint32_t boxIndex{}; boxIndex < instanceCount; ++boxIndex)
+		{
+			if (frustum.TestAABB(boxes[boxIndex]) != CullResult::Outside) visible.push_back(boxIndex);
+		}
+	}
+	const float simdMs = averageMs(start);
+
+	BoundingVolumeHierarchy hierarchy{};
+	start = std::chrono::steady_clock::now();
+	hierarchy.Build(boxes);
+	const float buildMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for (int iteration{}; iteration < iterations; ++iteration)
+	{
+		visible.clear();
+		hierarchy.Cull(frustum, visible);
+	}
+	const float cullMs = averageMs(start);
+	const size_t hierarchyVisible = visible.size();
+
+	//One percent of the instances moves every frame
+	const glm::vec3 offset{1.0f, 0.0f, 0.0f};
+	start = std::chrono::steady_clock::now();
+	for (int iteration{}; iteration < iterations; ++iteration)
+	{
+		for (uint32_t boxIndex{}; boxIndex < instanceCount; boxIndex += 100)
+		{
+			hierarchy.UpdateLeaf(boxIndex, {boxes[boxIndex].minimum + offset, boxes[boxIndex].maximum + offset});
+		}
+		hierarchy.Refit();
+	}
+	const float refitMs = averageMs(start);
+
+	const std::string simdName = Frustum::HasSimd() ? "SSE" : "SSE (not available, scalar)";
+	LogInfo("Frustum culling " + std::to_string(instanceCount) + " boxes, " + std::to_string(hierarchy.GetNodeCount()) + " tree nodes");
+	LogInfo("  Brute force scalar: " + std::to_string(scalarMs) + "ms, " + simdName + ": " + std::to_string(simdMs) + "ms");
+	LogInfo("  Tree build: " + std::to_string(buildMs) + "ms, cull: " + std::to_string(cullMs) + "ms, refit after moving 1%: " + std::to_string(refitMs) + "ms");
+	LogInfo("  Visible: " + std::to_string(hierarchyVisible) + " of " + std::to_string(instanceCount) + (hierarchyVisible == bruteForceVisible ? ", matches brute force" : ", brute force found " + std::to_string(bruteForceVisible)));
+}
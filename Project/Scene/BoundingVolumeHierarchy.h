@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Core/Frustum.h"
+
+// Binary tree over world space boxes, the scene uses one leaf per primitive
+// Build sorts the leaves into the tree once, moving leaves only get their box updated and the tree refit
+// Refitting keeps the culling correct, the tree just gets looser the further things move from where they were built
+class BoundingVolumeHierarchy final
+{
+public:
+	BoundingVolumeHierarchy() = default;
+	~BoundingVolumeHierarchy() = default;
+	BoundingVolumeHierarchy(const BoundingVolumeHierarchy&) = delete;
+	BoundingVolumeHierarchy& operator=(const BoundingVolumeHierarchy&) = delete;
+	BoundingVolumeHierarchy(BoundingVolumeHierarchy&&) = delete;
+	BoundingVolumeHierarchy& operator=(BoundingVolumeHierarchy&&) = delete;
+
+	// Leaf i keeps index i, the culling results refer to it
+	void Build(std::span<const AABB> leafBounds);
+	// The nodes above it get refit on the next Cull
+	void UpdateLeaf(uint32_t leafIndex, const AABB& bounds);
+
+	// Appends every leaf that intersects the frustum, subtrees that are fully inside skip the tests of their leaves
+	void Cull(const Frustum& frustum, std::vector<uint32_t>& visibleLeaves);
+
+	[[nodiscard]] uint32_t GetLeafCount() const { return static_cast<uint32_t>(m_LeafBounds.size()); }
+	[[nodiscard]] uint32_t GetNodeCount() const { return static_cast<uint32_t>(m_Nodes.size()); }
+
+	// Offline mode, culls <instance count> random boxes with a brute force loop (scalar and SSE) and with the tree
+	static void Benchmark(uint32_t instanceCount);
+
+private:
+	// Inner nodes have their children at firstChild and firstChild + 1, leaf nodes a range of m_LeafOrder
+	struct Node
+	{
+		AABB bounds{};
+		uint32_t first{};
+		uint32_t leafCount{};
+	};
+
+	static constexpr uint32_t MaxLeavesPerNode = 4;
+
+	void Subdivide(uint32_t nodeIndex);
+	// Children always come after their parent, so one backwards pass refits the whole tree
+	void Refit();
+	void AddLeaves(const Node& node, std::vector<uint32_t>& visibleLeaves) const;
+
+	std::vector<Node> m_Nodes{};
+	std::vector<uint32_t> m_LeafOrder{};
+	std::vector<AABB> m_LeafBounds{};
+	bool m_NeedsRefit{false};
+};
@@ -1,15 +1,26 @@
 #include "Scene.h"
 
+#include <algorithm>
+#include <chrono>
+
 #include <implot.h>
 
+#include "Core/AsyncCompute.h"
 #include "Core/CommandBuffer.h"
 #include "Core/DepthResource.h"
 #include "Core/GBuffer.h"
 #include "Core/GlobalDescriptor.h"
 #include "Core/ImGuiWrapper.h"
+#include "Core/IndirectRenderer.h"
 #include "Core/Logger.h"
+#include "Core/ParallelRecorder.h"
+#include "Core/RenderQueue.h"
 #include "Core/SwapChain.h"
+#include "Core/GeometryPool.h"
+#include "Core/Image/TextureCache.h"
+#include "Core/UploadBatch.h"
 #include "Input/Input.h"
+#include "Mesh/AssetStreamer.h"
 #include "Mesh/MaterialManager.h"
 #include "Mesh/Mesh.h"
 #include "Mesh/ModelLoader.h"
@@ -34,6 +45,18 @@ Scene::Scene(VulkanContext* vulkanContext)
 	depthMaterial->AddShader("depth.vert", ShaderType::VertexShader);
 	depthMaterial->AddShader("depth.frag", ShaderType::FragmentShader);
 
+	std::shared_ptr<Material> packedDepthMaterial = MaterialManager::CreateMaterial(vulkanContext, "DepthOnlyMaterial_Packed");
+	packedDepthMaterial->SetDepthOnly(true);
+	packedDepthMaterial->SetVertexFormat(VertexFormat::Packed);
+	packedDepthMaterial->AddShader("depth_packed.vert", ShaderType::VertexShader);
+	packedDepthMaterial->AddShader("depth.frag", ShaderType::FragmentShader);
+
+	//
+	//Frustum Culling, reads the instances and writes the indirect draws through the global set
+	//
+	std::shared_ptr<Material> frustumCullMaterial = MaterialManager::CreateMaterial(vulkanContext, "FrustumCull");
+	frustumCullMaterial->AddShader("FrustumCull.comp", ShaderType::ComputeShader);
+
 	//
 	//Skybox Material
 	//
@@ -41,6 +64,18 @@ Scene::Scene(VulkanContext* vulkanContext)
     skyboxMaterial->GetDescriptorSet()->AddTexture(1, "cubemap_vulkan.ktx", vulkanContext, ColorType::SRGB, TextureType::TEXTURE_CUBE);
     skyboxMaterial->SetCullMode(VK_CULL_MODE_FRONT_BIT);
 
+	//
+	//Placeholder Material, shown by the AssetStreamer while a model is still loading
+	//
+	std::shared_ptr<Material> placeholderMaterial = MaterialManager::CreateMaterial(vulkanContext, "shader.vert", "PBR_Graypacked.frag", "PlaceholderMaterial");
+	auto* placeholderUbo = placeholderMaterial->GetDescriptorSet()->AddBuffer(0, DescriptorType::UniformBuffer);
+	placeholderUbo->AddVariable(glm::vec4{1});
+	placeholderUbo->AddVariable(glm::vec4{1});
+	placeholderMaterial->GetDescriptorSet()->AddTexture(1, "white.ktx", vulkanContext, ColorType::LINEAR);
+	placeholderMaterial->GetDescriptorSet()->AddTexture(2, "white.ktx", vulkanContext, ColorType::LINEAR);
+	placeholderMaterial->GetDescriptorSet()->AddTexture(3, "white.ktx", vulkanContext, ColorType::LINEAR);
+	placeholderMaterial->GetDescriptorSet()->AddTexture(4, "cubemap_vulkan.ktx", vulkanContext, ColorType::SRGB, TextureType::TEXTURE_CUBE);
+
 	//
 	//SSAO Materials
 	//
@@ -112,6 +147,12 @@ Scene::Scene(VulkanContext* vulkanContext)
 	UpSampleMaterial->GetDescriptorSet()->AddTexture(2, blurredSSAO, vulkanContext);
 	std::shared_ptr<Texture> upSampleTexture = UpSampleMaterial->GetDescriptorSet()->CreateOutputTexture(3, vulkanContext, {width, height});
 
+	//The render graph orders the passes that write these and transitions them in between
+	m_DownSampleTexture = downSampleTexture;
+	m_SSAOTexture = SSAO;
+	m_BlurredSSAOTexture = blurredSSAO;
+	m_UpSampleTexture = upSampleTexture;
+
 
 
 
@@ -142,13 +183,14 @@ Scene::Scene(VulkanContext* vulkanContext)
 
 
 
-	//Load model
-	GLTFLoader::LoadGLTF("FlightHelmet.gltf", this, vulkanContext);
+	//Load model, streamed in on a worker so the first frame does not wait on it
+	AssetStreamer::RequestGLTF("FlightHelmet.gltf", this);
 
     //Create the cubmap last so its rendered last
     //with a simple shader & depthmap trick we can make it only over the fragments that are not yet written to
     m_Meshes.push_back(std::make_unique<Mesh>("Cube.obj", "Skybox_Material", "CubeMap"));
     m_Meshes.back()->SetRotation(glm::vec3{-90,0,0});
+    m_Meshes.back()->SetFrustumCulled(false);
 
     //
     // Setup Input
@@ -171,12 +213,138 @@ Scene::Scene(VulkanContext* vulkanContext)
 }
 
 
-void Scene::RenderDepth(VkCommandBuffer commandBuffer) const
+void Scene::PrepareDraws()
 {
-    for (const auto& mesh : m_Meshes)
-    {
-        mesh->RenderDepth(commandBuffer);
-    }
+	RenderQueue::Clear();
+	for (const auto& mesh : m_Meshes)
+	{
+		mesh->Update();
+	}
+
+	if (!CpuCulling)
+	{
+		m_CullStats = {};
+		for (const auto& mesh : m_Meshes)
+		{
+			if (mesh->IsInstancesOnly()) continue;
+			mesh->QueueDraws();
+			m_CullStats.visible += mesh->GetPrimitiveCount();
+		}
+		for (const auto& instance : m_Instances)
+		{
+			for (uint32_t primitiveIndex{}; primitiveIndex < instance->GetMesh()->GetPrimitiveCount(); ++primitiveIndex)
+			{
+				instance->GetMesh()->QueueDraw(primitiveIndex, instance->GetTransform());
+			}
+			m_CullStats.visible += instance->GetMesh()->GetPrimitiveCount();
+		}
+		RenderQueue::Sort(Camera::GetViewMatrix());
+		return;
+	}
+
+	const auto cullStart = std::chrono::steady_clock::now();
+	UpdateCulling();
+	m_VisibleLeaves.clear();
+	m_BoundingVolumeHierarchy.Cull(Frustum::FromMatrix(Camera::GetViewProjectionMatrix()), m_VisibleLeaves);
+	m_CullStats.cullMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - cullStart).count();
+
+	//The depth and the color pass both draw what the render queue got, so this is the only place that culls
+	m_CullStats.visible = static_cast<uint32_t>(m_VisibleLeaves.size());
+	m_CullStats.culled = m_BoundingVolumeHierarchy.GetLeafCount() - m_CullStats.visible;
+	for (const uint32_t leafIndex : m_VisibleLeaves)
+	{
+		const CullLeaf& leaf = m_CullLeaves[leafIndex];
+		const CulledMesh& culledMesh = m_CulledMeshes[leaf.culledMeshIndex];
+		culledMesh.pMesh->QueueDraw(leaf.primitiveIndex, culledMesh.transform);
+	}
+	for (const auto& mesh : m_Meshes)
+	{
+		if (mesh->IsFrustumCulled() || mesh->IsInstancesOnly()) continue;
+		mesh->QueueDraws();
+		m_CullStats.visible += mesh->GetPrimitiveCount();
+	}
+	for (const auto& instance : m_Instances)
+	{
+		if (instance->GetMesh()->IsFrustumCulled()) continue;
+		for (uint32_t primitiveIndex{}; primitiveIndex < instance->GetMesh()->GetPrimitiveCount(); ++primitiveIndex)
+		{
+			instance->GetMesh()->QueueDraw(primitiveIndex, instance->GetTransform());
+		}
+		m_CullStats.visible += instance->GetMesh()->GetPrimitiveCount();
+	}
+
+	RenderQueue::Sort(Camera::GetViewMatrix());
+}
+
+void Scene::UpdateCulling()
+{
+	if (m_IsCullingDirty)
+	{
+		m_CulledMeshes.clear();
+		for (const auto& mesh : m_Meshes)
+		{
+			if (mesh->IsFrustumCulled() && !mesh->IsInstancesOnly()) m_CulledMeshes.push_back({mesh.get(), nullptr, mesh->GetTransform()});
+		}
+		for (const auto& instance : m_Instances)
+		{
+			if (instance->GetMesh()->IsFrustumCulled()) m_CulledMeshes.push_back({instance->GetMesh(), instance.get(), instance->GetTransform()});
+		}
+
+		m_CullLeaves.clear();
+		std::vector<AABB> leafBounds{};
+		for (uint32_t culledMeshIndex{}; culledMeshIndex < m_CulledMeshes.size(); ++culledMeshIndex)
+		{
+			CulledMesh& culledMesh = m_CulledMeshes[culledMeshIndex];
+			culledMesh.firstLeaf = static_cast<uint32_t>(m_CullLeaves.size());
+			for (uint32_t primitiveIndex{}; primitiveIndex < culledMesh.pMesh->GetPrimitiveCount(); ++primitiveIndex)
+			{
+				m_CullLeaves.push_back({culledMeshIndex, primitiveIndex});
+				leafBounds.push_back(culledMesh.pMesh->GetWorldBounds(primitiveIndex, culledMesh.transform));
+			}
+		}
+
+		m_BoundingVolumeHierarchy.Build(leafBounds);
+		m_IsCullingDirty = false;
+		return;
+	}
+
+	//SetTransform, the gizmo and the rotation all write the model matrix, comparing it catches every one of them
+	for (CulledMesh& culledMesh : m_CulledMeshes)
+	{
+		const glm::mat4 transform = culledMesh.GetTransform();
+		if (transform == culledMesh.transform) continue;
+
+		culledMesh.transform = transform;
+		for (uint32_t primitiveIndex{}; primitiveIndex < culledMesh.pMesh->GetPrimitiveCount(); ++primitiveIndex)
+		{
+			m_BoundingVolumeHierarchy.UpdateLeaf(culledMesh.firstLeaf + primitiveIndex, culledMesh.pMesh->GetWorldBounds(primitiveIndex, transform));
+		}
+	}
+}
+
+void Scene::ExecuteCullingPass(VkCommandBuffer commandBuffer) const
+{
+	if (!IndirectRenderer::IsEnabled()) return;
+
+	//The counts get cleared even without instances, the draws still read them
+	IndirectRenderer::BeginCulling(commandBuffer);
+
+	constexpr uint32_t groupSize = 64;
+	const uint32_t instanceCount = IndirectRenderer::GetInstanceCount();
+	if (instanceCount > 0)
+	{
+		auto cullMaterial = MaterialManager::GetMaterial("FrustumCull");
+		GlobalDescriptor::Bind(ServiceLocator::GetService<VulkanContext>(), commandBuffer, cullMaterial->GetPipelineLayout(), PipelineType::Compute);
+		cullMaterial->Bind(commandBuffer);
+		vkCmdDispatch(commandBuffer, (instanceCount + groupSize - 1) / groupSize, 1, 1);
+	}
+
+	IndirectRenderer::EndCulling(commandBuffer);
+}
+
+void Scene::RenderDepth(VkCommandBuffer commandBuffer, const RenderingFormats& formats) const
+{
+    RenderQueue::SubmitDepth(ServiceLocator::GetService<VulkanContext>(), commandBuffer, formats);
 }
 
 
@@ -191,13 +359,12 @@ void Scene::AlbedoRender(VkCommandBuffer commandBuffer) const
 	vkCmdDraw(commandBuffer, 3, 1, 0, 0);
 }
 
-void Scene::Render(VkCommandBuffer commandBuffer) const
+void Scene::Render(VkCommandBuffer commandBuffer, const RenderingFormats& formats) const
 {
 	const ImGuiIO& io = ImGui::GetIO(); (void)io;
 	const float ms = 1000.0f / io.Framerate;
 	const float fps = io.Framerate;
 	TimerGraph::OnImGui(ms, fps);
-	Camera::Update();
 
 	GameTimer::UpdateDelta();
 
@@ -228,12 +395,13 @@ void Scene::Render(VkCommandBuffer commandBuffer) const
     GlobalDescriptor::OnImGui();
 	Camera::OnImGui();
 	GBuffer::OnImGui();
+	UploadBatch::OnImGui();
+	TextureCache::OnImGui();
+	GeometryPool::OnImGui();
+	Descriptor::DescriptorManager::OnImGui();
 
 	for (const auto& mesh : m_Meshes)
 	{
-		//Render Each Mesh
-		mesh->Render(commandBuffer);
-
 		ImGui::Begin("Mesh");
 		if(ImGui::CollapsingHeader(mesh->GetMeshName().c_str()))
 		{
@@ -242,125 +410,99 @@ void Scene::Render(VkCommandBuffer commandBuffer) const
 		ImGui::End();
 	}
 
+	//The draws got sorted in PrepareDraws, the queue binds the shared geometry buffers itself
+	RenderQueue::Submit(ServiceLocator::GetService<VulkanContext>(), commandBuffer, formats);
+	ImGui::Begin("Info");
+	ImGui::SeparatorText("Frustum Culling");
+	ImGui::Checkbox("Cull on the CPU", &CpuCulling);
+	ImGui::Text("Meshes: %zu, instances: %zu", m_Meshes.size(), m_Instances.size());
+	ImGui::Text("Tree: %u primitives, %u nodes", m_BoundingVolumeHierarchy.GetLeafCount(), m_BoundingVolumeHierarchy.GetNodeCount());
+	ImGui::Text("Visible: %u, culled: %u (%.3f ms)", m_CullStats.visible, m_CullStats.culled, m_CullStats.cullMs);
+	ImGui::End();
+
+	RenderQueue::OnImGui();
+	IndirectRenderer::OnImGui();
+	ParallelRecorder::OnImGui();
+	AsyncCompute::OnImGui();
+
     ImGui::Render();
 }
 
-void Scene::ExecuteComputePass(VkCommandBuffer commandBuffer) const
+ImageHandle Scene::AddComputePasses(RenderGraph& renderGraph, ImageHandle depthImage, ImageHandle normalImage) const
 {
-	auto extends = SwapChain::Extends();
 	constexpr uint32_t groupSize = 32;
-	uint32_t fullscreenGroupCountX = (extends.width) / groupSize;
-	uint32_t fullscreenGroupCountY = (extends.height) / groupSize;
-
-	uint32_t quarterGroupCountX = (extends.width / 2.0f) / groupSize;
-	uint32_t quarterGroupCountY = (extends.height / 2.0f) / groupSize;
 
-	Texture* downSampleTexture{};
-	Texture* SSAO{};
-	Texture* BlurrSSAO{};
+	//The whole chain only reads what the depth prepass wrote, so it can run on the compute queue while the color pass draws
+	//Only the passes of the frame use them, so the graph can put them in the same memory
+	ImageHandle downSampleImage = renderGraph.CreateTransient("DownSampledDepth", m_DownSampleTexture.get(), m_DownSampleTexture->GetMemoryRequirements());
+	ImageHandle ssaoImage = renderGraph.CreateTransient("SSAO", m_SSAOTexture.get(), m_SSAOTexture->GetMemoryRequirements());
+	ImageHandle blurredSSAOImage = renderGraph.CreateTransient("BlurredSSAO", m_BlurredSSAOTexture.get(), m_BlurredSSAOTexture->GetMemoryRequirements());
+	ImageHandle upSampleImage = renderGraph.CreateTransient("UpSampledSSAO", m_UpSampleTexture.get(), m_UpSampleTexture->GetMemoryRequirements());
 
-
-
-	auto downSampleMaterial = MaterialManager::GetMaterial("DownSample");
-	if(downSampleMaterial->IsCompute())
+	const RenderGraph::PassHandle downSamplePass = renderGraph.AddPass("DownSample", PassType::Compute, [](VkCommandBuffer commandBuffer)
 	{
-		//Transition the output texture to writable
-		const auto& textures = downSampleMaterial->GetDescriptorSet()->GetTextures();
-		for(const auto& texture : textures)
-		{
-			if(texture->IsOutputTexture()) downSampleTexture = texture.get();
-			break;
-		}
-
-		downSampleTexture->TransitionToGeneralImageLayout(commandBuffer);
+		auto downSampleMaterial = MaterialManager::GetMaterial("DownSample");
+		if(!downSampleMaterial->IsCompute()) return;
 
+		const auto extends = SwapChain::Extends();
 		downSampleMaterial->Bind(commandBuffer);
-		vkCmdDispatch(commandBuffer, fullscreenGroupCountX, fullscreenGroupCountY, 1);
-
-		downSampleTexture->TransitionToReadableImageLayout(commandBuffer);
-		downSampleTexture->SetOutputTexture(false);
-	}
+		vkCmdDispatch(commandBuffer, extends.width / groupSize, extends.height / groupSize, 1);
+	});
+	renderGraph.SetAsyncCompute(downSamplePass);
+	renderGraph.Read(downSamplePass, depthImage, ImageUsage::Sampled);
+	downSampleImage = renderGraph.Write(downSamplePass, downSampleImage, ImageUsage::Storage);
 
 	//Execute the SSAO Shader
-	auto ssaoMaterial = MaterialManager::GetMaterial("ComputeMaterial");
-    if(ssaoMaterial->IsCompute())
-    {
-        const auto& textures = ssaoMaterial->GetDescriptorSet()->GetTextures();
-
-    	//Transition the output texture to writable
-        for(const auto& texture : textures)
-		{
-			if(texture->IsOutputTexture())
-			{
-				SSAO = texture.get();
-				break;
-			}
-        }
-
-    	SSAO->TransitionToGeneralImageLayout(commandBuffer);
+	const RenderGraph::PassHandle ssaoPass = renderGraph.AddPass("SSAO", PassType::Compute, [](VkCommandBuffer commandBuffer)
+	{
+		auto ssaoMaterial = MaterialManager::GetMaterial("ComputeMaterial");
+		if(!ssaoMaterial->IsCompute()) return;
 
+		const auto extends = SwapChain::Extends();
 		GlobalDescriptor::Bind(ServiceLocator::GetService<VulkanContext>(), commandBuffer, ssaoMaterial->GetPipelineLayout(), PipelineType::Compute);
-    	ssaoMaterial->BindPushConstant(commandBuffer, Camera::GetViewMatrix());
+		ssaoMaterial->BindPushConstant(commandBuffer, Camera::GetViewMatrix());
 		ssaoMaterial->Bind(commandBuffer);
-		vkCmdDispatch(commandBuffer, quarterGroupCountX, quarterGroupCountY	, 1);
-
-    	SSAO->TransitionToReadableImageLayout(commandBuffer);
-		SSAO->SetOutputTexture(false);
-    }
-
+		vkCmdDispatch(commandBuffer, (extends.width / 2) / groupSize, (extends.height / 2) / groupSize, 1);
+	});
+	renderGraph.SetAsyncCompute(ssaoPass);
+	renderGraph.Read(ssaoPass, depthImage, ImageUsage::Sampled);
+	renderGraph.Read(ssaoPass, normalImage, ImageUsage::Sampled);
+	renderGraph.Read(ssaoPass, downSampleImage, ImageUsage::Sampled);
+	ssaoImage = renderGraph.Write(ssaoPass, ssaoImage, ImageUsage::Storage);
 
-	auto blurMaterial = MaterialManager::GetMaterial("Blur");
-	if(ssaoMaterial->IsCompute())
+	const RenderGraph::PassHandle blurPass = renderGraph.AddPass("Blur", PassType::Compute, [](VkCommandBuffer commandBuffer)
 	{
-		const auto& textures = blurMaterial->GetDescriptorSet()->GetTextures();
-		//Transition the output texture to writable
-		for(const auto& texture : textures)
-		{
-			if(texture->IsOutputTexture())
-			{
-				BlurrSSAO = texture.get();
-				break;
-			}
-		}
-
-		BlurrSSAO->TransitionToGeneralImageLayout(commandBuffer);
+		auto blurMaterial = MaterialManager::GetMaterial("Blur");
+		if(!blurMaterial->IsCompute()) return;
 
+		const auto extends = SwapChain::Extends();
 		blurMaterial->BindPushConstant(commandBuffer, Camera::GetProjectionMatrix());
 		blurMaterial->Bind(commandBuffer);
-		vkCmdDispatch(commandBuffer, quarterGroupCountX, quarterGroupCountY, 1);
-
-		BlurrSSAO->TransitionToReadableImageLayout(commandBuffer);
-		BlurrSSAO->SetOutputTexture(false);
-	}
-
-
-
+		vkCmdDispatch(commandBuffer, (extends.width / 2) / groupSize, (extends.height / 2) / groupSize, 1);
+	});
+	renderGraph.SetAsyncCompute(blurPass);
+	renderGraph.Read(blurPass, ssaoImage, ImageUsage::Sampled);
+	renderGraph.Read(blurPass, downSampleImage, ImageUsage::Sampled);
+	blurredSSAOImage = renderGraph.Write(blurPass, blurredSSAOImage, ImageUsage::Storage);
 
-	auto upSampleMaterial = MaterialManager::GetMaterial("UpSample");
-	if(upSampleMaterial->IsCompute())
+	const RenderGraph::PassHandle upSamplePass = renderGraph.AddPass("UpSample", PassType::Compute, [](VkCommandBuffer commandBuffer)
 	{
-		const auto& textures = upSampleMaterial->GetDescriptorSet()->GetTextures();
-		//Transition the output texture to writable
-		for(const auto& texture : textures)
-		{
-			if(texture->IsOutputTexture()) texture->TransitionToGeneralImageLayout(commandBuffer);
-		}
+		auto upSampleMaterial = MaterialManager::GetMaterial("UpSample");
+		if(!upSampleMaterial->IsCompute()) return;
 
+		const auto extends = SwapChain::Extends();
 		GlobalDescriptor::Bind(ServiceLocator::GetService<VulkanContext>(), commandBuffer, upSampleMaterial->GetPipelineLayout(), PipelineType::Compute);
 		upSampleMaterial->BindPushConstant(commandBuffer, Camera::GetProjectionMatrix());
 		upSampleMaterial->Bind(commandBuffer);
-		vkCmdDispatch(commandBuffer, fullscreenGroupCountX, fullscreenGroupCountY, 1);
-
-		//transition the output texture to readable
-			for(const auto& texture : textures)
-		{
-			if(texture->IsOutputTexture()) texture->TransitionToReadableImageLayout(commandBuffer);
-		}
-	}
+		vkCmdDispatch(commandBuffer, extends.width / groupSize, extends.height / groupSize, 1);
+	});
+	renderGraph.SetAsyncCompute(upSamplePass);
+	renderGraph.Read(upSamplePass, depthImage, ImageUsage::Sampled);
+	renderGraph.Read(upSamplePass, normalImage, ImageUsage::Sampled);
+	renderGraph.Read(upSamplePass, blurredSSAOImage, ImageUsage::Sampled);
+	upSampleImage = renderGraph.Write(upSamplePass, upSampleImage, ImageUsage::Storage);
 
-	SSAO->SetOutputTexture(true);
-	BlurrSSAO->SetOutputTexture(true);
-	downSampleTexture->SetOutputTexture(true);
+	return upSampleImage;
 }
 
 void Scene::CleanUp() const
@@ -373,6 +515,38 @@ void Scene::CleanUp() const
 void Scene::AddMesh(std::unique_ptr<Mesh> mesh)
 {
     m_Meshes.push_back(std::move(mesh));
+    m_IsCullingDirty = true;
+}
+
+void Scene::RemoveMesh(const Mesh* mesh)
+{
+    const auto it = std::ranges::find_if(m_Meshes, [mesh](const std::unique_ptr<Mesh>& ownedMesh) { return ownedMesh.get() == mesh; });
+    if (it == m_Meshes.end()) return;
+
+    std::erase_if(m_Instances, [mesh](const std::unique_ptr<MeshInstance>& instance) { return instance->GetMesh() == mesh; });
+
+    (*it)->CleanUp();
+    m_Meshes.erase(it);
+    m_IsCullingDirty = true;
+}
+
+Mesh* Scene::FindMesh(const std::string& meshName) const
+{
+    const auto it = std::ranges::find_if(m_Meshes, [&meshName](const std::unique_ptr<Mesh>& mesh) { return mesh->GetMeshName() == meshName; });
+    return it == m_Meshes.end() ? nullptr : it->get();
+}
+
+MeshInstance* Scene::AddInstance(Mesh* mesh, const glm::mat4& transform)
+{
+    m_Instances.push_back(std::make_unique<MeshInstance>(mesh, transform));
+    m_IsCullingDirty = true;
+    return m_Instances.back().get();
+}
+
+void Scene::RemoveInstance(const MeshInstance* instance)
+{
+    std::erase_if(m_Instances, [instance](const std::unique_ptr<MeshInstance>& ownedInstance) { return ownedInstance.get() == instance; });
+    m_IsCullingDirty = true;
 }
 
 std::vector<Mesh *> Scene::GetMeshes() const
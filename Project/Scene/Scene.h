@@ -4,9 +4,14 @@
 #include "Camera/Camera.h"
 #include <vulkan/vulkan.h>
 #include "Mesh/Mesh.h"
+#include "Core/RenderGraph.h"
+#include "Mesh/MeshInstance.h"
+#include "Scene/BoundingVolumeHierarchy.h"
 
 
 struct Vertex;
+struct RenderingFormats;
+class Texture;
 
 
 class Scene final
@@ -19,20 +24,77 @@ public:
 	Scene(Scene&&) = delete;
 	Scene& operator=(Scene&&) = delete;
 
+	// Turn off to queue every primitive again, the GPU culling still runs on whatever gets queued
+	inline static bool CpuCulling{true};
+
     //TODO: A Scene Should store a list of passes
-    void RenderDepth(VkCommandBuffer commandBuffer) const;
+    //Frustum culls the primitives, collects and sorts the draws of the visible ones, once per frame before anything gets recorded
+    void PrepareDraws();
+    //Frustum culls the instances on the GPU, has to be recorded before the depth pass
+    void ExecuteCullingPass(VkCommandBuffer commandBuffer) const;
+    //Both passes only record the render queue, so their rendering scope can be recorded on multiple threads
+    void RenderDepth(VkCommandBuffer commandBuffer, const RenderingFormats& formats) const;
 	void AlbedoRender(VkCommandBuffer commandBuffer) const;
-	void Render(VkCommandBuffer commandBuffer) const;
-    void ExecuteComputePass(VkCommandBuffer commandBuffer) const;
+	void Render(VkCommandBuffer commandBuffer, const RenderingFormats& formats) const;
+    //Adds the SSAO passes, returns the occlusion the composite reads
+    ImageHandle AddComputePasses(RenderGraph& renderGraph, ImageHandle depthImage, ImageHandle normalImage) const;
 
 
 	void CleanUp() const;
 
     void AddMesh(std::unique_ptr<Mesh> mesh);
+    // Destroys the mesh buffers right away, only call this while no frame is in flight, the instances of the mesh go with it
+    void RemoveMesh(const Mesh* mesh);
+    [[nodiscard]] Mesh* FindMesh(const std::string& meshName) const;
+
+    // Draws the mesh again with another transform, without another copy of its geometry
+    MeshInstance* AddInstance(Mesh* mesh, const glm::mat4& transform);
+    void RemoveInstance(const MeshInstance* instance);
 
 	[[nodiscard]] std::vector<Mesh*> GetMeshes() const;
 
 private:
+	// A mesh or one of its instances
+	struct CulledMesh
+	{
+		Mesh* pMesh{};
+		const MeshInstance* pInstance{};
+		// Transform the leaves were last updated with
+		glm::mat4 transform{1};
+		uint32_t firstLeaf{};
+
+		[[nodiscard]] glm::mat4 GetTransform() const { return pInstance ? pInstance->GetTransform() : pMesh->GetTransform(); }
+	};
+
+	struct CullLeaf
+	{
+		uint32_t culledMeshIndex{};
+		uint32_t primitiveIndex{};
+	};
+
+	struct CullStats
+	{
+		uint32_t visible{};
+		uint32_t culled{};
+		float cullMs{};
+	};
+
+	// Rebuilds the tree when meshes got added or removed, otherwise refits the leaves of the meshes that moved
+	void UpdateCulling();
+
 	std::vector<std::unique_ptr<Mesh>> m_Meshes{};
+	std::vector<std::unique_ptr<MeshInstance>> m_Instances{};
+
+	BoundingVolumeHierarchy m_BoundingVolumeHierarchy{};
+	std::vector<CulledMesh> m_CulledMeshes{};
+	std::vector<CullLeaf> m_CullLeaves{};
+	std::vector<uint32_t> m_VisibleLeaves{};
+	bool m_IsCullingDirty{true};
+	CullStats m_CullStats{};
+
+	std::shared_ptr<Texture> m_DownSampleTexture{};
+	std::shared_ptr<Texture> m_SSAOTexture{};
+	std::shared_ptr<Texture> m_BlurredSSAOTexture{};
+	std::shared_ptr<Texture> m_UpSampleTexture{};
 
 };
@@ -9,18 +9,29 @@ void SceneManager::RenderPresent(VkCommandBuffer commandBuffer)
 	m_ActiveScene->AlbedoRender(commandBuffer);
 }
 
-void SceneManager::Render(VkCommandBuffer commandBuffer) {
-    m_ActiveScene->Render(commandBuffer);
+void SceneManager::Render(VkCommandBuffer commandBuffer, const RenderingFormats& formats) {
+    m_ActiveScene->Render(commandBuffer, formats);
 }
 
-void SceneManager::RenderDepth(VkCommandBuffer commandBuffer)
+void SceneManager::RenderDepth(VkCommandBuffer commandBuffer, const RenderingFormats& formats)
 {
-    m_ActiveScene->RenderDepth(commandBuffer);
+    m_ActiveScene->RenderDepth(commandBuffer, formats);
 }
 
 
-void SceneManager::ExecuteComputePass(VkCommandBuffer commandBuffer){
-    m_ActiveScene->ExecuteComputePass(commandBuffer);
+void SceneManager::PrepareDraws()
+{
+    m_ActiveScene->PrepareDraws();
+}
+
+void SceneManager::ExecuteCullingPass(VkCommandBuffer commandBuffer)
+{
+    m_ActiveScene->ExecuteCullingPass(commandBuffer);
+}
+
+ImageHandle SceneManager::AddComputePasses(RenderGraph& renderGraph, ImageHandle depthImage, ImageHandle normalImage)
+{
+    return m_ActiveScene->AddComputePasses(renderGraph, depthImage, normalImage);
 }
 
 void SceneManager::AddScene(std::unique_ptr<Scene> scene) {
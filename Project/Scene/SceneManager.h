@@ -16,10 +16,12 @@ public:
     SceneManager& operator=(SceneManager&&) = delete;
 
 	static void RenderPresent(VkCommandBuffer commandBuffer);
-    static void Render(VkCommandBuffer commandBuffer);
-    static void RenderDepth(VkCommandBuffer commandBuffer);
+    static void Render(VkCommandBuffer commandBuffer, const RenderingFormats& formats);
+    static void RenderDepth(VkCommandBuffer commandBuffer, const RenderingFormats& formats);
+    static void PrepareDraws();
+    static void ExecuteCullingPass(VkCommandBuffer commandBuffer);
 	static void ComputeSSAO(VkCommandBuffer commandBuffer);
-    static void ExecuteComputePass(VkCommandBuffer commandBuffer);
+    static ImageHandle AddComputePasses(RenderGraph& renderGraph, ImageHandle depthImage, ImageHandle normalImage);
     static void AddScene(std::unique_ptr<Scene> scene);
     static Scene *GetActiveScene();
     static void CleanUp();
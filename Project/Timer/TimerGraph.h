@@ -1,4 +1,6 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <implot.h>
 
 #include "GameTimer.h"
@@ -10,6 +12,13 @@
 class TimerGraph
 {
 public:
+	// Called once per frame with the time since the previous frame and the time the CPU was blocked on the frame fence
+	static void RecordFrame(float frameIntervalMs, float fenceWaitMs)
+	{
+		frameIntervals.Push(frameIntervalMs);
+		fenceWaits.Push(fenceWaitMs);
+	}
+
 	static void OnImGui(float ms, float fps)
 	{
 		ImGui::Begin("Info");
@@ -31,9 +40,43 @@ public:
 			ImPlot::EndPlot();
 		}
 
+		FramePacingOnImGui();
+
 		ImGui::End();
 	}
 private:
+	// Distribution of the intervals between frames, a narrow spike means even pacing
+	static void FramePacingOnImGui()
+	{
+		const size_t sampleCount = frameIntervals.Size();
+		if (sampleCount == 0) return;
+
+		std::array<float, FrameSampleCount> sortedIntervals{};
+		std::copy_n(frameIntervals.Data(), sampleCount, sortedIntervals.begin());
+		std::sort(sortedIntervals.begin(), sortedIntervals.begin() + sampleCount);
+
+		float totalFenceWait{};
+		for (size_t sampleIndex{}; sampleIndex < fenceWaits.Size(); ++sampleIndex)
+		{
+			totalFenceWait += fenceWaits.Data()[sampleIndex];
+		}
+
+		ImGui::Text("Frame pacing p50 %.2f ms, p99 %.2f ms, max %.2f ms", sortedIntervals[sampleCount / 2], sortedIntervals[sampleCount * 99 / 100], sortedIntervals[sampleCount - 1]);
+		ImGui::Text("Blocked on the frame fence: %.3f ms per frame", totalFenceWait / static_cast<float>(fenceWaits.Size()));
+
+		if (ImPlot::BeginPlot("Frame Pacing", ImVec2(-1, 0), ImPlotFlags_NoInputs | ImPlotFlags_NoTitle))
+		{
+			ImPlot::SetupAxes("ms", "frames", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+			ImPlot::PlotHistogram("Frame Intervals", frameIntervals.Data(), static_cast<int>(sampleCount), 50);
+			ImPlot::EndPlot();
+		}
+	}
+
+	static constexpr size_t FrameSampleCount = 1000;
+
 	inline static float msToPush{0.01f};
 	inline static CircularBuffer<500> frameTimes{};
+
+	inline static CircularBuffer<FrameSampleCount> frameIntervals{};
+	inline static CircularBuffer<FrameSampleCount> fenceWaits{};
 };
@@ -2,154 +2,142 @@
 #include <set>
 #include "Core/SwapChain.h"
 
+#include "Core/AsyncCompute.h"
 #include "Core/ColorAttachment.h"
 #include "Core/DepthResource.h"
+#include "Core/RenderGraph.h"
 #include "Core/GBuffer.h"
 #include "Core/GlobalDescriptor.h"
+#include "Core/Image/TextureBaker.h"
+#include "Core/IndirectRenderer.h"
+#include "Core/ParallelRecorder.h"
 #include "Mesh/MaterialManager.h"
 #include "Scene/SceneManager.h"
 #include "vulkanbase/VulkanBase.h"
 #include "vulkanbase/VulkanTypes.h"
 
-void VulkanBase::drawFrame(uint32_t imageIndex) const
+void VulkanBase::buildRenderGraph()
 {
-	//TODO: Move to swapchain
-	// Transition the swapchain image to COLOR_ATTACHMENT_OPTIMAL for rendering
-	tools::InsertImageMemoryBarrier(
-		 commandBuffer.Handle,
-		 SwapChain::Image(static_cast<uint8_t>(imageIndex)),
-		 VK_ACCESS_NONE_KHR,                                // No prior access
-		 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,             // Writing to the color attachment
-		 VK_IMAGE_LAYOUT_UNDEFINED,                        // Initial undefined state
-		 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,         // Transitioning for rendering
-		 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,    // Source stage
-		 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,    // Destination stage
-		 VkImageSubresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1});
-
-
-	VkExtent2D& swapChainExtent = SwapChain::Extends();
-	VulkanWindow::SetViewportCmd(commandBuffer.Handle);
-
-    // ======================= Depth-Only Pass ============================
-	GBuffer::GetDepthAttachment()->ResetImageLayout();
-	GBuffer::GetDepthAttachment()->TransitionToDepthResource(commandBuffer.Handle);
-
-	GBuffer::GetColorAttachmentNormal()->ResetImageLayout();
-	GBuffer::GetColorAttachmentNormal()->TransitionToWrite(commandBuffer.Handle);
-
-
-
-
-
-	// Create rendering info
-	VkRenderingInfoKHR depthRenderInfo{};
-	depthRenderInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
-	depthRenderInfo.renderArea = {0, 0, swapChainExtent};
-	depthRenderInfo.layerCount = 1;
-	depthRenderInfo.colorAttachmentCount = 1;
-	depthRenderInfo.pColorAttachments = GBuffer::GetColorAttachmentNormal()->GetRenderingAttachmentInfo();
-	depthRenderInfo.pDepthAttachment = GBuffer::GetDepthAttachment()->GetRenderingAttachmentInfo();
-
-	vkCmdBeginRenderingKHR(commandBuffer.Handle, &depthRenderInfo);
-    SceneManager::RenderDepth(commandBuffer.Handle);
-	vkCmdEndRenderingKHR(commandBuffer.Handle);
-
-
-    // ======================= Downsample Depth Pass ============================
-
-    // Transition depth buffer to be used in the compute pass
-	GBuffer::GetDepthAttachment()->TransitionToGeneralResource(commandBuffer.Handle);
-	GBuffer::GetColorAttachmentNormal()->TransitionToGeneralResource(commandBuffer.Handle);
-
-	// Execute the compute pass
-	SceneManager::ExecuteComputePass(commandBuffer.Handle);
-
-	//Transition depth buffer to be used in the color pass
-	GBuffer::GetColorAttachmentNormal()->TransitionToRead(commandBuffer.Handle);
-	GBuffer::GetDepthAttachment()->TransitionToShaderRead(commandBuffer.Handle);
-
-
-
-
-
-
-
-
-
+	ColorAttachment* normalAttachment = GBuffer::GetColorAttachmentNormal();
+	DepthAttachment* depthAttachment = GBuffer::GetDepthAttachment();
+	ColorAttachment* albedoAttachment = GBuffer::GetAlbedoAttachment();
+
+	//The swap chain image gets set every frame, the submit waits for it before the color output
+	m_SwapChainImage = m_RenderGraph.Import("SwapChain", VkImage{VK_NULL_HANDLE}, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+	ImageHandle depthImage = m_RenderGraph.Import("Depth", depthAttachment, VK_IMAGE_ASPECT_DEPTH_BIT);
+	ImageHandle normalImage = m_RenderGraph.Import("Normal", normalAttachment, VK_IMAGE_ASPECT_COLOR_BIT);
+	ImageHandle albedoImage = m_RenderGraph.Import("Albedo", albedoAttachment, VK_IMAGE_ASPECT_COLOR_BIT);
+
+	//The SSAO chain runs on the compute queue next to the color pass, both read the depth so it got created concurrent
+	if (AsyncCompute::IsEnabled())
+	{
+		m_RenderGraph.EnableAsyncCompute(AsyncCompute::GetGraphicsFamily(), AsyncCompute::GetComputeFamily());
+		m_RenderGraph.SetConcurrent(depthImage);
+	}
 
+    // ======================= Frustum Culling Pass ============================
+	//Only touches buffers, it has its own barriers
+	const RenderGraph::PassHandle cullingPass = m_RenderGraph.AddPass("Culling", PassType::Compute, [](VkCommandBuffer commandBuffer)
+	{
+		SceneManager::ExecuteCullingPass(commandBuffer);
+	});
+	m_RenderGraph.SetSideEffect(cullingPass);
 
+    // ======================= Depth-Only Pass ============================
+	const RenderGraph::PassHandle depthPass = m_RenderGraph.AddPass("DepthPrepass", PassType::Graphics, [normalAttachment, depthAttachment](VkCommandBuffer commandBuffer)
+	{
+		VkRenderingInfoKHR depthRenderInfo{};
+		depthRenderInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+		depthRenderInfo.flags = ParallelRecorder::GetRenderingFlags();
+		depthRenderInfo.renderArea = {0, 0, SwapChain::Extends()};
+		depthRenderInfo.layerCount = 1;
+		depthRenderInfo.colorAttachmentCount = 1;
+		depthRenderInfo.pColorAttachments = normalAttachment->GetRenderingAttachmentInfo();
+		depthRenderInfo.pDepthAttachment = depthAttachment->GetRenderingAttachmentInfo();
+
+		//The passes of a frame can end up in different command buffers, none of them inherits the viewport
+		VulkanWindow::SetViewportCmd(commandBuffer);
+
+		const RenderingFormats depthFormats{*normalAttachment->GetFormat(), depthAttachment->GetFormat()};
+		vkCmdBeginRenderingKHR(commandBuffer, &depthRenderInfo);
+		SceneManager::RenderDepth(commandBuffer, depthFormats);
+		vkCmdEndRenderingKHR(commandBuffer);
+	});
+	depthImage = m_RenderGraph.Write(depthPass, depthImage, ImageUsage::DepthAttachment);
+	normalImage = m_RenderGraph.Write(depthPass, normalImage, ImageUsage::ColorAttachment);
+
+    // ======================= Downsample Depth / SSAO Passes ============================
+	const ImageHandle occlusionImage = SceneManager::AddComputePasses(m_RenderGraph, depthImage, normalImage);
 
 	// ======================= Final Color Rendering Pass ============================
-    VkRenderingInfoKHR renderInfo{};
-    renderInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
-    renderInfo.renderArea = { 0, 0, swapChainExtent };
-    renderInfo.layerCount = 1;
-    renderInfo.colorAttachmentCount = 1;
-    renderInfo.pColorAttachments = GBuffer::GetAlbedoAttachment()->GetRenderingAttachmentInfo();
-    renderInfo.pDepthAttachment = GBuffer::GetDepthAttachment()->GetRenderingAttachmentInfo();
-    renderInfo.pStencilAttachment = VK_NULL_HANDLE;
-
-
-
-
-	GBuffer::GetAlbedoAttachment()->ResetImageLayout();
-	GBuffer::GetAlbedoAttachment()->TransitionToWrite(commandBuffer.Handle);
-
-
-
-    vkCmdBeginRenderingKHR(commandBuffer.Handle, &renderInfo);
-    SceneManager::Render(commandBuffer.Handle);
-    vkCmdEndRenderingKHR(commandBuffer.Handle);
-
-	//Here we write to albedo
-	//Albedo should transition to read
-	GBuffer::GetAlbedoAttachment()->TransitionToRead(commandBuffer.Handle);
-
-
-
-
-
-
-	//TODO: Move to swapchain
-	VkRenderingAttachmentInfoKHR colorAttachmentInfo{};
-	colorAttachmentInfo.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
-	colorAttachmentInfo.pNext = VK_NULL_HANDLE;
-	colorAttachmentInfo.imageView = SwapChain::ImageViews()[imageIndex];
-	colorAttachmentInfo.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-	colorAttachmentInfo.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	colorAttachmentInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-	colorAttachmentInfo.clearValue = {{0.83f, 0.75f, 0.83f, 1.0f}};
-
-	VkRenderingInfoKHR presentInfo{};
-	presentInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
-	presentInfo.renderArea = { 0, 0, swapChainExtent };
-	presentInfo.layerCount = 1;
-	presentInfo.colorAttachmentCount = 1;
-	presentInfo.pColorAttachments = &colorAttachmentInfo;
-	presentInfo.pDepthAttachment = GBuffer::GetDepthAttachment()->GetRenderingAttachmentInfo();
-	presentInfo.pStencilAttachment = VK_NULL_HANDLE;
-
-
-
-	vkCmdBeginRenderingKHR(commandBuffer.Handle, &presentInfo);
-	SceneManager::RenderPresent(commandBuffer.Handle);
+	const RenderGraph::PassHandle colorPass = m_RenderGraph.AddPass("Color", PassType::Graphics, [albedoAttachment, depthAttachment](VkCommandBuffer commandBuffer)
+	{
+		VkRenderingInfoKHR renderInfo{};
+		renderInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+		renderInfo.flags = ParallelRecorder::GetRenderingFlags();
+		renderInfo.renderArea = { 0, 0, SwapChain::Extends() };
+		renderInfo.layerCount = 1;
+		renderInfo.colorAttachmentCount = 1;
+		renderInfo.pColorAttachments = albedoAttachment->GetRenderingAttachmentInfo();
+		renderInfo.pDepthAttachment = depthAttachment->GetRenderingAttachmentInfo();
+		renderInfo.pStencilAttachment = VK_NULL_HANDLE;
+
+		VulkanWindow::SetViewportCmd(commandBuffer);
+
+		const RenderingFormats colorFormats{*albedoAttachment->GetFormat(), depthAttachment->GetFormat()};
+		vkCmdBeginRenderingKHR(commandBuffer, &renderInfo);
+		SceneManager::Render(commandBuffer, colorFormats);
+		vkCmdEndRenderingKHR(commandBuffer);
+	});
+	//Only depth tests, a read keeps it in the read only layout the compute queue samples it in
+	m_RenderGraph.Read(colorPass, depthImage, ImageUsage::DepthAttachment);
+	albedoImage = m_RenderGraph.Write(colorPass, albedoImage, ImageUsage::ColorAttachment);
+
+	// ======================= Composite / Present Pass ============================
 	//Take Albedo and SSAO as input -> Render to SwapChain
-	ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer.Handle);
-	vkCmdEndRenderingKHR(commandBuffer.Handle);
-
-	//TODO: Move to swapchain
-	// Transition swapchain image for presentation
-	tools::InsertImageMemoryBarrier(
-		commandBuffer.Handle,
-		SwapChain::Image(static_cast<uint8_t>(imageIndex)),
-		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,              // Writing completed
-		VK_ACCESS_NONE_KHR,                                // No subsequent access
-		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,          // Current layout
-		VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,                   // Ready for presentation
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,     // Source stage
-		VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,              // Final stage
-		VkImageSubresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1});
+	const RenderGraph::PassHandle presentPass = m_RenderGraph.AddPass("Present", PassType::Graphics, [depthAttachment](VkCommandBuffer commandBuffer)
+	{
+		VkRenderingAttachmentInfoKHR colorAttachmentInfo{};
+		colorAttachmentInfo.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+		colorAttachmentInfo.pNext = VK_NULL_HANDLE;
+		colorAttachmentInfo.imageView = SwapChain::ImageViews()[SwapChain::GetImageIndex()];
+		colorAttachmentInfo.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		colorAttachmentInfo.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachmentInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachmentInfo.clearValue = {{0.83f, 0.75f, 0.83f, 1.0f}};
+
+		VkRenderingInfoKHR presentInfo{};
+		presentInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+		presentInfo.renderArea = { 0, 0, SwapChain::Extends() };
+		presentInfo.layerCount = 1;
+		presentInfo.colorAttachmentCount = 1;
+		presentInfo.pColorAttachments = &colorAttachmentInfo;
+		presentInfo.pDepthAttachment = depthAttachment->GetRenderingAttachmentInfo();
+		presentInfo.pStencilAttachment = VK_NULL_HANDLE;
+
+		VulkanWindow::SetViewportCmd(commandBuffer);
+		vkCmdBeginRenderingKHR(commandBuffer, &presentInfo);
+		SceneManager::RenderPresent(commandBuffer);
+		ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
+		vkCmdEndRenderingKHR(commandBuffer);
+	});
+	m_RenderGraph.Read(presentPass, albedoImage, ImageUsage::Sampled);
+	m_RenderGraph.Read(presentPass, occlusionImage, ImageUsage::Sampled);
+	m_RenderGraph.Read(presentPass, depthImage, ImageUsage::DepthAttachment);
+	m_RenderGraph.Write(presentPass, m_SwapChainImage, ImageUsage::ColorAttachment);
+
+	LogAssert(m_RenderGraph.Compile(), "Failed to compile the render graph!", true);
+	m_RenderGraph.AllocateTransients();
+	m_RenderGraph.LogSchedule();
+}
 
+void VulkanBase::drawFrame(FrameData& frame, uint32_t imageIndex)
+{
+	m_RenderGraph.SetImage(m_SwapChainImage, SwapChain::Image(static_cast<uint8_t>(imageIndex)));
+	//The color pass ends the ImGui frame
+	m_RenderGraph.OnImGui();
+
+	AsyncCompute::SubmitFrame(m_RenderGraph, frame);
 }
 
 void VulkanBase::pickPhysicalDevice()
@@ -220,8 +208,20 @@ void VulkanBase::createLogicalDevice()
 	
 	QueueFamilyIndices indices = QueueFamilyIndices::FindQueueFamilies(physicalDevice, SwapChain::GetSurface());
 
+	//The GPU driven path is optional, the CPU records every draw when one of these is missing
+	VkPhysicalDeviceVulkan12Features supportedVulkan12Features{};
+	supportedVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	VkPhysicalDeviceFeatures2 supportedFeatures{};
+	supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	supportedFeatures.pNext = &supportedVulkan12Features;
+	vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures);
+
+	//The queues wait on each other with timeline semaphores, without a compute only family the compute passes stay on the graphics queue
+	const bool useAsyncCompute = AsyncCompute::UseAsyncCompute && indices.computeFamily.has_value() && supportedVulkan12Features.timelineSemaphore;
+
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 	std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+	if (useAsyncCompute) uniqueQueueFamilies.insert(indices.computeFamily.value());
 
 	float queuePriority = 1.0f;
 	for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -234,24 +234,36 @@ void VulkanBase::createLogicalDevice()
 		queueCreateInfos.push_back(queueCreateInfo);
 	}
 
+	const bool isIndirectSupported = supportedVulkan12Features.drawIndirectCount && supportedFeatures.features.multiDrawIndirect && supportedFeatures.features.drawIndirectFirstInstance;
+	IndirectRenderer::SetSupported(isIndirectSupported);
+
+	//Baked textures are BC1/BC3/BC5, without it the loader falls back to the source images
+	TextureBaker::IsBlockCompressionSupported = supportedFeatures.features.textureCompressionBC == VK_TRUE;
+
 	//Set the device features
 	VkPhysicalDeviceFeatures deviceFeatures{};
 	deviceFeatures.samplerAnisotropy = VK_TRUE;
     deviceFeatures.fragmentStoresAndAtomics = VK_TRUE;
     deviceFeatures.vertexPipelineStoresAndAtomics = VK_TRUE;
+	deviceFeatures.multiDrawIndirect = isIndirectSupported;
+	deviceFeatures.drawIndirectFirstInstance = isIndirectSupported;
+	deviceFeatures.textureCompressionBC = TextureBaker::IsBlockCompressionSupported;
 
 
-	//Set the Dynamic Rendering Extension
-	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeature{};
-	dynamicRenderingFeature.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
-	dynamicRenderingFeature.dynamicRendering = VK_TRUE;
+	//Dynamic rendering, and the barriers of the render graph are vkCmdPipelineBarrier2
+	VkPhysicalDeviceVulkan13Features vulkan13Features{};
+	vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+	vulkan13Features.dynamicRendering = VK_TRUE;
+	vulkan13Features.synchronization2 = VK_TRUE;
 
-	//Setup Bindles rendering features
-	VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures{};
-	descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
-	descriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
-	descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
-	descriptorIndexingFeatures.pNext = &dynamicRenderingFeature;
+	//Setup Bindles rendering features, the 1.2 struct replaces the descriptor indexing one so drawIndirectCount can go in the same chain
+	VkPhysicalDeviceVulkan12Features vulkan12Features{};
+	vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+	vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+	vulkan12Features.drawIndirectCount = isIndirectSupported;
+	vulkan12Features.timelineSemaphore = useAsyncCompute;
+	vulkan12Features.pNext = &vulkan13Features;
 
 
 
@@ -262,7 +274,7 @@ void VulkanBase::createLogicalDevice()
 	createInfo.pEnabledFeatures = &deviceFeatures;
 	createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
 	createInfo.ppEnabledExtensionNames = deviceExtensions.data();
-	createInfo.pNext = &descriptorIndexingFeatures;
+	createInfo.pNext = &vulkan12Features;
 	createInfo.enabledLayerCount = 0;
 
 
@@ -276,4 +288,5 @@ void VulkanBase::createLogicalDevice()
 
 	vkGetDeviceQueue(m_pContext->device, indices.graphicsFamily.value(), 0, &m_pContext->graphicsQueue);
 	vkGetDeviceQueue(m_pContext->device, indices.presentFamily.value(), 0, &presentQueue);
+	if (useAsyncCompute) vkGetDeviceQueue(m_pContext->device, indices.computeFamily.value(), 0, &m_pContext->computeQueue);
 }
\ No newline at end of file
@@ -1,8 +1,17 @@
 #include <set>
+#include "Camera/Camera.h"
+#include "Core/AsyncCompute.h"
 #include "Core/DepthResource.h"
+#include "Core/GeometryPool.h"
 #include "Core/Descriptor.h"
+#include "Core/FrameRing.h"
+#include "Core/GlobalDescriptor.h"
+#include "Core/ParallelRecorder.h"
 #include "Core/SwapChain.h"
+#include "Mesh/AssetStreamer.h"
+#include "Scene/SceneManager.h"
 #include "shaders/Logic/Shader.h"
+#include "Timer/TimerGraph.h"
 #include "vulkanbase/VulkanBase.h"
 
 
@@ -18,35 +27,21 @@ VkDebugUtilsMessengerCreateInfoEXT VulkanBase::setupDebugMessenger()
 	return createInfo;
 }
 
-void VulkanBase::createSyncObjects()
-{
-	VkSemaphoreCreateInfo semaphoreInfo{};
-	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-
-	VkFenceCreateInfo fenceInfo{};
-	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-	if (vkCreateSemaphore(m_pContext->device, &semaphoreInfo, nullptr, &imageAvailableSemaphore) != VK_SUCCESS ||
-		vkCreateSemaphore(m_pContext->device, &semaphoreInfo, nullptr, &renderFinishedSemaphore) != VK_SUCCESS ||
-		vkCreateFence(m_pContext->device, &fenceInfo, nullptr, &inFlightFence) != VK_SUCCESS)
-	{
-		throw std::runtime_error("failed to create synchronization objects for a frame!");
-	}
-
-}
-
-
 void VulkanBase::drawFrame()
 {
-	VkDevice device = m_pContext->device;
-	vkWaitForFences(device, 1, &inFlightFence, VK_TRUE, UINT64_MAX);
+	//Only waits for the frame that used this slot last, the other frames keep running on the GPU
+	FrameData& frame = FrameRing::BeginFrame();
+	TimerGraph::RecordFrame(FrameRing::GetLastFrameIntervalMs(), FrameRing::GetLastFenceWaitMs());
+
+	//Frame boundary, hand finished loads to the scene
+	AssetStreamer::ProcessCompleted(m_pContext);
+	GeometryPool::CompactIfFragmented();
 
     //TODO: This check should only happen on events / not in the hot code path
     ShaderManager::ReloadNeededShaders(m_pContext);
 
 	uint32_t imageIndex;
-	const VkResult nextImageResult = vkAcquireNextImageKHR(m_pContext->device, SwapChain::GetSwapChain(), UINT64_MAX, imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+	const VkResult nextImageResult = vkAcquireNextImageKHR(m_pContext->device, SwapChain::GetSwapChain(), UINT64_MAX, frame.imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
 	if (nextImageResult == VK_ERROR_OUT_OF_DATE_KHR)
 	{
 		SwapChain::SetNeedsRecreation();
@@ -59,36 +54,25 @@ void VulkanBase::drawFrame()
 	SwapChain::SetImageIndex(imageIndex);
 
 
-	Descriptor::DescriptorManager::ClearPools(m_pContext->device);
-	vkResetFences(device, 1, &inFlightFence);
-
-	CommandBufferManager::ResetCommandBuffer(commandBuffer);
-	CommandBufferManager::BeginCommandBufferRecording(commandBuffer, false, false);
-
-	drawFrame(imageIndex);
+	//The sets of this slot were used by the frame the fence above waited on
+	Descriptor::DescriptorManager::NewFrame(m_pContext->device);
+	ParallelRecorder::BeginFrame();
+	AsyncCompute::BeginFrame();
 
-	CommandBufferManager::EndCommandBufferRecording(commandBuffer);
+	//Every pass of the frame sees the same camera, the draws only bind the result
+	//The draws get sorted first, their instance buffer is part of the global set
+	Camera::Update();
+	SceneManager::PrepareDraws();
+	GlobalDescriptor::UpdateFrameConstants(m_pContext);
 
-
-	VkSubmitInfo submitInfo{};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-	submitInfo.waitSemaphoreCount = 1;
-	submitInfo.pWaitSemaphores = &imageAvailableSemaphore;
-	submitInfo.pWaitDstStageMask = waitStages;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &commandBuffer.Handle;
-	submitInfo.signalSemaphoreCount = 1;
-	submitInfo.pSignalSemaphores = &renderFinishedSemaphore;
-
-	CommandBufferManager::SubmitCommandBuffer(m_pContext, commandBuffer, &submitInfo, inFlightFence);
+	//Records and submits every queue of the render graph, the last submit signals renderFinishedSemaphore
+	drawFrame(frame, imageIndex);
 
 
 	VkPresentInfoKHR presentInfo{};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 	presentInfo.waitSemaphoreCount = 1;
-	presentInfo.pWaitSemaphores = &renderFinishedSemaphore;
+	presentInfo.pWaitSemaphores = &frame.renderFinishedSemaphore;
 	const VkSwapchainKHR swapChains[] = { SwapChain::GetSwapChain() };
 	presentInfo.swapchainCount = 1;
 	presentInfo.pSwapchains = swapChains;
@@ -106,6 +90,8 @@ void VulkanBase::drawFrame()
 	{
 		LogError("Failed to present swap chain image! to queue");
 	}
+
+	FrameRing::AdvanceFrame();
 }
 
 VkBool32 VulkanBase::debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
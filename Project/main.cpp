@@ -3,14 +3,146 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <algorithm>
+#include <cstdlib>
 #include <ranges>
+#include <string>
+#include <vector>
 
 
+#include <filesystem>
+
+#include "Core/AsyncCompute.h"
+#include "Core/FrameRing.h"
 #include "Core/Logger.h"
+#include "Core/RenderGraph.h"
+#include "Core/RenderQueue.h"
+#include "Core/Image/MipGenerator.h"
+#include "Core/Image/TextureBaker.h"
+#include "Mesh/MeshCache.h"
+#include "Mesh/MeshOptimizer.h"
+#include "Mesh/ModelLoader.h"
+#include "Mesh/TangentGenerator.h"
+#include "Mesh/VertexQuantizer.h"
+#include "Patterns/ThreadPool.h"
+#include "Scene/BoundingVolumeHierarchy.h"
 #include "vulkanbase/VulkanBase.h"
 
-int main()
+int main(int argc, char* argv[])
 {
+	//Offline mode, writes the mesh caches without opening a window
+	if (argc > 1 && std::string(argv[1]) == "--bake-meshes")
+	{
+		ThreadPool::Init();
+		MeshCache::Bake(std::vector<std::string>(argv + 2, argv + argc));
+		ThreadPool::Shutdown();
+		return EXIT_SUCCESS;
+	}
+
+	//Offline mode, compresses the textures of the given glTF models into block compressed .ktx files without opening a window
+	if (argc > 1 && std::string(argv[1]) == "--bake-textures")
+	{
+		ThreadPool::Init();
+		TextureBaker::Bake(std::vector<std::string>(argv + 2, argv + argc));
+		ThreadPool::Shutdown();
+		return EXIT_SUCCESS;
+	}
+
+	//Offline mode, compares the obj deduplication paths for the given .obj files
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-obj-dedup")
+	{
+		ThreadPool::Init();
+		for (const std::string& modelPath : std::vector<std::string>(argv + 2, argv + argc))
+		{
+			ObjLoader::BenchmarkDeduplication(modelPath);
+		}
+		ThreadPool::Shutdown();
+		return EXIT_SUCCESS;
+	}
+
+	//Offline mode, times parsing the given glTF models with the serial and the parallel primitive decode
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-primitive-decode")
+	{
+		ThreadPool::Init();
+		for (const std::string& modelPath : std::vector<std::string>(argv + 2, argv + argc))
+		{
+			GLTFLoader::BenchmarkPrimitiveDecode(modelPath);
+		}
+		ThreadPool::Shutdown();
+		return EXIT_SUCCESS;
+	}
+
+	//Offline modes, log the speed and quality of the vertex quantization / tangent generation / mesh optimization for the given models
+	const bool benchmarkQuantization = argc > 1 && std::string(argv[1]) == "--benchmark-quantization";
+	const bool benchmarkTangents = argc > 1 && std::string(argv[1]) == "--benchmark-tangents";
+	const bool benchmarkMeshOptimizer = argc > 1 && std::string(argv[1]) == "--benchmark-mesh-optimizer";
+	if (benchmarkQuantization || benchmarkTangents || benchmarkMeshOptimizer)
+	{
+		//The mesh optimizer needs the index order of the source file
+		if (benchmarkMeshOptimizer)
+		{
+			MeshCache::UseCache = false;
+			MeshOptimizer::OptimizeOnImport = false;
+		}
+
+		ThreadPool::Init();
+		for (const std::string& modelPath : std::vector<std::string>(argv + 2, argv + argc))
+		{
+			const bool isObj = std::filesystem::path(modelPath).extension() == ".obj";
+			const std::optional<ParsedModel> model = isObj ? ObjLoader::ParseObj(modelPath) : GLTFLoader::ParseGLTF(modelPath);
+
+			if (!model) LogError("Failed to load: " + modelPath);
+			else if (benchmarkQuantization) VertexQuantizer::Benchmark(model.value());
+			else if (benchmarkTangents) TangentGenerator::Benchmark(model.value());
+			else MeshOptimizer::Benchmark(model.value());
+		}
+		ThreadPool::Shutdown();
+		return EXIT_SUCCESS;
+	}
+
+	//Offline mode, sorts a synthetic scene of <draw count> draws (10000 by default) and logs the state changes it saves
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-render-queue")
+	{
+		const int drawCount = argc > 2 ? std::atoi(argv[2]) : 10000;
+		RenderQueue::Benchmark(static_cast<uint32_t>(std::max(1, drawCount)));
+		return EXIT_SUCCESS;
+	}
+
+	//Offline mode, frustum culls <instance count> random boxes (100000 by default) brute force and through the bounding volume hierarchy
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-culling")
+	{
+		const int instanceCount = argc > 2 ? std::atoi(argv[2]) : 100000;
+		BoundingVolumeHierarchy::Benchmark(static_cast<uint32_t>(std::max(1, instanceCount)));
+		return EXIT_SUCCESS;
+	}
+
+	//Offline mode, compiles the passes of a frame without a device and checks the order, culling, barriers, aliasing and the queue split
+	if (argc > 1 && std::string(argv[1]) == "--validate-render-graph")
+	{
+		return RenderGraph::SelfTest() ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	//Offline mode, checks the reference mip filtering and logs the sRGB mip chain of the given images
+	if (argc > 1 && std::string(argv[1]) == "--validate-mips")
+	{
+		return MipGenerator::SelfTest(std::vector<std::string>(argv + 2, argv + argc)) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	//--frames-in-flight <count>, 1 serializes the CPU and the GPU again
+	for (int argIndex{1}; argIndex + 1 < argc; ++argIndex)
+	{
+		if (std::string(argv[argIndex]) == "--frames-in-flight")
+		{
+			FrameRing::FramesInFlight = static_cast<uint32_t>(std::max(1, std::atoi(argv[argIndex + 1])));
+		}
+	}
+
+	//--no-async-compute keeps the SSAO passes on the graphics queue
+	for (int argIndex{1}; argIndex < argc; ++argIndex)
+	{
+		if (std::string(argv[argIndex]) == "--no-async-compute") AsyncCompute::UseAsyncCompute = false;
+	}
+
 	VulkanBase app;
 	try
 	{
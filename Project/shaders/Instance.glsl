@@ -0,0 +1,20 @@
+// Per draw data of the render queue, one entry per sorted draw, matches GpuInstance in Core/IndirectRenderer.h
+// Vertex shaders index it with gl_InstanceIndex (the firstInstance of the draw), fragment shaders with the flat index the vertex shader passes on
+struct Instance
+{
+    mat4 transform;
+    vec4 boundingSphere;
+    uint indexCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint batch;
+    uint firstCommand;
+    uint padding0;
+    uint padding1;
+    uint padding2;
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer InstanceBuffer
+{
+    Instance instances[];
+};
@@ -4,6 +4,7 @@
 
 #include <vector>
 
+#include "Core/FrameRing.h"
 #include "Mesh/Material.h"
 #include "Patterns/ServiceLocator.h"
 #include "ShaderEditor.h"
@@ -121,6 +122,9 @@ void ShaderManager::ReloadNeededShaders(const VulkanContext *vulkanContext)
 {
     if(m_ShadersToReload.empty()) return;
 
+    //The pipelines get recreated, the frames in flight can still be using the old ones
+    FrameRing::WaitForAllFrames();
+
     for(const auto& shaderName : m_ShadersToReload)
     {
         //Check if the shader exists
@@ -210,8 +214,22 @@ bool ShaderManager::ImGuiShaderGetter(void *data, int idx, const char **out_text
     return true;
 }
 
-VkPipelineVertexInputStateCreateInfo ShaderManager::GetVertexInputStateInfo()
+VkPipelineVertexInputStateCreateInfo ShaderManager::GetVertexInputStateInfo(VertexFormat vertexFormat)
 {
+	if (vertexFormat == VertexFormat::Packed)
+	{
+		constexpr VkPipelineVertexInputStateCreateInfo packedVertexInputInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+			.vertexBindingDescriptionCount = 1,
+			.pVertexBindingDescriptions = &m_PackedVertexInputBindingDescription,
+			.vertexAttributeDescriptionCount = static_cast<uint32_t>(m_PackedVertexInputAttributeDescription.size()),
+			.pVertexAttributeDescriptions = m_PackedVertexInputAttributeDescription.data()
+		};
+
+		return packedVertexInputInfo;
+	}
+
 	constexpr VkPipelineVertexInputStateCreateInfo vertexInputInfo
     {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
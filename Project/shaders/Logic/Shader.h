@@ -82,7 +82,7 @@ public:
     //TODO This needs to be moved to a more appropriate place
     static bool ImGuiShaderGetter(void *data, int idx, const char **out_text);
 
-    static VkPipelineVertexInputStateCreateInfo GetVertexInputStateInfo();
+    static VkPipelineVertexInputStateCreateInfo GetVertexInputStateInfo(VertexFormat vertexFormat = VertexFormat::Full);
 	static VkPipelineInputAssemblyStateCreateInfo GetInputAssemblyStateInfo();
 private:
 	class ShaderBuilder final
@@ -110,4 +110,6 @@ private:
 	//TODO: the lifetime of these variables are too long
 	inline static VkVertexInputBindingDescription m_VertexInputBindingDescription = Vertex::GetBindingDescription();
 	inline static std::array<VkVertexInputAttributeDescription, 4> m_VertexInputAttributeDescription = Vertex::GetAttributeDescriptions();
+	inline static VkVertexInputBindingDescription m_PackedVertexInputBindingDescription = PackedVertex::GetBindingDescription();
+	inline static std::array<VkVertexInputAttributeDescription, 4> m_PackedVertexInputAttributeDescription = PackedVertex::GetAttributeDescriptions();
 };
\ No newline at end of file
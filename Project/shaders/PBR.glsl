@@ -80,13 +80,17 @@ vec3 specularContribution(vec3 L, vec3 V, vec3 N, vec3 F0, float metallic, float
     return color;
 }
 
-vec3 calculateNormal(sampler2D normalMap, vec3 normal, vec3 tangent, vec2 uv)
+// tangent.w is the handedness of the tangent frame
+vec3 calculateNormal(sampler2D normalMap, vec3 normal, vec4 tangent, vec2 uv)
 {
     vec3 tangentNormal = texture(normalMap, uv).xyz * 2.0 - 1.0;
+    // Baked BC5 normal maps only store x and y, their blue reads as 0
+    if (tangentNormal.z == -1.0)
+        tangentNormal.z = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
 
     vec3 N = normalize(normal);
-    vec3 T = normalize(tangent.xyz);
-    vec3 B = normalize(cross(N, T));
+    vec3 T = normalize(tangent.xyz - N * dot(N, tangent.xyz));
+    vec3 B = cross(N, T) * tangent.w;
     mat3 TBN = mat3(T, B, N);
     return normalize(TBN * tangentNormal);
 }
\ No newline at end of file
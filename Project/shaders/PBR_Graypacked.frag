@@ -1,10 +1,6 @@
 #version 450
 #include "PBR.glsl"
-
-layout(push_constant) uniform constants
-{
-	mat4 model;
-} push;
+#include "Instance.glsl"
 
 layout(set = 0, binding = 0) uniform UniformBufferObject
 {
@@ -32,6 +28,7 @@ layout (location = 0) in vec3 inWorldPos;
 layout (location = 1) in vec3 inNormal;
 layout (location = 2) in vec2 inUV;
 layout (location = 3) in vec4 inTangent;
+layout (location = 4) flat in uint inInstanceIndex;
 
 layout(location = 0) out vec4 outColor;
 
@@ -44,7 +41,7 @@ layout(location = 0) out vec4 outColor;
 
 void main()
 {
-	vec3 N = calculateNormal(normalMap, inNormal, inTangent.xyz, inUV);
+	vec3 N = calculateNormal(normalMap, inNormal, inTangent, inUV);
 	vec3 V = normalize(ubo.viewPos.xyz - inWorldPos);
 	vec3 R = reflect(-V, N);
 
@@ -96,7 +93,7 @@ void main()
 	vec3 kD = 1.0 - F;
 	kD *= 1.0 - metallic;
 
-	mat4 inverseModel = inverse(mat4(push.model));
+	mat4 inverseModel = inverse(instances[inInstanceIndex].transform);
 	vec4 skyboxReflection = SkyboxReflection(inWorldPos, inNormal, inverseModel, skyBox);
 	vec3 ambient = skyboxReflection.rgb * 0.2 +  (kD * diffuse + specular);
 
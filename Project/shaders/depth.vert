@@ -1,8 +1,5 @@
 #version 450
-
-layout(push_constant) uniform constants {
-    mat4 model;
-} push;
+#include "Instance.glsl"
 
 layout(set = 0, binding = 0) uniform UniformBufferObject {
     mat4 viewProjection;
@@ -13,7 +10,7 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
 
 layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec3 inTangent;
+layout(location = 2) in vec4 inTangent;
 layout(location = 3) in vec2 inUV;
 
 layout(location = 0) out vec3 outWorldPos;
@@ -22,8 +19,9 @@ layout(location = 2) out vec2 outUV;
 layout(location = 3) out vec4 outTangent;
 
 void main() {
-    vec4 localPosition = push.model * vec4(inPos, 1.0);  // Local -> World space
-    vec3 normalWorld = mat3(push.model) * inNormal;      // Local -> World space normal
+    mat4 model = instances[gl_InstanceIndex].transform;
+    vec4 localPosition = model * vec4(inPos, 1.0);       // Local -> World space
+    vec3 normalWorld = mat3(model) * inNormal;           // Local -> World space normal
 
     outWorldPos = localPosition.xyz;                     // World space position
     outUV = inUV;
@@ -0,0 +1,40 @@
+#version 450
+
+// depth.vert for meshes with VertexFormat::Packed, the model matrix already contains the dequantize matrix
+#include "Instance.glsl"
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 viewProjection;
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+} ubo;
+
+layout(location = 0) in vec4 inPos;
+layout(location = 1) in vec2 inNormal;
+layout(location = 2) in vec2 inTangent;
+layout(location = 3) in vec2 inUV;
+
+layout(location = 0) out vec3 outWorldPos;
+layout(location = 1) out vec3 outNormal;
+layout(location = 2) out vec2 outUV;
+layout(location = 3) out vec4 outTangent;
+
+vec3 OctahedralDecode(vec2 encoded) {
+    vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float t = max(-direction.z, 0.0);
+    direction.xy += vec2(direction.x >= 0.0 ? -t : t, direction.y >= 0.0 ? -t : t);
+    return normalize(direction);
+}
+
+void main() {
+    mat4 model = instances[gl_InstanceIndex].transform;
+    vec4 localPosition = model * vec4(inPos.xyz, 1.0);                       // Quantized -> World space
+    vec3 normalWorld = mat3(model) * OctahedralDecode(inNormal);           // Local -> World space normal
+
+    outWorldPos = localPosition.xyz;                     // World space position
+    outUV = inUV;
+    outNormal = normalWorld;
+
+    gl_Position = ubo.viewProjection * localPosition;    // Transform to clip space
+}
@@ -1,9 +1,5 @@
 #version 450
-
-layout(push_constant) uniform constants
-{
-    mat4 model;
-} push;
+#include "Instance.glsl"
 
 layout(set = 0, binding = 0) uniform UniformBufferObject
 {
@@ -13,22 +9,25 @@ layout(set = 0, binding = 0) uniform UniformBufferObject
 
 layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec3 inTangent;
+layout(location = 2) in vec4 inTangent;
 layout(location = 3) in vec2 inUV;
 
 layout (location = 0) out vec3 outWorldPos;
 layout (location = 1) out vec3 outNormal;
 layout (location = 2) out vec2 outUV;
 layout (location = 3) out vec4 outTangent;
+layout (location = 4) flat out uint outInstanceIndex;
 
 void main() 
 {
-	vec3 localPosition = vec3(push.model * vec4(inPos, 1.0));
+	mat4 model = instances[gl_InstanceIndex].transform;
+	vec3 localPosition = vec3(model * vec4(inPos, 1.0));
 	outWorldPos = localPosition;
 
-	outNormal = mat3(push.model) * inNormal;
-	outTangent = vec4(mat3(push.model) * inTangent.xyz, 1);
+	outNormal = mat3(model) * inNormal;
+	outTangent = vec4(mat3(model) * inTangent.xyz, inTangent.w);
 	outUV = inUV;
+	outInstanceIndex = gl_InstanceIndex;
 
 
 	gl_Position =  ubo.viewProjection * vec4(outWorldPos, 1.0);
@@ -0,0 +1,44 @@
+#version 450
+
+// shader.vert for meshes with VertexFormat::Packed, the model matrix already contains the dequantize matrix
+#include "Instance.glsl"
+
+layout(set = 0, binding = 0) uniform UniformBufferObject
+{
+    mat4 viewProjection;
+	vec4 viewPos;
+} ubo;
+
+layout(location = 0) in vec4 inPos;
+layout(location = 1) in vec2 inNormal;
+layout(location = 2) in vec2 inTangent;
+layout(location = 3) in vec2 inUV;
+
+layout (location = 0) out vec3 outWorldPos;
+layout (location = 1) out vec3 outNormal;
+layout (location = 2) out vec2 outUV;
+layout (location = 3) out vec4 outTangent;
+layout (location = 4) flat out uint outInstanceIndex;
+
+vec3 OctahedralDecode(vec2 encoded)
+{
+	vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float t = max(-direction.z, 0.0);
+	direction.xy += vec2(direction.x >= 0.0 ? -t : t, direction.y >= 0.0 ? -t : t);
+	return normalize(direction);
+}
+
+void main()
+{
+	mat4 model = instances[gl_InstanceIndex].transform;
+	vec3 localPosition = vec3(model * vec4(inPos.xyz, 1.0));
+	outWorldPos = localPosition;
+
+	outNormal = mat3(model) * OctahedralDecode(inNormal);
+	outTangent = vec4(mat3(model) * OctahedralDecode(inTangent), inPos.w < 0.0 ? -1.0 : 1.0);
+	outUV = inUV;
+	outInstanceIndex = gl_InstanceIndex;
+
+
+	gl_Position =  ubo.viewProjection * vec4(outWorldPos, 1.0);
+}
@@ -1,9 +1,5 @@
 #version 450
-
-layout(push_constant) uniform constants
-{
-	mat4 model;
-} push;
+#include "Instance.glsl"
 
 layout(set = 0, binding = 0) uniform UniformBufferObject
 {
@@ -24,7 +20,7 @@ void main()
 	// Convert cubemap coordinates into Vulkan coordinate space
 	outUVW.xy *= -1.0;
 	// Remove translation from view matrix
-	mat4 viewMat = mat4(mat3(push.model));
+	mat4 viewMat = mat4(mat3(instances[gl_InstanceIndex].transform));
 
 	vec4 worldPos = viewMat * vec4(inPos.xyz, 1.0);
 
@@ -1,12 +1,21 @@
 #include "VulkanBase.h"
 
+#include "Core/AsyncCompute.h"
 #include "Core/CommandPool.h"
+#include "Core/FrameRing.h"
 #include "Core/ImGuiWrapper.h"
 #include "Core/SwapChain.h"
+#include "Core/GeometryPool.h"
+#include "Core/Image/TextureCache.h"
+#include "Core/IndirectRenderer.h"
+#include "Core/ParallelRecorder.h"
+#include "Core/UploadBatch.h"
 #include "Core/VmaUsage.h"
 #include "Input/Input.h"
+#include "Mesh/AssetStreamer.h"
 #include "Mesh/MaterialManager.h"
 #include "Patterns/ServiceLocator.h"
+#include "Patterns/ThreadPool.h"
 #include "Scene/SceneManager.h"
 #include "shaders/Logic/ShaderEditor.h"
 #include "VulkanTypes.h"
@@ -17,12 +26,14 @@
 void VulkanBase::run()
 {
     ServiceConfigurator::Configure();
+    ThreadPool::Init();
     initVulkan();
 	ImGuiWrapper::Initialize(m_pContext->graphicsQueue);
     ShaderEditor::Init();
     SceneManager::AddScene(std::make_unique<Scene>(m_pContext));
     Input::SetupInput(m_pContext->window.Get());
     MaterialManager::CreatePipelines();
+    buildRenderGraph();
 
 
 
@@ -56,9 +67,13 @@ void VulkanBase::initVulkan()
     vkCmdEndRenderingKHR = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(m_pContext->device, "vkCmdEndRenderingKHR"));
 
     CommandPool::CreateCommandPool(m_pContext);
-    CommandBufferManager::CreateCommandBuffer(m_pContext, commandBuffer);
+    FrameRing::Init(m_pContext);
+    ParallelRecorder::Init(m_pContext);
+    AsyncCompute::Init(m_pContext);
+    UploadBatch::Init(m_pContext);
+    GeometryPool::Init(m_pContext);
+    IndirectRenderer::Init(m_pContext);
     Descriptor::DescriptorManager::Init(m_pContext);
-    createSyncObjects();
     ShaderManager::Setup();
 
 
@@ -90,13 +105,15 @@ void VulkanBase::mainLoop()
     vkDeviceWaitIdle(m_pContext->device);
 }
 
-void VulkanBase::cleanup() const
+void VulkanBase::cleanup()
 {
     VkDevice device = m_pContext->device;
 
-    vkDestroySemaphore(device, renderFinishedSemaphore, nullptr);
-    vkDestroySemaphore(device, imageAvailableSemaphore, nullptr);
-    vkDestroyFence(device, inFlightFence, nullptr);
+    AssetStreamer::Cleanup();
+
+    FrameRing::Cleanup(m_pContext);
+    ParallelRecorder::Cleanup(m_pContext);
+    AsyncCompute::Cleanup(m_pContext);
 
 	GBuffer::Cleanup(m_pContext);
 
@@ -108,11 +125,17 @@ void VulkanBase::cleanup() const
     Descriptor::DescriptorManager::Cleanup(m_pContext->device);
     ShaderManager::Cleanup(m_pContext->device);
     MaterialManager::Cleanup();
+    TextureCache::Cleanup(m_pContext);
+    m_RenderGraph.Cleanup();
     SceneManager::CleanUp();
+    GeometryPool::Cleanup();
+    IndirectRenderer::Cleanup();
+    UploadBatch::Cleanup(m_pContext);
     Allocator::Cleanup(m_pContext->device);
     ImGuiWrapper::Cleanup();
     SwapChain::Cleanup(m_pContext);
     m_pContext->CleanUp();
+    ThreadPool::Shutdown();
 }
 
 
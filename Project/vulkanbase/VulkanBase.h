@@ -11,6 +11,8 @@
 #include <vulkan/vulkan.h>
 
 #include "Core/CommandBuffer.h"
+#include "Core/FrameRing.h"
+#include "Core/RenderGraph.h"
 #include "shaders/Logic/ShaderFileWatcher.h"
 
 
@@ -37,11 +39,10 @@ private:
 	void initVulkan();
 	void mainLoop();
 
-    void cleanup() const;
+    void cleanup();
 
     VulkanContext* m_pContext{};
 	ShaderFileWatcher shaderFileWatcher{};
-    CommandBuffer commandBuffer{};
 	PFN_vkCmdBeginRenderingKHR vkCmdBeginRenderingKHR{ VK_NULL_HANDLE };
 	PFN_vkCmdEndRenderingKHR vkCmdEndRenderingKHR{ VK_NULL_HANDLE };
 
@@ -51,12 +52,14 @@ private:
 
 	VkQueue presentQueue;
 	VkDebugUtilsMessengerEXT debugMessenger;
-	VkSemaphore imageAvailableSemaphore;
-	VkSemaphore renderFinishedSemaphore;
-	VkFence inFlightFence;
 
 
-	void drawFrame(uint32_t imageIndex) const;
+	//The passes of a frame, declared once after the pipelines exist
+	RenderGraph m_RenderGraph{};
+	ImageHandle m_SwapChainImage{};
+
+	void buildRenderGraph();
+	void drawFrame(FrameData& frame, uint32_t imageIndex);
 
 
     void pickPhysicalDevice();
@@ -69,7 +72,6 @@ private:
 	std::vector<const char*> getRequiredExtensions();
 	static void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
 	static bool CheckValidationLayerSupport(const std::vector<const char*>& validationLayers);
-	void createSyncObjects();
 	void drawFrame();
 
 	static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void*);
@@ -67,6 +67,8 @@ public:
 
 	//TODO Store a CommandPool Manager here? (typically there would be 1 command pool for each thread)-> the same can be done for the graphics queue
 	VkQueue graphicsQueue{};
+	// Only there when the device has a compute only family and async compute is on
+	VkQueue computeQueue{};
 	VkCommandPool commandPool{};
     VkInstance instance{};
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;